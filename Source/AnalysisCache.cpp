@@ -0,0 +1,450 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the AnalysisCache class for a JUCE application,
+    finding mix points from a loudness envelope snapped to the beat grid.
+
+  ==============================================================================
+*/
+
+#include "AnalysisCache.h"
+#include "StartupTrace.h"
+
+namespace
+{
+    constexpr double windowSeconds = 0.5; // Loudness envelope resolution
+}
+
+AnalysisCache::AnalysisCache(juce::AudioFormatManager& formatManagerToUse)
+    : juce::Thread("Track analyser"), formatManager(formatManagerToUse)
+{
+    cacheFile = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("analysis-cache.xml");
+}
+
+AnalysisCache::~AnalysisCache()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+void AnalysisCache::start()
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+bool AnalysisCache::lookup(const juce::File& file, TrackAnalysis& result) const
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(file.getFullPathName());
+    if (it == entries.end() || !it->second.ready)
+    {
+        return false;
+    }
+
+    result = it->second.analysis;
+    return true;
+}
+
+// Queue a file unless a current analysis of it is already cached or pending
+void AnalysisCache::request(const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        auto it = entries.find(file.getFullPathName());
+        if (it != entries.end()
+            && (!it->second.ready
+                || (it->second.fileSize == file.getSize()
+                    && it->second.modified == file.getLastModificationTime().toMilliseconds())))
+        {
+            return;
+        }
+
+        entries[file.getFullPathName()] = Entry();
+        pending.push_back(file);
+    }
+
+    notify();
+}
+
+bool AnalysisCache::isCurrent(const juce::File& file) const
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(file.getFullPathName());
+    return it != entries.end() && it->second.ready
+        && it->second.fileSize == file.getSize()
+        && it->second.modified == file.getLastModificationTime().toMilliseconds();
+}
+
+bool AnalysisCache::analyseNow(const juce::File& file, const std::function<bool()>& shouldExit,
+                               const juce::Array<DecodePipeline::Consumer*>& alsoFeed)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    Entry entry;
+    if (reader == nullptr || !analyse(*reader, shouldExit, entry.analysis, alsoFeed))
+    {
+        return false;
+    }
+
+    entry.fileSize = file.getSize();
+    entry.modified = file.getLastModificationTime().toMilliseconds();
+    entry.ready = true;
+
+    const juce::ScopedLock sl(lock);
+    entries[file.getFullPathName()] = entry;
+    dirty = true;
+    ++generation;
+    return true;
+}
+
+void AnalysisCache::run()
+{
+    load(); // Off the message thread so a large cache never delays startup
+    StartupTrace::mark("analysis cache loaded");
+    triggerAsyncUpdate();
+    auto lastSave = juce::Time::getMillisecondCounter();
+
+    while (!threadShouldExit())
+    {
+        juce::File next;
+        {
+            const juce::ScopedLock sl(lock);
+            if (!pending.empty())
+            {
+                next = pending.back();
+                pending.pop_back();
+            }
+        }
+
+        if (next == juce::File())
+        {
+            save(); // Idle: write what the last scan added, once
+            lastSave = juce::Time::getMillisecondCounter();
+            wait(-1);
+            continue;
+        }
+
+        TrackAnalysis analysis;
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(next));
+        auto analysed = reader != nullptr && analyse(*reader, [this] { return threadShouldExit(); }, analysis);
+
+        {
+            const juce::ScopedLock sl(lock);
+            auto it = entries.find(next.getFullPathName());
+            if (it != entries.end())
+            {
+                if (analysed)
+                {
+                    it->second.analysis = analysis;
+                    it->second.fileSize = next.getSize();
+                    it->second.modified = next.getLastModificationTime().toMilliseconds();
+                    it->second.ready = true;
+                    dirty = true;
+                    ++generation;
+                }
+                else
+                {
+                    entries.erase(it); // Unreadable for now; it may be requested again
+                }
+            }
+        }
+
+        if (analysed)
+        {
+            // save() rewrites the whole file, so a long scan writes it now and then, not per track
+            if (juce::Time::getMillisecondCounter() - lastSave >= saveIntervalMs)
+            {
+                save();
+                lastSave = juce::Time::getMillisecondCounter();
+            }
+            triggerAsyncUpdate();
+        }
+    }
+
+    save(); // Whatever was analysed since the last write
+}
+
+void AnalysisCache::handleAsyncUpdate()
+{
+    if (onAnalysisArrived)
+    {
+        onAnalysisArrived();
+    }
+}
+
+// One decode feeds the analyser and anything else that wants the track
+bool AnalysisCache::analyse(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit,
+                            TrackAnalysis& result, const juce::Array<DecodePipeline::Consumer*>& alsoFeed)
+{
+    Analyser analyser;
+    juce::Array<DecodePipeline::Consumer*> consumers { &analyser };
+    consumers.addArray(alsoFeed);
+    return DecodePipeline::decodeNow(reader, consumers, shouldExit) && analyser.getResult(result);
+}
+
+void AnalysisCache::store(const juce::File& file, const TrackAnalysis& analysis)
+{
+    Entry entry;
+    entry.analysis = analysis;
+    entry.fileSize = file.getSize();
+    entry.modified = file.getLastModificationTime().toMilliseconds();
+    entry.ready = true;
+
+    {
+        const juce::ScopedLock sl(lock);
+        entries[file.getFullPathName()] = entry;
+        dirty = true;
+        ++generation;
+    }
+
+    notify(); // The analysis thread saves when it finds nothing queued
+    triggerAsyncUpdate();
+}
+
+AnalysisCache::Analyser::Analyser(AnalysisCache* cacheToFill)
+    : cache(cacheToFill)
+{
+}
+
+void AnalysisCache::Analyser::setFile(const juce::File& fileBeingDecoded)
+{
+    file = fileBeingDecoded;
+    finished = false;
+}
+
+bool AnalysisCache::Analyser::getResult(TrackAnalysis& result) const
+{
+    if (finished)
+    {
+        result = analysis;
+    }
+    return finished;
+}
+
+// A deck sits the decode out when the cache already has this version of the file
+juce::int64 AnalysisCache::Analyser::decodeStarting(const juce::AudioFormatReader& reader)
+{
+    finished = false;
+    sampleRate = reader.sampleRate;
+    length = reader.lengthInSamples;
+    if (sampleRate <= 0.0 || (cache != nullptr && (file == juce::File() || cache->isCurrent(file))))
+    {
+        return 0;
+    }
+
+    beats.reset();
+    beatsWanted = beats.decodeStarting(reader);
+    keysWanted = keys.decodeStarting(reader);
+    windowSamples = juce::jmax(1, static_cast<int>(windowSeconds * sampleRate));
+    levels.clear();
+    levels.reserve(static_cast<size_t>(length / windowSamples + 1));
+    sumLeft = sumRight = 0.0;
+    filled = 0;
+    return length;
+}
+
+// The beat and key analysers take only the opening they asked for; loudness windows run
+// across block boundaries
+void AnalysisCache::Analyser::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples)
+{
+    if (startSample < beatsWanted)
+    {
+        beats.decodedBlock(block, startSample, static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), beatsWanted - startSample)));
+    }
+    if (startSample < keysWanted)
+    {
+        keys.decodedBlock(block, startSample, static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), keysWanted - startSample)));
+    }
+
+    auto* left = block.getReadPointer(0);
+    auto* right = block.getReadPointer(1);
+    for (int i = 0; i < numSamples; ++i)
+    {
+        sumLeft += left[i] * left[i];
+        sumRight += right[i] * right[i];
+        if (++filled == windowSamples)
+        {
+            finishWindow();
+        }
+    }
+}
+
+void AnalysisCache::Analyser::decodeFinished(bool complete)
+{
+    beats.decodeFinished(complete && beatsWanted > 0);
+    keys.decodeFinished(complete && keysWanted > 0);
+    if (filled > 0)
+    {
+        finishWindow(); // The short last window
+    }
+
+    analysis = {};
+    finished = complete && findMixPoints();
+    if (finished && cache != nullptr)
+    {
+        cache->store(file, analysis);
+    }
+    levels = {};
+}
+
+// Mean of the two channels' RMS levels, in dB
+void AnalysisCache::Analyser::finishWindow()
+{
+    auto rms = 0.5 * (std::sqrt(sumLeft / filled) + std::sqrt(sumRight / filled));
+    levels.push_back(juce::Decibels::gainToDecibels(static_cast<float>(rms), -100.0f));
+    sumLeft = sumRight = 0.0;
+    filled = 0;
+}
+
+// Tempo, phase, key and the loudness envelope together: the mix-in is the first loud beat,
+// the mix-out ends the transition on the last loud one
+bool AnalysisCache::Analyser::findMixPoints()
+{
+    auto& result = analysis;
+    result.durationSeconds = static_cast<double>(length) / sampleRate;
+    result.grid = beats.getBeatGrid();
+    result.key = keys.getKey();
+
+    if (levels.empty())
+    {
+        return false;
+    }
+
+    // Loud parts sit within 15 dB of the track's 80th-percentile level
+    auto sorted = levels;
+    std::sort(sorted.begin(), sorted.end());
+    auto threshold = sorted[sorted.size() * 4 / 5] - 15.0f;
+
+    size_t firstLoud = 0;
+    while (firstLoud + 1 < levels.size() && levels[firstLoud] < threshold)
+    {
+        ++firstLoud;
+    }
+    size_t lastLoud = levels.size() - 1;
+    while (lastLoud > firstLoud && levels[lastLoud] < threshold)
+    {
+        --lastLoud;
+    }
+
+    double loudPower = 0.0;
+    int numLoud = 0;
+    for (auto level : levels)
+    {
+        if (level >= threshold)
+        {
+            loudPower += std::pow(10.0, level / 10.0);
+            ++numLoud;
+        }
+    }
+    result.loudnessDb = static_cast<float>(10.0 * std::log10(juce::jmax(1.0e-10, loudPower / juce::jmax(1, numLoud))));
+
+    auto loudStart = static_cast<double>(firstLoud) * windowSeconds;
+    auto loudEnd = juce::jmin(result.durationSeconds, static_cast<double>(lastLoud + 1) * windowSeconds);
+
+    if (result.grid.isValid())
+    {
+        result.mixSeconds = 16.0 * result.grid.getBeatSeconds();
+        result.mixInSeconds = juce::jmax(0.0, result.grid.nearestBeat(loudStart));
+        result.mixOutSeconds = result.grid.nearestBeat(loudEnd - result.mixSeconds);
+    }
+    else
+    {
+        result.mixInSeconds = loudStart;
+        result.mixOutSeconds = loudEnd - result.mixSeconds;
+    }
+
+    // Very short or very quiet tracks still get a usable window
+    result.mixOutSeconds = juce::jlimit(juce::jmin(result.mixInSeconds + 10.0, result.durationSeconds),
+                                        juce::jmax(0.0, result.durationSeconds - 1.0),
+                                        result.mixOutSeconds);
+    return true;
+}
+
+void AnalysisCache::load()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        if (loaded)
+        {
+            return;
+        }
+        loaded = true;
+    }
+
+    auto xml = juce::XmlDocument::parse(cacheFile);
+    if (xml == nullptr || !xml->hasTagName("AnalysisCache"))
+    {
+        return;
+    }
+
+    std::unordered_map<juce::String, Entry> fromDisk;
+    for (auto* element : xml->getChildWithTagNameIterator("Track"))
+    {
+        if (threadShouldExit())
+        {
+            return;
+        }
+
+        Entry entry;
+        entry.fileSize = element->getStringAttribute("size").getLargeIntValue();
+        entry.modified = element->getStringAttribute("modified").getLargeIntValue();
+        entry.analysis.durationSeconds = element->getDoubleAttribute("duration");
+        entry.analysis.grid.bpm = element->getDoubleAttribute("bpm");
+        entry.analysis.grid.firstBeatSeconds = element->getDoubleAttribute("firstBeat");
+        entry.analysis.mixInSeconds = element->getDoubleAttribute("mixIn");
+        entry.analysis.mixOutSeconds = element->getDoubleAttribute("mixOut");
+        entry.analysis.mixSeconds = element->getDoubleAttribute("mix", 10.0);
+        entry.analysis.key = element->getStringAttribute("key");
+        entry.analysis.loudnessDb = static_cast<float>(element->getDoubleAttribute("loudness", -100.0));
+        entry.ready = true;
+        fromDisk[element->getStringAttribute("path")] = entry;
+    }
+
+    const juce::ScopedLock sl(lock);
+    for (auto& [path, entry] : fromDisk)
+    {
+        entries.emplace(path, entry); // Requests made while loading keep their pending entry
+    }
+    ++generation;
+}
+
+void AnalysisCache::save()
+{
+    juce::XmlElement xml("AnalysisCache");
+    {
+        const juce::ScopedLock sl(lock);
+        if (!dirty)
+        {
+            return;
+        }
+
+        for (const auto& [path, entry] : entries)
+        {
+            if (!entry.ready)
+            {
+                continue;
+            }
+
+            auto* element = xml.createNewChildElement("Track");
+            element->setAttribute("path", path);
+            element->setAttribute("size", juce::String(entry.fileSize));
+            element->setAttribute("modified", juce::String(entry.modified));
+            element->setAttribute("duration", entry.analysis.durationSeconds);
+            element->setAttribute("bpm", entry.analysis.grid.bpm);
+            element->setAttribute("firstBeat", entry.analysis.grid.firstBeatSeconds);
+            element->setAttribute("mixIn", entry.analysis.mixInSeconds);
+            element->setAttribute("mixOut", entry.analysis.mixOutSeconds);
+            element->setAttribute("mix", entry.analysis.mixSeconds);
+            element->setAttribute("key", entry.analysis.key);
+            element->setAttribute("loudness", entry.analysis.loudnessDb);
+        }
+        dirty = false;
+    }
+
+    cacheFile.getParentDirectory().createDirectory();
+    if (!xml.writeTo(cacheFile))
+    {
+        DBG("Failed to save analysis cache to " << cacheFile.getFullPathName());
+    }
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    This file defines the AnalysisCache class for a JUCE application,
+    keeping each track's beat grid and mix points on disk between sessions.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "BeatAnalyser.h"
+#include "KeyAnalyser.h"
+
+// TrackAnalysis: What automix needs to know to bring a track in and take it out
+struct TrackAnalysis
+{
+    double durationSeconds = 0.0;
+    BeatGrid grid;
+    double mixInSeconds = 0.0;   // First beat where the music is at full level
+    double mixOutSeconds = 0.0;  // Where the transition to the next track should start
+    double mixSeconds = 10.0;    // Length of the transition: 16 beats, or 10 s without a grid
+    juce::String key;            // Camelot notation, empty if no key stands out
+    float loudnessDb = -100.0f;  // Mean RMS level of the loud parts, dBFS
+};
+
+// AnalysisCache: Beat and loudness analysis for whole tracks, run on a background thread
+// and saved to disk, so a track is only ever analysed once. Like TagCache, requests are
+// served newest first and results are announced on the message thread.
+class AnalysisCache : private juce::Thread,
+                      private juce::AsyncUpdater
+{
+//==============================================================================
+public:
+    explicit AnalysisCache(juce::AudioFormatManager& formatManagerToUse);
+    ~AnalysisCache() override;
+
+    void start(); // Once the format manager has its formats; requests made earlier wait for this
+    bool lookup(const juce::File& file, TrackAnalysis& result) const; // False until analysed
+    void request(const juce::File& file);                             // Queue a file if it isn't known yet
+    int getGeneration() const noexcept { return generation.load(); }  // Goes up whenever analyses are added
+
+    // Headless batch use, from any thread and without start(); call load() first and save() at the end
+    bool isCurrent(const juce::File& file) const; // Analysed, and the file has not changed since
+    bool analyseNow(const juce::File& file, const std::function<bool()>& shouldExit,
+                    const juce::Array<DecodePipeline::Consumer*>& alsoFeed = {}); // e.g. a thumbnail builder
+    void load(); // Once; merges the file on disk under any entries made meanwhile
+    void save(); // Writes only if something changed
+
+    // Blocking analysis of a whole track from a single decode, which also feeds alsoFeed;
+    // shouldExit is polled between blocks
+    static bool analyse(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit,
+                        TrackAnalysis& result, const juce::Array<DecodePipeline::Consumer*>& alsoFeed = {});
+    void store(const juce::File& file, const TrackAnalysis& analysis); // Any thread
+
+    // Analyser: Beat, key and loudness analysis as one decode consumer. analyse() runs it over
+    // its own reader; a deck adds one to its pipeline, so the track it loads is analysed from
+    // the decode it does anyway and the result goes straight into the cache.
+    class Analyser : public DecodePipeline::Consumer
+    {
+    public:
+        explicit Analyser(AnalysisCache* cacheToFill = nullptr); // With a cache, skips files it has
+
+        void setFile(const juce::File& fileBeingDecoded); // With the pipeline stopped
+        bool getResult(TrackAnalysis& result) const;      // False unless the last decode completed
+
+        juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+        void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+        void decodeFinished(bool complete) override;
+
+    private:
+        AnalysisCache* cache;
+        juce::File file;
+        BeatAnalyser beats;
+        KeyAnalyser keys;
+        juce::int64 beatsWanted = 0, keysWanted = 0;
+        std::vector<float> levels; // Loudness envelope, dB per window
+        int windowSamples = 1;
+        int filled = 0;
+        double sumLeft = 0.0, sumRight = 0.0;
+        double sampleRate = 0.0;
+        juce::int64 length = 0;
+        TrackAnalysis analysis;
+        bool finished = false;
+
+        void finishWindow();
+        bool findMixPoints();
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Analyser)
+    };
+
+    std::function<void()> onAnalysisArrived; // Called on the message thread
+
+//==============================================================================
+private:
+    struct Entry
+    {
+        TrackAnalysis analysis;
+        juce::int64 fileSize = 0;
+        juce::int64 modified = 0;  // Milliseconds; a changed file is analysed again
+        bool ready = false;
+    };
+
+    juce::AudioFormatManager& formatManager;
+    juce::File cacheFile;
+
+    juce::CriticalSection lock;
+    std::unordered_map<juce::String, Entry> entries; // By full path
+    std::deque<juce::File> pending;
+    bool dirty = false;
+    bool loaded = false;
+    std::atomic<int> generation{0};
+
+    static constexpr juce::uint32 saveIntervalMs = 30000; // During a scan; also saved when idle and on exit
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisCache)
+};
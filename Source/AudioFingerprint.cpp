@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the AudioFingerprint struct for a JUCE application,
+    reducing the start of a track to band-energy difference bits.
+
+  ==============================================================================
+*/
+
+#include "AudioFingerprint.h"
+
+namespace
+{
+    constexpr int fftOrder = 11;
+    constexpr int frameSize = 1 << fftOrder;    // 0.37 s at the analysis rate
+    constexpr int hopSize = 256;                // 46 ms
+    constexpr int numBands = 33;                // 33 bands give 32 difference bits
+    constexpr double lowestHz = 300.0;
+    constexpr double highestHz = 2000.0;
+    constexpr float silenceThreshold = 0.003f;  // About -50 dBFS; the fingerprint starts at the music
+}
+
+float AudioFingerprint::bitErrorRate(const AudioFingerprint& other, int offset) const noexcept
+{
+    auto first = juce::jmax(0, offset);
+    auto last = juce::jmin(static_cast<int>(frames.size()), static_cast<int>(other.frames.size()) + offset);
+    if (last - first < minFrames)
+    {
+        return 1.0f;
+    }
+
+    int errors = 0;
+    for (int i = first; i < last; ++i)
+    {
+        errors += juce::countNumberOfBits(frames[static_cast<size_t>(i)] ^ other.frames[static_cast<size_t>(i - offset)]);
+    }
+    return static_cast<float>(errors) / static_cast<float>(32 * (last - first));
+}
+
+bool AudioFingerprint::compute(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit,
+                               AudioFingerprint& result)
+{
+    result.frames.clear();
+    if (reader.sampleRate < 2.0 * highestHz * 1.1)
+    {
+        return false;
+    }
+
+    // Low-pass, then keep every nth sample: every source rate ends up near the same analysis rate
+    auto decimation = juce::jmax(1, juce::roundToInt(reader.sampleRate / analysisRate));
+    auto rate = reader.sampleRate / decimation;
+    juce::IIRFilter lowPass[2];
+    for (auto& filter : lowPass)
+    {
+        filter.setCoefficients(juce::IIRCoefficients::makeLowPass(reader.sampleRate, highestHz * 1.15));
+    }
+
+    const size_t needed = frameSize + static_cast<size_t>(maxFrames) * hopSize; // One extra frame for the first difference
+    std::vector<float> samples;
+    samples.reserve(needed);
+
+    juce::AudioBuffer<float> chunk(2, 16384);
+    juce::HeapBlock<float> mono(chunk.getNumSamples());
+    int phase = 0;
+
+    for (juce::int64 start = 0; start < reader.lengthInSamples && samples.size() < needed; start += chunk.getNumSamples())
+    {
+        if (shouldExit())
+        {
+            return false;
+        }
+
+        auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(chunk.getNumSamples()), reader.lengthInSamples - start));
+        reader.read(&chunk, 0, numSamples, start, true, true);
+        auto* left = chunk.getReadPointer(0);
+        auto* right = chunk.getReadPointer(1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            mono[i] = 0.5f * (left[i] + right[i]);
+        }
+        lowPass[0].processSamples(mono, numSamples);
+        lowPass[1].processSamples(mono, numSamples);
+
+        for (int i = 0; i < numSamples && samples.size() < needed; ++i)
+        {
+            if (samples.empty() && std::abs(mono[i]) < silenceThreshold)
+            {
+                continue;
+            }
+
+            if (phase == 0)
+            {
+                samples.push_back(mono[i]);
+            }
+            phase = (phase + 1) % decimation;
+        }
+    }
+
+    auto numEnergyFrames = samples.size() < frameSize ? 0 : static_cast<int>((samples.size() - frameSize) / hopSize) + 1;
+    if (numEnergyFrames < minFrames + 1)
+    {
+        return false;
+    }
+
+    // Band edges in FFT bins, log spaced
+    int edges[numBands + 1];
+    for (int band = 0; band <= numBands; ++band)
+    {
+        auto hz = lowestHz * std::pow(highestHz / lowestHz, static_cast<double>(band) / numBands);
+        edges[band] = juce::roundToInt(hz * frameSize / rate);
+    }
+
+    juce::dsp::FFT fft(fftOrder);
+    juce::dsp::WindowingFunction<float> window(frameSize, juce::dsp::WindowingFunction<float>::hann, false);
+    std::vector<float> buffer(2 * frameSize);
+    float previous[numBands] = {};
+    result.frames.reserve(static_cast<size_t>(numEnergyFrames - 1));
+
+    for (int frame = 0; frame < numEnergyFrames; ++frame)
+    {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+        std::copy_n(samples.begin() + static_cast<std::ptrdiff_t>(frame) * hopSize, frameSize, buffer.begin());
+        window.multiplyWithWindowingTable(buffer.data(), frameSize);
+        fft.performFrequencyOnlyForwardTransform(buffer.data(), true);
+
+        float energy[numBands];
+        for (int band = 0; band < numBands; ++band)
+        {
+            energy[band] = 0.0f;
+            for (int bin = edges[band]; bin < juce::jmax(edges[band] + 1, edges[band + 1]); ++bin)
+            {
+                energy[band] += buffer[static_cast<size_t>(bin)] * buffer[static_cast<size_t>(bin)];
+            }
+        }
+
+        if (frame > 0)
+        {
+            juce::uint32 bits = 0;
+            for (int m = 0; m < numBands - 1; ++m)
+            {
+                auto change = (energy[m] - energy[m + 1]) - (previous[m] - previous[m + 1]);
+                if (change > 0.0f)
+                {
+                    bits |= 1u << m;
+                }
+            }
+            result.frames.push_back(bits);
+        }
+        std::copy_n(energy, numBands, previous);
+    }
+
+    return result.isValid();
+}
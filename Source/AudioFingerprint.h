@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    This file defines the AudioFingerprint struct for a JUCE application,
+    a compact spectral signature that survives re-encoding at other formats and bitrates.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// AudioFingerprint: One 32-bit sub-fingerprint per 46 ms frame over the first ~12 s of music.
+// Bit m is set when the energy difference between bands m and m+1 (300 Hz - 2 kHz, log spaced)
+// grew since the previous frame, so level, EQ and codec noise barely flip bits. Leading silence
+// is skipped, which lines up copies with different encoder delays.
+struct AudioFingerprint
+{
+    std::vector<juce::uint32> frames;
+
+    bool isValid() const noexcept { return frames.size() >= static_cast<size_t>(minFrames); }
+
+    // Fraction of differing bits with frames[i] aligned to other.frames[i - offset]; 1 if they barely overlap
+    float bitErrorRate(const AudioFingerprint& other, int offset) const noexcept;
+
+    // Blocking; reads only as much of the track as the fingerprint covers
+    static bool compute(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit,
+                        AudioFingerprint& result);
+
+    static constexpr int maxFrames = 256;
+    static constexpr int minFrames = 64;      // Also the least overlap bitErrorRate will judge
+    static constexpr double analysisRate = 5512.5;
+};
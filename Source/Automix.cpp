@@ -0,0 +1,385 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the Automix class for a JUCE application,
+    cueing the next playlist entry early and timing each crossfade from its analysis.
+
+  ==============================================================================
+*/
+
+#include "Automix.h"
+#include "DeckGUI.h"
+#include "Mixer.h"
+
+Automix::Automix(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToDrive, AnalysisCache& cacheToUse)
+    : Automix(deckA, deckB, mixerToDrive, cacheToUse, getPlaylistFile(), true)
+{
+}
+
+Automix::Automix(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToDrive, AnalysisCache& cacheToUse,
+                 const juce::File& playlistToPlay, bool driveFromTimer)
+    : decks{ &deckA, &deckB }, mixer(mixerToDrive), analysisCache(cacheToUse), interactive(driveFromTimer)
+{
+    playlistFile = playlistToPlay;
+    loadPlaylist();
+}
+
+Automix::~Automix()
+{
+    stopTimer();
+    if (interactive)
+    {
+        savePlaylist();
+    }
+}
+
+void Automix::addTrack(const juce::File& file)
+{
+    playlist.add(file);
+    analysisCache.request(file); // Analysed long before its turn comes
+    if (interactive)
+    {
+        savePlaylist();
+    }
+
+    if (enabled && cuedIndex < 0 && !transitioning)
+    {
+        cueNextTrack();
+    }
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+// Keep the live and cued positions pointing at the same tracks after the removal. A removed
+// live track plays on to its mix-out point; the entry that followed it is still next.
+void Automix::removeTrack(int index)
+{
+    if (!juce::isPositiveAndBelow(index, playlist.size()))
+    {
+        return;
+    }
+
+    playlist.remove(index);
+    if (interactive)
+    {
+        savePlaylist();
+    }
+
+    if (index == currentIndex && !currentRemoved)
+    {
+        currentRemoved = true; // currentIndex now names the entry after it
+    }
+    else if (index < currentIndex)
+    {
+        --currentIndex;
+    }
+
+    if (index == cuedIndex)
+    {
+        if (transitioning)
+        {
+            abortTransition();
+        }
+        else if (enabled)
+        {
+            cueNextTrack();
+        }
+        else
+        {
+            cuedIndex = -1;
+        }
+    }
+    else if (index < cuedIndex)
+    {
+        --cuedIndex;
+    }
+
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+// Take over whichever deck is playing (the one the crossfader favours if both are), or start
+// the playlist from the top. With both playing, the next track is cued once the other stops.
+void Automix::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == enabled || (shouldBeEnabled && playlist.isEmpty()))
+    {
+        return;
+    }
+
+    enabled = shouldBeEnabled;
+
+    if (enabled)
+    {
+        auto playingA = decks[0]->isPlaying();
+        auto playingB = decks[1]->isPlaying();
+        if (playingA || playingB)
+        {
+            liveDeck = playingA && playingB ? (mixer.getCrossfader() <= 0.5f ? 0 : 1) : (playingA ? 0 : 1);
+            cueNextTrack();
+        }
+        else
+        {
+            startFirstTrack();
+        }
+        if (interactive)
+        {
+            startTimerHz(20);
+        }
+    }
+    else
+    {
+        stopTimer();
+        transitioning = false; // The faders stay where they are
+    }
+
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+juce::String Automix::getStatus() const
+{
+    if (!enabled)
+    {
+        return "Automix off";
+    }
+
+    if (transitioning && cuedIndex >= 0)
+    {
+        return "Mixing into " + playlist[cuedIndex].getFileNameWithoutExtension();
+    }
+
+    if (cuedIndex < 0)
+    {
+        return getNextIndex() < playlist.size() ? juce::String("Waiting for deck ") + juce::String(2 - liveDeck) + " to stop"
+                                                : juce::String("Last track");
+    }
+
+    auto remaining = getAnalysis(decks[liveDeck]->getLoadedFile()).mixOutSeconds - decks[liveDeck]->getPosition();
+    auto seconds = juce::jmax(0, static_cast<int>(remaining));
+    return juce::String::formatted("Next in %d:%02d: ", seconds / 60, seconds % 60)
+           + playlist[cuedIndex].getFileNameWithoutExtension();
+}
+
+bool Automix::hasFinished() const
+{
+    auto& live = *decks[liveDeck];
+    return enabled && !transitioning && cuedIndex < 0 && getNextIndex() >= playlist.size()
+           && (!live.isPlaying() || live.getPosition() >= live.getLengthInSeconds() - 0.05);
+}
+
+void Automix::timerCallback()
+{
+    advance(juce::Time::getMillisecondCounterHiRes() / 1000.0);
+}
+
+void Automix::advance(double nowSeconds)
+{
+    now = nowSeconds;
+    if (!enabled)
+    {
+        return;
+    }
+
+    auto& live = *decks[liveDeck];
+
+    if (transitioning)
+    {
+        auto elapsed = now - transitionStart;
+        auto fraction = static_cast<float>(juce::jlimit(0.0, 1.0, elapsed / transitionSeconds));
+        mixer.setCrossfader(transitionFrom + (faderFor(1 - liveDeck) - transitionFrom) * fraction);
+
+        if (fraction >= 1.0f)
+        {
+            finishTransition();
+        }
+        return;
+    }
+
+    if (cuedIndex < 0)
+    {
+        if (getNextIndex() < playlist.size() && !decks[1 - liveDeck]->isPlaying())
+        {
+            cueNextTrack(); // The other deck has stopped since
+        }
+        return; // Otherwise nothing left to mix into yet
+    }
+
+    auto position = live.getPosition();
+    auto analysis = getAnalysis(live.getLoadedFile());
+
+    if (!live.isPlaying())
+    {
+        // The track ran out before its mix point (or was never analysed): cut straight over
+        if (position >= live.getLengthInSeconds() - 0.5)
+        {
+            startTransition(0.0);
+        }
+        return; // Otherwise the DJ has paused; wait
+    }
+
+    if (position >= analysis.mixOutSeconds)
+    {
+        startTransition(position - analysis.mixOutSeconds);
+    }
+}
+
+void Automix::startFirstTrack()
+{
+    currentIndex = getNextIndex();
+    currentRemoved = false;
+    if (currentIndex >= playlist.size())
+    {
+        currentIndex = 0; // Played through: start over
+    }
+
+    liveDeck = 0;
+    decks[0]->loadFile(playlist[currentIndex]);
+    mixer.setCrossfader(faderFor(0));
+    decks[0]->setPlaying(true);
+    cueNextTrack();
+}
+
+// Loading now starts the pre-decode, waveform and beat analysis for the idle deck, so
+// by the mix-out point the track is in memory and the transition never waits on disk.
+// A deck that is playing is never loaded: the DJ may still be using it.
+void Automix::cueNextTrack()
+{
+    cuedIndex = -1;
+    auto next = getNextIndex();
+    auto& idle = *decks[1 - liveDeck];
+    if (next >= playlist.size() || idle.isPlaying())
+    {
+        return;
+    }
+
+    idle.loadFile(playlist[next]);
+    idle.setTransportPosition(getAnalysis(playlist[next]).mixInSeconds);
+    cuedIndex = next;
+
+    if (next + 1 < playlist.size())
+    {
+        analysisCache.request(playlist[next + 1]);
+    }
+}
+
+// Start the incoming track as far past its mix-in point as the timer fired late past the
+// mix-out point. Both tracks play at their own tempo; nothing matches or aligns their beats.
+void Automix::startTransition(double lateSeconds)
+{
+    auto& incoming = *decks[1 - liveDeck];
+    auto& live = *decks[liveDeck];
+
+    incoming.setTransportPosition(getAnalysis(incoming.getLoadedFile()).mixInSeconds + lateSeconds);
+    incoming.setPlaying(true);
+
+    auto remaining = live.isPlaying() ? live.getLengthInSeconds() - live.getPosition() : 0.0;
+    transitionSeconds = juce::jlimit(0.05, juce::jmax(0.05, remaining), getAnalysis(live.getLoadedFile()).mixSeconds);
+    transitionFrom = mixer.getCrossfader();
+    transitionStart = now;
+    transitioning = true;
+
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+void Automix::finishTransition()
+{
+    auto incomingDeck = 1 - liveDeck;
+    mixer.setCrossfader(faderFor(incomingDeck));
+    decks[liveDeck]->setPlaying(false);
+
+    liveDeck = incomingDeck;
+    currentIndex = cuedIndex;
+    currentRemoved = false;
+    transitioning = false;
+    cueNextTrack();
+
+    if (onChange)
+    {
+        onChange();
+    }
+}
+
+// The incoming deck stops and the crossfader returns to the live deck. The entry after the
+// removed one is cued instead, and mixed in straight away if the mix-out point has passed.
+void Automix::abortTransition()
+{
+    transitioning = false;
+    decks[1 - liveDeck]->setPlaying(false);
+    mixer.setCrossfader(faderFor(liveDeck));
+    cueNextTrack();
+}
+
+// By file rather than playlist entry, so a live track that was removed keeps its mix-out
+// point. Without an analysis yet, mix out over the last ten seconds.
+TrackAnalysis Automix::getAnalysis(const juce::File& file) const
+{
+    TrackAnalysis analysis;
+    if (file != juce::File() && !analysisCache.lookup(file, analysis))
+    {
+        analysisCache.request(file);
+
+        auto* deck = decks[0]->getLoadedFile() == file ? decks[0] : decks[1];
+        analysis.durationSeconds = deck->getLoadedFile() == file ? deck->getLengthInSeconds() : 0.0;
+        analysis.mixOutSeconds = juce::jmax(0.0, analysis.durationSeconds - analysis.mixSeconds);
+    }
+    return analysis;
+}
+
+juce::File Automix::getPlaylistFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile("dj_playlist.xml");
+}
+
+juce::Array<juce::File> Automix::readPlaylist(const juce::File& xmlFile)
+{
+    juce::Array<juce::File> tracks;
+    auto xml = juce::XmlDocument::parse(xmlFile);
+    if (xml == nullptr || !xml->hasTagName("Playlist"))
+    {
+        return tracks;
+    }
+
+    for (auto* element : xml->getChildWithTagNameIterator("Track"))
+    {
+        juce::File file(element->getStringAttribute("path"));
+        if (file.existsAsFile())
+        {
+            tracks.add(file);
+        }
+    }
+    return tracks;
+}
+
+void Automix::loadPlaylist()
+{
+    playlist = readPlaylist(playlistFile);
+    for (const auto& file : playlist)
+    {
+        analysisCache.request(file);
+    }
+}
+
+void Automix::savePlaylist()
+{
+    juce::XmlElement xml("Playlist");
+    for (const auto& track : playlist)
+    {
+        xml.createNewChildElement("Track")->setAttribute("path", track.getFullPathName());
+    }
+
+    if (!xml.writeTo(playlistFile))
+    {
+        DBG("Failed to save playlist to " << playlistFile.getFullPathName());
+    }
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    This file defines the Automix class for a JUCE application,
+    playing an ordered playlist by crossfading between the two decks.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "AnalysisCache.h"
+
+class DeckGUI;
+class Mixer;
+
+// Automix: Plays the playlist unattended. As soon as a transition finishes, the next track
+// is loaded into the idle deck and cued at its mix-in point, so it has been pre-decoded
+// long before it is needed. When the playing track reaches its mix-out point, the idle
+// deck starts and the crossfader sweeps across over the analysed transition length.
+// The same state machine renders the playlist headless, driven by the rendered time.
+class Automix : private juce::Timer
+{
+//==============================================================================
+public:
+    Automix(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToDrive, AnalysisCache& cacheToUse);
+    // Headless when driveFromTimer is false: only advance() moves it on, and the playlist
+    // file is read but never written
+    Automix(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToDrive, AnalysisCache& cacheToUse,
+            const juce::File& playlistToPlay, bool driveFromTimer);
+    ~Automix() override;
+
+    // Playlist, GUI thread
+    int getNumTracks() const noexcept { return playlist.size(); }
+    juce::File getTrack(int index) const { return playlist[index]; }
+    void addTrack(const juce::File& file);
+    void removeTrack(int index);
+    int getCurrentIndex() const noexcept { return currentRemoved ? -1 : currentIndex; } // -1 before the first track, or once removed
+    int getCuedIndex() const noexcept { return cuedIndex; }  // Loaded into the idle deck, or -1
+    int getNextIndex() const noexcept { return currentRemoved ? currentIndex : currentIndex + 1; } // Plays after the live track
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled; }
+    bool isTransitioning() const noexcept { return transitioning; }
+    bool hasFinished() const; // The last track has played to its end
+    juce::String getStatus() const;
+
+    void advance(double nowSeconds); // Called by the timer with wall time, or per block headless with rendered time
+
+    std::function<void()> onChange; // Playlist or position in it changed
+
+    static juce::File getPlaylistFile();
+    static juce::Array<juce::File> readPlaylist(const juce::File& xmlFile); // Existing files only
+
+//==============================================================================
+private:
+    DeckGUI* decks[2];
+    Mixer& mixer;
+    AnalysisCache& analysisCache;
+
+    juce::Array<juce::File> playlist;
+    juce::File playlistFile;
+    bool enabled = false;
+    const bool interactive; // Timer-driven and saving the playlist; false when rendering headless
+
+    int currentIndex = -1;  // Playlist entry on the live deck
+    bool currentRemoved = false; // The live track was taken off the playlist; currentIndex is the entry that followed it
+    int liveDeck = 0;
+    int cuedIndex = -1;     // Playlist entry loaded into the idle deck, or -1
+    bool transitioning = false;
+    double now = 0.0;       // Seconds, as last passed to advance()
+    double transitionStart = 0.0;
+    double transitionSeconds = 0.0;
+    float transitionFrom = 0.0f;
+
+    void timerCallback() override;
+
+    void startFirstTrack();
+    void cueNextTrack();       // Load the next entry into the idle deck, unless that deck is playing
+    void abortTransition();    // The incoming track was removed: back to the live deck alone
+    void startTransition(double lateSeconds);
+    void finishTransition();
+    TrackAnalysis getAnalysis(const juce::File& file) const; // Cached analysis, or a plain fallback
+    static float faderFor(int deck) { return deck == 0 ? 0.0f : 1.0f; }
+
+    void loadPlaylist();
+    void savePlaylist();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Automix)
+};
@@ -0,0 +1,380 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the BatchProcessor class for a JUCE application,
+    running library import, analysis, cache building and mix rendering from the command line.
+
+  ==============================================================================
+*/
+
+#include "BatchProcessor.h"
+#include "AnalysisCache.h"
+#include "Automix.h"
+#include "DuplicateFinder.h"
+#include "MusicLibrary.h"
+#include "OfflineRenderer.h"
+#include "ThumbnailDiskCache.h"
+#include <iostream>
+
+namespace
+{
+    juce::String formatRate(int done, double audioSeconds, double elapsed)
+    {
+        elapsed = juce::jmax(elapsed, 1.0e-3);
+        return juce::String::formatted("%7.1f tracks/s  %7.0fx real time", done / elapsed, audioSeconds / elapsed);
+    }
+}
+
+int BatchProcessor::runCommandLine(const juce::String& commandLine)
+{
+    auto tokens = juce::StringArray::fromTokens(commandLine, true);
+    tokens.trim();
+    tokens.removeEmptyStrings();
+
+    Options options;
+    options.playlistFile = Automix::getPlaylistFile();
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 0; i < tokens.size(); ++i)
+    {
+        auto token = tokens[i].unquoted();
+        auto value = tokens[i + 1].unquoted();
+
+        if (token == "--batch")
+        {
+            continue;
+        }
+        else if (token == "--analyse")
+        {
+            options.analyse = true;
+        }
+        else if (token == "--thumbnails")
+        {
+            options.thumbnails = true;
+        }
+        else if (token == "--fingerprint")
+        {
+            options.fingerprint = true;
+        }
+        else if (token == "--all")
+        {
+            options.analyse = options.thumbnails = options.fingerprint = true;
+        }
+        else if (token == "--force")
+        {
+            options.force = true;
+        }
+        else if (token == "--import")
+        {
+            options.importFolders.add(cwd.getChildFile(value));
+            ++i;
+        }
+        else if (token == "--threads")
+        {
+            options.numThreads = juce::jmax(0, value.getIntValue());
+            ++i;
+        }
+        else if (token == "--render-mix")
+        {
+            options.mixFile = cwd.getChildFile(value);
+            ++i;
+        }
+        else if (token == "--playlist")
+        {
+            options.playlistFile = cwd.getChildFile(value);
+            ++i;
+        }
+        else if (token == "--max-minutes")
+        {
+            options.maxMixSeconds = 60.0 * value.getDoubleValue();
+            ++i;
+        }
+        else
+        {
+            std::cout << "Unknown option " << token << "\n";
+            return 1;
+        }
+    }
+
+    if (options.importFolders.isEmpty() && !options.analyse && !options.thumbnails && !options.fingerprint
+        && options.mixFile == juce::File())
+    {
+        std::cout << "usage: --batch [--import folder]... [--analyse] [--thumbnails] [--fingerprint] [--all] [--force]\n"
+                     "               [--threads N] [--render-mix out.wav [--playlist file.xml] [--max-minutes N]]\n";
+        return 1;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::Array<juce::File> library;
+    MusicLibrary::readTrackList(MusicLibrary::getLibraryFile(), library, [] { return false; });
+    std::cout << "Library: " << library.size() << " tracks in " << MusicLibrary::getLibraryFile().getFullPathName() << "\n";
+
+    if (!options.importFolders.isEmpty())
+    {
+        auto added = importFolders(options, formatManager, library);
+        if (added < 0)
+        {
+            return 1;
+        }
+    }
+
+    AnalysisCache analysisCache(formatManager); // Never started: the batch calls it directly
+    analysisCache.load();
+
+    if (options.analyse || options.thumbnails)
+    {
+        analyseTracks(options, library, formatManager, analysisCache);
+    }
+
+    if (options.fingerprint)
+    {
+        fingerprintTracks(options, library, formatManager);
+    }
+
+    if (options.mixFile != juce::File() && !renderMix(options, analysisCache))
+    {
+        return 1;
+    }
+
+    std::cout << "Caches are in " << ThumbnailDiskCache::getDirectory().getParentDirectory().getFullPathName() << "\n" << std::flush;
+    return 0;
+}
+
+// Add every readable audio file under the folders, skipping paths already in the library
+int BatchProcessor::importFolders(const Options& options, juce::AudioFormatManager& formatManager,
+                                  juce::Array<juce::File>& library)
+{
+    std::unordered_set<juce::String> known;
+    for (const auto& track : library)
+    {
+        known.insert(track.getFullPathName());
+    }
+
+    auto wildcard = formatManager.getWildcardForAllFormats();
+    int added = 0;
+
+    for (const auto& folder : options.importFolders)
+    {
+        if (!folder.isDirectory())
+        {
+            std::cout << "Not a folder: " << folder.getFullPathName() << "\n";
+            continue;
+        }
+
+        auto startMs = juce::Time::getMillisecondCounterHiRes();
+        auto found = folder.findChildFiles(juce::File::findFiles, true, wildcard);
+        for (const auto& file : found)
+        {
+            if (known.insert(file.getFullPathName()).second)
+            {
+                library.add(file);
+                ++added;
+            }
+        }
+
+        std::cout << "Imported " << folder.getFullPathName() << ": " << found.size() << " audio files in "
+                  << juce::String((juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0, 1) << " s\n";
+    }
+
+    if (!MusicLibrary::writeTrackList(MusicLibrary::getLibraryFile(), library))
+    {
+        std::cout << "Cannot write " << MusicLibrary::getLibraryFile().getFullPathName() << "\n";
+        return -1;
+    }
+
+    std::cout << "Added " << added << " tracks; library now has " << library.size() << "\n" << std::flush;
+    return added;
+}
+
+// BPM, key, loudness and mix points into the analysis cache, waveform overviews into the thumbnail cache
+void BatchProcessor::analyseTracks(const Options& options, const juce::Array<juce::File>& tracks,
+                                   juce::AudioFormatManager& formatManager, AnalysisCache& analysisCache)
+{
+    auto numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+    juce::ThreadPool pool(juce::ThreadPoolOptions{}
+                              .withThreadName("Batch analyser")
+                              .withNumberOfThreads(numThreads));
+
+    std::atomic<int> done{0};
+    std::atomic<int> failed{0};
+    std::atomic<juce::int64> audioMilliseconds{0};
+    int queued = 0;
+
+    for (const auto& track : tracks)
+    {
+        auto needsAnalysis = options.analyse && (options.force || !analysisCache.isCurrent(track));
+        auto needsThumbnail = options.thumbnails && (options.force || !ThumbnailDiskCache::isCached(track));
+        if (!needsAnalysis && !needsThumbnail)
+        {
+            continue;
+        }
+
+        ++queued;
+        pool.addJob([&, track, needsAnalysis, needsThumbnail]
+        {
+            auto neverExit = [] { return false; };
+            auto ok = true;
+
+            // One decode feeds the beat, key and loudness analysis and the thumbnail
+            if (needsAnalysis)
+            {
+                ThumbnailDiskCache::Builder thumbnail(track, formatManager);
+                juce::Array<DecodePipeline::Consumer*> alsoFeed;
+                if (needsThumbnail)
+                {
+                    alsoFeed.add(&thumbnail);
+                }
+                ok = analysisCache.analyseNow(track, neverExit, alsoFeed) && (!needsThumbnail || thumbnail.wasWritten());
+            }
+            else
+            {
+                ok = ThumbnailDiskCache::build(track, formatManager, neverExit);
+            }
+
+            TrackAnalysis analysis;
+            if (analysisCache.lookup(track, analysis))
+            {
+                audioMilliseconds += static_cast<juce::int64>(analysis.durationSeconds * 1000.0);
+            }
+            if (!ok)
+            {
+                ++failed;
+            }
+            ++done;
+        });
+    }
+
+    std::cout << "Analysing " << queued << " of " << tracks.size() << " tracks on " << numThreads << " threads ("
+              << (tracks.size() - queued) << " already current)\n" << std::flush;
+
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+    auto lastSaveMs = startMs;
+
+    while (done.load() < queued)
+    {
+        juce::Thread::sleep(1000);
+        auto nowMs = juce::Time::getMillisecondCounterHiRes();
+        std::cout << juce::String::formatted("  %d/%d  ", done.load(), queued)
+                  << formatRate(done.load(), static_cast<double>(audioMilliseconds.load()) / 1000.0, (nowMs - startMs) / 1000.0)
+                  << "  " << failed.load() << " failed\n" << std::flush;
+
+        if (nowMs - lastSaveMs > 60000.0)
+        {
+            analysisCache.save(); // An interrupted overnight run keeps what it has done
+            lastSaveMs = nowMs;
+        }
+    }
+
+    analysisCache.save();
+    std::cout << "Analysed " << queued << " tracks in "
+              << juce::String((juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0, 1) << " s, "
+              << failed.load() << " failed\n" << std::flush;
+}
+
+void BatchProcessor::fingerprintTracks(const Options& options, const juce::Array<juce::File>& tracks,
+                                       juce::AudioFormatManager& formatManager)
+{
+    if (options.force)
+    {
+        DuplicateFinder::getCacheFile().deleteFile();
+    }
+
+    DuplicateFinder finder(formatManager);
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+    finder.scan(tracks);
+
+    while (finder.isScanning())
+    {
+        juce::Thread::sleep(1000);
+        std::cout << "  fingerprints " << juce::roundToInt(finder.getProgress() * 100.0f) << "%\n" << std::flush;
+    }
+
+    auto groups = finder.getGroups();
+    size_t copies = 0;
+    for (const auto& group : groups)
+    {
+        copies += static_cast<size_t>(group.size()) - 1;
+    }
+
+    std::cout << "Fingerprinted " << tracks.size() << " tracks in "
+              << juce::String((juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0, 1) << " s: "
+              << static_cast<int>(groups.size()) << " duplicate groups, " << static_cast<int>(copies) << " extra copies\n" << std::flush;
+}
+
+// The playlist played through by Automix itself, driven by the rendered time instead of its
+// timer, so the file has exactly the transitions the app would play
+bool BatchProcessor::renderMix(const Options& options, AnalysisCache& analysisCache)
+{
+    auto playlist = Automix::readPlaylist(options.playlistFile);
+    if (playlist.isEmpty())
+    {
+        std::cout << "No tracks in playlist " << options.playlistFile.getFullPathName() << "\n";
+        return false;
+    }
+
+    for (const auto& track : playlist) // Automix finds every mix point in the cache
+    {
+        TrackAnalysis analysis;
+        if (!analysisCache.lookup(track, analysis)
+            && !(analysisCache.analyseNow(track, [] { return false; }) && analysisCache.lookup(track, analysis)))
+        {
+            std::cout << "Cannot analyse " << track.getFullPathName() << "\n";
+            return false;
+        }
+    }
+    analysisCache.save();
+
+    constexpr double sampleRate = 44100.0;
+    constexpr int blockSize = 4096;
+
+    options.mixFile.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(options.mixFile);
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(stream->failedToOpen() ? nullptr
+                                                    : wav.createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+    if (writer == nullptr)
+    {
+        std::cout << "Cannot write " << options.mixFile.getFullPathName() << "\n";
+        return false;
+    }
+    stream.release(); // Now owned by the writer
+
+    OfflineRenderer renderer;
+    renderer.prepare(sampleRate, 512);
+
+    double rendered = 0.0;
+    Automix automix(renderer.getDeck(0), renderer.getDeck(1), renderer.getMixer(), analysisCache,
+                    options.playlistFile, false);
+    automix.onChange = [&automix, &rendered]
+    {
+        if (automix.isTransitioning())
+        {
+            std::cout << "  " << juce::String(rendered / 60.0, 2) << " min: mixing into "
+                      << automix.getTrack(automix.getCuedIndex()).getFileName() << "\n" << std::flush;
+        }
+    };
+    automix.advance(0.0);
+    automix.setEnabled(true);
+
+    juce::AudioBuffer<float> block(2, blockSize);
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+    while (rendered < options.maxMixSeconds && !automix.hasFinished())
+    {
+        // Advanced before every device-sized block, as often as the live timer fires or more
+        renderer.render(block, nullptr, [&automix, &rendered](double blockStart, double)
+                        {
+                            automix.advance(rendered + blockStart);
+                        });
+        writer->writeFromAudioSampleBuffer(block, 0, blockSize);
+        rendered += blockSize / sampleRate;
+    }
+
+    auto elapsed = (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    std::cout << "Rendered " << playlist.size() << " tracks, " << juce::String(rendered / 60.0, 1) << " min in "
+              << juce::String(elapsed, 1) << " s (" << juce::String(rendered / juce::jmax(elapsed, 1.0e-3), 1)
+              << "x real time) to " << options.mixFile.getFullPathName() << "\n" << std::flush;
+    return true;
+}
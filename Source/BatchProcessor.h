@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    This file defines the BatchProcessor class for a JUCE application,
+    preparing a library headless so its caches can be copied to other machines.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class AnalysisCache;
+
+// BatchProcessor: Imports folders into the saved library, then analyses every track on a
+// pool with one worker per core, writing the same caches the app reads at startup
+// (analysis, waveform thumbnails, fingerprints). Optionally renders the saved playlist as
+// a continuous mix. Nothing opens a window or an audio device; progress goes to stdout.
+class BatchProcessor
+{
+//==============================================================================
+public:
+    // --batch [--import folder]... [--analyse] [--thumbnails] [--fingerprint] [--all] [--force]
+    //         [--threads N] [--render-mix out.wav [--playlist file.xml] [--max-minutes N]]
+    // Returns the process exit code.
+    static int runCommandLine(const juce::String& commandLine);
+
+//==============================================================================
+private:
+    struct Options
+    {
+        juce::Array<juce::File> importFolders;
+        bool analyse = false;
+        bool thumbnails = false;
+        bool fingerprint = false;
+        bool force = false;  // Redo work the caches say is current
+        int numThreads = 0;  // 0: one per core
+        juce::File mixFile;
+        juce::File playlistFile;
+        double maxMixSeconds = 3600.0;
+    };
+
+    static int importFolders(const Options& options, juce::AudioFormatManager& formatManager,
+                             juce::Array<juce::File>& library);
+    static void analyseTracks(const Options& options, const juce::Array<juce::File>& tracks,
+                              juce::AudioFormatManager& formatManager, AnalysisCache& analysisCache);
+    static void fingerprintTracks(const Options& options, const juce::Array<juce::File>& tracks,
+                                  juce::AudioFormatManager& formatManager);
+    static bool renderMix(const Options& options, AnalysisCache& analysisCache);
+};
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the BeatAnalyser class for a JUCE application,
+    turning decoded audio into an onset envelope and fitting a constant beat grid to it.
+
+  ==============================================================================
+*/
+
+#include "BeatAnalyser.h"
+
+namespace
+{
+    constexpr int hopSize = 512;            // Samples per onset frame at the analysis rate
+    constexpr double minimumBpm = 70.0;
+    constexpr double maximumBpm = 180.0;
+    constexpr double preferredBpm = 120.0;  // Centre of the octave-error weighting
+    constexpr double analysedSeconds = 120.0; // Enough for a steady tempo, on a deck or in the library
+}
+
+double BeatGrid::nearestBeat(double seconds) const
+{
+    if (!isValid())
+    {
+        return seconds;
+    }
+
+    auto beats = std::round((seconds - firstBeatSeconds) / getBeatSeconds());
+    return juce::jmax(0.0, firstBeatSeconds + beats * getBeatSeconds());
+}
+
+void BeatAnalyser::reset()
+{
+    bpm.store(0.0);
+    firstBeat.store(0.0);
+}
+
+BeatGrid BeatAnalyser::getBeatGrid() const noexcept
+{
+    BeatGrid grid;
+    grid.firstBeatSeconds = firstBeat.load();
+    grid.bpm = bpm.load();
+    return grid;
+}
+
+juce::int64 BeatAnalyser::decodeStarting(const juce::AudioFormatReader& reader)
+{
+    auto length = juce::jmin(reader.lengthInSamples, static_cast<juce::int64>(analysedSeconds * reader.sampleRate));
+    detector.reset(reader.sampleRate, length);
+    return reader.sampleRate > 0.0 ? length : 0;
+}
+
+void BeatAnalyser::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64, int numSamples)
+{
+    detector.process(block.getReadPointer(0), block.getReadPointer(1), numSamples);
+}
+
+void BeatAnalyser::decodeFinished(bool complete)
+{
+    if (complete)
+    {
+        auto grid = fitGrid(detector.onsets, detector.sampleRate);
+        firstBeat.store(grid.firstBeatSeconds);
+        bpm.store(grid.bpm); // Published last: a valid bpm means the phase is valid too
+    }
+    detector.onsets = {};
+}
+
+void BeatAnalyser::OnsetDetector::reset(double newSampleRate, juce::int64 expectedSamples)
+{
+    sampleRate = newSampleRate;
+    onsets.clear();
+    onsets.reserve(static_cast<size_t>(juce::jmax<juce::int64>(0, expectedSamples / hopSize)));
+    lowCoefficient = static_cast<float>(1.0 - std::exp(-juce::MathConstants<double>::twoPi * 150.0 / sampleRate));
+    lowState = previousLow = previousFull = 0.0f;
+}
+
+// Onset strength: positive change in log energy of a low band and the full band. Blocks
+// are whole hops except the last, whose remainder is dropped.
+void BeatAnalyser::OnsetDetector::process(const float* left, const float* right, int numSamples)
+{
+    for (int frame = 0; frame + hopSize <= numSamples; frame += hopSize)
+    {
+        float lowEnergy = 0.0f, fullEnergy = 0.0f;
+        for (int i = frame; i < frame + hopSize; ++i)
+        {
+            auto mono = 0.5f * (left[i] + right[i]);
+            lowState += lowCoefficient * (mono - lowState);
+            lowEnergy += lowState * lowState;
+            fullEnergy += mono * mono;
+        }
+
+        auto low = std::log1p(100.0f * lowEnergy);
+        auto full = std::log1p(100.0f * fullEnergy);
+        onsets.push_back(juce::jmax(0.0f, low - previousLow) + 0.5f * juce::jmax(0.0f, full - previousFull));
+        previousLow = low;
+        previousFull = full;
+    }
+}
+
+BeatGrid BeatAnalyser::fitGrid(const std::vector<float>& onsets, double sampleRate)
+{
+    BeatGrid grid;
+    if (sampleRate <= 0.0 || onsets.size() < 64)
+    {
+        return grid;
+    }
+
+    // Remove the slowly varying level so the autocorrelation sees only the pulses
+    auto numFrames = static_cast<int>(onsets.size());
+    std::vector<float> envelope(onsets.size());
+    const int meanWindow = 16;
+    for (int i = 0; i < numFrames; ++i)
+    {
+        auto from = juce::jmax(0, i - meanWindow), to = juce::jmin(numFrames, i + meanWindow + 1);
+        auto mean = std::accumulate(onsets.begin() + from, onsets.begin() + to, 0.0f) / static_cast<float>(to - from);
+        envelope[static_cast<size_t>(i)] = juce::jmax(0.0f, onsets[static_cast<size_t>(i)] - mean);
+    }
+
+    // Tempo: autocorrelation over the allowed lag range, weighted against octave errors
+    auto frameRate = sampleRate / hopSize;
+    auto shortestLag = static_cast<int>(std::floor(frameRate * 60.0 / maximumBpm));
+    auto longestLag = static_cast<int>(std::ceil(frameRate * 60.0 / minimumBpm));
+    if (longestLag * 4 >= numFrames)
+    {
+        return grid;
+    }
+
+    std::vector<double> correlation(static_cast<size_t>(longestLag + 2), 0.0);
+    for (int lag = shortestLag - 1; lag <= longestLag + 1; ++lag)
+    {
+        double sum = 0.0;
+        for (int i = lag; i < numFrames; ++i)
+        {
+            sum += envelope[static_cast<size_t>(i)] * envelope[static_cast<size_t>(i - lag)];
+        }
+        correlation[static_cast<size_t>(lag)] = sum / (numFrames - lag);
+    }
+
+    auto bestLag = shortestLag;
+    auto bestScore = -1.0;
+    for (int lag = shortestLag; lag <= longestLag; ++lag)
+    {
+        auto lagBpm = 60.0 * frameRate / lag;
+        auto octaves = std::log2(lagBpm / preferredBpm);
+        auto score = correlation[static_cast<size_t>(lag)] * std::exp(-0.5 * octaves * octaves / (0.7 * 0.7));
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+
+    if (bestScore <= 0.0)
+    {
+        return grid; // No periodic onsets, e.g. an ambient intro
+    }
+
+    // Parabolic interpolation around the peak for sub-frame tempo resolution
+    auto before = correlation[static_cast<size_t>(bestLag - 1)];
+    auto at = correlation[static_cast<size_t>(bestLag)];
+    auto after = correlation[static_cast<size_t>(bestLag + 1)];
+    auto denominator = before - 2.0 * at + after;
+    auto refinedLag = bestLag + (std::abs(denominator) > 1.0e-12 ? 0.5 * (before - after) / denominator : 0.0);
+
+    // Phase: the offset whose comb of beat positions collects the most onset energy
+    auto bestPhase = 0.0;
+    auto bestPhaseScore = -1.0;
+    for (int phase = 0; phase < bestLag; ++phase)
+    {
+        double sum = 0.0;
+        for (double position = phase; position < numFrames; position += refinedLag)
+        {
+            sum += envelope[static_cast<size_t>(position)];
+        }
+        if (sum > bestPhaseScore)
+        {
+            bestPhaseScore = sum;
+            bestPhase = phase;
+        }
+    }
+
+    grid.bpm = 60.0 * frameRate / refinedLag;
+    grid.firstBeatSeconds = bestPhase * hopSize / sampleRate;
+    return grid;
+}
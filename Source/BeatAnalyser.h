@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    This file defines the BeatAnalyser class for a JUCE application,
+    estimating a track's tempo and beat phase as the deck decodes it.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DecodePipeline.h"
+
+// BeatGrid: Constant-tempo grid; beat n falls at firstBeatSeconds + n * 60 / bpm
+struct BeatGrid
+{
+    double bpm = 0.0;
+    double firstBeatSeconds = 0.0;
+
+    bool isValid() const { return bpm > 0.0; }
+    double getBeatSeconds() const { return 60.0 / bpm; }
+    double nearestBeat(double seconds) const; // Time of the grid line closest to seconds
+};
+
+// BeatAnalyser: Onset envelope from band energies, tempo from its autocorrelation,
+// phase from the comb that best lines up with the onsets. On a deck it is fed by the
+// decode pipeline; for the library, by the same decode as the key and loudness analysis.
+class BeatAnalyser : public DecodePipeline::Consumer
+{
+//==============================================================================
+public:
+    BeatAnalyser() = default;
+
+    void reset();                          // GUI thread, with the pipeline stopped
+    BeatGrid getBeatGrid() const noexcept; // Invalid until the analysis finishes
+
+    // Pipeline thread
+    juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+    void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+    void decodeFinished(bool complete) override;
+
+//==============================================================================
+private:
+    // OnsetDetector: Onset strength, one value per hop, accumulated block by block
+    struct OnsetDetector
+    {
+        void reset(double sampleRate, juce::int64 expectedSamples);
+        void process(const float* left, const float* right, int numSamples);
+
+        std::vector<float> onsets;
+        double sampleRate = 0.0;
+        float lowCoefficient = 0.0f;
+        float lowState = 0.0f, previousLow = 0.0f, previousFull = 0.0f;
+    };
+
+    OnsetDetector detector; // Pipeline thread
+    std::atomic<double> bpm{0.0};
+    std::atomic<double> firstBeat{0.0};
+
+    static BeatGrid fitGrid(const std::vector<float>& onsets, double sampleRate);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BeatAnalyser)
+};
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the Benchmarks class for a JUCE application,
+    collecting the per-component DSP benchmarks into one report.
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "PerfCounter.h"
+#include "DeckEQ.h"
+#include "EffectsRack.h"
+#include "MasterLimiter.h"
+#include "MeterSource.h"
+#include "PolyphaseResampler.h"
+#include "LibrarySearch.h"
+#include "TrackBitmap.h"
+
+juce::String Benchmarks::runAll()
+{
+    juce::String report;
+    report << DeckEQ::runBenchmark();
+    report << EffectsRack::runBenchmark();
+    report << MasterLimiter::runBenchmark();
+    report << MeterSource::runBenchmark();
+    report << PolyphaseResampler::runBenchmark();
+    report << LibrarySearch::runBenchmark();
+    report << TrackBitmap::runBenchmark();
+    return report;
+}
+
+juce::String Benchmarks::timeBlockSizes(const juce::String& name,
+                                        const PrepareFunction& prepare,
+                                        const ProcessFunction& process)
+{
+    juce::String report;
+    juce::Random random(1234);
+
+    for (auto blockSize : { 64, 128, 256, 512 })
+    {
+        prepare(sampleRate, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        PerfCounter cost;
+
+        for (int block = 0; block < blocksPerRun; ++block)
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            {
+                auto* data = buffer.getWritePointer(ch);
+                for (int i = 0; i < blockSize; ++i)
+                    data[i] = random.nextFloat() * 0.5f - 0.25f;
+            }
+
+            PerfCounter::ScopedTimer timer(cost);
+            process(buffer, blockSize);
+        }
+
+        auto periodMicros = 1.0e6 * blockSize / sampleRate;
+        report << juce::String::formatted("%-24s %4d samples: avg %8.2f us  max %8.2f us  (%5.2f%% of period)\n",
+                                          name.toRawUTF8(), blockSize,
+                                          cost.getAverageMicros(), cost.getMaxMicros(),
+                                          100.0 * cost.getAverageMicros() / periodMicros);
+    }
+
+    return report;
+}
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    This file defines the Benchmarks class for a JUCE application,
+    timing the audio-thread DSP offline at typical buffer sizes.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Benchmarks: Runs each DSP block on noise and reports cost per block (run with --benchmark)
+class Benchmarks
+{
+//==============================================================================
+public:
+    using PrepareFunction = std::function<void(double sampleRate, int blockSize)>;
+    using ProcessFunction = std::function<void(juce::AudioBuffer<float>& buffer, int numSamples)>;
+
+    static juce::String runAll();
+
+    // Times process() at 64, 128, 256 and 512 samples, one report line per size
+    static juce::String timeBlockSizes(const juce::String& name,
+                                       const PrepareFunction& prepare,
+                                       const ProcessFunction& process);
+
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blocksPerRun = 2000;
+};
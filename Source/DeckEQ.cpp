@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the DeckEQ class for a JUCE application,
+    running the band split and sweep filter as four-lane transposed direct form II biquads.
+
+  ==============================================================================
+*/
+
+#include "DeckEQ.h"
+#include "Benchmarks.h"
+
+namespace
+{
+    constexpr double butterworthQ = 0.70710678118654752; // Two cascaded give Linkwitz-Riley 24 dB/oct
+    constexpr double sweepQ = 0.9;                       // Slight resonance, as on DJ mixer filters
+    constexpr float filterDeadZone = 0.02f;
+}
+
+DeckEQ::DeckEQ()
+{
+    for (auto& target : gainTargets)
+    {
+        target.store(1.0f);
+    }
+}
+
+// Compute the fixed crossover coefficients and reset the parameter smoothing
+void DeckEQ::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    setLanes(lowSplit, 0, 2, false, lowCrossover, butterworthQ, sampleRate);
+    setLanes(lowSplit, 2, 2, true, lowCrossover, butterworthQ, sampleRate);
+    setLanes(highSplit, 0, 2, false, highCrossover, butterworthQ, sampleRate);
+    setLanes(highSplit, 2, 2, true, highCrossover, butterworthQ, sampleRate);
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        gains[band].reset(sampleRate, 0.02);
+        gains[band].setCurrentAndTargetValue(gainTargets[band].load());
+    }
+
+    filterPosition.reset(sampleRate, 0.03);
+    filterPosition.setCurrentAndTargetValue(filterTarget.load());
+    reset();
+}
+
+void DeckEQ::reset()
+{
+    for (auto* state : { &lowSplitState[0], &lowSplitState[1], &highSplitState[0], &highSplitState[1], &sweepState })
+    {
+        *state = State();
+    }
+    sweepActive = false;
+}
+
+void DeckEQ::setBandGain(Band band, float gain)
+{
+    gainTargets[band].store(juce::jmax(0.0f, gain));
+}
+
+void DeckEQ::setFilter(float position)
+{
+    filterTarget.store(juce::jlimit(-1.0f, 1.0f, position));
+}
+
+// Audio thread: EQ then sweep filter, in place
+void DeckEQ::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (buffer.getNumChannels() == 0 || numSamples <= 0)
+    {
+        return;
+    }
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        gains[band].setTargetValue(gainTargets[band].load());
+    }
+    filterPosition.setTargetValue(filterTarget.load());
+
+    auto stereo = buffer.getNumChannels() > 1;
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = stereo ? buffer.getWritePointer(1, startSample) : left;
+    alignas(16) float lanes[4];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (i % coefficientInterval == 0)
+        {
+            updateSweep(filterPosition.skip(juce::jmin(coefficientInterval, numSamples - i)));
+        }
+
+        auto l = left[i];
+        auto r = right[i];
+
+        // Split off the lows: {L, R, L, R} -> {lowL, lowR, upperL, upperR}
+        lanes[0] = l; lanes[1] = r; lanes[2] = l; lanes[3] = r;
+        auto split = processBiquad(Vec::fromRawArray(lanes), lowSplit, lowSplitState[0]);
+        split = processBiquad(split, lowSplit, lowSplitState[1]);
+        split.copyToRawArray(lanes);
+        auto lowL = lanes[0];
+        auto lowR = lanes[1];
+
+        // Split the rest into mids and highs: {upperL, upperR, upperL, upperR} -> {midL, midR, highL, highR}
+        lanes[0] = lanes[2]; lanes[1] = lanes[3];
+        auto bands = processBiquad(Vec::fromRawArray(lanes), highSplit, highSplitState[0]);
+        bands = processBiquad(bands, highSplit, highSplitState[1]);
+        bands.copyToRawArray(lanes);
+
+        auto lowGain = gains[low].getNextValue();
+        auto midGain = gains[mid].getNextValue();
+        auto highGain = gains[high].getNextValue();
+        l = lowGain * lowL + midGain * lanes[0] + highGain * lanes[2];
+        r = lowGain * lowR + midGain * lanes[1] + highGain * lanes[3];
+
+        if (sweepActive)
+        {
+            lanes[0] = l; lanes[1] = r; lanes[2] = 0.0f; lanes[3] = 0.0f;
+            processBiquad(Vec::fromRawArray(lanes), sweep, sweepState).copyToRawArray(lanes);
+            l = lanes[0];
+            r = lanes[1];
+        }
+
+        left[i] = l;
+        if (stereo)
+        {
+            right[i] = r;
+        }
+    }
+}
+
+// Transposed direct form II, four lanes at once
+DeckEQ::Vec DeckEQ::processBiquad(Vec input, const Coefficients& c, State& s) noexcept
+{
+    auto output = c.b0 * input + s.z1;
+    s.z1 = c.b1 * input - c.a1 * output + s.z2;
+    s.z2 = c.b2 * input - c.a2 * output;
+    return output;
+}
+
+// RBJ cookbook low/high-pass coefficients, normalised by a0, written into the given lanes
+void DeckEQ::setLanes(Coefficients& c, int firstLane, int numLanes, bool highPass,
+                      double frequency, double q, double rate)
+{
+    auto w0 = juce::MathConstants<double>::twoPi * juce::jlimit(10.0, rate * 0.45, frequency) / rate;
+    auto cosW0 = std::cos(w0);
+    auto alpha = std::sin(w0) / (2.0 * q);
+    auto a0 = 1.0 + alpha;
+
+    auto b0 = (highPass ? (1.0 + cosW0) : (1.0 - cosW0)) * 0.5 / a0;
+    auto b1 = (highPass ? -(1.0 + cosW0) : (1.0 - cosW0)) / a0;
+    auto a1 = -2.0 * cosW0 / a0;
+    auto a2 = (1.0 - alpha) / a0;
+
+    for (auto lane = static_cast<size_t>(firstLane); lane < static_cast<size_t>(firstLane + numLanes); ++lane)
+    {
+        c.b0.set(lane, static_cast<float>(b0));
+        c.b1.set(lane, static_cast<float>(b1));
+        c.b2.set(lane, static_cast<float>(b0));
+        c.a1.set(lane, static_cast<float>(a1));
+        c.a2.set(lane, static_cast<float>(a2));
+    }
+}
+
+// Map the knob onto an exponential cutoff sweep; the dead zone around centre bypasses the filter
+void DeckEQ::updateSweep(float position) noexcept
+{
+    auto amount = (std::abs(position) - filterDeadZone) / (1.0f - filterDeadZone);
+    if (amount <= 0.0f)
+    {
+        sweepActive = false;
+        return;
+    }
+
+    if (!sweepActive)
+    {
+        sweepState = State(); // Starts from a near-transparent cutoff, so no click
+        sweepActive = true;
+    }
+
+    auto highPass = position > 0.0f;
+    auto cutoff = highPass ? 20.0 * std::pow(8000.0 / 20.0, static_cast<double>(amount))
+                           : 20000.0 * std::pow(60.0 / 20000.0, static_cast<double>(amount));
+    setLanes(sweep, 0, 4, highPass, cutoff, sweepQ, sampleRate);
+}
+
+// Worst case: every band moving and the sweep filter engaged
+juce::String DeckEQ::runBenchmark()
+{
+    DeckEQ eq;
+    return Benchmarks::timeBlockSizes("DeckEQ (EQ + sweep)",
+        [&eq](double rate, int)
+        {
+            eq.setBandGain(low, 0.0f);
+            eq.setBandGain(mid, 0.7f);
+            eq.setBandGain(high, 1.3f);
+            eq.setFilter(-0.5f);
+            eq.prepare(rate);
+            eq.setFilter(0.5f); // Keeps the smoother and coefficient updates busy
+        },
+        [&eq](juce::AudioBuffer<float>& buffer, int numSamples)
+        {
+            eq.process(buffer, 0, numSamples);
+        });
+}
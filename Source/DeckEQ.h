@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    This file defines the DeckEQ class for a JUCE application,
+    a per-deck 3-band kill EQ and HPF/LPF sweep filter built from SIMD biquads.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// DeckEQ: Linkwitz-Riley band split into low/mid/high with smoothed band gains,
+// followed by a one-knob sweep filter. Left and right run through the same SIMD
+// register so each biquad evaluation processes both channels (and both crossover
+// outputs) at once. Setters may be called from any thread.
+class DeckEQ
+{
+//==============================================================================
+public:
+    enum Band { low = 0, mid, high, numBands };
+
+    DeckEQ();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    void setBandGain(Band band, float gain); // 0 kills the band, 1 is flat
+    void setFilter(float position);          // -1 closes the LPF, 0 is off, +1 closes the HPF
+
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    static juce::String runBenchmark(); // Cost per deck per block at 64-512 sample buffers
+
+//==============================================================================
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static_assert(Vec::SIMDNumElements == 4, "DeckEQ lays out {L, R, L, R} in one register");
+
+    struct Coefficients { Vec b0, b1, b2, a1, a2; };
+    struct State { Vec z1, z2; };
+
+    static constexpr float lowCrossover = 250.0f;
+    static constexpr float highCrossover = 2500.0f;
+    static constexpr int coefficientInterval = 16; // Samples between sweep filter coefficient updates
+
+    double sampleRate{44100.0};
+
+    // Crossovers: lanes {0, 1} take the low-pass output, lanes {2, 3} the high-pass output
+    Coefficients lowSplit;
+    Coefficients highSplit;
+    State lowSplitState[2];
+    State highSplitState[2];
+
+    Coefficients sweep;
+    State sweepState;
+    bool sweepActive{false};
+
+    std::atomic<float> gainTargets[numBands];
+    std::atomic<float> filterTarget{0.0f};
+    juce::SmoothedValue<float> gains[numBands];
+    juce::SmoothedValue<float> filterPosition;
+
+    static Vec processBiquad(Vec input, const Coefficients& c, State& s) noexcept;
+    static void setLanes(Coefficients& c, int firstLane, int numLanes, bool highPass, double frequency, double q, double sampleRate);
+    void updateSweep(float position) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckEQ)
+};
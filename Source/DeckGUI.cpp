@@ -1,279 +1,777 @@
-/*
-  ==============================================================================
-
-    This file contains the implementation of the DeckGUI class for a JUCE application,
-    managing audio playback, UI controls, and turntable visualization for a deck.
-
-  ==============================================================================
-*/
-
-#include "DeckGUI.h"
-
-// Custom slider appearance
-void DeckGUI::SliderLookAndFeel::drawLinearSlider(juce::Graphics& g, int x, int y, int width, int height,
-                                                float sliderPos, float minSliderPos, float maxSliderPos,
-                                                const juce::Slider::SliderStyle, juce::Slider& slider)
-{
-    auto trackBounds = juce::Rectangle<float>(x, y + height * 0.4f, width, height * 0.2f);
-    g.setColour(juce::Colours::black);
-    g.fillRoundedRectangle(trackBounds, 2.0f);
-
-    g.setColour(juce::Colours::grey.darker(0.5f));
-    for (int i = 0; i <= 10; ++i)
-    {
-        float tickX = x + (width * i / 10.0f);
-        g.drawVerticalLine(static_cast<int>(tickX), trackBounds.getY() - 5, trackBounds.getBottom() + 5);
-    }
-
-    auto thumbWidth = 12.0f;
-    auto thumbHeight = 20.0f;
-    auto thumbBounds = juce::Rectangle<float>(sliderPos - thumbWidth / 2, y + (height - thumbHeight) / 2, thumbWidth, thumbHeight);
-    g.setColour(juce::Colours::orange);
-    g.fillRect(thumbBounds);
-    g.setColour(juce::Colours::black.withAlpha(0.3f));
-    g.drawRect(thumbBounds, 1.0f);
-}
-
-// Constructor: Set up UI and audio components
-DeckGUI::DeckGUI(int _id,
-                 juce::AudioFormatManager& formatManagerToUse,
-                 juce::AudioThumbnailCache& cacheToUse)
-    : id(_id), waveformDisplay(formatManagerToUse, cacheToUse)
-{
-    addAndMakeVisible(playButton);
-    addAndMakeVisible(volumeSlider);
-    addAndMakeVisible(speedSlider);
-    addAndMakeVisible(waveformDisplay);
-    addAndMakeVisible(volumeLabel);
-    addAndMakeVisible(speedLabel);
-
-    playButton.addListener(this);
-    volumeSlider.addListener(this);
-    speedSlider.addListener(this);
-
-    volumeSlider.setRange(0.0, 1.0);
-    speedSlider.setRange(0.5, 1.5);
-    volumeSlider.setValue(1.0);
-    speedSlider.setValue(1.0);
-
-    volumeSlider.setLookAndFeel(&sliderLookAndFeel);
-    speedSlider.setLookAndFeel(&sliderLookAndFeel);
-
-    volumeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
-    speedSlider.setSliderStyle(juce::Slider::LinearHorizontal);
-    
-    volumeSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    speedSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-
-    volumeLabel.setText("Volume", juce::dontSendNotification);
-    speedLabel.setText("Speed", juce::dontSendNotification);
-
-    volumeLabel.setFont(juce::FontOptions(14.0f));
-    speedLabel.setFont(juce::FontOptions(14.0f));
-
-    volumeLabel.setJustificationType(juce::Justification::centred);
-    speedLabel.setJustificationType(juce::Justification::centred);
-
-    formatManager.registerBasicFormats();
-
-    waveformDisplay.onPositionClicked = [this](double position) {
-        setTransportPosition(position); // Link waveform click to transport
-    };
-
-    startTimer(16); // 60 FPS for turntable animation
-}
-
-DeckGUI::~DeckGUI()
-{
-    volumeSlider.setLookAndFeel(nullptr);
-    speedSlider.setLookAndFeel(nullptr);
-    stopTimer();
-    transportSource.stop();
-    transportSource.releaseResources();
-    transportSource.setSource(nullptr);
-    readerSource.reset();
-}
-
-// Draw deck UI with animated turntable
-void DeckGUI::paint(juce::Graphics& g)
-{
-    juce::ColourGradient bgGradient(
-        juce::Colours::black.brighter(0.1f), 0, 0,
-        juce::Colours::darkgrey.darker(0.3f), 0, getHeight(),
-        false);
-    bgGradient.addColour(0.3, juce::Colours::grey.darker(0.2f));
-    g.setGradientFill(bgGradient);
-    g.fillRoundedRectangle(getLocalBounds().toFloat(), 8.0f);
-
-    g.setColour(juce::Colours::grey.withAlpha(0.05f));
-    for (int i = 0; i < 100; ++i)
-    {
-        float x = juce::Random::getSystemRandom().nextFloat() * getWidth();
-        float y = juce::Random::getSystemRandom().nextFloat() * getHeight();
-        g.fillRect(x, y, 1.0f, 1.0f);
-    }
-
-    g.setColour(juce::Colours::black.withAlpha(0.2f));
-    g.drawRoundedRectangle(getLocalBounds().reduced(2).toFloat(), 8.0f, 2.0f);
-
-    auto bounds = getLocalBounds().reduced(10);
-    auto turntableHeight = bounds.getHeight() / 2;
-    auto turntableBounds = bounds.removeFromBottom(turntableHeight).withSizeKeepingCentre(200, 200);
-
-    g.setColour(juce::Colours::black.withAlpha(0.3f));
-    g.fillEllipse(turntableBounds.toFloat().translated(5.0f, 5.0f));
-
-    juce::ColourGradient vinylGradient(juce::Colours::black, turntableBounds.getCentreX(), turntableBounds.getCentreY(),
-                                      juce::Colours::grey.darker(0.5f), turntableBounds.getRight(), turntableBounds.getBottom(), true);
-    g.setGradientFill(vinylGradient);
-    g.fillEllipse(turntableBounds.toFloat());
-
-    g.setColour(juce::Colours::red.brighter(0.2f));
-    g.drawEllipse(turntableBounds.toFloat(), 5.0f);
-
-    auto center = turntableBounds.getCentre();
-    g.saveState();
-    if (transportSource.getTotalLength() > 0)
-    {
-        g.addTransform(juce::AffineTransform::rotation(currentAngle, center.x, center.y));
-    }
-
-    g.setColour(juce::Colours::red);
-    g.drawLine(center.x, center.y, center.x + 80.0f, center.y, 2.0f);
-
-    g.restoreState();
-}
-
-// Arrange deck UI components (play button, volume/speed controls, waveform) vertically
-void DeckGUI::resized()
-{
-    auto area = getLocalBounds().reduced(10);
-    
-    auto playArea = area.removeFromTop(50);
-    playButton.setBounds(playArea.reduced(5));
-
-    auto volumeArea = area.removeFromTop(60);
-    volumeLabel.setBounds(volumeArea.removeFromTop(20).reduced(5));
-    volumeSlider.setBounds(volumeArea.reduced(5));
-
-    auto speedArea = area.removeFromTop(60);
-    speedLabel.setBounds(speedArea.removeFromTop(20).reduced(5));
-    speedSlider.setBounds(speedArea.reduced(5));
-
-    waveformDisplay.setBounds(area.removeFromTop(80).reduced(5));
-}
-
-// Toggle play/stop state
-void DeckGUI::buttonClicked(juce::Button* button)
-{
-    if (button == &playButton)
-    {
-        if (playing)
-        {
-            transportSource.stop();
-        }
-        else if (readerSource != nullptr)
-        {
-            transportSource.start();
-        }
-        playing = !playing;
-        playButton.setButtonText(playing ? "Stop" : "Play");
-    }
-}
-
-// Update volume or speed based on slider
-void DeckGUI::sliderValueChanged(juce::Slider* slider)
-{
-    if (slider == &volumeSlider)
-    {
-        volume = static_cast<float>(slider->getValue());
-    }
-    else if (slider == &speedSlider)
-    {
-        speed = static_cast<float>(slider->getValue());
-        resampleSource.setResamplingRatio(speed); // Adjust playback speed
-    }
-}
-
-// Load audio file into transport and waveform
-void DeckGUI::loadFile(const juce::File& file)
-{
-    if (!file.existsAsFile())
-    {
-        return;
-    }
-
-    if (playing)
-    {
-        transportSource.stop();
-        playing = false;
-        playButton.setButtonText("Play");
-    }
-
-    transportSource.setSource(nullptr);
-    readerSource.reset();
-    currentAngle = 0.0f;
-
-    auto* reader = formatManager.createReaderFor(file);
-    if (reader != nullptr)
-    {
-        readerSource.reset(new juce::AudioFormatReaderSource(reader, true));
-        transportSource.setSource(readerSource.get());
-        juce::URL fileURL(file);
-        waveformDisplay.loadURL(fileURL);
-    }
-}
-
-void DeckGUI::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
-{
-    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-}
-
-// Fill the audio buffer with the next block of samples from the resampler if playing
-void DeckGUI::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
-{
-    if (playing && readerSource != nullptr)
-    {
-        resampleSource.getNextAudioBlock(bufferToFill);
-        juce::MessageManager::callAsync([this]() { updatePlayhead(); }); // Async update of playhead
-    }
-    else
-    {
-        bufferToFill.clearActiveBufferRegion(); // Clear buffer if not playing
-    }
-}
-
-// Sync the waveform display’s playhead with the current transport position
-void DeckGUI::updatePlayhead()
-{
-    waveformDisplay.setPosition(transportSource.getCurrentPosition());
-}
-
-// Release audio resources held by the transport and resampler
-void DeckGUI::releaseResources()
-{
-    transportSource.releaseResources();
-    resampleSource.releaseResources();
-}
-
-// Set the playback position in the transport and update the waveform display
-void DeckGUI::setTransportPosition(double positionInSeconds)
-{
-    if (readerSource != nullptr)
-    {
-        transportSource.setPosition(positionInSeconds);
-        waveformDisplay.setPosition(positionInSeconds); // Keep waveform in sync
-    }
-}
-
-// Animate turntable rotation
-void DeckGUI::timerCallback()
-{
-    if (playing && transportSource.getTotalLength() > 0)
-    {
-        float rotationSpeed = 0.5f * juce::MathConstants<float>::pi;
-        currentAngle += rotationSpeed * speed * (16.0f / 1000.0f);
-        repaint();
-    }
-}
+/*
+  ==============================================================================
+
+    This file contains the implementation of the DeckGUI class for a JUCE application,
+    managing audio playback, UI controls, and turntable visualization for a deck.
+
+  ==============================================================================
+*/
+
+#include "DeckGUI.h"
+
+// Custom slider appearance
+void DeckGUI::SliderLookAndFeel::drawLinearSlider(juce::Graphics& g, int x, int y, int width, int height,
+                                                float sliderPos, float minSliderPos, float maxSliderPos,
+                                                const juce::Slider::SliderStyle, juce::Slider& slider)
+{
+    auto trackBounds = juce::Rectangle<float>(x, y + height * 0.4f, width, height * 0.2f);
+    g.setColour(juce::Colours::black);
+    g.fillRoundedRectangle(trackBounds, 2.0f);
+
+    g.setColour(juce::Colours::grey.darker(0.5f));
+    for (int i = 0; i <= 10; ++i)
+    {
+        float tickX = x + (width * i / 10.0f);
+        g.drawVerticalLine(static_cast<int>(tickX), trackBounds.getY() - 5, trackBounds.getBottom() + 5);
+    }
+
+    auto thumbWidth = 12.0f;
+    auto thumbHeight = 20.0f;
+    auto thumbBounds = juce::Rectangle<float>(sliderPos - thumbWidth / 2, y + (height - thumbHeight) / 2, thumbWidth, thumbHeight);
+    g.setColour(juce::Colours::orange);
+    g.fillRect(thumbBounds);
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.drawRect(thumbBounds, 1.0f);
+}
+
+// Constructor: Set up UI and audio components
+DeckGUI::DeckGUI(int _id,
+                 juce::AudioFormatManager& formatManagerToUse,
+                 juce::AudioThumbnailCache& cacheToUse)
+    : id(_id), formatManager(formatManagerToUse), loopSource(transportSource, formatManagerToUse, cacheSource),
+      waveformDisplay(formatManagerToUse, cacheToUse), scratchEngine(formatManagerToUse, cacheSource),
+      decodePipeline(formatManagerToUse)
+{
+    // One decode of each loaded track feeds all of these
+    decodePipeline.addConsumer(&cacheSource);
+    decodePipeline.addConsumer(&waveformDisplay);
+    decodePipeline.addConsumer(&scrollingWaveform);
+    decodePipeline.addConsumer(&beatAnalyser);
+
+    addAndMakeVisible(playButton);
+    addAndMakeVisible(cueButton);
+    addAndMakeVisible(volumeSlider);
+    addAndMakeVisible(speedSlider);
+    addAndMakeVisible(waveformDisplay);
+    addAndMakeVisible(scrollingWaveform);
+    addAndMakeVisible(levelMeter);
+    addAndMakeVisible(spectrumDisplay);
+    addAndMakeVisible(volumeLabel);
+    addAndMakeVisible(speedLabel);
+
+    playButton.addListener(this);
+    cueButton.setClickingTogglesState(true);
+    cueButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.3f));
+    cueButton.onClick = [this] { cueEnabled.store(cueButton.getToggleState()); };
+    volumeSlider.addListener(this);
+    speedSlider.addListener(this);
+
+    volumeSlider.setRange(0.0, 1.0);
+    speedSlider.setRange(0.5, 1.5);
+    volumeSlider.setValue(1.0);
+    speedSlider.setValue(1.0);
+
+    volumeSlider.setLookAndFeel(&sliderLookAndFeel);
+    speedSlider.setLookAndFeel(&sliderLookAndFeel);
+
+    volumeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    speedSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    
+    volumeSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    speedSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+
+    volumeLabel.setText("Volume", juce::dontSendNotification);
+    speedLabel.setText("Speed", juce::dontSendNotification);
+
+    volumeLabel.setFont(juce::FontOptions(14.0f));
+    speedLabel.setFont(juce::FontOptions(14.0f));
+
+    volumeLabel.setJustificationType(juce::Justification::centred);
+    speedLabel.setJustificationType(juce::Justification::centred);
+
+    setupKnob(lowSlider, lowLabel, "Low", 0.0, 2.0, 1.0);
+    setupKnob(midSlider, midLabel, "Mid", 0.0, 2.0, 1.0);
+    setupKnob(highSlider, highLabel, "High", 0.0, 2.0, 1.0);
+    setupKnob(filterSlider, filterLabel, "Filter", -1.0, 1.0, 0.0);
+    setupKnob(fxMixSlider, fxMixLabel, "FX", 0.0, 1.0, 0.5);
+
+    for (int type = 0; type < EffectsRack::numEffects; ++type)
+    {
+        auto& button = effectButtons[type];
+        button.setButtonText(EffectsRack::getEffectName(static_cast<EffectsRack::EffectType>(type)));
+        button.setClickingTogglesState(true);
+        button.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.3f));
+        button.addListener(this);
+        addAndMakeVisible(button);
+    }
+
+    for (auto* button : { &loopInButton, &loopOutButton, &loopButton, &rollButton })
+    {
+        addAndMakeVisible(button);
+    }
+    addAndMakeVisible(loopLengthSelector);
+    addAndMakeVisible(bpmLabel);
+
+    loopButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::limegreen.darker(0.4f));
+    loopInButton.onClick = [this] { loopInSample = getPlayheadSample(); };
+    loopOutButton.onClick = [this]
+    {
+        auto outSample = getPlayheadSample();
+        if (loopInSample >= 0 && outSample > loopInSample)
+        {
+            loopSource.setLoop(loopInSample, outSample);
+        }
+    };
+    loopButton.onClick = [this] { loopButtonClicked(); };
+    rollButton.onStateChange = [this] { rollStateChanged(); };
+
+    // Auto-loop lengths from 1/4 to 32 beats; item id is the length in quarter beats
+    for (auto quarters : { 1, 2, 4, 8, 16, 32, 64, 128 })
+    {
+        loopLengthSelector.addItem(quarters < 4 ? "1/" + juce::String(4 / quarters) : juce::String(quarters / 4), quarters);
+    }
+    loopLengthSelector.setSelectedId(16, juce::dontSendNotification);
+
+    bpmLabel.setFont(juce::FontOptions(12.0f));
+    bpmLabel.setJustificationType(juce::Justification::centredRight);
+
+    waveformDisplay.onPositionClicked = [this](double position) {
+        setTransportPosition(position); // Link waveform click to transport
+    };
+
+    startTimer(16); // 60 FPS for turntable animation and waveform scrolling
+}
+
+DeckGUI::~DeckGUI()
+{
+    volumeSlider.setLookAndFeel(nullptr);
+    speedSlider.setLookAndFeel(nullptr);
+    stopTimer();
+    decodePipeline.stop();
+    scratchEngine.unload(); // Both copy from the PCM cache
+    loopSource.unload();
+    transportSource.stop();
+    transportSource.releaseResources();
+    trackLoaded.store(false);
+    transportSource.setSource(nullptr);
+    cacheSource.setSource(nullptr, {});
+    readerSource.reset();
+}
+
+// Draw deck UI with animated turntable
+void DeckGUI::paint(juce::Graphics& g)
+{
+    juce::ColourGradient bgGradient(
+        juce::Colours::black.brighter(0.1f), 0, 0,
+        juce::Colours::darkgrey.darker(0.3f), 0, getHeight(),
+        false);
+    bgGradient.addColour(0.3, juce::Colours::grey.darker(0.2f));
+    g.setGradientFill(bgGradient);
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 8.0f);
+
+    g.setColour(juce::Colours::grey.withAlpha(0.05f));
+    for (int i = 0; i < 100; ++i)
+    {
+        float x = juce::Random::getSystemRandom().nextFloat() * getWidth();
+        float y = juce::Random::getSystemRandom().nextFloat() * getHeight();
+        g.fillRect(x, y, 1.0f, 1.0f);
+    }
+
+    g.setColour(juce::Colours::black.withAlpha(0.2f));
+    g.drawRoundedRectangle(getLocalBounds().reduced(2).toFloat(), 8.0f, 2.0f);
+
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.fillEllipse(turntableBounds.toFloat().translated(5.0f, 5.0f));
+
+    juce::ColourGradient vinylGradient(juce::Colours::black, turntableBounds.getCentreX(), turntableBounds.getCentreY(),
+                                      juce::Colours::grey.darker(0.5f), turntableBounds.getRight(), turntableBounds.getBottom(), true);
+    g.setGradientFill(vinylGradient);
+    g.fillEllipse(turntableBounds.toFloat());
+
+    g.setColour(juce::Colours::red.brighter(0.2f));
+    g.drawEllipse(turntableBounds.toFloat(), 5.0f);
+
+    auto center = turntableBounds.getCentre();
+    g.saveState();
+    if (transportSource.getTotalLength() > 0)
+    {
+        g.addTransform(juce::AffineTransform::rotation(currentAngle, center.x, center.y));
+    }
+
+    g.setColour(juce::Colours::red);
+    g.drawLine(center.x, center.y, center.x + 80.0f, center.y, 2.0f);
+
+    g.restoreState();
+
+    if (jogging)
+    {
+        auto& latency = scratchEngine.getMotionLatency();
+        g.setColour(juce::Colours::white.withAlpha(0.7f));
+        g.setFont(juce::FontOptions(12.0f));
+        g.drawText(juce::String::formatted("jog %.1f ms (max %.1f) / buffer %.1f ms",
+                                           latency.getAverageMicros() / 1000.0,
+                                           latency.getMaxMicros() / 1000.0,
+                                           scratchEngine.getBufferDurationMs()),
+                   turntableBounds.withTop(turntableBounds.getBottom() - 16).expanded(40, 0),
+                   juce::Justification::centred);
+    }
+}
+
+// Arrange deck UI components (play button, volume/speed controls, waveforms) vertically,
+// leaving the remaining space to the turntable
+void DeckGUI::resized()
+{
+    auto area = getLocalBounds().reduced(10);
+    
+    auto playArea = area.removeFromTop(50);
+    cueButton.setBounds(playArea.removeFromRight(60).reduced(5));
+    playButton.setBounds(playArea.reduced(5));
+
+    auto volumeArea = area.removeFromTop(60);
+    volumeLabel.setBounds(volumeArea.removeFromTop(20).reduced(5));
+    volumeSlider.setBounds(volumeArea.reduced(5));
+
+    auto speedArea = area.removeFromTop(60);
+    speedLabel.setBounds(speedArea.removeFromTop(20).reduced(5));
+    speedSlider.setBounds(speedArea.reduced(5));
+
+    scrollingWaveform.setBounds(area.removeFromTop(70).reduced(5));
+    waveformDisplay.setBounds(area.removeFromTop(70).reduced(5));
+
+    auto meterArea = area.removeFromTop(60).reduced(5);
+    levelMeter.setBounds(meterArea.removeFromRight(14));
+    spectrumDisplay.setBounds(meterArea.withTrimmedRight(5));
+
+    auto knobArea = area.removeFromTop(70).reduced(5, 0);
+    auto knobWidth = knobArea.getWidth() / 5;
+    for (auto knob : { std::make_pair(&lowSlider, &lowLabel), std::make_pair(&midSlider, &midLabel),
+                       std::make_pair(&highSlider, &highLabel), std::make_pair(&filterSlider, &filterLabel),
+                       std::make_pair(&fxMixSlider, &fxMixLabel) })
+    {
+        auto column = knobArea.removeFromLeft(knobWidth);
+        knob.second->setBounds(column.removeFromBottom(16));
+        knob.first->setBounds(column);
+    }
+
+    auto effectArea = area.removeFromTop(28).reduced(5, 2);
+    auto effectWidth = effectArea.getWidth() / EffectsRack::numEffects;
+    for (auto& button : effectButtons)
+    {
+        button.setBounds(effectArea.removeFromLeft(effectWidth).reduced(2, 0));
+    }
+
+    auto loopArea = area.removeFromTop(28).reduced(5, 2);
+    auto loopWidth = loopArea.getWidth() / 7;
+    loopInButton.setBounds(loopArea.removeFromLeft(loopWidth).reduced(2, 0));
+    loopOutButton.setBounds(loopArea.removeFromLeft(loopWidth).reduced(2, 0));
+    loopLengthSelector.setBounds(loopArea.removeFromLeft(loopWidth).reduced(2, 0));
+    loopButton.setBounds(loopArea.removeFromLeft(loopWidth).reduced(2, 0));
+    rollButton.setBounds(loopArea.removeFromLeft(loopWidth).reduced(2, 0));
+    bpmLabel.setBounds(loopArea);
+
+    auto turntableSize = juce::jmin(200, area.getWidth(), area.getHeight());
+    turntableBounds = area.withSizeKeepingCentre(turntableSize, turntableSize);
+}
+
+// Toggle play/stop state, or switch an effect in the rack
+void DeckGUI::buttonClicked(juce::Button* button)
+{
+    if (button == &playButton)
+    {
+        setPlaying(!playing);
+        return;
+    }
+
+    for (int type = 0; type < EffectsRack::numEffects; ++type)
+    {
+        if (button == &effectButtons[type])
+        {
+            effectsRack.setEffectEnabled(static_cast<EffectsRack::EffectType>(type), button->getToggleState());
+        }
+    }
+}
+
+// The transport runs while a track is loaded and `playing` gates it on the audio thread,
+// so a controller can start and stop the deck without a trip through the message thread
+void DeckGUI::setPlaying(bool shouldPlay)
+{
+    if (shouldPlay && readerSource == nullptr)
+    {
+        return;
+    }
+
+    if (shouldPlay && !transportSource.isPlaying())
+    {
+        transportSource.start(); // It stops itself at the end of the track
+    }
+    playing = shouldPlay;
+    shownPlaying = shouldPlay;
+    playButton.setButtonText(playing ? "Stop" : "Play");
+}
+
+void DeckGUI::setCueEnabled(bool shouldCue)
+{
+    cueButton.setToggleState(shouldCue, juce::dontSendNotification);
+    cueEnabled.store(shouldCue);
+}
+
+void DeckGUI::applyCommand(const EngineCommand& command) noexcept
+{
+    switch (command.type)
+    {
+        case EngineCommand::volume:
+            volume.store(juce::jlimit(0.0f, 1.0f, command.value));
+            break;
+
+        case EngineCommand::pitch:
+            speed.store(command.value);
+            resampleSource.setSpeed(command.value);
+            break;
+
+        case EngineCommand::play:
+            if (trackLoaded.load())
+            {
+                playing.store(!playing.load());
+            }
+            break;
+
+        case EngineCommand::cue:
+            cueEnabled.store(!cueEnabled.load());
+            break;
+
+        case EngineCommand::jogTouch:
+            if (command.value > 0.5f)
+            {
+                lastMidiJogTime.store(juce::Time::getMillisecondCounterHiRes());
+                scratchEngine.touch();
+            }
+            else
+            {
+                scratchEngine.release(playing.load() ? speed.load() : 0.0f);
+            }
+            break;
+
+        case EngineCommand::jog:
+            if (scratchEngine.isTouched())
+            {
+                lastMidiJogTime.store(juce::Time::getMillisecondCounterHiRes());
+                scratchEngine.setTargetVelocity(command.value);
+            }
+            break;
+
+        case EngineCommand::crossfader:
+        case EngineCommand::cueMix:
+        case EngineCommand::pad:
+            break;
+    }
+}
+
+// Update volume or speed based on slider
+void DeckGUI::sliderValueChanged(juce::Slider* slider)
+{
+    if (slider == &volumeSlider)
+    {
+        volume.store(static_cast<float>(slider->getValue()));
+    }
+    else if (slider == &speedSlider)
+    {
+        speed.store(static_cast<float>(slider->getValue()));
+        resampleSource.setSpeed(speed.load()); // Adjust playback speed
+    }
+    else if (slider == &lowSlider)
+    {
+        deckEQ.setBandGain(DeckEQ::low, static_cast<float>(slider->getValue()));
+    }
+    else if (slider == &midSlider)
+    {
+        deckEQ.setBandGain(DeckEQ::mid, static_cast<float>(slider->getValue()));
+    }
+    else if (slider == &highSlider)
+    {
+        deckEQ.setBandGain(DeckEQ::high, static_cast<float>(slider->getValue()));
+    }
+    else if (slider == &filterSlider)
+    {
+        deckEQ.setFilter(static_cast<float>(slider->getValue()));
+    }
+    else if (slider == &fxMixSlider)
+    {
+        effectsRack.setMix(static_cast<float>(slider->getValue()));
+    }
+}
+
+// Load audio file into transport and waveform
+void DeckGUI::loadFile(const juce::File& file)
+{
+    if (!file.existsAsFile())
+    {
+        return;
+    }
+
+    trackLoaded.store(false); // From here the audio thread treats the deck as empty
+
+    if (playing)
+    {
+        transportSource.stop();
+        playing = false;
+        playButton.setButtonText("Play");
+    }
+
+    decodePipeline.stop(); // Its consumers are about to be reset
+    scratchEngine.unload(); // Both copy from the PCM cache, which is about to be replaced
+    loopSource.unload();
+    transportSource.setSource(nullptr);
+    cacheSource.setSource(nullptr, {});
+    readerSource.reset();
+    currentAngle = 0.0f;
+
+    auto* reader = formatManager.createReaderFor(file);
+    loadedFile = reader != nullptr ? file : juce::File();
+    if (reader != nullptr)
+    {
+        resampleSource.setSourceSampleRate(reader->sampleRate); // Plays a 48 kHz file at pitch on a 44.1 kHz device
+        readerSource.reset(new juce::AudioFormatReaderSource(reader, true));
+        cacheSource.setSource(readerSource.get(), file);
+        transportSource.setSource(&cacheSource);
+        transportSource.start(); // Held silent until `playing` is set
+        waveformDisplay.loadFile(file);
+        scrollingWaveform.clear();
+        beatAnalyser.reset();
+        if (trackAnalyser != nullptr)
+        {
+            trackAnalyser->setFile(file);
+        }
+        scratchEngine.loadFile(file);
+        loopSource.loadFile(file);
+        decodePipeline.start(file); // Cache, overview, peaks, beat grid and library analysis from one decode
+    }
+    loopInSample = -1;
+    publishedPosition.store(0.0);
+
+    // A play toggle that raced the start of the load must not start the new track
+    playing.store(false);
+    shownPlaying = false;
+    playButton.setButtonText("Play");
+    trackLoaded.store(reader != nullptr);
+}
+
+void DeckGUI::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    playFade.reset(sampleRate, 0.005);
+    playFade.setCurrentAndTargetValue(playing.load() ? 1.0f : 0.0f);
+    meterSource.prepare(sampleRate);
+    scratchEngine.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    deckEQ.prepare(sampleRate);
+    effectsRack.prepare(sampleRate);
+}
+
+// Fill the audio buffer from the scratch engine while the platter is held,
+// otherwise with the next block of samples from the resampler if playing
+void DeckGUI::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    juce::int64 handBackPosition = -1;
+
+    auto loaded = trackLoaded.load();
+
+    if (loaded
+        && scratchEngine.renderNextBlock(bufferToFill, loopSource.getNextReadPosition(), handBackPosition))
+    {
+        if (handBackPosition >= 0)
+        {
+            transportSource.setNextReadPosition(handBackPosition); // Resume where the platter left off
+        }
+        publishedPosition.store(scratchEngine.getPositionInSeconds());
+        playFade.setCurrentAndTargetValue(playing.load() ? 1.0f : 0.0f);
+    }
+    else if (loaded && (playing.load() || playFade.getCurrentValue() > 0.0f))
+    {
+        resampleSource.getNextAudioBlock(bufferToFill);
+        publishedPosition.store(loopSource.getPositionInSeconds()); // Picked up by the GUI timer
+
+        // Fade in on play and out on stop; the source keeps running until the fade ends
+        playFade.setTargetValue(playing.load() ? 1.0f : 0.0f);
+        if (playFade.isSmoothing())
+        {
+            for (int i = 0; i < bufferToFill.numSamples; ++i)
+            {
+                auto gain = playFade.getNextValue();
+                for (int ch = 0; ch < bufferToFill.buffer->getNumChannels(); ++ch)
+                {
+                    bufferToFill.buffer->getWritePointer(ch, bufferToFill.startSample)[i] *= gain;
+                }
+            }
+        }
+        else if (playFade.getCurrentValue() == 0.0f)
+        {
+            bufferToFill.clearActiveBufferRegion();
+        }
+    }
+    else
+    {
+        bufferToFill.clearActiveBufferRegion(); // Clear buffer if not playing
+    }
+
+    deckEQ.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+    effectsRack.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+    meterSource.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples); // Pre-fader metering
+}
+
+double DeckGUI::getLengthInSeconds() const
+{
+    auto rate = loopSource.getSourceSampleRate();
+    return readerSource != nullptr && rate > 0.0 ? static_cast<double>(readerSource->getTotalLength()) / rate : 0.0;
+}
+
+// Sync both waveform views with the playhead position published by the audio thread
+void DeckGUI::updatePlayhead()
+{
+    auto position = publishedPosition.load();
+    waveformDisplay.setPosition(position);
+    scrollingWaveform.setPosition(position);
+}
+
+// Release audio resources held by the transport and resampler
+void DeckGUI::releaseResources()
+{
+    transportSource.releaseResources();
+    resampleSource.releaseResources();
+}
+
+// Every buffer the deck holds decoded audio in is charged to the shared budget
+void DeckGUI::setMemoryBudget(MemoryBudget* budget)
+{
+    cacheSource.setMemoryBudget(budget);
+    loopSource.setMemoryBudget(budget);
+    scratchEngine.setMemoryBudget(budget);
+}
+
+void DeckGUI::setAnalysisCache(AnalysisCache* cache)
+{
+    jassert(trackAnalyser == nullptr && cache != nullptr);
+    trackAnalyser = std::make_unique<AnalysisCache::Analyser>(cache);
+    decodePipeline.addConsumer(trackAnalyser.get());
+}
+
+// Set the playback position in the transport and update the waveform display
+void DeckGUI::setTransportPosition(double positionInSeconds)
+{
+    if (readerSource != nullptr)
+    {
+        transportSource.setNextReadPosition(static_cast<juce::int64>(positionInSeconds * loopSource.getSourceSampleRate()));
+        publishedPosition.store(positionInSeconds);
+        updatePlayhead(); // Keep waveforms in sync
+    }
+}
+
+// Animate turntable rotation and scroll the waveforms
+void DeckGUI::timerCallback()
+{
+    if (playing || jogging || scratchEngine.isTouched())
+    {
+        updatePlayhead();
+    }
+
+    // Controller moves reach the engine first; bring the controls into line afterwards
+    if (playing && !transportSource.isPlaying() && readerSource != nullptr)
+    {
+        if (transportSource.hasStreamFinished())
+        {
+            setPlaying(false);
+        }
+        else
+        {
+            transportSource.start();
+        }
+    }
+    if (playing != shownPlaying)
+    {
+        shownPlaying = playing;
+        playButton.setButtonText(shownPlaying ? "Stop" : "Play");
+    }
+    if (!volumeSlider.isMouseButtonDown() && static_cast<float>(volumeSlider.getValue()) != volume.load())
+    {
+        volumeSlider.setValue(volume.load(), juce::dontSendNotification);
+    }
+    if (!speedSlider.isMouseButtonDown() && static_cast<float>(speedSlider.getValue()) != speed.load())
+    {
+        speedSlider.setValue(speed.load(), juce::dontSendNotification);
+    }
+    cueButton.setToggleState(cueEnabled.load(), juce::dontSendNotification);
+
+    auto grid = beatAnalyser.getBeatGrid();
+    if (grid.bpm != shownBpm)
+    {
+        shownBpm = grid.bpm;
+        bpmLabel.setText(grid.isValid() ? juce::String(grid.bpm, 1) + " BPM" : juce::String(), juce::dontSendNotification);
+    }
+    loopButton.setToggleState(loopSource.isLooping() && !rolling, juce::dontSendNotification);
+    waveformDisplay.setDecodeProgress(cacheSource.isCaching() ? cacheSource.getCachedFraction() : -1.0f);
+
+    if (jogging)
+    {
+        // A hand resting still on the platter holds the record
+        if (juce::Time::getMillisecondCounterHiRes() - jogTime > 40.0)
+        {
+            scratchEngine.setTargetVelocity(0.0);
+        }
+    }
+    else if (scratchEngine.isTouched())
+    {
+        // Same for a controller platter that has stopped sending ticks
+        if (juce::Time::getMillisecondCounterHiRes() - lastMidiJogTime.load() > 40.0)
+        {
+            scratchEngine.setTargetVelocity(0.0);
+        }
+    }
+    else if (playing && transportSource.getTotalLength() > 0)
+    {
+        currentAngle += platterRadiansPerSecond * speed.load() * (16.0f / 1000.0f);
+        repaint();
+    }
+}
+
+// Grab the platter: the scratch engine takes over from the transport
+void DeckGUI::mouseDown(const juce::MouseEvent& event)
+{
+    auto centre = turntableBounds.getCentre().toFloat();
+    auto radius = turntableBounds.getWidth() * 0.5f;
+
+    if (readerSource == nullptr || event.position.getDistanceFrom(centre) > radius)
+    {
+        return;
+    }
+
+    jogging = true;
+    jogAngle = angleAroundPlatter(event.position);
+    jogTime = juce::Time::getMillisecondCounterHiRes();
+    scratchEngine.touch();
+}
+
+// Turn platter motion into a target playback velocity
+void DeckGUI::mouseDrag(const juce::MouseEvent& event)
+{
+    if (!jogging)
+    {
+        return;
+    }
+
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto angle = angleAroundPlatter(event.position);
+    auto delta = angle - jogAngle;
+
+    // Unwrap across the -pi/pi boundary
+    if (delta > juce::MathConstants<float>::pi)
+        delta -= juce::MathConstants<float>::twoPi;
+    else if (delta < -juce::MathConstants<float>::pi)
+        delta += juce::MathConstants<float>::twoPi;
+
+    auto elapsedSeconds = juce::jmax(0.001, (now - jogTime) / 1000.0);
+    scratchEngine.setTargetVelocity(delta / elapsedSeconds / platterRadiansPerSecond);
+
+    currentAngle += delta;
+    jogAngle = angle;
+    jogTime = now;
+    repaint();
+}
+
+// Let go of the platter: glide back to the deck's speed and hand back to the transport
+void DeckGUI::mouseUp(const juce::MouseEvent&)
+{
+    if (!jogging)
+    {
+        return;
+    }
+
+    jogging = false;
+    scratchEngine.release(playing ? speed.load() : 0.0f);
+    repaint();
+}
+
+float DeckGUI::angleAroundPlatter(juce::Point<float> point) const
+{
+    auto centre = turntableBounds.getCentre().toFloat();
+    return std::atan2(point.y - centre.y, point.x - centre.x);
+}
+
+juce::int64 DeckGUI::getPlayheadSample() const
+{
+    return static_cast<juce::int64>(publishedPosition.load() * loopSource.getSourceSampleRate());
+}
+
+// Beat length from the analysed tempo, or 120 BPM until the analysis is done
+juce::int64 DeckGUI::getLoopLengthSamples() const
+{
+    auto grid = beatAnalyser.getBeatGrid();
+    auto beatSeconds = grid.isValid() ? grid.getBeatSeconds() : 0.5;
+    auto beats = loopLengthSelector.getSelectedId() / 4.0;
+    return juce::jmax<juce::int64>(1, juce::roundToInt(beats * beatSeconds * loopSource.getSourceSampleRate()));
+}
+
+// Snap the playhead to the nearest beat so auto-loops and rolls stay on the grid
+juce::int64 DeckGUI::getQuantisedPlayheadSample() const
+{
+    auto seconds = beatAnalyser.getBeatGrid().nearestBeat(publishedPosition.load());
+    return static_cast<juce::int64>(seconds * loopSource.getSourceSampleRate());
+}
+
+// Auto-loop: start a loop of the selected length on the nearest beat, or leave the current one
+void DeckGUI::loopButtonClicked()
+{
+    if (readerSource == nullptr)
+    {
+        return;
+    }
+
+    if (loopSource.isLooping())
+    {
+        loopSource.clearLoop();
+    }
+    else
+    {
+        auto start = getQuantisedPlayheadSample();
+        loopSource.setLoop(start, start + getLoopLengthSamples());
+    }
+}
+
+// Loop roll: repeats while held, then playback continues as if it had never stopped
+void DeckGUI::rollStateChanged()
+{
+    auto held = rollButton.isDown();
+    if (held == rolling || readerSource == nullptr)
+    {
+        return;
+    }
+
+    rolling = held;
+    if (rolling)
+    {
+        auto start = getQuantisedPlayheadSample();
+        loopSource.startRoll(start, start + getLoopLengthSamples());
+    }
+    else
+    {
+        loopSource.clearLoop();
+    }
+}
+
+// Rotary knob with a caption; double-click returns it to its initial value
+void DeckGUI::setupKnob(juce::Slider& knob, juce::Label& label, const juce::String& name,
+                        double minimum, double maximum, double initial)
+{
+    addAndMakeVisible(knob);
+    addAndMakeVisible(label);
+
+    knob.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    knob.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    knob.setRange(minimum, maximum);
+    knob.setValue(initial, juce::dontSendNotification);
+    knob.setDoubleClickReturnValue(true, initial);
+    knob.setColour(juce::Slider::rotarySliderFillColourId, juce::Colours::orange);
+    knob.addListener(this);
+
+    label.setText(name, juce::dontSendNotification);
+    label.setFont(juce::FontOptions(12.0f));
+    label.setJustificationType(juce::Justification::centred);
+}
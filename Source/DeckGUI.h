@@ -1,78 +1,152 @@
-/*
-  ==============================================================================
-
-    This file defines the DeckGUI class for a JUCE application,
-    handling audio playback controls and UI for a single deck.
-
-  ==============================================================================
-*/
-
-#pragma once
-#include <JuceHeader.h>
-#include "WaveformDisplay.h"
-
-// DeckGUI: Controls audio playback and UI for a single deck
-class DeckGUI : public juce::Component,
-                public juce::Button::Listener,
-                public juce::Slider::Listener,
-                public juce::Timer
-{
-//==============================================================================
-public:
-    DeckGUI(int _id,
-            juce::AudioFormatManager& formatManagerToUse,
-            juce::AudioThumbnailCache& cacheToUse);
-    ~DeckGUI() override;
-
-    void paint(juce::Graphics&) override;
-    void resized() override;
-    void buttonClicked(juce::Button* button) override;
-    void sliderValueChanged(juce::Slider* slider) override;
-
-    void loadFile(const juce::File& file); // Load audio file into deck
-    bool isPlaying() { return playing; }
-    
-    // Audio processing methods
-    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
-    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill);
-    void releaseResources();
-    float getVolume() const { return volume; }
-    float& getVolume() { return volume; }
-    double getPosition() const { return transportSource.getCurrentPosition(); }
-
-    void updatePlayhead(); // Sync waveform playhead with transport
-    void setTransportPosition(double positionInSeconds); // Set playback position
-
-//==============================================================================
-private:
-    int id;
-    bool playing = false;
-    float volume = 1.0f;
-    float speed = 1.0f;
-    float currentAngle = 0.0f;
-
-    juce::TextButton playButton{"Play"};
-    juce::Slider volumeSlider;
-    juce::Slider speedSlider;
-    juce::Label volumeLabel;
-    juce::Label speedLabel;
-    juce::AudioFormatManager formatManager;
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-    juce::AudioTransportSource transportSource;
-    juce::ResamplingAudioSource resampleSource{&transportSource, false, 2};
-    WaveformDisplay waveformDisplay;
-
-    class SliderLookAndFeel : public juce::LookAndFeel_V4
-    {
-    public:
-        void drawLinearSlider(juce::Graphics&, int x, int y, int width, int height,
-                            float sliderPos, float minSliderPos, float maxSliderPos,
-                            const juce::Slider::SliderStyle, juce::Slider&) override;
-    };
-    
-    SliderLookAndFeel sliderLookAndFeel;
-
-    void timerCallback() override; // Update turntable animation
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckGUI)
-};
+/*
+  ==============================================================================
+
+    This file defines the DeckGUI class for a JUCE application,
+    handling audio playback controls and UI for a single deck.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "WaveformDisplay.h"
+#include "ScrollingWaveform.h"
+#include "MeterSource.h"
+#include "LevelMeter.h"
+#include "SpectrumDisplay.h"
+#include "ScratchEngine.h"
+#include "DeckEQ.h"
+#include "EffectsRack.h"
+#include "LoopSource.h"
+#include "BeatAnalyser.h"
+#include "AnalysisCache.h"
+#include "PcmCacheSource.h"
+#include "PolyphaseResampler.h"
+#include "EngineCommandQueue.h"
+#include "DecodePipeline.h"
+
+// DeckGUI: Controls audio playback and UI for a single deck
+class DeckGUI : public juce::Component,
+                public juce::Button::Listener,
+                public juce::Slider::Listener,
+                public juce::Timer
+{
+//==============================================================================
+public:
+    DeckGUI(int _id,
+            juce::AudioFormatManager& formatManagerToUse,
+            juce::AudioThumbnailCache& cacheToUse);
+    ~DeckGUI() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void buttonClicked(juce::Button* button) override;
+    void sliderValueChanged(juce::Slider* slider) override;
+
+    // Turntable jog wheel
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseDrag(const juce::MouseEvent& event) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+
+    void loadFile(const juce::File& file); // Load audio file into deck
+    bool isPlaying() { return playing.load(); }
+    void setPlaying(bool shouldPlay);
+    bool isCueEnabled() const noexcept { return cueEnabled.load(); } // PFL: send to the cue bus
+    void setCueEnabled(bool shouldCue);
+    void applyCommand(const EngineCommand& command) noexcept; // Audio thread: a controller move
+    
+    // Audio processing methods
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+    void releaseResources();
+    float getVolume() const { return volume.load(); } // Channel fader, applied by the Mixer
+    double getPosition() const { return publishedPosition.load(); } // In file seconds, whatever the device rate
+    double getLengthInSeconds() const;
+    juce::File getLoadedFile() const { return loadedFile; }
+
+    void updatePlayhead(); // Sync waveform views with the published playhead
+    void setTransportPosition(double positionInSeconds); // Set playback position
+    void setMemoryBudget(MemoryBudget* budget); // Charges the deck's caches and buffers, pinned
+    void setAnalysisCache(AnalysisCache* cache); // Before the first load: loaded tracks are analysed from the deck's decode
+    void stopDecoding() { decodePipeline.stop(); } // Before the analysis cache is destroyed
+
+//==============================================================================
+private:
+    int id;
+    juce::File loadedFile;
+    std::atomic<bool> playing{false};
+    std::atomic<bool> trackLoaded{false};       // Set once the transport has its source; the audio thread tests this, not readerSource
+    std::atomic<double> publishedPosition{0.0}; // Written by the audio thread after each block
+    std::atomic<bool> cueEnabled{false};
+    std::atomic<float> volume{1.0f};
+    std::atomic<float> speed{1.0f};
+    std::atomic<double> lastMidiJogTime{0.0};   // Milliseconds; a still controller platter holds the record
+    juce::SmoothedValue<float> playFade;        // Audio thread: de-clicks play and stop
+    bool shownPlaying = false;
+    float currentAngle = 0.0f;
+
+    juce::TextButton playButton{"Play"};
+    juce::TextButton cueButton{"Cue"};
+    juce::Slider volumeSlider;
+    juce::Slider speedSlider;
+    juce::Label volumeLabel;
+    juce::Label speedLabel;
+    juce::Slider lowSlider, midSlider, highSlider, filterSlider, fxMixSlider;
+    juce::Label lowLabel, midLabel, highLabel, filterLabel, fxMixLabel;
+    juce::TextButton effectButtons[EffectsRack::numEffects];
+    juce::TextButton loopInButton{"In"};
+    juce::TextButton loopOutButton{"Out"};
+    juce::TextButton loopButton{"Loop"};
+    juce::TextButton rollButton{"Roll"};
+    juce::ComboBox loopLengthSelector;
+    juce::Label bpmLabel;
+    juce::AudioFormatManager& formatManager; // Shared; formats are registered once by MainComponent
+    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+    PcmCacheSource cacheSource;
+    juce::AudioTransportSource transportSource;
+    LoopSource loopSource;
+    PolyphaseResampler resampleSource{&loopSource}; // File rate -> device rate, times the pitch fader
+    WaveformDisplay waveformDisplay;
+    ScrollingWaveform scrollingWaveform;
+    MeterSource meterSource;
+    LevelMeter levelMeter{meterSource};
+    SpectrumDisplay spectrumDisplay{meterSource};
+    ScratchEngine scratchEngine;
+    DeckEQ deckEQ;
+    EffectsRack effectsRack;
+    BeatAnalyser beatAnalyser;
+    std::unique_ptr<AnalysisCache::Analyser> trackAnalyser;
+    DecodePipeline decodePipeline; // After its consumers, so it stops before they are destroyed
+    double shownBpm = -1.0;
+    juce::int64 loopInSample = -1;
+    bool rolling = false;
+    juce::Rectangle<int> turntableBounds;
+
+    bool jogging = false;
+    float jogAngle = 0.0f;  // Mouse angle around the platter centre at the last drag
+    double jogTime = 0.0;   // Time of the last drag, in milliseconds
+    static constexpr float platterRadiansPerSecond = 0.5f * juce::MathConstants<float>::pi; // At normal speed
+
+    float angleAroundPlatter(juce::Point<float> point) const;
+    juce::int64 getPlayheadSample() const; // Published playhead in source samples
+    juce::int64 getLoopLengthSamples() const; // Selected beat count on the analysed grid
+    juce::int64 getQuantisedPlayheadSample() const;
+    void loopButtonClicked();
+    void rollStateChanged();
+    void setupKnob(juce::Slider& knob, juce::Label& label, const juce::String& name,
+                   double minimum, double maximum, double initial);
+
+    class SliderLookAndFeel : public juce::LookAndFeel_V4
+    {
+    public:
+        void drawLinearSlider(juce::Graphics&, int x, int y, int width, int height,
+                            float sliderPos, float minSliderPos, float maxSliderPos,
+                            const juce::Slider::SliderStyle, juce::Slider&) override;
+    };
+    
+    SliderLookAndFeel sliderLookAndFeel;
+
+    void timerCallback() override; // Update turntable animation
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckGUI)
+};
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the DecodePipeline class for a JUCE application,
+    reading a track front to back in large blocks and fanning them out to its consumers.
+
+  ==============================================================================
+*/
+
+#include "DecodePipeline.h"
+
+DecodePipeline::DecodePipeline(juce::AudioFormatManager& formatManagerToUse)
+    : juce::Thread("Deck decoder"), formatManager(formatManagerToUse)
+{
+}
+
+DecodePipeline::~DecodePipeline()
+{
+    stop();
+}
+
+void DecodePipeline::addConsumer(Consumer* consumer)
+{
+    jassert(!isThreadRunning());
+    consumers.addIfNotAlreadyThere(consumer);
+}
+
+void DecodePipeline::start(const juce::File& file)
+{
+    stop();
+    sourceFile = file;
+    startThread(juce::Thread::Priority::low);
+}
+
+void DecodePipeline::stop()
+{
+    stopThread(4000);
+}
+
+// Pipeline thread
+void DecodePipeline::run()
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
+    if (reader == nullptr)
+    {
+        for (auto* consumer : consumers)
+        {
+            consumer->decodeFinished(false);
+        }
+        return;
+    }
+
+    decodeNow(*reader, consumers, [this] { return threadShouldExit(); });
+}
+
+// Ask each consumer how much it wants, then decode up to the largest request
+bool DecodePipeline::decodeNow(juce::AudioFormatReader& reader, const juce::Array<Consumer*>& consumersToFeed,
+                               const std::function<bool()>& shouldExit)
+{
+    if (reader.lengthInSamples <= 0)
+    {
+        for (auto* consumer : consumersToFeed)
+        {
+            consumer->decodeFinished(false);
+        }
+        return false;
+    }
+
+    std::vector<juce::int64> wanted;
+    juce::int64 length = 0;
+    for (auto* consumer : consumersToFeed)
+    {
+        wanted.push_back(juce::jmin(reader.lengthInSamples, consumer->decodeStarting(reader)));
+        length = juce::jmax(length, wanted.back());
+    }
+
+    juce::AudioBuffer<float> block(2, static_cast<int>(juce::jmin(static_cast<juce::int64>(blockFrames), juce::jmax<juce::int64>(1, length))));
+    juce::int64 start = 0;
+    for (; start < length && !shouldExit(); start += blockFrames)
+    {
+        auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockFrames), length - start));
+        if (!reader.read(&block, 0, numSamples, start, true, true)) // A mono file fills both channels
+        {
+            break;
+        }
+
+        for (int i = 0; i < consumersToFeed.size(); ++i)
+        {
+            auto limit = wanted[static_cast<size_t>(i)];
+            if (start < limit)
+            {
+                consumersToFeed.getUnchecked(i)->decodedBlock(block, start, static_cast<int>(juce::jmin(static_cast<juce::int64>(numSamples), limit - start)));
+            }
+        }
+    }
+
+    auto allComplete = true;
+    for (int i = 0; i < consumersToFeed.size(); ++i)
+    {
+        auto complete = wanted[static_cast<size_t>(i)] > 0 && start >= wanted[static_cast<size_t>(i)];
+        consumersToFeed.getUnchecked(i)->decodeFinished(complete);
+        allComplete = allComplete && (complete || wanted[static_cast<size_t>(i)] == 0);
+    }
+    return allComplete;
+}
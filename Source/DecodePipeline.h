@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    This file defines the DecodePipeline class for a JUCE application,
+    decoding a loaded track once and handing every block to all of its consumers.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// DecodePipeline: One background decode per deck. Each block read from the file is passed
+// in order to every consumer that asked for it (the PCM cache, the overview thumbnail, the
+// scrolling peaks and the beat analyser), so a track is decoded once however many views
+// and analysers want it. The pipeline stops reading once the consumer wanting the most
+// frames has them all. decodeNow() runs the same loop on the caller's thread, which is how
+// the library and batch analysis feed several consumers from one decode.
+class DecodePipeline : private juce::Thread
+{
+//==============================================================================
+public:
+    // Consumer: Everything is called on the pipeline thread, in file order
+    class Consumer
+    {
+    public:
+        virtual ~Consumer() = default;
+        virtual juce::int64 decodeStarting(const juce::AudioFormatReader& reader) = 0; // Frames wanted from the start; 0 sits this file out
+        virtual void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) = 0; // Always two channels
+        virtual void decodeFinished(bool complete) { juce::ignoreUnused(complete); } // False if the file changed or could not be read
+    };
+
+    explicit DecodePipeline(juce::AudioFormatManager& formatManagerToUse);
+    ~DecodePipeline() override;
+
+    void addConsumer(Consumer* consumer); // Before the first start()
+    void start(const juce::File& file);   // Stops any decode in progress first
+    void stop();                          // Returns once no consumer is being called
+
+    // Blocking: one pass over the reader for all the consumers; false if stopped early or unreadable
+    static bool decodeNow(juce::AudioFormatReader& reader, const juce::Array<Consumer*>& consumersToFeed,
+                          const std::function<bool()>& shouldExit);
+
+    static constexpr int blockFrames = 65536; // A multiple of every consumer's frame size
+
+//==============================================================================
+private:
+    juce::AudioFormatManager& formatManager;
+    juce::Array<Consumer*> consumers;
+    juce::File sourceFile;
+
+    void run() override; // Pipeline thread
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodePipeline)
+};
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the DelayLinePool class for a JUCE application,
+    lending preallocated delay lines to effects without touching the allocator.
+
+  ==============================================================================
+*/
+
+#include "DelayLinePool.h"
+
+void DelayLinePool::Line::push(float left, float right) noexcept
+{
+    buffer.setSample(0, writePosition, left);
+    buffer.setSample(1, writePosition, right);
+
+    if (++writePosition == buffer.getNumSamples())
+    {
+        writePosition = 0;
+    }
+    numWritten = juce::jmin(numWritten + 1, buffer.getNumSamples());
+}
+
+// Linear-interpolated tap; a delay of 1 is the most recently pushed sample
+float DelayLinePool::Line::read(int channel, float delayInSamples) const noexcept
+{
+    if (delayInSamples < 1.0f || delayInSamples > static_cast<float>(numWritten))
+    {
+        return 0.0f; // Not written since this line was acquired, so it would be stale data
+    }
+
+    auto size = buffer.getNumSamples();
+    auto position = static_cast<float>(writePosition) - delayInSamples;
+    if (position < 0.0f)
+    {
+        position += static_cast<float>(size);
+    }
+
+    auto index = juce::jmin(size - 1, static_cast<int>(position));
+    auto fraction = position - static_cast<float>(index);
+    auto next = index + 1 == size ? 0 : index + 1;
+    auto* data = buffer.getReadPointer(channel);
+    return data[index] + fraction * (data[next] - data[index]);
+}
+
+void DelayLinePool::prepare(int numLines, int maximumDelaySamples)
+{
+    lines.clear();
+    for (int i = 0; i < numLines; ++i)
+    {
+        auto* line = lines.add(new Line());
+        line->buffer.setSize(2, juce::jmax(2, maximumDelaySamples));
+        line->buffer.clear();
+    }
+}
+
+// Hand out a free line. Stale contents are masked by numWritten instead of clearing
+// the whole buffer, which keeps acquire() constant-time.
+DelayLinePool::Line* DelayLinePool::acquire() noexcept
+{
+    for (auto* line : lines)
+    {
+        if (!line->inUse)
+        {
+            line->inUse = true;
+            line->writePosition = 0;
+            line->numWritten = 0;
+            return line;
+        }
+    }
+    return nullptr;
+}
+
+void DelayLinePool::release(Line* line) noexcept
+{
+    if (line != nullptr)
+    {
+        line->inUse = false;
+    }
+}
+
+size_t DelayLinePool::getBytesAllocated() const noexcept
+{
+    size_t total = 0;
+    for (auto* line : lines)
+    {
+        total += static_cast<size_t>(line->buffer.getNumChannels() * line->buffer.getNumSamples()) * sizeof(float);
+    }
+    return total;
+}
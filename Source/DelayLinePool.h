@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    This file defines the DelayLinePool class for a JUCE application,
+    a fixed set of stereo delay lines allocated up front and lent to effects.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// DelayLinePool: Allocates its lines in prepare(); acquire() and release() only
+// flip ownership flags, so effects can start and stop on the audio thread.
+class DelayLinePool
+{
+//==============================================================================
+public:
+    // Line: Stereo circular buffer owned by one effect at a time
+    class Line
+    {
+    public:
+        void push(float left, float right) noexcept;
+        float read(int channel, float delayInSamples) const noexcept; // Silence beyond what was written since acquire
+        int getCapacity() const noexcept { return buffer.getNumSamples(); }
+
+    private:
+        friend class DelayLinePool;
+        juce::AudioBuffer<float> buffer;
+        int writePosition = 0;
+        int numWritten = 0;
+        bool inUse = false;
+    };
+
+    void prepare(int numLines, int maximumDelaySamples); // Allocates: call from prepareToPlay only
+    Line* acquire() noexcept;                            // nullptr when every line is lent out
+    void release(Line* line) noexcept;
+    size_t getBytesAllocated() const noexcept;
+
+//==============================================================================
+private:
+    juce::OwnedArray<Line> lines;
+};
@@ -0,0 +1,476 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the DuplicateFinder class for a JUCE application,
+    running fingerprint jobs on a thread pool and grouping near-identical fingerprints.
+
+  ==============================================================================
+*/
+
+#include "DuplicateFinder.h"
+
+namespace
+{
+    constexpr int indexedFrames = 64;   // Opening frames of each track that go into the hash index
+    constexpr int searchSlack = 16;     // Query frames beyond those, for copies that start a little later
+    constexpr size_t maxPostings = 32;  // Hashes shared by more tracks than this are silence or noise
+    constexpr int maxAlignmentsPerPair = 8; // Distinct offsets tried per candidate before giving up on it
+    constexpr juce::uint32 cacheMagic = 0x31504641; // "AFP1"
+
+    // Footprint of one cache entry, including its map node and path
+    template <typename EntryType>
+    size_t entryBytes(const juce::String& path, const EntryType& entry)
+    {
+        return sizeof(EntryType) + 64 + path.getNumBytesAsUTF8() + entry.print.frames.size() * sizeof(juce::uint32);
+    }
+}
+
+DuplicateFinder::DuplicateFinder(juce::AudioFormatManager& formatManagerToUse)
+    : formatManager(formatManagerToUse),
+      pool(juce::ThreadPoolOptions{}
+               .withThreadName("Fingerprinter")
+               .withNumberOfThreads(juce::jmax(1, juce::SystemStats::getNumCpus() - 1)) // Leave a core for audio
+               .withDesiredThreadPriority(juce::Thread::Priority::low))
+{
+    cacheFile = getCacheFile();
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    cancelled.store(true);
+    pool.removeAllJobs(true, 10000);
+    cancelPendingUpdate();
+    setMemoryBudget(nullptr);
+}
+
+void DuplicateFinder::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::fingerprints, scanning.load());
+        size_t held;
+        {
+            const juce::ScopedLock sl(lock);
+            held = approxBytes;
+        }
+        memoryBudget->charge(this, held); // Outside the lock: charging may evict other caches
+    }
+}
+
+juce::File DuplicateFinder::getCacheFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("fingerprints.bin");
+}
+
+bool DuplicateFinder::scan(const juce::Array<juce::File>& tracks)
+{
+    if (scanning.exchange(true))
+    {
+        return false;
+    }
+
+    cancelled.store(false);
+    jobsTotal.store(0);
+    jobsRemaining.store(0);
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->setPinned(this, true); // Grouping holds pointers into the entries
+    }
+    pool.addJob([this, tracks] { startScan(tracks); });
+    return true;
+}
+
+float DuplicateFinder::getProgress() const noexcept
+{
+    auto total = jobsTotal.load();
+    if (total == 0)
+    {
+        return scanning.load() ? 0.0f : 1.0f;
+    }
+    return 1.0f - static_cast<float>(jobsRemaining.load()) / static_cast<float>(total);
+}
+
+std::vector<juce::Array<juce::File>> DuplicateFinder::getGroups() const
+{
+    const juce::ScopedLock sl(lock);
+    return groups;
+}
+
+// Stat every track off the message thread and queue the ones whose fingerprint is missing or stale
+void DuplicateFinder::startScan(juce::Array<juce::File> tracks)
+{
+    bool needsLoad;
+    {
+        const juce::ScopedLock sl(lock);
+        needsLoad = !cacheLoaded;
+    }
+    if (needsLoad)
+    {
+        load();
+    }
+
+    juce::Array<juce::File> stale;
+    for (const auto& track : tracks)
+    {
+        if (cancelled.load())
+        {
+            finishScan();
+            return;
+        }
+
+        auto size = track.getSize();
+        auto modified = track.getLastModificationTime().toMilliseconds();
+        const juce::ScopedLock sl(lock);
+        auto it = entries.find(track.getFullPathName());
+        if (it == entries.end() || it->second.fileSize != size || it->second.modified != modified)
+        {
+            stale.add(track);
+        }
+    }
+
+    {
+        const juce::ScopedLock sl(lock);
+        scanTracks.swapWith(tracks);
+    }
+
+    jobsTotal.store(stale.size());
+    jobsRemaining.store(stale.size());
+    triggerAsyncUpdate();
+
+    if (stale.isEmpty())
+    {
+        finishScan();
+        return;
+    }
+
+    for (const auto& file : stale)
+    {
+        pool.addJob([this, file] { fingerprint(file); });
+    }
+}
+
+void DuplicateFinder::fingerprint(const juce::File& file)
+{
+    if (!cancelled.load())
+    {
+        Entry entry;
+        entry.fileSize = file.getSize();
+        entry.modified = file.getLastModificationTime().toMilliseconds();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader != nullptr)
+        {
+            AudioFingerprint::compute(*reader, [this] { return cancelled.load(); }, entry.print);
+        }
+
+        if (!cancelled.load())
+        {
+            auto path = file.getFullPathName();
+            auto added = entryBytes(path, entry);
+            size_t removed = 0;
+            {
+                const juce::ScopedLock sl(lock);
+                auto it = entries.find(path);
+                if (it != entries.end())
+                {
+                    removed = entryBytes(path, it->second);
+                }
+                entries[path] = std::move(entry); // Unreadable files are cached too, empty
+                dirty = true;
+            }
+            chargeEntries(added, removed);
+        }
+    }
+
+    triggerAsyncUpdate();
+    if (--jobsRemaining == 0)
+    {
+        finishScan();
+    }
+}
+
+void DuplicateFinder::finishScan()
+{
+    if (cancelled.load())
+    {
+        if (memoryBudget != nullptr)
+        {
+            memoryBudget->setPinned(this, false);
+        }
+        scanning.store(false);
+        return;
+    }
+
+    save();
+
+    // No fingerprint is written while scanning is set, so the pointers stay valid outside the lock
+    std::vector<const AudioFingerprint*> prints;
+    juce::Array<juce::File> files;
+    {
+        const juce::ScopedLock sl(lock);
+        for (const auto& track : scanTracks)
+        {
+            auto it = entries.find(track.getFullPathName());
+            if (it != entries.end() && it->second.print.isValid())
+            {
+                prints.push_back(&it->second.print);
+                files.add(track);
+            }
+        }
+    }
+
+    std::vector<juce::Array<juce::File>> found;
+    for (const auto& group : findGroups(prints))
+    {
+        juce::Array<juce::File> groupFiles;
+        for (auto index : group)
+        {
+            groupFiles.add(files.getReference(index));
+        }
+        found.push_back(std::move(groupFiles));
+    }
+
+    {
+        const juce::ScopedLock sl(lock);
+        groups.swap(found);
+    }
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->setPinned(this, false);
+    }
+    scanning.store(false);
+    triggerAsyncUpdate();
+}
+
+// Fingerprints are only needed while scanning; between scans the disk cache has them all
+size_t DuplicateFinder::evict(size_t)
+{
+    size_t freed = 0;
+    {
+        const juce::ScopedLock sl(lock);
+        if (scanning.load() || dirty)
+        {
+            return 0;
+        }
+
+        entries.clear();
+        cacheLoaded = false;
+        freed = approxBytes;
+        approxBytes = 0;
+    }
+
+    memoryBudget->release(this, freed);
+    return freed;
+}
+
+// Called without the lock held, since charging may evict other caches
+void DuplicateFinder::chargeEntries(size_t added, size_t removed)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        approxBytes += added;
+        approxBytes -= juce::jmin(removed, approxBytes);
+    }
+
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->charge(this, added);
+        memoryBudget->release(this, removed);
+    }
+}
+
+std::vector<std::vector<int>> DuplicateFinder::findGroups(const std::vector<const AudioFingerprint*>& prints,
+                                                          float maxBitErrorRate)
+{
+    struct Posting
+    {
+        juce::uint32 hash;
+        int track;
+        int frame;
+        bool operator<(const Posting& other) const noexcept { return hash < other.hash; }
+    };
+
+    auto numTracks = static_cast<int>(prints.size());
+    std::vector<Posting> index;
+    index.reserve(prints.size() * indexedFrames);
+    for (int track = 0; track < numTracks; ++track)
+    {
+        auto numFrames = juce::jmin(indexedFrames, static_cast<int>(prints[static_cast<size_t>(track)]->frames.size()));
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            index.push_back({ prints[static_cast<size_t>(track)]->frames[static_cast<size_t>(frame)], track, frame });
+        }
+    }
+    std::sort(index.begin(), index.end());
+
+    // Union-find over verified matches, so A~B and B~C put all three in one group
+    std::vector<int> parent(prints.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto root = [&parent](int track)
+    {
+        while (parent[static_cast<size_t>(track)] != track)
+        {
+            parent[static_cast<size_t>(track)] = parent[static_cast<size_t>(parent[static_cast<size_t>(track)])];
+            track = parent[static_cast<size_t>(track)];
+        }
+        return track;
+    };
+
+    // A spurious shared hash must not stop the true alignment being tried later, so each
+    // candidate is compared once per distinct offset, up to a few offsets
+    std::set<std::pair<int, int>> triedAlignments; // (other, offset) pairs, for the current track
+    std::map<int, int> alignmentsTried;            // Per other track, for the current track
+    for (int track = 0; track < numTracks; ++track)
+    {
+        const auto& print = *prints[static_cast<size_t>(track)];
+        auto numFrames = juce::jmin(indexedFrames + searchSlack, static_cast<int>(print.frames.size()));
+        triedAlignments.clear();
+        alignmentsTried.clear();
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            Posting probe{ print.frames[static_cast<size_t>(frame)], 0, 0 };
+            auto range = std::equal_range(index.begin(), index.end(), probe);
+            if (static_cast<size_t>(range.second - range.first) > maxPostings)
+            {
+                continue;
+            }
+
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                auto other = it->track;
+                auto offset = frame - it->frame;
+                if (other <= track || root(other) == root(track)
+                    || alignmentsTried[other] >= maxAlignmentsPerPair
+                    || !triedAlignments.insert({ other, offset }).second)
+                {
+                    continue;
+                }
+                ++alignmentsTried[other];
+
+                auto errors = 1.0f;
+                for (auto nudge : { 0, -1, 1 })
+                {
+                    errors = juce::jmin(errors, print.bitErrorRate(*prints[static_cast<size_t>(other)], offset + nudge));
+                }
+
+                if (errors <= maxBitErrorRate)
+                {
+                    parent[static_cast<size_t>(root(other))] = root(track);
+                }
+            }
+        }
+    }
+
+    std::map<int, std::vector<int>> byRoot; // Ordered by root, so groups keep library order
+    for (int track = 0; track < numTracks; ++track)
+    {
+        byRoot[root(track)].push_back(track);
+    }
+
+    std::vector<std::vector<int>> result;
+    for (auto& [groupRoot, members] : byRoot)
+    {
+        if (members.size() > 1)
+        {
+            result.push_back(std::move(members));
+        }
+    }
+    return result;
+}
+
+void DuplicateFinder::handleAsyncUpdate()
+{
+    if (onProgress)
+    {
+        onProgress();
+    }
+}
+
+void DuplicateFinder::load()
+{
+    std::unordered_map<juce::String, Entry> loaded;
+    juce::FileInputStream stream(cacheFile);
+
+    if (stream.openedOk() && static_cast<juce::uint32>(stream.readInt()) == cacheMagic)
+    {
+        auto count = stream.readInt();
+        for (int i = 0; i < count && !stream.isExhausted(); ++i)
+        {
+            auto path = stream.readString();
+            Entry entry;
+            entry.fileSize = stream.readInt64();
+            entry.modified = stream.readInt64();
+            auto numFrames = juce::jlimit(0, AudioFingerprint::maxFrames, stream.readInt());
+            entry.print.frames.resize(static_cast<size_t>(numFrames));
+            for (auto& frame : entry.print.frames)
+            {
+                frame = static_cast<juce::uint32>(stream.readInt());
+            }
+            loaded[path] = std::move(entry);
+        }
+    }
+
+    size_t added = 0;
+    {
+        const juce::ScopedLock sl(lock);
+        for (auto& [path, entry] : loaded)
+        {
+            auto bytes = entryBytes(path, entry);
+            if (entries.emplace(path, std::move(entry)).second)
+            {
+                added += bytes;
+            }
+        }
+        cacheLoaded = true;
+    }
+    chargeEntries(added, 0);
+}
+
+// Written whole to a temporary file, so an interrupted save leaves the old cache intact
+void DuplicateFinder::save()
+{
+    cacheFile.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp(cacheFile);
+    {
+        juce::FileOutputStream stream(temp.getFile());
+        if (!stream.openedOk())
+        {
+            return;
+        }
+
+        const juce::ScopedLock sl(lock);
+        if (!dirty)
+        {
+            return;
+        }
+
+        stream.writeInt(static_cast<int>(cacheMagic));
+        stream.writeInt(static_cast<int>(entries.size()));
+        for (const auto& [path, entry] : entries)
+        {
+            stream.writeString(path);
+            stream.writeInt64(entry.fileSize);
+            stream.writeInt64(entry.modified);
+            stream.writeInt(static_cast<int>(entry.print.frames.size()));
+            for (auto frame : entry.print.frames)
+            {
+                stream.writeInt(static_cast<int>(frame));
+            }
+        }
+        dirty = false;
+    }
+
+    if (!temp.overwriteTargetFileWithTemporary())
+    {
+        DBG("Failed to save fingerprints to " << cacheFile.getFullPathName());
+    }
+}
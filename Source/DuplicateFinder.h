@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    This file defines the DuplicateFinder class for a JUCE application,
+    fingerprinting the library in parallel and grouping copies of the same recording.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "AudioFingerprint.h"
+#include "MemoryBudget.h"
+
+// DuplicateFinder: Fingerprints tracks on a pool with a worker per spare core, caching the
+// results on disk by path, size and modification time. Grouping looks up each track's
+// opening sub-fingerprints in a sorted hash index, so only tracks sharing an exact 32-bit
+// frame are compared bit by bit; that keeps 100k tracks to seconds rather than n^2 work.
+// Between scans the fingerprints may be evicted; the next scan reads them back from disk.
+class DuplicateFinder : private juce::AsyncUpdater,
+                        private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    explicit DuplicateFinder(juce::AudioFormatManager& formatManagerToUse);
+    ~DuplicateFinder() override;
+
+    bool scan(const juce::Array<juce::File>& tracks); // False if a scan is already running
+    bool isScanning() const noexcept { return scanning.load(); }
+    float getProgress() const noexcept;               // Fingerprinting progress of the current scan
+    std::vector<juce::Array<juce::File>> getGroups() const; // Two or more files each, from the last scan
+
+    // Indices of fingerprints that match within maxBitErrorRate, grouped transitively
+    static std::vector<std::vector<int>> findGroups(const std::vector<const AudioFingerprint*>& prints,
+                                                    float maxBitErrorRate = 0.3f);
+
+    static juce::File getCacheFile();
+    void setMemoryBudget(MemoryBudget* budgetToUse);
+
+    std::function<void()> onProgress; // Message thread, coalesced; the last call follows the grouping
+
+//==============================================================================
+private:
+    struct Entry
+    {
+        juce::int64 fileSize = 0;
+        juce::int64 modified = 0;
+        AudioFingerprint print;    // Empty if the file could not be fingerprinted
+    };
+
+    juce::AudioFormatManager& formatManager;
+    juce::File cacheFile;
+    juce::ThreadPool pool;
+
+    mutable juce::CriticalSection lock;
+    std::unordered_map<juce::String, Entry> entries; // By full path
+    juce::Array<juce::File> scanTracks;
+    std::vector<juce::Array<juce::File>> groups;
+    bool cacheLoaded = false;
+    bool dirty = false;
+    size_t approxBytes = 0; // Of entries, as charged to the budget
+    MemoryBudget* memoryBudget = nullptr;
+
+    std::atomic<bool> scanning{false};
+    std::atomic<bool> cancelled{false};
+    std::atomic<int> jobsTotal{0};
+    std::atomic<int> jobsRemaining{0};
+
+    void startScan(juce::Array<juce::File> tracks); // Pool thread: work out what needs fingerprinting
+    void fingerprint(const juce::File& file);       // Pool thread
+    void finishScan();                              // Pool thread, after the last fingerprint
+    void handleAsyncUpdate() override;
+    size_t evict(size_t bytesWanted) override;
+    void chargeEntries(size_t added, size_t removed);
+
+    void load(); // Binary: a large library's fingerprints are tens of megabytes
+    void save();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DuplicateFinder)
+};
@@ -0,0 +1,543 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the EffectsRack class for a JUCE application,
+    including the individual effects and the tail handling that lets them finish naturally.
+
+  ==============================================================================
+*/
+
+#include "EffectsRack.h"
+#include "Benchmarks.h"
+
+namespace
+{
+    constexpr int poolLines = 4;              // Echo, ping-pong and flanger each hold one, plus a spare
+    constexpr double maximumDelaySeconds = 2.0;
+    constexpr float tailThreshold = 1.0e-4f;  // -80 dBFS: below this a tail is considered finished
+    constexpr double tailHoldSeconds = 0.25;  // Tail must stay below the threshold this long
+
+    // Echo: Stereo feedback delay with a damped feedback path
+    class Echo : public EffectsRack::RackEffect
+    {
+    public:
+        void prepare(double sampleRate) override
+        {
+            delaySamples = static_cast<float>(0.375 * sampleRate);
+        }
+
+        bool start(DelayLinePool& pool) noexcept override
+        {
+            line = pool.acquire();
+            dampedLeft = dampedRight = 0.0f;
+            return line != nullptr;
+        }
+
+        void stop(DelayLinePool& pool) noexcept override
+        {
+            pool.release(line);
+            line = nullptr;
+        }
+
+        void process(const float* left, const float* right, float* wetLeft, float* wetRight, const float* inputGain,
+                     int numSamples) noexcept override
+        {
+            wetPeak = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delayedLeft = line->read(0, delaySamples);
+                auto delayedRight = line->read(1, delaySamples);
+                dampedLeft += damping * (delayedLeft - dampedLeft);
+                dampedRight += damping * (delayedRight - dampedRight);
+
+                line->push(left[i] * inputGain[i] + feedback * dampedLeft,
+                           right[i] * inputGain[i] + feedback * dampedRight);
+
+                wetLeft[i] = delayedLeft;
+                wetRight[i] = delayedRight;
+                wetPeak = juce::jmax(wetPeak, std::abs(delayedLeft), std::abs(delayedRight));
+            }
+        }
+
+        bool hasTail() const noexcept override { return true; }
+
+    private:
+        DelayLinePool::Line* line = nullptr;
+        float delaySamples = 0.0f;
+        float dampedLeft = 0.0f, dampedRight = 0.0f;
+        static constexpr float feedback = 0.45f;
+        static constexpr float damping = 0.35f;
+    };
+
+    // PingPong: Mono input bouncing between the left and right delay taps
+    class PingPong : public EffectsRack::RackEffect
+    {
+    public:
+        void prepare(double sampleRate) override
+        {
+            delaySamples = static_cast<float>(0.25 * sampleRate);
+        }
+
+        bool start(DelayLinePool& pool) noexcept override
+        {
+            line = pool.acquire();
+            return line != nullptr;
+        }
+
+        void stop(DelayLinePool& pool) noexcept override
+        {
+            pool.release(line);
+            line = nullptr;
+        }
+
+        void process(const float* left, const float* right, float* wetLeft, float* wetRight, const float* inputGain,
+                     int numSamples) noexcept override
+        {
+            wetPeak = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delayedLeft = line->read(0, delaySamples);
+                auto delayedRight = line->read(1, delaySamples);
+                auto input = 0.5f * (left[i] + right[i]) * inputGain[i];
+
+                line->push(input + feedback * delayedRight, feedback * delayedLeft);
+
+                wetLeft[i] = delayedLeft;
+                wetRight[i] = delayedRight;
+                wetPeak = juce::jmax(wetPeak, std::abs(delayedLeft), std::abs(delayedRight));
+            }
+        }
+
+        bool hasTail() const noexcept override { return true; }
+
+    private:
+        DelayLinePool::Line* line = nullptr;
+        float delaySamples = 0.0f;
+        static constexpr float feedback = 0.55f;
+    };
+
+    // RackReverb: juce::Reverb, whose comb and all-pass buffers are sized in prepare()
+    class RackReverb : public EffectsRack::RackEffect
+    {
+    public:
+        void prepare(double sampleRate) override
+        {
+            juce::Reverb::Parameters parameters;
+            parameters.roomSize = 0.75f;
+            parameters.damping = 0.45f;
+            parameters.wetLevel = 0.5f;
+            parameters.dryLevel = 0.0f;
+            parameters.width = 1.0f;
+            reverb.setParameters(parameters);
+            reverb.setSampleRate(sampleRate);
+        }
+
+        bool start(DelayLinePool&) noexcept override
+        {
+            reverb.reset();
+            return true;
+        }
+
+        void stop(DelayLinePool&) noexcept override {}
+
+        void process(const float* left, const float* right, float* wetLeft, float* wetRight, const float* inputGain,
+                     int numSamples) noexcept override
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                wetLeft[i] = left[i] * inputGain[i];
+                wetRight[i] = right[i] * inputGain[i];
+            }
+
+            reverb.processStereo(wetLeft, wetRight, numSamples);
+
+            wetPeak = 0.0f;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                wetPeak = juce::jmax(wetPeak, std::abs(wetLeft[i]), std::abs(wetRight[i]));
+            }
+        }
+
+        bool hasTail() const noexcept override { return true; }
+
+    private:
+        juce::Reverb reverb;
+    };
+
+    // Flanger: LFO-swept short delay with feedback; its wet signal is the comb of input and delay
+    class Flanger : public EffectsRack::RackEffect
+    {
+    public:
+        void prepare(double sampleRate) override
+        {
+            minimumDelay = static_cast<float>(0.001 * sampleRate);
+            sweepDepth = static_cast<float>(0.0035 * sampleRate);
+            phaseIncrement = static_cast<float>(juce::MathConstants<double>::twoPi * 0.25 / sampleRate);
+        }
+
+        bool start(DelayLinePool& pool) noexcept override
+        {
+            line = pool.acquire();
+            phase = 0.0f;
+            return line != nullptr;
+        }
+
+        void stop(DelayLinePool& pool) noexcept override
+        {
+            pool.release(line);
+            line = nullptr;
+        }
+
+        void process(const float* left, const float* right, float* wetLeft, float* wetRight, const float* inputGain,
+                     int numSamples) noexcept override
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delay = minimumDelay + sweepDepth * 0.5f * (1.0f + std::sin(phase));
+                phase += phaseIncrement;
+                if (phase > juce::MathConstants<float>::twoPi)
+                {
+                    phase -= juce::MathConstants<float>::twoPi;
+                }
+
+                auto delayedLeft = line->read(0, delay);
+                auto delayedRight = line->read(1, delay);
+                line->push(left[i] + feedback * delayedLeft, right[i] + feedback * delayedRight);
+
+                // An insert has no tail: while it fades out its wet signal fades back to the input
+                wetLeft[i] = left[i] + inputGain[i] * 0.5f * (delayedLeft - left[i]);
+                wetRight[i] = right[i] + inputGain[i] * 0.5f * (delayedRight - right[i]);
+            }
+        }
+
+    private:
+        DelayLinePool::Line* line = nullptr;
+        float minimumDelay = 0.0f, sweepDepth = 0.0f;
+        float phase = 0.0f, phaseIncrement = 0.0f;
+        static constexpr float feedback = 0.6f;
+    };
+
+    // Bitcrusher: Sample-and-hold rate reduction plus amplitude quantisation, no memory
+    class Bitcrusher : public EffectsRack::RackEffect
+    {
+    public:
+        void prepare(double) override {}
+
+        bool start(DelayLinePool&) noexcept override
+        {
+            holdCounter = 0;
+            return true;
+        }
+
+        void stop(DelayLinePool&) noexcept override {}
+
+        void process(const float* left, const float* right, float* wetLeft, float* wetRight, const float* inputGain,
+                     int numSamples) noexcept override
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                if (holdCounter++ % downsampleFactor == 0)
+                {
+                    heldLeft = std::round(left[i] * levels) / levels;
+                    heldRight = std::round(right[i] * levels) / levels;
+                }
+
+                wetLeft[i] = left[i] + inputGain[i] * (heldLeft - left[i]);
+                wetRight[i] = right[i] + inputGain[i] * (heldRight - right[i]);
+            }
+        }
+
+    private:
+        unsigned int holdCounter = 0;
+        float heldLeft = 0.0f, heldRight = 0.0f;
+        static constexpr unsigned int downsampleFactor = 4;
+        static constexpr float levels = 32.0f; // 6-bit
+    };
+}
+
+// Constructor: Effects are created here, on the GUI thread, never on the audio thread
+EffectsRack::EffectsRack()
+{
+    for (int type = 0; type < numEffects; ++type)
+    {
+        slots[type].effect = createEffect(static_cast<EffectType>(type));
+    }
+}
+
+EffectsRack::~EffectsRack() = default;
+
+// Allocate the delay line pool and all effect state for the new sample rate
+void EffectsRack::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (auto& slot : slots)
+    {
+        slot.running.store(false);
+        slot.effect->prepare(sampleRate);
+        slot.inputGain.reset(sampleRate, 0.01);
+        slot.inputGain.setCurrentAndTargetValue(0.0f);
+    }
+
+    pool.prepare(poolLines, static_cast<int>(maximumDelaySeconds * sampleRate));
+    mix.reset(sampleRate, 0.02);
+    mix.setCurrentAndTargetValue(mixTarget.load());
+}
+
+void EffectsRack::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (buffer.getNumChannels() < 2)
+    {
+        return;
+    }
+
+    mix.setTargetValue(mixTarget.load());
+
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getWritePointer(1, startSample);
+
+    for (int offset = 0; offset < numSamples; offset += chunkSize)
+    {
+        processChunk(left + offset, right + offset, juce::jmin(chunkSize, numSamples - offset));
+    }
+}
+
+void EffectsRack::setEffectEnabled(EffectType type, bool shouldBeEnabled)
+{
+    slots[type].enabled.store(shouldBeEnabled);
+}
+
+void EffectsRack::setMix(float wetAmount)
+{
+    mixTarget.store(juce::jlimit(0.0f, 1.0f, wetAmount));
+}
+
+bool EffectsRack::isEffectRunning(EffectType type) const noexcept
+{
+    return slots[type].running.load();
+}
+
+juce::String EffectsRack::getEffectName(EffectType type)
+{
+    switch (type)
+    {
+        case echo:       return "Echo";
+        case pingPong:   return "Ping";
+        case reverb:     return "Verb";
+        case flanger:    return "Flange";
+        case bitcrusher: return "Crush";
+        case numEffects: break;
+    }
+    return {};
+}
+
+// Run every effect that is enabled or still ringing out; skip the rest entirely
+void EffectsRack::processChunk(float* left, float* right, int numSamples) noexcept
+{
+    auto mixComputed = false;
+
+    for (auto& slot : slots)
+    {
+        auto wanted = slot.enabled.load();
+        auto running = slot.running.load(std::memory_order_relaxed);
+
+        if (!running)
+        {
+            if (!wanted || !slot.effect->start(pool))
+            {
+                continue; // Bypassed: no processing at all
+            }
+
+            slot.running.store(true);
+            slot.inputGain.setCurrentAndTargetValue(0.0f);
+            slot.silentSamples = 0;
+        }
+
+        if (!mixComputed)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                mixRamp[static_cast<size_t>(i)] = mix.getNextValue();
+            mixComputed = true;
+        }
+
+        slot.inputGain.setTargetValue(wanted ? 1.0f : 0.0f);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            gainRamp[static_cast<size_t>(i)] = slot.inputGain.getNextValue();
+        }
+
+        slot.effect->process(left, right, wetLeft.data(), wetRight.data(), gainRamp.data(), numSamples);
+
+        // The dry share returns with the input gain, so a switched-off delay rings out over the full dry signal
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto wetAmount = mixRamp[static_cast<size_t>(i)];
+            auto dryAmount = 1.0f - wetAmount * gainRamp[static_cast<size_t>(i)];
+            left[i] = left[i] * dryAmount + wetLeft[static_cast<size_t>(i)] * wetAmount;
+            right[i] = right[i] * dryAmount + wetRight[static_cast<size_t>(i)] * wetAmount;
+        }
+
+        if (wanted || slot.inputGain.isSmoothing())
+        {
+            continue;
+        }
+
+        // Input is fully off: inserts stop now, delays and reverb once their tail has died away
+        if (!slot.effect->hasTail())
+        {
+            stopSlot(slot);
+        }
+        else if (slot.effect->getLastWetPeak() < tailThreshold)
+        {
+            slot.silentSamples += numSamples;
+            if (slot.silentSamples > static_cast<int>(tailHoldSeconds * sampleRate))
+            {
+                stopSlot(slot);
+            }
+        }
+        else
+        {
+            slot.silentSamples = 0;
+        }
+    }
+
+    if (!mixComputed)
+    {
+        mix.skip(numSamples);
+    }
+}
+
+void EffectsRack::stopSlot(Slot& slot) noexcept
+{
+    slot.effect->stop(pool);
+    slot.running.store(false);
+}
+
+std::unique_ptr<EffectsRack::RackEffect> EffectsRack::createEffect(EffectType type)
+{
+    switch (type)
+    {
+        case echo:       return std::make_unique<Echo>();
+        case pingPong:   return std::make_unique<PingPong>();
+        case reverb:     return std::make_unique<RackReverb>();
+        case flanger:    return std::make_unique<Flanger>();
+        case bitcrusher: return std::make_unique<Bitcrusher>();
+        case numEffects: break;
+    }
+    return {};
+}
+
+// Each effect alone at full wet, then the rack with everything bypassed
+juce::String EffectsRack::runBenchmark()
+{
+    juce::String report;
+    EffectsRack rack;
+    rack.setMix(1.0f);
+
+    for (int type = 0; type <= numEffects; ++type)
+    {
+        auto name = type < numEffects ? "FX " + getEffectName(static_cast<EffectType>(type)) : juce::String("FX all bypassed");
+
+        report << Benchmarks::timeBlockSizes(name,
+            [&rack, type](double rate, int)
+            {
+                for (int other = 0; other < numEffects; ++other)
+                    rack.setEffectEnabled(static_cast<EffectType>(other), other == type);
+                rack.prepare(rate);
+            },
+            [&rack](juce::AudioBuffer<float>& buffer, int numSamples)
+            {
+                rack.process(buffer, 0, numSamples);
+            });
+    }
+
+    return report;
+}
+
+// Each effect alone through the rack: at mix 0 the output must be the input exactly, and at
+// mix 1, once the effect has faded in, it must be what a lone copy of the effect writes as wet
+juce::String EffectsRack::checkMixLaw()
+{
+    constexpr double rate = 44100.0;
+    constexpr int blockSize = 512;
+    const int length = static_cast<int>(rate);
+
+    juce::AudioBuffer<float> input(2, length);
+    juce::Random random(42);
+    for (int i = 0; i < length; ++i)
+    {
+        auto tone = 0.3f * std::sin(juce::MathConstants<float>::twoPi * 330.0f * static_cast<float>(i / rate));
+        auto click = i % 11025 < 64 ? random.nextFloat() * 0.8f - 0.4f : 0.0f;
+        input.setSample(0, i, tone + click);
+        input.setSample(1, i, 0.5f * tone - click);
+    }
+
+    juce::String failures;
+    for (int type = 0; type < numEffects; ++type)
+    {
+        auto effectType = static_cast<EffectType>(type);
+
+        for (auto wet : { 0.0f, 1.0f })
+        {
+            EffectsRack rack;
+            rack.setMix(wet);
+            rack.setEffectEnabled(effectType, true);
+            rack.prepare(rate);
+
+            juce::AudioBuffer<float> output(input);
+            for (int start = 0; start < length; start += blockSize)
+            {
+                rack.process(output, start, juce::jmin(blockSize, length - start));
+            }
+
+            // The expected output: the input itself, or the wet signal of a lone effect fed the same fade-in
+            juce::AudioBuffer<float> expected(input);
+            auto firstChecked = 0;
+            if (wet > 0.0f)
+            {
+                DelayLinePool linePool;
+                linePool.prepare(1, static_cast<int>(maximumDelaySeconds * rate));
+                auto effect = createEffect(effectType);
+                effect->prepare(rate);
+                effect->start(linePool);
+
+                juce::SmoothedValue<float> gain;
+                gain.reset(rate, 0.01);
+                gain.setCurrentAndTargetValue(0.0f);
+                gain.setTargetValue(1.0f);
+                firstChecked = static_cast<int>(0.01 * rate) + 1; // Dry still leaks by design while fading in
+
+                std::array<float, chunkSize> gains{};
+                for (int start = 0; start < length; start += chunkSize)
+                {
+                    auto count = juce::jmin(chunkSize, length - start);
+                    for (int i = 0; i < count; ++i)
+                        gains[static_cast<size_t>(i)] = gain.getNextValue();
+                    effect->process(input.getReadPointer(0, start), input.getReadPointer(1, start),
+                                    expected.getWritePointer(0, start), expected.getWritePointer(1, start),
+                                    gains.data(), count);
+                }
+                effect->stop(linePool);
+            }
+
+            float worst = 0.0f;
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int i = firstChecked; i < length; ++i)
+                {
+                    auto difference = std::abs(output.getSample(ch, i) - expected.getSample(ch, i));
+                    if (!(difference <= worst)) // NaN counts as the worst
+                        worst = std::isfinite(difference) ? difference : std::numeric_limits<float>::infinity();
+                }
+            }
+
+            if (!(worst <= 1.0e-6f))
+            {
+                failures << getEffectName(effectType) << " at mix " << juce::String(wet, 0)
+                         << " is off by " << juce::String(worst, 6) << "\n";
+            }
+        }
+    }
+
+    return failures;
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    This file defines the EffectsRack class for a JUCE application,
+    a per-deck chain of echo, ping-pong, reverb, flanger and bitcrusher effects.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DelayLinePool.h"
+
+// EffectsRack: Effects switch on and off from the GUI thread; the audio thread takes delay
+// lines from a pool filled in prepare(), so switching never allocates. A disabled effect
+// stops receiving input but keeps playing its tail, then returns its line and costs nothing.
+// Every effect is blended by the same law, out = dry * (1 - mix) + wet * mix.
+class EffectsRack
+{
+//==============================================================================
+public:
+    enum EffectType { echo = 0, pingPong, reverb, flanger, bitcrusher, numEffects };
+
+    EffectsRack();
+    ~EffectsRack();
+
+    void prepare(double sampleRate);
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    void setEffectEnabled(EffectType type, bool shouldBeEnabled);
+    void setMix(float wetAmount); // 0 = dry, 1 = fully wet
+    bool isEffectRunning(EffectType type) const noexcept; // True while enabled or finishing its tail
+
+    static juce::String getEffectName(EffectType type);
+    static juce::String runBenchmark(); // Cost of each effect alone, and of the bypassed rack
+    static juce::String checkMixLaw();  // Empty when mix 0 is exactly dry and mix 1 exactly wet
+
+    // RackEffect: One effect in the rack, processed in place
+    class RackEffect
+    {
+    public:
+        virtual ~RackEffect() = default;
+        virtual void prepare(double sampleRate) = 0;          // May allocate
+        virtual bool start(DelayLinePool& pool) noexcept = 0; // False if the pool is exhausted
+        virtual void stop(DelayLinePool& pool) noexcept = 0;
+        // Writes the wet signal for the dry input; the rack does the blending
+        virtual void process(const float* left, const float* right, float* wetLeft, float* wetRight,
+                             const float* inputGain, int numSamples) noexcept = 0;
+        virtual bool hasTail() const noexcept { return false; }
+        float getLastWetPeak() const noexcept { return wetPeak; }
+
+    protected:
+        float wetPeak = 0.0f;
+    };
+
+    static constexpr int chunkSize = 256; // Work arrays are fixed-size; longer blocks are chunked
+
+//==============================================================================
+private:
+    struct Slot
+    {
+        std::unique_ptr<RackEffect> effect;
+        std::atomic<bool> enabled{false};
+        std::atomic<bool> running{false};
+        juce::SmoothedValue<float> inputGain;
+        int silentSamples = 0;
+    };
+
+    DelayLinePool pool;
+    Slot slots[numEffects];
+    std::atomic<float> mixTarget{0.5f};
+    juce::SmoothedValue<float> mix;
+    double sampleRate{44100.0};
+
+    std::array<float, chunkSize> mixRamp{};
+    std::array<float, chunkSize> gainRamp{};
+    std::array<float, chunkSize> wetLeft{};
+    std::array<float, chunkSize> wetRight{};
+
+    static std::unique_ptr<RackEffect> createEffect(EffectType type);
+
+    void processChunk(float* left, float* right, int numSamples) noexcept;
+    void stopSlot(Slot& slot) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EffectsRack)
+};
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the EngineCommandQueue class for a JUCE application,
+    a fixed ring of decoded controller commands.
+
+  ==============================================================================
+*/
+
+#include "EngineCommandQueue.h"
+
+bool EngineCommandQueue::push(const EngineCommand& command) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+    {
+        return false;
+    }
+
+    commands[static_cast<size_t>(start1)] = command;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+bool EngineCommandQueue::pop(EngineCommand& command) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    if (size1 == 0)
+    {
+        return false;
+    }
+
+    command = commands[static_cast<size_t>(start1)];
+    fifo.finishedRead(1);
+    return true;
+}
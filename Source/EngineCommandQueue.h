@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    This file defines the EngineCommandQueue class for a JUCE application,
+    carrying controller commands to the audio thread without locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// EngineCommand: One control change, already decoded; the audio thread applies it as is
+struct EngineCommand
+{
+    enum Type
+    {
+        crossfader = 0, // value 0..1
+        cueMix,         // value 0..1
+        volume,         // target = deck, value 0..1
+        pitch,          // target = deck, value = playback speed
+        play,           // target = deck, toggles
+        cue,            // target = deck, toggles the PFL
+        jogTouch,       // target = deck, value 1 = touched, 0 = released
+        jog,            // target = deck, value = platter velocity in multiples of normal speed
+        pad             // target = pad, value = gain
+    };
+
+    Type type = crossfader;
+    int target = 0;
+    float value = 0.0f;
+    juce::int64 ticks = 0; // When the message arrived, for measuring latency
+};
+
+// EngineCommandQueue: Single-producer, single-consumer FIFO from the MIDI thread to the
+// audio thread; a controller with several input threads serialises its pushes itself. The mixer drains it at the start of every block, so a command is heard
+// in the next buffer.
+class EngineCommandQueue
+{
+//==============================================================================
+public:
+    EngineCommandQueue() = default;
+
+    bool push(const EngineCommand& command) noexcept; // Wait-free; false if the queue is full
+    bool pop(EngineCommand& command) noexcept;        // Audio thread
+
+    static constexpr int capacity = 512;
+
+//==============================================================================
+private:
+    juce::AbstractFifo fifo{capacity};
+    std::array<EngineCommand, capacity> commands;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EngineCommandQueue)
+};
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the KeyAnalyser class for a JUCE application,
+    accumulating a chromagram and matching it against major and minor key profiles.
+
+  ==============================================================================
+*/
+
+#include "KeyAnalyser.h"
+
+namespace
+{
+    constexpr int fftOrder = 12;
+    constexpr int fftSize = 1 << fftOrder;   // 0.37 s at the analysis rate: 2.7 Hz bins
+    constexpr double analysisRate = 11025.0;
+    constexpr double lowestHz = 55.0;
+    constexpr double highestHz = 2000.0;
+
+    // Krumhansl-Kessler probe-tone ratings, tonic first
+    constexpr float majorProfile[12] = { 6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f };
+    constexpr float minorProfile[12] = { 6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f };
+
+    float correlate(const float* chroma, const float* profile, int tonic)
+    {
+        float chromaMean = 0.0f, profileMean = 0.0f;
+        for (int i = 0; i < 12; ++i)
+        {
+            chromaMean += chroma[i] / 12.0f;
+            profileMean += profile[i] / 12.0f;
+        }
+
+        float product = 0.0f, chromaSquares = 0.0f, profileSquares = 0.0f;
+        for (int i = 0; i < 12; ++i)
+        {
+            auto c = chroma[(i + tonic) % 12] - chromaMean;
+            auto p = profile[i] - profileMean;
+            product += c * p;
+            chromaSquares += c * c;
+            profileSquares += p * p;
+        }
+        return product / std::sqrt(juce::jmax(1.0e-12f, chromaSquares * profileSquares));
+    }
+}
+
+KeyAnalyser::KeyAnalyser(double maxSecondsToAnalyse)
+    : maxSeconds(maxSecondsToAnalyse)
+{
+}
+
+KeyAnalyser::~KeyAnalyser() = default;
+
+// Bin-to-pitch-class table, filters and FFT for this file's rate; 0 if the rate is too low
+juce::int64 KeyAnalyser::decodeStarting(const juce::AudioFormatReader& reader)
+{
+    key = {};
+    active = reader.sampleRate >= 2.0 * highestHz * 1.1;
+    if (!active)
+    {
+        return 0;
+    }
+
+    decimation = juce::jmax(1, juce::roundToInt(reader.sampleRate / analysisRate));
+    auto rate = reader.sampleRate / decimation;
+    for (auto& filter : lowPass)
+    {
+        filter.setCoefficients(juce::IIRCoefficients::makeLowPass(reader.sampleRate, highestHz * 1.2));
+        filter.reset();
+    }
+
+    pitchClassOfBin.assign(fftSize / 2, -1);
+    for (int bin = 1; bin < fftSize / 2; ++bin)
+    {
+        auto hz = bin * rate / fftSize;
+        if (hz >= lowestHz && hz <= highestHz)
+        {
+            auto midiNote = juce::roundToInt(69.0 + 12.0 * std::log2(hz / 440.0));
+            pitchClassOfBin[static_cast<size_t>(bin)] = ((midiNote % 12) + 12) % 12;
+        }
+    }
+
+    if (fft == nullptr)
+    {
+        fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    }
+    frame.assign(2 * fftSize, 0.0f);
+    pending.clear();
+    pending.reserve(2 * fftSize);
+    std::fill(std::begin(chroma), std::end(chroma), 0.0f);
+    phase = 0;
+
+    return juce::jmin(reader.lengthInSamples, static_cast<juce::int64>(maxSeconds * reader.sampleRate));
+}
+
+void KeyAnalyser::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64, int numSamples)
+{
+    if (!active)
+    {
+        return;
+    }
+
+    auto* left = block.getReadPointer(0);
+    auto* right = block.getReadPointer(1);
+    mono.resize(static_cast<size_t>(numSamples));
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        mono[static_cast<size_t>(i)] = 0.5f * (left[i] + right[i]);
+    }
+    lowPass[0].processSamples(mono.data(), numSamples);
+    lowPass[1].processSamples(mono.data(), numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (phase == 0)
+        {
+            pending.push_back(mono[static_cast<size_t>(i)]);
+        }
+        phase = (phase + 1) % decimation;
+    }
+
+    // Non-overlapping frames; compressed magnitudes keep a few loud notes from dominating
+    size_t consumed = 0;
+    while (pending.size() - consumed >= static_cast<size_t>(fftSize))
+    {
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        std::copy_n(pending.begin() + static_cast<std::ptrdiff_t>(consumed), fftSize, frame.begin());
+        consumed += fftSize;
+        window->multiplyWithWindowingTable(frame.data(), fftSize);
+        fft->performFrequencyOnlyForwardTransform(frame.data(), true);
+
+        for (int bin = 1; bin < fftSize / 2; ++bin)
+        {
+            auto pitchClass = pitchClassOfBin[static_cast<size_t>(bin)];
+            if (pitchClass >= 0)
+            {
+                chroma[pitchClass] += std::sqrt(frame[static_cast<size_t>(bin)]);
+            }
+        }
+    }
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(consumed));
+}
+
+void KeyAnalyser::decodeFinished(bool complete)
+{
+    if (!active || !complete)
+    {
+        return;
+    }
+
+    auto bestScore = 0.0f;
+    juce::String bestKey;
+    for (int tonic = 0; tonic < 12; ++tonic)
+    {
+        for (auto minor : { false, true })
+        {
+            auto score = correlate(chroma, minor ? minorProfile : majorProfile, tonic);
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestKey = toCamelot(tonic, minor);
+            }
+        }
+    }
+
+    key = bestScore > 0.3f ? bestKey : juce::String(); // Weak correlation: atonal or silence
+}
+
+// Camelot numbers step round the circle of fifths from C major = 8B; minors share their relative major's number
+juce::String KeyAnalyser::toCamelot(int tonicPitchClass, bool minor)
+{
+    auto major = minor ? (tonicPitchClass + 3) % 12 : tonicPitchClass % 12;
+    auto number = ((major * 7) % 12 + 7) % 12 + 1;
+    return juce::String(number) + (minor ? "A" : "B");
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    This file defines the KeyAnalyser class for a JUCE application,
+    estimating a track's musical key from its pitch-class profile.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DecodePipeline.h"
+
+// KeyAnalyser: Folds the spectrum from 55 Hz to 2 kHz onto the twelve pitch classes,
+// then picks the major or minor key whose Krumhansl-Kessler profile correlates best.
+// Keys are given in Camelot notation ("8A" = A minor, "8B" = C major) for harmonic mixing.
+// It is a decode consumer, so it shares one decode with the beat and loudness analysis.
+class KeyAnalyser : public DecodePipeline::Consumer
+{
+//==============================================================================
+public:
+    explicit KeyAnalyser(double maxSecondsToAnalyse = 120.0);
+    ~KeyAnalyser() override;
+
+    juce::String getKey() const { return key; } // Empty until finished, or if no key stands out
+
+    // Decoding thread
+    juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+    void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+    void decodeFinished(bool complete) override;
+
+    static juce::String toCamelot(int tonicPitchClass, bool minor); // Pitch class 0 = C
+
+//==============================================================================
+private:
+    const double maxSeconds;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    juce::IIRFilter lowPass[2];
+    std::vector<int> pitchClassOfBin;  // -1 outside the analysed range
+    std::vector<float> frame;
+    std::vector<float> pending;        // Decimated samples not yet consumed by a frame
+    std::vector<float> mono;
+    float chroma[12] = {};
+    int decimation = 1;
+    int phase = 0;
+    bool active = false;
+    juce::String key;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KeyAnalyser)
+};
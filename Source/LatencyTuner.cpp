@@ -0,0 +1,286 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the LatencyTuner class for a JUCE application,
+    turning per-callback load into a buffer size recommendation and applying it.
+
+  ==============================================================================
+*/
+
+#include "LatencyTuner.h"
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+ #include <sys/resource.h>
+#endif
+
+namespace
+{
+    constexpr float nearMissLoad = 0.8f;    // A callback using this much of its period nearly dropped out
+    constexpr float targetLoad = 0.5f;      // Worst load a smaller buffer is allowed to be predicted at
+    constexpr int quietSecondsToShrink = 30;
+    constexpr int holdSecondsAfterGrowth = 120;
+    constexpr int realtimePriority = 80;    // Below the kernel's own interrupt threads
+}
+
+LatencyTuner::LatencyTuner()
+{
+    loadSettings();
+}
+
+void LatencyTuner::prepare(double newSampleRate) noexcept
+{
+    sampleRate.store(newSampleRate);
+}
+
+// Audio thread: a new device may call back on a new thread, which needs its priority too
+juce::int64 LatencyTuner::callbackStarted() noexcept
+{
+    auto thread = juce::Thread::getCurrentThreadId();
+    if (thread != audioThread)
+    {
+        audioThread = thread;
+        requestRealtimePriority();
+    }
+    return juce::Time::getHighResolutionTicks();
+}
+
+void LatencyTuner::callbackFinished(juce::int64 ticks, int numSamples) noexcept
+{
+    auto rate = sampleRate.load(std::memory_order_relaxed);
+    if (rate <= 0.0 || numSamples <= 0)
+    {
+        return;
+    }
+
+    auto load = static_cast<float>(juce::Time::highResolutionTicksToSeconds(ticks) * rate / numSamples);
+    if (load > windowPeakLoad.load(std::memory_order_relaxed))
+    {
+        windowPeakLoad.store(load, std::memory_order_relaxed);
+    }
+
+    if (load >= 1.0f)
+    {
+        windowOverruns.fetch_add(1, std::memory_order_relaxed);
+        totalOverruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (load >= nearMissLoad)
+    {
+        windowNearMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// SCHED_FIFO needs CAP_SYS_NICE or an rtprio limit (e.g. the audio group's limits.conf);
+// without either the thread keeps the priority the device gave it
+void LatencyTuner::requestRealtimePriority() noexcept
+{
+#if JUCE_LINUX
+    int policy = 0;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR))
+    {
+        priority.store(priorityRealtime); // The device already runs it in realtime
+        return;
+    }
+
+    param.sched_priority = juce::jmin(realtimePriority, sched_get_priority_max(SCHED_FIFO));
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+    {
+        priority.store(priorityRealtime);
+        return;
+    }
+
+    // Try the highest priority the rtprio limit allows instead
+    rlimit limit{};
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0)
+    {
+        param.sched_priority = static_cast<int>(juce::jmin(static_cast<rlim_t>(param.sched_priority), limit.rlim_cur));
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        {
+            priority.store(priorityRealtime);
+            return;
+        }
+    }
+
+    priority.store(priorityDenied);
+#else
+    priority.store(priorityUnsupported);
+#endif
+}
+
+// Message thread: grow on repeated near-misses, shrink one step after a quiet spell
+void LatencyTuner::update(juce::AudioDeviceManager& deviceManager, bool decksIdle, bool recording)
+{
+    auto peak = windowPeakLoad.exchange(0.0f);
+    auto nearMisses = windowNearMisses.exchange(0);
+    auto overruns = windowOverruns.exchange(0);
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr || peak <= 0.0f)
+    {
+        return; // No callbacks in this window
+    }
+
+    auto sizes = device->getAvailableBufferSizes();
+    sizes.sort();
+    if (sizes.isEmpty())
+    {
+        return;
+    }
+
+    if (currentSize != device->getCurrentBufferSizeSamples())
+    {
+        currentSize = device->getCurrentBufferSizeSamples(); // Changed here or in the settings
+        quietPeakLoad = 0.0f;
+        quietSeconds = 0;
+    }
+
+    lastPeakLoad = peak;
+    if (mode == off)
+    {
+        recommendedSize = currentSize;
+        return;
+    }
+
+    holdSeconds = juce::jmax(0, holdSeconds - 1);
+    auto nearMiss = nearMisses > 0;
+    recommendedSize = currentSize;
+
+    if (overruns > 0 || nearMisses >= 2 || (nearMiss && lastWindowNearMiss))
+    {
+        for (auto size : sizes)
+        {
+            if (size > currentSize)
+            {
+                recommendedSize = size;
+                break;
+            }
+        }
+        holdSeconds = holdSecondsAfterGrowth;
+        quietSeconds = 0;
+        quietPeakLoad = 0.0f;
+    }
+    else
+    {
+        quietPeakLoad = juce::jmax(quietPeakLoad, peak);
+        ++quietSeconds;
+
+        // Callbacks have a fixed cost as well as a per-sample one, so assume the worst:
+        // the whole callback takes as long in a smaller buffer
+        auto index = sizes.indexOf(currentSize);
+        if (quietSeconds >= quietSecondsToShrink && holdSeconds == 0 && index > 0)
+        {
+            auto smaller = sizes[index - 1];
+            if (quietPeakLoad * static_cast<float>(currentSize) / static_cast<float>(smaller) <= targetLoad)
+            {
+                recommendedSize = smaller;
+            }
+        }
+    }
+    lastWindowNearMiss = nearMiss;
+
+    // Growing restarts the device too: worth a moment's gap in the music to stop the dropouts,
+    // but not a gap in the recording of the set
+    auto due = mode == automatic && recommendedSize != currentSize && (recommendedSize > currentSize || decksIdle);
+    waitingForRecording = due && recording;
+    if (due && !recording)
+    {
+        applyBufferSize(deviceManager, recommendedSize);
+    }
+}
+
+void LatencyTuner::applyBufferSize(juce::AudioDeviceManager& deviceManager, int bufferSize)
+{
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = bufferSize;
+    auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    if (error.isNotEmpty())
+    {
+        DBG("Buffer size " << bufferSize << " rejected: " << error);
+        return;
+    }
+
+    currentSize = bufferSize;
+    quietSeconds = 0;
+    quietPeakLoad = 0.0f;
+    lastWindowNearMiss = false;
+    windowPeakLoad.store(0.0f); // The restart itself is not a measurement
+}
+
+void LatencyTuner::setMode(Mode newMode)
+{
+    mode = newMode;
+    saveSettings();
+}
+
+juce::String LatencyTuner::getSummary() const
+{
+    if (mode == off || currentSize == 0)
+    {
+        return "Buffer " + getModeName(mode);
+    }
+
+    auto text = "Buf " + juce::String(currentSize);
+    if (recommendedSize != currentSize)
+    {
+        text << " > " << recommendedSize;
+    }
+    return text << juce::String::formatted("  %d%%", juce::roundToInt(lastPeakLoad * 100.0f));
+}
+
+juce::String LatencyTuner::getReport() const
+{
+    juce::String report;
+    report << "Buffer mode: " << getModeName(mode) << " (click to change)\n";
+    report << "Current buffer: " << currentSize << " samples, recommended " << recommendedSize
+           << (waitingForRecording ? " (applied when the recording stops)" : "") << "\n";
+    report << juce::String::formatted("Peak callback load: %.0f%% last second, %.0f%% since the last change\n",
+                                      lastPeakLoad * 100.0f, quietPeakLoad * 100.0f);
+    report << "Callbacks over their period: " << totalOverruns.load() << "\n";
+
+    switch (priority.load())
+    {
+        case priorityRealtime:    report << "Audio thread: realtime (SCHED_FIFO)"; break;
+        case priorityDenied:      report << "Audio thread: realtime priority not permitted (needs an rtprio limit)"; break;
+        case priorityUnsupported: report << "Audio thread: scheduled by the audio device"; break;
+        default:                  report << "Audio thread: not started"; break;
+    }
+    return report;
+}
+
+juce::String LatencyTuner::getModeName(Mode modeToName)
+{
+    switch (modeToName)
+    {
+        case off:       return "fixed";
+        case advise:    return "advise";
+        case automatic: return "auto";
+    }
+    return {};
+}
+
+juce::File LatencyTuner::getSettingsFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("latency.xml");
+}
+
+void LatencyTuner::loadSettings()
+{
+    auto xml = juce::XmlDocument::parse(getSettingsFile());
+    if (xml != nullptr && xml->hasTagName("Latency"))
+    {
+        mode = static_cast<Mode>(juce::jlimit(static_cast<int>(off), static_cast<int>(automatic),
+                                              xml->getIntAttribute("mode", static_cast<int>(advise))));
+    }
+}
+
+void LatencyTuner::saveSettings() const
+{
+    juce::XmlElement xml("Latency");
+    xml.setAttribute("mode", static_cast<int>(mode));
+    getSettingsFile().getParentDirectory().createDirectory();
+    xml.writeTo(getSettingsFile());
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    This file defines the LatencyTuner class for a JUCE application,
+    choosing the audio buffer size from the measured load of the audio callback.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// LatencyTuner: Times every audio callback against its buffer period. Once a second the
+// message thread looks at the worst load seen and works out the smallest buffer the device
+// offers that keeps a safety margin. Repeated near-misses grow the buffer at once; it only
+// shrinks after a long quiet spell, and then only while nothing is playing, since changing
+// the buffer restarts the device. Neither happens while recording. In advise mode it only
+// reports. On Linux the first callback on each audio thread also asks for SCHED_FIFO
+// scheduling where allowed.
+class LatencyTuner
+{
+//==============================================================================
+public:
+    enum Mode
+    {
+        off,
+        advise,    // Report the recommended size only
+        automatic  // Apply it to the device
+    };
+
+    LatencyTuner();
+
+    // ScopedCallback: Measures one audio callback; put it at the top of getNextAudioBlock
+    class ScopedCallback
+    {
+    public:
+        ScopedCallback(LatencyTuner& tunerToUse, int numSamplesToUse) noexcept
+            : tuner(tunerToUse), numSamples(numSamplesToUse), startTicks(tuner.callbackStarted()) {}
+
+        ~ScopedCallback() { tuner.callbackFinished(juce::Time::getHighResolutionTicks() - startTicks, numSamples); }
+
+    private:
+        LatencyTuner& tuner;
+        int numSamples;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedCallback)
+    };
+
+    void prepare(double sampleRate) noexcept; // From prepareToPlay
+
+    // Message thread, about once a second. decksIdle is false while any deck plays; while
+    // recording the device is never restarted, so a change waits for the recording to end.
+    void update(juce::AudioDeviceManager& deviceManager, bool decksIdle, bool recording);
+
+    void setMode(Mode newMode);
+    Mode getMode() const noexcept { return mode; }
+    int getRecommendedBufferSize() const noexcept { return recommendedSize; }
+    juce::String getSummary() const; // One line for the status bar
+    juce::String getReport() const;  // Loads, misses and scheduling, for a tooltip
+
+    static juce::String getModeName(Mode mode);
+    static juce::File getSettingsFile();
+
+//==============================================================================
+private:
+    enum Priority
+    {
+        priorityUnknown,
+        priorityRealtime,
+        priorityDenied,
+        priorityUnsupported
+    };
+
+    // Audio thread -> message thread, collected and cleared once a second
+    std::atomic<double> sampleRate{0.0};
+    std::atomic<float> windowPeakLoad{0.0f};
+    std::atomic<int> windowNearMisses{0};
+    std::atomic<int> windowOverruns{0};
+    std::atomic<juce::int64> totalOverruns{0};
+    std::atomic<int> priority{priorityUnknown};
+    juce::Thread::ThreadID audioThread = nullptr; // Audio thread only
+
+    // Message thread
+    Mode mode = advise;
+    int currentSize = 0;
+    int recommendedSize = 0;
+    float lastPeakLoad = 0.0f;
+    float quietPeakLoad = 0.0f;  // Worst load since the last change
+    int quietSeconds = 0;
+    int holdSeconds = 0;         // No shrinking for a while after growing
+    bool lastWindowNearMiss = false;
+    bool waitingForRecording = false; // A change is due but the recorder is running
+
+    juce::int64 callbackStarted() noexcept;
+    void callbackFinished(juce::int64 ticks, int numSamples) noexcept;
+    void requestRealtimePriority() noexcept;
+    void applyBufferSize(juce::AudioDeviceManager& deviceManager, int bufferSize);
+    void loadSettings();
+    void saveSettings() const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyTuner)
+};
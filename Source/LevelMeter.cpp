@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the LevelMeter class for a JUCE application,
+    applying meter ballistics on the GUI thread to levels published by a MeterSource.
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+namespace
+{
+    constexpr float releasePerFrame = 0.88f;   // RMS bar fall-back
+    constexpr juce::uint32 peakHoldMs = 1500;  // Peak marker hold before it decays
+    constexpr juce::uint32 clipHoldMs = 2000;  // Clip lamp hold
+}
+
+LevelMeter::LevelMeter(MeterSource& sourceToUse)
+    : source(sourceToUse)
+{
+    startTimerHz(60);
+}
+
+LevelMeter::~LevelMeter()
+{
+    stopTimer();
+}
+
+// Draw one vertical bar per channel with peak markers and a clip lamp on top
+void LevelMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    g.setColour(juce::Colours::black);
+    g.fillRoundedRectangle(bounds, 2.0f);
+
+    auto clipArea = bounds.removeFromTop(4.0f);
+    auto clipping = juce::Time::getMillisecondCounter() - clipTime < clipHoldMs && clipTime != 0;
+    g.setColour(clipping ? juce::Colours::red : juce::Colours::darkred.darker(0.6f));
+    g.fillRect(clipArea.reduced(1.0f, 0.0f));
+
+    bounds.removeFromTop(1.0f);
+    auto barWidth = bounds.getWidth() / MeterSource::numChannels;
+
+    for (int ch = 0; ch < MeterSource::numChannels; ++ch)
+    {
+        auto bar = bounds.removeFromLeft(barWidth).reduced(1.0f, 0.0f);
+
+        juce::ColourGradient barGradient(juce::Colours::red, 0, bar.getY(),
+                                         juce::Colours::lightgreen, 0, bar.getBottom(), false);
+        barGradient.addColour(0.25, juce::Colours::yellow);
+        g.setGradientFill(barGradient);
+        g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * toProportion(level[ch])));
+
+        auto peakY = bar.getBottom() - bar.getHeight() * toProportion(peakHold[ch]);
+        g.setColour(juce::Colours::white.withAlpha(0.9f));
+        g.fillRect(bar.getX(), peakY, bar.getWidth(), 1.5f);
+    }
+}
+
+// Apply ballistics: fast attack, exponential release, held then decaying peaks
+void LevelMeter::timerCallback()
+{
+    auto now = juce::Time::getMillisecondCounter();
+
+    for (int ch = 0; ch < MeterSource::numChannels; ++ch)
+    {
+        level[ch] = juce::jmax(source.getRms(ch), level[ch] * releasePerFrame);
+
+        auto peak = source.getPeakAndReset(ch);
+        if (peak >= 1.0f)
+        {
+            clipTime = now;
+        }
+
+        if (peak >= peakHold[ch])
+        {
+            peakHold[ch] = peak;
+            peakHoldTime[ch] = now;
+        }
+        else if (now - peakHoldTime[ch] > peakHoldMs)
+        {
+            peakHold[ch] = juce::jmax(peak, peakHold[ch] * releasePerFrame);
+        }
+    }
+
+    repaint();
+}
+
+float LevelMeter::toProportion(float gain)
+{
+    return juce::jmap(juce::jlimit(-60.0f, 0.0f, juce::Decibels::gainToDecibels(gain, -60.0f)), -60.0f, 0.0f, 0.0f, 1.0f);
+}
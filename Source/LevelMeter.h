@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    This file defines the LevelMeter class for a JUCE application,
+    drawing a stereo VU bar with peak-hold and clip indication.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MeterSource.h"
+
+// LevelMeter: Stereo RMS bars with decaying peak-hold markers
+class LevelMeter : public juce::Component,
+                   private juce::Timer
+{
+//==============================================================================
+public:
+    LevelMeter(MeterSource& sourceToUse);
+    ~LevelMeter() override;
+
+    void paint(juce::Graphics&) override;
+
+//==============================================================================
+private:
+    MeterSource& source;
+    float level[MeterSource::numChannels]{};
+    float peakHold[MeterSource::numChannels]{};
+    juce::uint32 peakHoldTime[MeterSource::numChannels]{};
+    juce::uint32 clipTime{0};
+
+    void timerCallback() override; // Pull levels at frame rate
+
+    static float toProportion(float gain); // Map -60..0 dBFS onto 0..1
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
@@ -0,0 +1,698 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the LibraryFilter class for a JUCE application,
+    parsing compound library queries and evaluating them over the bitmap indexes.
+
+  ==============================================================================
+*/
+
+#include "LibraryFilter.h"
+#include "AnalysisCache.h"
+#include <optional>
+
+namespace
+{
+    // Brackets are tokens of their own; quotes keep spaces and brackets inside a name
+    juce::StringArray tokenise(const juce::String& text)
+    {
+        juce::StringArray tokens;
+        juce::String current;
+        auto quoted = false;
+        auto flush = [&]
+        {
+            if (current.isNotEmpty())
+            {
+                tokens.add(current);
+                current.clear();
+            }
+        };
+
+        for (auto p = text.getCharPointer(); !p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+            if (c == '"')
+            {
+                quoted = !quoted;
+            }
+            else if (!quoted && (c == '(' || c == ')'))
+            {
+                flush();
+                tokens.add(juce::String::charToString(c));
+            }
+            else if (!quoted && juce::CharacterFunctions::isWhitespace(c))
+            {
+                flush();
+            }
+            else
+            {
+                current += c;
+            }
+        }
+        flush();
+        return tokens;
+    }
+
+    bool isNumber(const juce::String& text)
+    {
+        return text.isNotEmpty() && text.containsOnly("0123456789.");
+    }
+}
+
+//==============================================================================
+// Parser: Recursive descent straight to bitmaps. An empty optional stands for every
+// track, so words and missing terms cost nothing until a real filter narrows them.
+class LibraryFilter::Parser
+{
+public:
+    Parser(const LibraryFilter& filterToUse, const juce::String& text, Query& queryToFill)
+        : filter(filterToUse), tokens(tokenise(text)), query(queryToFill) {}
+
+    std::optional<TrackBitmap> parse()
+    {
+        auto result = parseOr();
+        if (pos < tokens.size())
+        {
+            fail("Unexpected " + tokens[pos]);
+        }
+        return result;
+    }
+
+private:
+    using Result = std::optional<TrackBitmap>;
+
+    const LibraryFilter& filter;
+    juce::StringArray tokens;
+    Query& query;
+    int pos = 0;
+    int numWords = 0;
+
+    bool atEnd() const { return pos >= tokens.size(); }
+    const juce::String& peek() const { return tokens.getReference(pos); }
+
+    void fail(const juce::String& message)
+    {
+        if (query.error.isEmpty())
+        {
+            query.error = message; // The first problem is the useful one
+        }
+    }
+
+    TrackBitmap all() const { return TrackBitmap::allBelow(filter.paths.size()); }
+
+    Result parseOr()
+    {
+        auto wordsBefore = numWords;
+        auto result = parseAnd();
+        auto anyOr = false;
+
+        while (!atEnd() && peek() == "OR")
+        {
+            ++pos;
+            anyOr = true;
+            auto right = parseAnd();
+            if (!result.has_value() || !right.has_value())
+            {
+                result.reset(); // Either side matching everything matches everything
+            }
+            else
+            {
+                *result |= *right;
+            }
+        }
+
+        if (anyOr && numWords != wordsBefore)
+        {
+            fail("Words always narrow the search; use OR between filter terms only");
+        }
+        return result;
+    }
+
+    Result parseAnd()
+    {
+        Result result;
+        while (!atEnd() && peek() != "OR" && peek() != ")")
+        {
+            if (peek() == "AND")
+            {
+                ++pos;
+                continue;
+            }
+
+            auto term = parseUnary();
+            if (!result.has_value())
+            {
+                result = std::move(term);
+            }
+            else if (term.has_value())
+            {
+                *result &= *term;
+            }
+        }
+        return result;
+    }
+
+    Result parseUnary()
+    {
+        const auto& token = peek();
+        if (token == "NOT" || (token.startsWithChar('-') && token.length() > 1 && isFilterTerm(token.substring(1))))
+        {
+            auto wordsBefore = numWords;
+            if (token == "NOT")
+            {
+                ++pos;
+            }
+            else
+            {
+                tokens.set(pos, token.substring(1));
+            }
+
+            if (atEnd())
+            {
+                fail("NOT needs a filter term after it");
+                return TrackBitmap();
+            }
+
+            auto operand = parseUnary();
+            if (numWords != wordsBefore)
+            {
+                fail("Only filter terms can be excluded");
+            }
+
+            auto result = all();
+            if (operand.has_value())
+            {
+                result.andNot(*operand);
+            }
+            else
+            {
+                result.clear();
+            }
+            query.hasFilter = true;
+            return result;
+        }
+
+        if (token == "(")
+        {
+            ++pos;
+            auto result = parseOr();
+            if (atEnd() || peek() != ")")
+            {
+                fail("Missing )");
+            }
+            else
+            {
+                ++pos;
+            }
+            return result;
+        }
+
+        return parseTerm();
+    }
+
+    static bool isFilterTerm(const juce::String& token)
+    {
+        auto lower = token.toLowerCase();
+        return lower.startsWith("tag:") || lower.startsWith("crate:") || lower == "bpm" || lower.startsWith("bpm:")
+            || lower == "key" || lower.startsWith("key:");
+    }
+
+    Result parseTerm()
+    {
+        auto token = tokens[pos++];
+        auto lower = token.toLowerCase();
+
+        for (auto kind : { crate, tag })
+        {
+            auto prefix = kind == crate ? juce::String("crate:") : juce::String("tag:");
+            if (lower.startsWith(prefix))
+            {
+                auto name = token.substring(prefix.length());
+                if (name.isEmpty() && !atEnd())
+                {
+                    name = tokens[pos++]; // "crate: name"
+                }
+                if (kind == tag)
+                {
+                    name = makeTagName(name);
+                }
+
+                query.hasFilter = true;
+                if (const auto* set = filter.findSet(kind, name))
+                {
+                    return set->members;
+                }
+                fail("No " + prefix.dropLastCharacters(1) + " called " + name.quoted());
+                return TrackBitmap();
+            }
+        }
+
+        if (lower == "bpm" || lower.startsWith("bpm:"))
+        {
+            return parseBpm(token, lower.startsWith("bpm:") ? token.substring(4) : juce::String());
+        }
+
+        if (lower == "key" || lower.startsWith("key:"))
+        {
+            return parseKey(token, lower.startsWith("key:") ? token.substring(4) : juce::String());
+        }
+
+        return word(token);
+    }
+
+    Result word(const juce::String& token)
+    {
+        query.text << token << " ";
+        ++numWords;
+        return {};
+    }
+
+    // "bpm 124", "bpm 120-126", "BPM 120 – 126" or "bpm:120..126", in whole beats per minute
+    Result parseBpm(const juce::String& token, juce::String value)
+    {
+        auto explicitValue = value.isNotEmpty();
+        if (!explicitValue && !atEnd())
+        {
+            value = peek();
+            if (pos + 2 < tokens.size() && (tokens[pos + 1] == "-" || tokens[pos + 1] == juce::String::charToString(0x2013)))
+            {
+                value << "-" << tokens[pos + 2];
+            }
+        }
+
+        auto range = value.replace(juce::String::charToString(0x2013), "-").replace("..", "-");
+        auto low = range.upToFirstOccurrenceOf("-", false, false).trim();
+        auto high = range.containsChar('-') ? range.fromFirstOccurrenceOf("-", false, false).trim() : low;
+        if (!isNumber(low) || !isNumber(high))
+        {
+            if (explicitValue)
+            {
+                fail("BPM needs a number or a range, like bpm:120-126");
+            }
+            return word(token); // Just the word "bpm"
+        }
+
+        if (!explicitValue)
+        {
+            pos += value.containsChar('-') && !peek().containsChar('-') ? 3 : 1;
+        }
+
+        auto first = juce::jlimit(0, maxBpm, juce::roundToInt(juce::jmin(low.getDoubleValue(), high.getDoubleValue())));
+        auto last = juce::jlimit(0, maxBpm, juce::roundToInt(juce::jmax(low.getDoubleValue(), high.getDoubleValue())));
+
+        query.hasFilter = true;
+        query.usesAnalysis = true;
+        TrackBitmap result;
+        for (auto bpm = first; bpm <= last; ++bpm)
+        {
+            result |= filter.bpmBitmaps[static_cast<size_t>(bpm)];
+        }
+        return result;
+    }
+
+    // "key 8A/9A", "key:8a,9a" or "key 8A+" for 8A and its harmonic neighbours 7A, 9A and 8B
+    Result parseKey(const juce::String& token, juce::String value)
+    {
+        auto explicitValue = value.isNotEmpty();
+        if (!explicitValue && !atEnd())
+        {
+            value = peek();
+        }
+
+        std::vector<int> keys;
+        for (auto key : juce::StringArray::fromTokens(value, "/,", {}))
+        {
+            auto compatible = key.endsWithChar('+');
+            auto index = camelotIndex(compatible ? key.dropLastCharacters(1) : key);
+            if (index < 0)
+            {
+                keys.clear();
+                break;
+            }
+
+            if (compatible)
+            {
+                auto neighbours = SuggestionIndex::compatibleKeys(index);
+                keys.insert(keys.end(), neighbours.begin(), neighbours.end());
+            }
+            else
+            {
+                keys.push_back(index);
+            }
+        }
+
+        if (keys.empty())
+        {
+            if (explicitValue)
+            {
+                fail("Keys are in Camelot notation, like key:8A/9A");
+            }
+            return word(token);
+        }
+
+        if (!explicitValue)
+        {
+            ++pos;
+        }
+
+        query.hasFilter = true;
+        query.usesAnalysis = true;
+        TrackBitmap result;
+        for (auto index : keys)
+        {
+            result |= filter.keyBitmaps[index];
+        }
+        return result;
+    }
+};
+
+//==============================================================================
+LibraryFilter::LibraryFilter()
+{
+    load();
+}
+
+LibraryFilter::~LibraryFilter()
+{
+    if (unsaved)
+    {
+        save(); // Deletes have dropped members since the last change
+    }
+}
+
+LibraryFilter::Query LibraryFilter::evaluate(const juce::String& queryText) const
+{
+    Query query;
+    Parser parser(*this, queryText, query);
+    auto result = parser.parse();
+
+    if (query.hasFilter)
+    {
+        query.matches = result.has_value() ? std::move(*result) : TrackBitmap::allBelow(paths.size());
+    }
+    query.text = query.text.trim();
+    return query;
+}
+
+// Carry membership across by path; the analysis bitmaps are refilled on the next query
+void LibraryFilter::rebuild(const juce::Array<juce::File>& tracks)
+{
+    std::vector<juce::StringArray> memberPaths;
+    for (const auto& set : sets)
+    {
+        juce::StringArray members;
+        set.members.forEach([this, &members](int index) { members.add(paths[index]); });
+        memberPaths.push_back(members);
+    }
+
+    paths.clearQuick();
+    indexOfPath.clear();
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        paths.add(tracks.getReference(i).getFullPathName());
+        indexOfPath.emplace(paths[i], i);
+    }
+
+    for (size_t s = 0; s < sets.size(); ++s)
+    {
+        auto& set = sets[s];
+        set.members.clear();
+        for (const auto& path : memberPaths[s])
+        {
+            auto it = indexOfPath.find(path);
+            if (it != indexOfPath.end())
+            {
+                set.members.add(it->second);
+            }
+            else
+            {
+                unsaved = true; // Deleted from the library, so from its crates and tags too
+            }
+        }
+        resolveMissing(set);
+    }
+
+    analysed.clear();
+    suggestionIndex.clear();
+    for (auto& bitmap : bpmBitmaps)
+    {
+        bitmap.clear();
+    }
+    for (auto& bitmap : keyBitmaps)
+    {
+        bitmap.clear();
+    }
+    analysisReset = true;
+}
+
+void LibraryFilter::addTrack(int trackIndex, const juce::File& file)
+{
+    jassert(trackIndex == paths.size()); // Tracks are only ever appended
+    auto path = file.getFullPathName();
+    paths.add(path);
+    indexOfPath[path] = trackIndex;
+
+    for (auto& set : sets)
+    {
+        if (set.missing.contains(path))
+        {
+            set.members.add(trackIndex);
+            set.missing.removeString(path);
+        }
+    }
+    analysisReset = true;
+}
+
+// Look up the tracks without a BPM or key yet, whenever the cache has new results;
+// --batch analyses the whole library ahead of time
+bool LibraryFilter::updateAnalysis(const AnalysisCache& cache)
+{
+    auto generation = cache.getGeneration();
+    if (!analysisReset && generation == lastGeneration)
+    {
+        return false;
+    }
+
+    analysisReset = false;
+    lastGeneration = generation;
+
+    auto pending = TrackBitmap::allBelow(paths.size());
+    pending.andNot(analysed);
+
+    auto changed = false;
+    pending.forEach([this, &cache, &changed](int index)
+    {
+        TrackAnalysis analysis;
+        if (!cache.lookup(juce::File(paths[index]), analysis))
+        {
+            return;
+        }
+
+        analysed.add(index);
+        if (analysis.grid.isValid())
+        {
+            bpmBitmaps[static_cast<size_t>(juce::jlimit(0, maxBpm, juce::roundToInt(analysis.grid.bpm)))].add(index);
+        }
+
+        auto key = camelotIndex(analysis.key);
+        if (key >= 0)
+        {
+            keyBitmaps[key].add(index);
+        }
+
+        SuggestionIndex::Features features;
+        features.bpm = analysis.grid.isValid() ? static_cast<float>(analysis.grid.bpm) : 0.0f;
+        features.key = key;
+        features.loudnessDb = analysis.loudnessDb;
+        suggestionIndex.add(index, features);
+        changed = true;
+    });
+    return changed;
+}
+
+int LibraryFilter::indexOf(const juce::File& file) const
+{
+    auto it = indexOfPath.find(file.getFullPathName());
+    return it != indexOfPath.end() ? it->second : -1;
+}
+
+juce::StringArray LibraryFilter::getNames(Kind kind) const
+{
+    juce::StringArray names;
+    for (const auto& set : sets)
+    {
+        if (set.kind == kind)
+        {
+            names.add(set.name);
+        }
+    }
+    names.sortNatural();
+    return names;
+}
+
+bool LibraryFilter::isMember(Kind kind, const juce::String& name, int trackIndex) const
+{
+    const auto* set = findSet(kind, name);
+    return set != nullptr && set->members.contains(trackIndex);
+}
+
+void LibraryFilter::setMember(Kind kind, const juce::String& name, int trackIndex, bool shouldBeMember)
+{
+    auto setName = kind == tag ? makeTagName(name) : name.trim();
+    if (setName.isEmpty() || trackIndex < 0 || trackIndex >= paths.size())
+    {
+        return;
+    }
+
+    auto* set = findSet(kind, setName);
+    if (set == nullptr)
+    {
+        if (!shouldBeMember)
+        {
+            return;
+        }
+
+        sets.push_back({ kind, setName, {}, {} });
+        set = &sets.back();
+    }
+
+    if (shouldBeMember)
+    {
+        set->members.add(trackIndex);
+    }
+    else
+    {
+        set->members.remove(trackIndex);
+    }
+    save();
+}
+
+void LibraryFilter::removeSet(Kind kind, const juce::String& name)
+{
+    sets.erase(std::remove_if(sets.begin(), sets.end(), [kind, &name](const TrackSet& set)
+    {
+        return set.kind == kind && set.name.equalsIgnoreCase(name);
+    }), sets.end());
+    save();
+}
+
+LibraryFilter::TrackSet* LibraryFilter::findSet(Kind kind, const juce::String& name)
+{
+    for (auto& set : sets)
+    {
+        if (set.kind == kind && set.name.equalsIgnoreCase(name))
+        {
+            return &set;
+        }
+    }
+    return nullptr;
+}
+
+const LibraryFilter::TrackSet* LibraryFilter::findSet(Kind kind, const juce::String& name) const
+{
+    return const_cast<LibraryFilter*>(this)->findSet(kind, name);
+}
+
+void LibraryFilter::resolveMissing(TrackSet& set)
+{
+    juce::StringArray stillMissing;
+    for (const auto& path : set.missing)
+    {
+        auto it = indexOfPath.find(path);
+        if (it != indexOfPath.end())
+        {
+            set.members.add(it->second);
+        }
+        else
+        {
+            stillMissing.add(path); // Perhaps on a drive that is not mounted
+        }
+    }
+    set.missing.swapWith(stillMissing);
+}
+
+juce::String LibraryFilter::makeTagName(const juce::String& text)
+{
+    return juce::StringArray::fromTokens(text.toLowerCase(), false).joinIntoString("-");
+}
+
+juce::String LibraryFilter::makeQueryTerm(Kind kind, const juce::String& name)
+{
+    auto prefix = kind == crate ? juce::String("crate:") : juce::String("tag:");
+    return name.containsAnyOf(" ()\t") ? prefix + name.quoted() : prefix + name;
+}
+
+// "8A" -> 7, "12B" -> 23
+int LibraryFilter::camelotIndex(const juce::String& key)
+{
+    auto text = key.trim().toUpperCase();
+    auto letter = text.getLastCharacter();
+    auto number = text.dropLastCharacters(1);
+    if ((letter != 'A' && letter != 'B') || number.isEmpty() || !number.containsOnly("0123456789"))
+    {
+        return -1;
+    }
+
+    auto value = number.getIntValue();
+    if (value < 1 || value > 12)
+    {
+        return -1;
+    }
+    return (letter == 'B' ? 12 : 0) + value - 1;
+}
+
+juce::File LibraryFilter::getSettingsFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("crates.xml");
+}
+
+// Every saved path starts out missing and is matched up once the library is listed
+void LibraryFilter::load()
+{
+    auto xml = juce::XmlDocument::parse(getSettingsFile());
+    if (xml == nullptr || !xml->hasTagName("Crates"))
+    {
+        return;
+    }
+
+    for (auto* element : xml->getChildIterator())
+    {
+        TrackSet set;
+        set.kind = element->hasTagName("Tag") ? tag : crate;
+        set.name = element->getStringAttribute("name");
+        if (set.name.isEmpty() || findSet(set.kind, set.name) != nullptr)
+        {
+            continue;
+        }
+
+        for (auto* track : element->getChildWithTagNameIterator("Track"))
+        {
+            set.missing.add(track->getStringAttribute("path"));
+        }
+        sets.push_back(std::move(set));
+    }
+}
+
+void LibraryFilter::save()
+{
+    unsaved = false;
+    juce::XmlElement xml("Crates");
+    for (const auto& set : sets)
+    {
+        auto* element = xml.createNewChildElement(set.kind == tag ? "Tag" : "Crate");
+        element->setAttribute("name", set.name);
+        set.members.forEach([this, element](int index)
+        {
+            element->createNewChildElement("Track")->setAttribute("path", paths[index]);
+        });
+        for (const auto& path : set.missing)
+        {
+            element->createNewChildElement("Track")->setAttribute("path", path);
+        }
+    }
+
+    getSettingsFile().getParentDirectory().createDirectory();
+    xml.writeTo(getSettingsFile());
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    This file defines the LibraryFilter class for a JUCE application,
+    holding crates, user tags and analysed attributes as bitmaps for compound queries.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackBitmap.h"
+#include "SuggestionIndex.h"
+
+class AnalysisCache;
+
+// LibraryFilter: Crates and tags are TrackBitmaps of library indices; BPM (whole beats)
+// and Camelot key are one bitmap per value, filled from the analysis cache. A query like
+//     bpm 120-126 key 8A/9A tag:peak-time
+// is parsed and evaluated straight to a bitmap by AND, OR and AND NOT. Filter terms may
+// be combined with AND (implied), OR, NOT or a leading '-', and grouped in brackets. Any
+// other words are handed back as text for the fuzzy search, which narrows the result.
+// Membership is saved by path, so it survives the library being reordered or reloaded.
+// The same analysis pass fills the suggestion index used to pick the next track.
+class LibraryFilter
+{
+//==============================================================================
+public:
+    enum Kind
+    {
+        crate,
+        tag
+    };
+
+    // Query: The outcome of evaluating a search box entry
+    struct Query
+    {
+        bool hasFilter = false;    // Otherwise every track passes the filter terms
+        TrackBitmap matches;
+        juce::String text;         // Words that are not filter terms
+        juce::String error;        // Empty if the query made sense
+        bool usesAnalysis = false; // Mentions BPM or key
+    };
+
+    LibraryFilter();
+    ~LibraryFilter();
+
+    // Library changes: indices follow the library's track array
+    void rebuild(const juce::Array<juce::File>& tracks); // After a reload or a delete
+    void addTrack(int trackIndex, const juce::File& file);
+    bool updateAnalysis(const AnalysisCache& cache);      // True if tracks gained a BPM or key since the last call
+    int indexOf(const juce::File& file) const;            // -1 if not in the library
+    const SuggestionIndex& getSuggestionIndex() const noexcept { return suggestionIndex; }
+
+    Query evaluate(const juce::String& queryText) const;
+
+    juce::StringArray getNames(Kind kind) const;
+    bool isMember(Kind kind, const juce::String& name, int trackIndex) const;
+    void setMember(Kind kind, const juce::String& name, int trackIndex, bool shouldBeMember); // Creates the set
+    void removeSet(Kind kind, const juce::String& name);
+
+    static juce::String makeTagName(const juce::String& text); // "Peak Time" -> "peak-time"
+    static juce::String makeQueryTerm(Kind kind, const juce::String& name); // crate:"Warm up"
+    static juce::File getSettingsFile();
+    static int camelotIndex(const juce::String& key); // "8A" -> 7, "12B" -> 23, -1 if not Camelot notation
+
+    static constexpr int maxBpm = 300;
+
+//==============================================================================
+private:
+    // TrackSet: A crate or tag; saved paths not in the library wait in missing
+    struct TrackSet
+    {
+        Kind kind = crate;
+        juce::String name;
+        TrackBitmap members;
+        juce::StringArray missing;
+    };
+
+    std::vector<TrackSet> sets;
+    juce::StringArray paths; // Full path per track index
+    std::unordered_map<juce::String, int> indexOfPath;
+
+    TrackBitmap analysed;
+    std::vector<TrackBitmap> bpmBitmaps{static_cast<size_t>(maxBpm + 1)};
+    TrackBitmap keyBitmaps[24]; // 1A..12A, then 1B..12B
+    SuggestionIndex suggestionIndex;
+    int lastGeneration = -1; // Of the analysis cache when last looked at
+    bool analysisReset = true;
+    bool unsaved = false;
+
+    TrackSet* findSet(Kind kind, const juce::String& name);
+    const TrackSet* findSet(Kind kind, const juce::String& name) const;
+    void resolveMissing(TrackSet& set);
+    void load();
+    void save();
+
+    class Parser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryFilter)
+};
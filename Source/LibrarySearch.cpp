@@ -0,0 +1,701 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the LibrarySearch class for a JUCE application,
+    folding track names into a trigram index and scoring candidates against the query.
+
+  ==============================================================================
+*/
+
+#include "LibrarySearch.h"
+#include "PerfCounter.h"
+#include <numeric>
+
+namespace
+{
+    constexpr size_t maxDocumentBytes = 1024;
+    constexpr char startMarker = '\x01'; // Marks a gram taken from the start of a token
+    constexpr size_t typoScanBelow = 20;  // Hits from the index below which the rest is scanned for typos
+
+    // Accented Latin-1 and Latin Extended-A letters, upper and lower case, by their base letters
+    const char* const latin1Folds[64] = {
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+        "d", "n", "o", "o", "o", "o", "o", "",  "o", "u", "u", "u", "u", "y", "th", "ss",
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+        "d", "n", "o", "o", "o", "o", "o", "",  "o", "u", "u", "u", "u", "y", "th", "y"
+    };
+
+    struct FoldRange
+    {
+        juce::juce_wchar first, last;
+        const char* text;
+    };
+
+    const FoldRange latinExtendedFolds[] = {
+        { 0x100, 0x105, "a" }, { 0x106, 0x10d, "c" }, { 0x10e, 0x111, "d" }, { 0x112, 0x11b, "e" },
+        { 0x11c, 0x123, "g" }, { 0x124, 0x127, "h" }, { 0x128, 0x131, "i" }, { 0x132, 0x133, "ij" },
+        { 0x134, 0x135, "j" }, { 0x136, 0x138, "k" }, { 0x139, 0x142, "l" }, { 0x143, 0x14b, "n" },
+        { 0x14c, 0x151, "o" }, { 0x152, 0x153, "oe" }, { 0x154, 0x159, "r" }, { 0x15a, 0x161, "s" },
+        { 0x162, 0x167, "t" }, { 0x168, 0x173, "u" }, { 0x174, 0x175, "w" }, { 0x176, 0x178, "y" },
+        { 0x179, 0x17e, "z" }, { 0x17f, 0x17f, "s" }
+    };
+
+    void appendUTF8(juce::juce_wchar c, std::string& out)
+    {
+        char bytes[8] = {};
+        juce::CharPointer_UTF8 dest(bytes);
+        dest.write(c);
+        out.append(bytes, juce::CharPointer_UTF8::getBytesRequiredFor(c));
+    }
+
+    // Lower-case, accent-folded tokens separated by single spaces
+    std::string fold(const juce::String& text)
+    {
+        std::string out;
+        out.reserve(static_cast<size_t>(text.length()));
+        auto separate = [&out]
+        {
+            if (!out.empty() && out.back() != ' ')
+            {
+                out += ' ';
+            }
+        };
+
+        for (auto p = text.getCharPointer(); !p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+            if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            {
+                out += static_cast<char>(c);
+            }
+            else if (c >= 'A' && c <= 'Z')
+            {
+                out += static_cast<char>(c - 'A' + 'a');
+            }
+            else if (c == '\'' || c == 0x2019)
+            {
+                continue; // "Don't" is one word
+            }
+            else if (c < 0xc0)
+            {
+                separate();
+            }
+            else if (c <= 0xff)
+            {
+                auto* folded = latin1Folds[c - 0xc0];
+                if (*folded == 0)
+                {
+                    separate(); // The multiplication and division signs
+                }
+                out += folded;
+            }
+            else if (c <= 0x17f)
+            {
+                for (const auto& range : latinExtendedFolds)
+                {
+                    if (c >= range.first && c <= range.last)
+                    {
+                        out += range.text;
+                        break;
+                    }
+                }
+            }
+            else if (juce::CharacterFunctions::isLetterOrDigit(c))
+            {
+                appendUTF8(juce::CharacterFunctions::toLowerCase(c), out); // Other scripts are matched as they are
+            }
+            else
+            {
+                separate();
+            }
+        }
+
+        if (!out.empty() && out.back() == ' ')
+        {
+            out.pop_back();
+        }
+        return out;
+    }
+
+    juce::uint32 gramKey(char a, char b, char c)
+    {
+        return (static_cast<juce::uint32>(static_cast<unsigned char>(a)) << 16)
+             | (static_cast<juce::uint32>(static_cast<unsigned char>(b)) << 8)
+             | static_cast<juce::uint32>(static_cast<unsigned char>(c));
+    }
+
+    // Edits a query word of this length may contain and still match
+    int maxEditsFor(size_t length)
+    {
+        return length <= 3 ? 0 : (length <= 6 ? 1 : 2);
+    }
+}
+
+juce::String LibrarySearch::normalise(const juce::String& text)
+{
+    auto folded = fold(text);
+    return juce::String::fromUTF8(folded.data(), static_cast<int>(folded.size()));
+}
+
+// Start again from the library's current order; used after loading and after a delete
+void LibrarySearch::rebuild(const juce::Array<juce::File>& tracks)
+{
+    documents.clear();
+    postings.clear();
+    documents.reserve(static_cast<size_t>(tracks.size()));
+
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        addTrack(i, tracks.getReference(i));
+    }
+}
+
+void LibrarySearch::addTrack(int trackIndex, const juce::File& file)
+{
+    if (trackIndex < 0)
+    {
+        return;
+    }
+
+    if (static_cast<size_t>(trackIndex) >= documents.size())
+    {
+        documents.resize(static_cast<size_t>(trackIndex) + 1);
+    }
+    addText(trackIndex, file.getFileNameWithoutExtension());
+}
+
+// Tags are read lazily for the rows on screen, so they join the index as they arrive
+void LibrarySearch::addTags(int trackIndex, const juce::String& artist, const juce::String& title)
+{
+    if (trackIndex < 0 || static_cast<size_t>(trackIndex) >= documents.size()
+        || documents[static_cast<size_t>(trackIndex)].tagged)
+    {
+        return;
+    }
+
+    documents[static_cast<size_t>(trackIndex)].tagged = true;
+    addText(trackIndex, artist + " " + title);
+}
+
+// Append the tokens the document does not already contain and post their trigrams
+void LibrarySearch::addText(int trackIndex, const juce::String& text)
+{
+    auto& document = documents[static_cast<size_t>(trackIndex)];
+    auto folded = fold(text);
+    std::vector<juce::uint32> grams;
+
+    size_t start = 0;
+    while (start < folded.size())
+    {
+        auto end = folded.find(' ', start);
+        if (end == std::string::npos)
+        {
+            end = folded.size();
+        }
+
+        auto token = folded.substr(start, end - start);
+        start = end + 1;
+
+        if (document.text.size() + token.size() > maxDocumentBytes)
+        {
+            break;
+        }
+
+        if (hasToken(document, token))
+        {
+            continue; // File names usually repeat the artist and title
+        }
+
+        document.starts.push_back(static_cast<juce::uint16>(document.text.size()));
+        document.text += token;
+        document.letters |= letterMask(token);
+        appendGrams(token, grams);
+    }
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    for (auto gram : grams)
+    {
+        auto& list = postings[gram];
+        if (list.empty() || list.back() < trackIndex)
+        {
+            list.push_back(trackIndex); // The common case: tracks are indexed in order
+        }
+        else
+        {
+            auto it = std::lower_bound(list.begin(), list.end(), trackIndex);
+            if (it == list.end() || *it != trackIndex)
+            {
+                list.insert(it, trackIndex);
+            }
+        }
+    }
+}
+
+// Whole tokens only: "the" must still be added after "other"
+bool LibrarySearch::hasToken(const Document& document, const std::string& token)
+{
+    for (size_t i = 0; i < document.starts.size(); ++i)
+    {
+        size_t start = document.starts[i];
+        auto end = i + 1 < document.starts.size() ? static_cast<size_t>(document.starts[i + 1]) : document.text.size();
+        if (end - start == token.size() && document.text.compare(start, token.size(), token) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// A token's first two letters as a start gram, then every three letters within it
+void LibrarySearch::appendGrams(const std::string& token, std::vector<juce::uint32>& grams)
+{
+    if (token.size() >= 2)
+    {
+        grams.push_back(gramKey(startMarker, token[0], token[1]));
+    }
+
+    for (size_t i = 0; i + 3 <= token.size(); ++i)
+    {
+        grams.push_back(gramKey(token[i], token[i + 1], token[i + 2]));
+    }
+}
+
+std::vector<LibrarySearch::Word> LibrarySearch::splitQuery(const juce::String& query)
+{
+    std::vector<Word> words;
+    auto folded = fold(query);
+
+    size_t start = 0;
+    while (start < folded.size())
+    {
+        auto end = folded.find(' ', start);
+        if (end == std::string::npos)
+        {
+            end = folded.size();
+        }
+
+        Word word;
+        word.text = folded.substr(start, end - start);
+        word.letters = letterMask(word.text);
+        start = end + 1;
+
+        if (word.text.size() >= 3) // Shorter words are matched by a scan instead
+        {
+            appendGrams(word.text, word.grams);
+            std::sort(word.grams.begin(), word.grams.end());
+            word.grams.erase(std::unique(word.grams.begin(), word.grams.end()), word.grams.end());
+        }
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+// Every track containing the word, then the near misses sharing the most trigrams with it,
+// in library order on ties; every track when the word is too short to have any
+void LibrarySearch::candidatesFor(const Word& word, const TrackBitmap* allowed, std::vector<int>& result) const
+{
+    result.clear();
+    if (word.grams.empty())
+    {
+        if (allowed != nullptr)
+        {
+            result = allowed->toVector();
+            return;
+        }
+        result.resize(documents.size());
+        std::iota(result.begin(), result.end(), 0);
+        return;
+    }
+
+    counts.resize(documents.size());
+    touched.clear();
+
+    for (auto gram : word.grams)
+    {
+        auto it = postings.find(gram);
+        if (it == postings.end())
+        {
+            continue;
+        }
+
+        for (auto track : it->second)
+        {
+            if (counts[static_cast<size_t>(track)]++ == 0)
+            {
+                touched.push_back(track);
+            }
+        }
+    }
+
+    // Each edit can break up to three grams, but a subsequence match may break more, so any shared gram will do
+    result.swap(touched);
+    if (allowed != nullptr)
+    {
+        result.erase(std::remove_if(result.begin(), result.end(), [this, allowed](int track)
+        {
+            if (allowed->contains(track))
+            {
+                return false;
+            }
+            counts[static_cast<size_t>(track)] = 0;
+            return true;
+        }), result.end());
+    }
+
+    // Substring hits are what a common word is looking for, so only the near misses are capped
+    auto nearMisses = std::partition(result.begin(), result.end(), [this, &word](int track)
+    {
+        return documents[static_cast<size_t>(track)].text.find(word.text) != std::string::npos;
+    });
+
+    auto maxNearMisses = static_cast<std::ptrdiff_t>(maxCandidates);
+    if (result.end() - nearMisses > maxNearMisses)
+    {
+        std::nth_element(nearMisses, nearMisses + maxNearMisses, result.end(), [this](int a, int b)
+        {
+            auto countA = counts[static_cast<size_t>(a)];
+            auto countB = counts[static_cast<size_t>(b)];
+            return countA != countB ? countA > countB : a < b;
+        });
+    }
+
+    for (auto track : result)
+    {
+        counts[static_cast<size_t>(track)] = 0;
+    }
+
+    if (result.end() - nearMisses > maxNearMisses)
+    {
+        result.erase(nearMisses + maxNearMisses, result.end());
+    }
+}
+
+std::vector<int> LibrarySearch::search(const juce::String& query, int maxLooseResults, const TrackBitmap* allowed) const
+{
+    auto words = splitQuery(query);
+    if (words.empty())
+    {
+        return {};
+    }
+
+    // The word with the most grams narrows the candidates furthest
+    auto selective = std::max_element(words.begin(), words.end(), [](const Word& a, const Word& b)
+    {
+        return a.grams.size() < b.grams.size();
+    });
+
+    std::vector<int> candidates;
+    candidatesFor(*selective, allowed, candidates);
+
+    struct Hit
+    {
+        int track;
+        int score;
+        size_t length;
+        bool substring; // Every word found as it was typed
+    };
+
+    std::vector<Hit> hits;
+    size_t numSubstringHits = 0;
+    auto scoreTrack = [&hits, &numSubstringHits, &words, this](int track)
+    {
+        const auto& document = documents[static_cast<size_t>(track)];
+        int total = 0;
+        auto substring = true;
+        for (const auto& word : words)
+        {
+            auto score = scoreWord(word, document);
+            if (score == 0)
+            {
+                return;
+            }
+            total += score;
+            substring = substring && score >= substringScore;
+        }
+        hits.push_back({ track, total, document.text.size(), substring });
+        numSubstringHits += substring ? 1 : 0;
+    };
+
+    for (auto track : candidates)
+    {
+        scoreTrack(track);
+    }
+
+    // "dfat" shares no trigram with "daft", so a word that may hold a typo can miss its
+    // track in the index. Too few hits: scan the rest, skipping tracks that lack more of a
+    // word's letters than it may have edits.
+    auto mayHoldTypo = !selective->grams.empty() && maxEditsFor(selective->text.size()) > 0;
+    auto fewHits = hits.size() < typoScanBelow;
+    if (mayHoldTypo && fewHits && candidates.size() < documents.size())
+    {
+        std::sort(candidates.begin(), candidates.end());
+        auto next = candidates.begin();
+        for (int track = 0; track < static_cast<int>(documents.size()); ++track)
+        {
+            if (next != candidates.end() && *next == track)
+            {
+                ++next;
+                continue; // Already scored
+            }
+
+            if ((allowed == nullptr || allowed->contains(track))
+                && std::all_of(words.begin(), words.end(), [this, track](const Word& word)
+                               {
+                                   return lettersCouldMatch(word, documents[static_cast<size_t>(track)]);
+                               }))
+            {
+                scoreTrack(track);
+            }
+        }
+    }
+
+    // Substring matches first, then best score, then the shorter (more specific) name, then library order
+    auto better = [](const Hit& a, const Hit& b)
+    {
+        if (a.substring != b.substring)
+        {
+            return a.substring;
+        }
+        if (a.score != b.score)
+        {
+            return a.score > b.score;
+        }
+        if (a.length != b.length)
+        {
+            return a.length < b.length;
+        }
+        return a.track < b.track;
+    };
+
+    auto numResults = juce::jmin(hits.size(), numSubstringHits + static_cast<size_t>(juce::jmax(0, maxLooseResults)));
+    if (numResults == hits.size())
+    {
+        std::sort(hits.begin(), hits.end(), better);
+    }
+    else
+    {
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(numResults), hits.end(), better);
+    }
+
+    std::vector<int> result;
+    result.reserve(numResults);
+    for (size_t i = 0; i < numResults; ++i)
+    {
+        result.push_back(hits[i].track);
+    }
+    return result;
+}
+
+// Substring beats subsequence beats a near miss; matches at the start of a token score higher
+int LibrarySearch::scoreWord(const Word& word, const Document& document)
+{
+    const auto& text = document.text;
+    const auto& w = word.text;
+    auto isTokenStart = [&document](size_t position)
+    {
+        return std::binary_search(document.starts.begin(), document.starts.end(), static_cast<juce::uint16>(position));
+    };
+
+    auto position = text.find(w);
+    if (position != std::string::npos)
+    {
+        return substringScore + (isTokenStart(position) ? 200 : 0) + (position == 0 ? 100 : 0);
+    }
+
+    if (w.size() < 3)
+    {
+        return 0; // Too short to match loosely
+    }
+
+    // Tightest subsequence: letters dropped from the query, like "dafpunk" for "daft punk"
+    size_t bestSpan = std::numeric_limits<size_t>::max();
+    size_t bestStart = 0;
+    for (auto first = text.find(w[0]); first != std::string::npos; first = text.find(w[0], first + 1))
+    {
+        size_t i = 1, j = first + 1;
+        for (; i < w.size() && j < text.size(); ++j)
+        {
+            if (text[j] == w[i])
+            {
+                ++i;
+            }
+        }
+
+        if (i < w.size())
+        {
+            break; // Later starts cannot complete either
+        }
+
+        if (j - first < bestSpan)
+        {
+            bestSpan = j - first;
+            bestStart = first;
+        }
+    }
+
+    if (bestSpan <= w.size() + w.size() / 2 + 1)
+    {
+        return 400 + static_cast<int>(200 * w.size() / bestSpan) + (isTokenStart(bestStart) ? 50 : 0);
+    }
+
+    auto allowed = maxEditsFor(w.size());
+    if (allowed > 0)
+    {
+        auto edits = editDistanceWithin(w, text);
+        if (edits <= allowed)
+        {
+            return 400 - 100 * edits;
+        }
+    }
+    return 0;
+}
+
+juce::uint32 LibrarySearch::letterMask(const std::string& text)
+{
+    juce::uint32 mask = 0;
+    for (auto c : text)
+    {
+        if (c >= 'a' && c <= 'z')
+        {
+            mask |= 1u << (c - 'a');
+        }
+        else
+        {
+            mask |= (c >= '0' && c <= '9') ? (1u << 26) : (1u << 27);
+        }
+    }
+    return mask;
+}
+
+// Each edit removes at most one of the word's letters from the text, so a name missing more
+// of them than the word may have edits cannot match it in any way
+bool LibrarySearch::lettersCouldMatch(const Word& word, const Document& document)
+{
+    auto missing = juce::countNumberOfBits(word.letters & ~document.letters);
+    return missing <= maxEditsFor(word.text.size());
+}
+
+// Fewest insertions, deletions, substitutions or swapped neighbours turning the word into
+// any substring of the text; one column per text character, so no allocation
+int LibrarySearch::editDistanceWithin(const std::string& word, const std::string& text)
+{
+    constexpr int maxWord = 48;
+    auto m = static_cast<int>(word.size());
+    if (m == 0 || m > maxWord)
+    {
+        return m == 0 ? 0 : maxWord;
+    }
+
+    int before[maxWord + 1], previous[maxWord + 1], current[maxWord + 1];
+    for (int i = 0; i <= m; ++i)
+    {
+        previous[i] = i;
+        before[i] = i;
+    }
+
+    auto best = m;
+    for (size_t j = 0; j < text.size(); ++j)
+    {
+        current[0] = 0; // A match may start anywhere in the text
+        for (int i = 1; i <= m; ++i)
+        {
+            auto cost = word[static_cast<size_t>(i - 1)] == text[j] ? 0 : 1;
+            current[i] = juce::jmin(previous[i] + 1, current[i - 1] + 1, previous[i - 1] + cost);
+
+            if (i > 1 && j > 0 && word[static_cast<size_t>(i - 1)] == text[j - 1]
+                && word[static_cast<size_t>(i - 2)] == text[j])
+            {
+                current[i] = juce::jmin(current[i], before[i - 2] + 1);
+            }
+        }
+
+        best = juce::jmin(best, current[m]);
+        if (best == 0)
+        {
+            break;
+        }
+
+        std::copy(previous, previous + m + 1, before);
+        std::copy(current, current + m + 1, previous);
+    }
+    return best;
+}
+
+// A keystroke at a time over 100k synthetic "artist - title" names, including typos
+juce::String LibrarySearch::runBenchmark()
+{
+    const char* const words[] = { "daft", "punk", "around", "the", "world", "night", "drive", "deep", "house",
+                                  "sound", "system", "love", "dance", "floor", "summer", "club", "mix", "remix",
+                                  "original", "edit", "bass", "line", "city", "lights", "moon", "shadow",
+                                  "fire", "river", "electric", "dream", "Beyonc\xc3\xa9", "Sigur R\xc3\xb3s", "Mot\xc3\xb6rhead" };
+    constexpr int numWords = static_cast<int>(sizeof(words) / sizeof(words[0]));
+    constexpr int numTracks = 100000;
+
+    juce::Random random(42);
+    juce::Array<juce::File> tracks;
+    tracks.ensureStorageAllocated(numTracks);
+    auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    for (int i = 0; i < numTracks; ++i)
+    {
+        juce::String name;
+        auto numNameWords = 2 + random.nextInt(4);
+        for (int w = 0; w < numNameWords; ++w)
+        {
+            name << juce::String::fromUTF8(words[random.nextInt(numWords)]) << (w == 1 ? " - " : " ");
+        }
+        tracks.add(folder.getChildFile(name + juce::String(i) + ".mp3"));
+    }
+
+    LibrarySearch search;
+    PerfCounter buildCost;
+    {
+        PerfCounter::ScopedTimer timer(buildCost);
+        search.rebuild(tracks);
+    }
+
+    juce::String report;
+    report << juce::String::formatted("%-24s %d tracks: %8.2f ms\n", "Library index build", numTracks,
+                                      buildCost.getMaxMicros() / 1000.0);
+
+    for (juce::String query : { "daft punk", "dafpunk", "dfat", "pnuk", "arund the wrld", "motorhead", "beyonce deep" })
+    {
+        PerfCounter cost;
+        size_t numResults = 0;
+        for (int length = 1; length <= query.length(); ++length)
+        {
+            PerfCounter::ScopedTimer timer(cost);
+            numResults = search.search(query.substring(0, length), 500).size();
+        }
+
+        report << juce::String::formatted("%-24s %-16s: avg %8.2f us  max %8.2f us  (%d results)\n",
+                                          "Library search", query.quoted().toRawUTF8(),
+                                          cost.getAverageMicros(), cost.getMaxMicros(),
+                                          static_cast<int>(numResults));
+    }
+
+    // The typo fallback's worst case: "dnace" shares no trigram with any name, so the whole
+    // library is scanned and every name holding its letters gets an edit distance
+    {
+        auto word = splitQuery("dnace").front();
+        int scanned = 0;
+        for (const auto& document : search.documents)
+        {
+            scanned += lettersCouldMatch(word, document) ? 1 : 0;
+        }
+
+        PerfCounter cost;
+        size_t numResults = 0;
+        for (int i = 0; i < 20; ++i)
+        {
+            PerfCounter::ScopedTimer timer(cost);
+            numResults = search.search("dnace", 500).size();
+        }
+
+        report << juce::String::formatted("%-24s %-16s: avg %8.2f us  max %8.2f us  (%d results, %d of %d names scored)\n",
+                                          "Library typo scan", "\"dnace\"", cost.getAverageMicros(), cost.getMaxMicros(),
+                                          static_cast<int>(numResults), scanned, numTracks);
+    }
+    return report;
+}
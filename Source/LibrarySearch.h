@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    This file defines the LibrarySearch class for a JUCE application,
+    ranking library tracks against a typed query with typo-tolerant matching.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackBitmap.h"
+
+// LibrarySearch: Each track's name (and its artist and title once the tags are read) is
+// case- and accent-folded into tokens. A trigram index over those tokens picks candidate
+// tracks, so a keystroke only scores tracks that share letters with the query; each query
+// word then scores as a substring, a subsequence ("dafpunk") or within an edit or two
+// ("dfat"). A typo may share no trigram with the name it means, so when the index finds
+// too few, the other tracks are scanned behind a cheap letter filter. Every word must
+// match. Every track holding each word as a substring comes back, then the best of the
+// looser matches, ranked best first.
+class LibrarySearch
+{
+//==============================================================================
+public:
+    LibrarySearch() = default;
+
+    void rebuild(const juce::Array<juce::File>& tracks); // Indices follow the array
+    void addTrack(int trackIndex, const juce::File& file); // Appended at the end of the library
+    void addTags(int trackIndex, const juce::String& artist, const juce::String& title); // Once per track
+
+    // Track indices, best match first; ties keep library order. Substring matches are never
+    // capped; at most maxLooseResults subsequence or typo matches follow them. With allowed
+    // set, only those tracks are considered, before the candidates are capped.
+    std::vector<int> search(const juce::String& query, int maxLooseResults, const TrackBitmap* allowed = nullptr) const;
+
+    static juce::String normalise(const juce::String& text); // Folded tokens separated by spaces
+    static juce::String runBenchmark();                     // For --benchmark: keystrokes over 100k names
+
+    static constexpr int substringScore = 1000; // Per word; looser matches score below it
+    static constexpr int maxCandidates = 4000; // Near misses scored per keystroke, most trigrams in common first; substring hits are never capped
+
+//==============================================================================
+private:
+    // Document: Folded tokens run together, with where each token starts
+    struct Document
+    {
+        std::string text;
+        std::vector<juce::uint16> starts;
+        juce::uint32 letters = 0; // See letterMask()
+        bool tagged = false;
+    };
+
+    struct Word
+    {
+        std::string text;
+        std::vector<juce::uint32> grams;
+        juce::uint32 letters = 0;
+    };
+
+    std::vector<Document> documents;
+    std::unordered_map<juce::uint32, std::vector<int>> postings; // Trigram -> sorted track indices
+    mutable std::vector<juce::uint16> counts;                    // Scratch, one per track
+    mutable std::vector<int> touched;
+
+    void addText(int trackIndex, const juce::String& text);
+    static bool hasToken(const Document& document, const std::string& token);
+    void candidatesFor(const Word& word, const TrackBitmap* allowed, std::vector<int>& result) const;
+    static std::vector<Word> splitQuery(const juce::String& query);
+    static void appendGrams(const std::string& token, std::vector<juce::uint32>& grams);
+    static int scoreWord(const Word& word, const Document& document); // 0 if it does not match
+    static int editDistanceWithin(const std::string& word, const std::string& text); // Best substring
+    static juce::uint32 letterMask(const std::string& text); // A bit per letter a-z, one for digits, one for the rest
+    static bool lettersCouldMatch(const Word& word, const Document& document);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibrarySearch)
+};
@@ -0,0 +1,400 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the LoopSource class for a JUCE application,
+    decoding loop regions in the background and wrapping them on exact sample boundaries.
+
+  ==============================================================================
+*/
+
+#include "LoopSource.h"
+
+LoopSource::LoopSource(juce::AudioTransportSource& transportToLoop, juce::AudioFormatManager& formatManagerToUse,
+                       const PcmCacheSource& decodedAudio)
+    : juce::Thread("Loop decoder"), transport(transportToLoop), formatManager(formatManagerToUse), decoded(decodedAudio)
+{
+}
+
+// The audio device is closed before the deck is destroyed, so every Loop can be freed here
+LoopSource::~LoopSource()
+{
+    stopThread(4000);
+    collectRetired();
+    discard(incoming.exchange(nullptr));
+    discard(current);
+    current = nullptr;
+    setMemoryBudget(nullptr);
+}
+
+void LoopSource::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::cueBuffers, true);
+    }
+}
+
+// Open a decoding reader for the new file and drop any loop on the old one
+void LoopSource::loadFile(const juce::File& file)
+{
+    stopThread(4000);
+    reader.reset(formatManager.createReaderFor(file));
+    sourceSampleRate.store(reader != nullptr ? reader->sampleRate : 0.0);
+    queueRequest(0, 0, false, false);
+    startThread();
+}
+
+void LoopSource::unload()
+{
+    stopThread(4000);
+}
+
+void LoopSource::setLoop(juce::int64 startSample, juce::int64 endSample)
+{
+    queueRequest(startSample, endSample, true, false);
+}
+
+void LoopSource::startRoll(juce::int64 startSample, juce::int64 endSample)
+{
+    queueRequest(startSample, endSample, true, true);
+}
+
+void LoopSource::clearLoop()
+{
+    queueRequest(0, 0, false, false);
+}
+
+void LoopSource::queueRequest(juce::int64 startSample, juce::int64 endSample, bool active, bool roll)
+{
+    if (active && endSample <= startSample)
+    {
+        return;
+    }
+
+    {
+        const juce::ScopedLock lock(requestLock);
+        request.start = juce::jmax<juce::int64>(0, startSample);
+        request.end = endSample;
+        request.active = active;
+        request.roll = roll;
+        request.generation = nextGeneration++;
+        requestPending = true;
+    }
+
+    loopActive.store(active); // Reflected in the GUI straight away
+    notify();
+}
+
+// Decoder thread: announce each request at once so the boundaries take effect,
+// then decode its region and publish it again as resident
+void LoopSource::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(200);
+        collectRetired();
+
+        Loop next;
+        {
+            const juce::ScopedLock lock(requestLock);
+            if (!requestPending)
+            {
+                continue;
+            }
+            next.start = request.start;
+            next.end = request.end;
+            next.active = request.active;
+            next.roll = request.roll;
+            next.generation = request.generation;
+            requestPending = false;
+        }
+
+        auto* announcement = new Loop();
+        announcement->start = next.start;
+        announcement->end = next.end;
+        announcement->active = next.active;
+        announcement->roll = next.roll;
+        announcement->generation = next.generation;
+        post(announcement);
+
+        if (!next.active || reader == nullptr)
+        {
+            continue;
+        }
+
+        auto fadeSamples = static_cast<juce::int64>(fadeSeconds * reader->sampleRate);
+        auto fade = static_cast<int>(juce::jmin(fadeSamples, next.start, (next.end - next.start) / 2));
+        auto length = static_cast<int>(next.end - next.start) + fade;
+        auto bytes = static_cast<size_t>(length) * 2 * sizeof(float);
+        if (memoryBudget != nullptr && !memoryBudget->reserve(this, bytes))
+        {
+            continue; // No room: the announced loop keeps wrapping by re-reading the transport
+        }
+
+        auto* resident = new Loop();
+        resident->start = next.start;
+        resident->end = next.end;
+        resident->active = true;
+        resident->roll = next.roll;
+        resident->generation = next.generation;
+        resident->fade = fade;
+        resident->resident = true;
+        resident->samples.setSize(2, length);
+        if (!decoded.copyDecoded(resident->samples, 0, next.start - fade, length))
+        {
+            reader->read(&resident->samples, 0, length, next.start - fade, true, true);
+        }
+
+        bool superseded;
+        {
+            const juce::ScopedLock lock(requestLock);
+            superseded = requestPending;
+        }
+
+        if (superseded || threadShouldExit())
+        {
+            discard(resident);
+        }
+        else
+        {
+            post(resident);
+        }
+    }
+}
+
+// Replace whatever the audio thread has not yet picked up; it was superseded
+void LoopSource::post(Loop* loop)
+{
+    discard(incoming.exchange(loop));
+}
+
+void LoopSource::collectRetired()
+{
+    for (auto& slot : retired)
+    {
+        discard(slot.exchange(nullptr));
+    }
+}
+
+void LoopSource::discard(Loop* loop)
+{
+    if (loop == nullptr)
+    {
+        return;
+    }
+
+    if (memoryBudget != nullptr && loop->resident)
+    {
+        memoryBudget->release(this, static_cast<size_t>(loop->samples.getNumSamples()) * 2 * sizeof(float));
+    }
+    delete loop;
+}
+
+void LoopSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    transport.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    transportPosition = -1; // Resynchronise with the transport on the next block
+    inside = false;
+}
+
+void LoopSource::releaseResources()
+{
+    transport.releaseResources();
+}
+
+double LoopSource::getPositionInSeconds() const noexcept
+{
+    auto rate = sourceSampleRate.load();
+    return rate > 0.0 ? static_cast<double>(publishedPosition.load()) / rate : 0.0;
+}
+
+// Audio thread: live reads up to the loop end, then resident (or, until the decode
+// lands, re-read) copies of the region, wrapping exactly at the end sample
+void LoopSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    takeIncoming();
+
+    // Anything that moved the transport behind our back (waveform click, scratch hand-back,
+    // new track) becomes the new playhead
+    auto transportNow = transport.getNextReadPosition();
+    if (transportNow != transportPosition)
+    {
+        position = transportPosition = transportNow;
+        inside = false;
+    }
+
+    auto numSamples = bufferToFill.numSamples;
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        auto remaining = numSamples - done;
+        if (current == nullptr || !current->active || (!inside && position >= current->end))
+        {
+            readLive(bufferToFill, done, remaining);
+            break;
+        }
+
+        auto count = static_cast<int>(juce::jmin(static_cast<juce::int64>(remaining), current->end - position));
+        if (inside)
+        {
+            readResident(bufferToFill, done, count);
+        }
+        else
+        {
+            readLive(bufferToFill, done, count);
+        }
+        done += count;
+
+        if (position >= current->end)
+        {
+            if (current->resident)
+            {
+                inside = true;
+            }
+            else
+            {
+                seekTransport(current->start); // Decode not ready yet: fall back to the reader
+            }
+            position = current->start;
+        }
+    }
+
+    if (current != nullptr && current->active && current->roll)
+    {
+        rollElapsed += numSamples;
+    }
+    publishedPosition.store(position);
+}
+
+// Take the latest request. A new generation ends the previous loop: a roll resumes where
+// playback would have been, a plain loop carries on from wherever it had got to.
+void LoopSource::takeIncoming() noexcept
+{
+    if (incoming.load() == nullptr)
+    {
+        return;
+    }
+
+    std::atomic<Loop*>* freeSlot = nullptr;
+    for (auto& slot : retired)
+    {
+        if (slot.load() == nullptr)
+        {
+            freeSlot = &slot;
+            break;
+        }
+    }
+    if (freeSlot == nullptr)
+    {
+        return; // Decoder has not freed the old ones yet; try again next block
+    }
+
+    auto* next = incoming.exchange(nullptr);
+    if (next == nullptr)
+    {
+        return;
+    }
+
+    auto* previous = current;
+    if (previous == nullptr || previous->generation != next->generation)
+    {
+        if (previous != nullptr && previous->active)
+        {
+            if (previous->roll)
+            {
+                position = rollOrigin + rollElapsed;
+                seekTransport(position);
+            }
+            else if (inside)
+            {
+                seekTransport(position);
+            }
+        }
+        inside = false;
+
+        if (next->active && next->roll)
+        {
+            rollOrigin = position;
+            rollElapsed = 0;
+        }
+
+        // A loop that ends where the playhead already is (loop out, or a roll
+        // quantised back to the last beat) starts over immediately
+        if (next->active && position >= next->end && position - next->end < next->end - next->start)
+        {
+            position = next->start;
+            seekTransport(position);
+        }
+    }
+
+    current = next;
+    if (previous != nullptr)
+    {
+        freeSlot->store(previous);
+    }
+}
+
+void LoopSource::readLive(const juce::AudioSourceChannelInfo& info, int offset, int numSamples) noexcept
+{
+    auto chunkStart = position;
+    transport.getNextAudioBlock(juce::AudioSourceChannelInfo(info.buffer, info.startSample + offset, numSamples));
+    position = transportPosition = transport.getNextReadPosition();
+
+    if (current != nullptr && current->active && current->resident)
+    {
+        applyWrapFade(info, offset, numSamples, chunkStart); // First pass into the loop
+    }
+}
+
+void LoopSource::readResident(const juce::AudioSourceChannelInfo& info, int offset, int numSamples) noexcept
+{
+    auto index = static_cast<int>(position - current->start) + current->fade;
+    for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+    {
+        info.buffer->copyFrom(ch, info.startSample + offset, current->samples, juce::jmin(ch, 1), index, numSamples);
+    }
+
+    applyWrapFade(info, offset, numSamples, position);
+    position += numSamples;
+}
+
+// Over the last `fade` samples before the end, blend in the samples that precede the
+// loop start, so the jump back lands on a continuous waveform
+void LoopSource::applyWrapFade(const juce::AudioSourceChannelInfo& info, int offset, int numSamples,
+                               juce::int64 chunkStart) noexcept
+{
+    auto fade = current->fade;
+    auto fadeStart = current->end - fade;
+    auto from = juce::jmax(chunkStart, fadeStart);
+    auto to = juce::jmin(chunkStart + numSamples, current->end);
+    if (fade == 0 || from >= to)
+    {
+        return;
+    }
+
+    for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+    {
+        auto* out = info.buffer->getWritePointer(ch, info.startSample + offset);
+        auto* lead = current->samples.getReadPointer(juce::jmin(ch, 1));
+
+        for (auto p = from; p < to; ++p)
+        {
+            auto w = static_cast<float>(p - fadeStart) / static_cast<float>(fade);
+            auto& sample = out[p - chunkStart];
+            sample += w * (lead[p - fadeStart] - sample);
+        }
+    }
+}
+
+void LoopSource::seekTransport(juce::int64 newPosition) noexcept
+{
+    transport.setNextReadPosition(newPosition);
+    transportPosition = newPosition;
+}
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    This file defines the LoopSource class for a JUCE application,
+    adding sample-accurate loops and loop rolls between a deck's transport and resampler.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MemoryBudget.h"
+#include "PcmCacheSource.h"
+
+// LoopSource: Passes the transport through until a loop is set, then repeats the loop
+// region exactly on its sample boundaries. A background thread decodes the region into
+// a resident buffer, so once it is ready the wrap-around never touches the transport,
+// its reader or the decoder. Regions the deck's pipeline has already decoded are copied
+// from its PCM cache rather than decoded again. Positions are in source samples, so the
+// resampler's speed change applies to looped audio just as it does to the transport.
+class LoopSource : public juce::AudioSource,
+                   private juce::Thread,
+                   private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    LoopSource(juce::AudioTransportSource& transportToLoop, juce::AudioFormatManager& formatManagerToUse,
+               const PcmCacheSource& decodedAudio);
+    ~LoopSource() override;
+
+    void loadFile(const juce::File& file); // Clears the loop and opens a reader for decoding
+    void unload();                         // Stops the decoder thread before the PCM cache is replaced
+    void setMemoryBudget(MemoryBudget* budgetToUse); // Resident regions are charged as cue buffers
+
+    // GUI thread: start and end are source sample positions
+    void setLoop(juce::int64 startSample, juce::int64 endSample);
+    void startRoll(juce::int64 startSample, juce::int64 endSample); // On release, playback resumes
+    void clearLoop();                                                // where it would have been
+    bool isLooping() const noexcept { return loopActive.load(); }
+    double getSourceSampleRate() const noexcept { return sourceSampleRate.load(); }
+
+    // Audio thread
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+    juce::int64 getNextReadPosition() const noexcept { return position; } // Accounts for looping
+
+    double getPositionInSeconds() const noexcept; // Safe from any thread
+
+    static constexpr double fadeSeconds = 0.004; // Crossfade into the loop start at each wrap
+
+//==============================================================================
+private:
+    // Loop: One request. Published decoder -> audio through `incoming`, handed back through `retired`.
+    struct Loop
+    {
+        juce::int64 start = 0;
+        juce::int64 end = 0;
+        bool active = false;      // False asks the audio thread to leave the current loop
+        bool roll = false;
+        int generation = 0;       // Same generation = same request, now with its samples
+        int fade = 0;             // Samples before start held in the buffer for the wrap crossfade
+        bool resident = false;
+        juce::AudioBuffer<float> samples; // [start - fade, end)
+    };
+
+    juce::AudioTransportSource& transport;
+    juce::AudioFormatManager& formatManager;
+    const PcmCacheSource& decoded;
+    std::unique_ptr<juce::AudioFormatReader> reader; // Decoder thread only
+    std::atomic<double> sourceSampleRate{0.0};
+
+    // Requests from the GUI to the decoder thread
+    juce::CriticalSection requestLock;
+    Loop request;
+    bool requestPending = false;
+    int nextGeneration = 1;
+
+    // Handoff between the decoder thread and the audio thread
+    static constexpr int numRetiredSlots = 8;
+    std::atomic<Loop*> incoming{nullptr};
+    std::atomic<Loop*> retired[numRetiredSlots] = {}; // Filled by the audio thread, freed by the decoder
+
+    // Audio thread state
+    Loop* current = nullptr;
+    juce::int64 position = 0;             // Next source sample to be output
+    juce::int64 transportPosition = -1;   // Where the transport was left, to detect outside seeks
+    bool inside = false;                  // Reading from the resident buffer
+    juce::int64 rollOrigin = 0;           // Position when the roll began
+    juce::int64 rollElapsed = 0;          // Samples played since then
+    std::atomic<juce::int64> publishedPosition{0};
+    std::atomic<bool> loopActive{false};
+    MemoryBudget* memoryBudget = nullptr;
+
+    void run() override; // Decoder thread
+    void post(Loop* loop);
+    void collectRetired();
+    void discard(Loop* loop); // Frees the loop and returns its samples to the budget
+    size_t evict(size_t) override { return 0; } // Loops belong to a loaded deck
+    void queueRequest(juce::int64 startSample, juce::int64 endSample, bool active, bool roll);
+
+    void takeIncoming() noexcept;
+    void readLive(const juce::AudioSourceChannelInfo& info, int offset, int numSamples) noexcept;
+    void readResident(const juce::AudioSourceChannelInfo& info, int offset, int numSamples) noexcept;
+    void applyWrapFade(const juce::AudioSourceChannelInfo& info, int offset, int numSamples,
+                       juce::int64 chunkStart) noexcept;
+    void seekTransport(juce::int64 newPosition) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopSource)
+};
@@ -1,97 +1,309 @@
-/*
-  ==============================================================================
-
-    This file contains the implementation of the MainComponent class for a JUCE application,
-    serving as the top-level component managing audio decks and music library.
-
-  ==============================================================================
-*/
-
-#include "MainComponent.h"
-
-// Constructor: Set up UI components and audio channels
-MainComponent::MainComponent()
-{
-    addAndMakeVisible(deck1);
-    addAndMakeVisible(deck2);
-    addAndMakeVisible(musicLib);
-    
-    musicLib.setDecks(&deck1, &deck2); // Link music library to decks
-    
-    setSize(800, 600);
-    setAudioChannels(0, 2); // Stereo output
-    formatManager.registerBasicFormats();
-}
-
-MainComponent::~MainComponent()
-{
-    shutdownAudio();
-}
-
-// Prepare audio processing for decks
-void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
-{
-    deck1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    deck2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-}
-
-// Mix audio from both decks into output buffer
-void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
-{
-    juce::AudioBuffer<float> tempBuffer(2, bufferToFill.numSamples);
-    tempBuffer.clear();
-
-    deck1.getNextAudioBlock(bufferToFill);
-    for (int ch = 0; ch < 2; ++ch)
-    {
-        tempBuffer.addFrom(ch, 0, *bufferToFill.buffer, ch, 0, bufferToFill.numSamples, deck1.getVolume());
-    }
-
-    deck2.getNextAudioBlock(bufferToFill);
-    for (int ch = 0; ch < 2; ++ch)
-    {
-        tempBuffer.addFrom(ch, 0, *bufferToFill.buffer, ch, 0, bufferToFill.numSamples, deck2.getVolume());
-    }
-
-    bufferToFill.buffer->copyFrom(0, 0, tempBuffer.getReadPointer(0), bufferToFill.numSamples);
-    bufferToFill.buffer->copyFrom(1, 0, tempBuffer.getReadPointer(1), bufferToFill.numSamples);
-}
-
-// Free up audio resources for both decks
-void MainComponent::releaseResources()
-{
-    deck1.releaseResources();
-    deck2.releaseResources();
-}
-
-// Draw radial gradient background
-void MainComponent::paint(juce::Graphics& g)
-{
-    juce::ColourGradient bgGradient(
-        juce::Colours::darkgrey.darker(0.8f), getWidth() / 2.0f, getHeight() / 2.0f,
-        juce::Colours::darkgrey.brighter(0.2f), 0, 0,
-        true);
-    bgGradient.addColour(0.5, juce::Colours::darkgrey);
-    g.setGradientFill(bgGradient);
-    g.fillAll();
-
-    g.setColour(juce::Colours::grey.darker(0.5f).withAlpha(0.5f));
-    g.drawRect(getLocalBounds().toFloat(), 1.0f);
-}
-
-// Layout components: Decks on sides, music library in center
-void MainComponent::resized()
-{
-    auto area = getLocalBounds().reduced(10);
-    auto contentArea = area;
-    int totalWidth = contentArea.getWidth();
-    
-    int deckWidth = totalWidth * 0.3f;
-    int libraryWidth = totalWidth * 0.4f;
-    
-    int libraryX = (totalWidth - libraryWidth) / 2 + contentArea.getX();
-    
-    deck1.setBounds(contentArea.getX(), contentArea.getY(), deckWidth, contentArea.getHeight());
-    musicLib.setBounds(libraryX, contentArea.getY(), libraryWidth, contentArea.getHeight());
-    deck2.setBounds(contentArea.getX() + totalWidth - deckWidth, contentArea.getY(), deckWidth, contentArea.getHeight());
-}
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MainComponent class for a JUCE application,
+    serving as the top-level component managing audio decks and music library.
+
+  ==============================================================================
+*/
+
+#include "MainComponent.h"
+#include "StartupTrace.h"
+
+// Constructor: Set up UI components; the audio device opens once the window is on screen
+MainComponent::MainComponent()
+{
+    formatManager.registerBasicFormats(); // Once, shared by the decks, pads and analysers
+    StartupTrace::mark("formats registered");
+
+    addAndMakeVisible(deck1);
+    addAndMakeVisible(deck2);
+    addAndMakeVisible(musicLib);
+    addAndMakeVisible(masterMeter);
+    addAndMakeVisible(masterSpectrum);
+    addAndMakeVisible(padGrid);
+    addAndMakeVisible(playlistPanel);
+    addAndMakeVisible(suggestionsPanel);
+    addAndMakeVisible(cueMixKnob);
+    addAndMakeVisible(cueMixLabel);
+    addAndMakeVisible(recordButton);
+    addAndMakeVisible(recordFormatSelector);
+    addAndMakeVisible(recordStatus);
+    addAndMakeVisible(memoryStatus);
+    addAndMakeVisible(latencyButton);
+
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red.darker(0.2f));
+    recordButton.onClick = [this] { toggleRecording(); };
+    recordFormatSelector.addItem("WAV", SessionRecorder::wav + 1);
+    recordFormatSelector.addItem("FLAC", SessionRecorder::flac + 1);
+    recordFormatSelector.setSelectedId(SessionRecorder::flac + 1, juce::dontSendNotification);
+    recordStatus.setFont(juce::FontOptions(12.0f));
+    recordStatus.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    memoryStatus.setFont(juce::FontOptions(12.0f));
+    memoryStatus.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    memoryStatus.setJustificationType(juce::Justification::centredRight);
+    latencyButton.onClick = [this]
+    {
+        latencyTuner.setMode(static_cast<LatencyTuner::Mode>((latencyTuner.getMode() + 1) % 3));
+        updateLatency();
+    };
+
+    // Headphones: fully left hears only the PFL decks, fully right only the master
+    cueMixKnob.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    cueMixKnob.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    cueMixKnob.setRange(0.0, 1.0);
+    cueMixKnob.setValue(0.0, juce::dontSendNotification);
+    cueMixKnob.setDoubleClickReturnValue(true, 0.0);
+    cueMixKnob.setColour(juce::Slider::rotarySliderFillColourId, juce::Colours::orange);
+    cueMixKnob.onValueChange = [this] { mixer.setCueMix(static_cast<float>(cueMixKnob.getValue())); };
+    cueMixLabel.setFont(juce::FontOptions(11.0f));
+    cueMixLabel.setJustificationType(juce::Justification::centred);
+    
+    mixer.setDecks(&deck1, &deck2);
+    musicLib.setDecks(&deck1, &deck2); // Link music library to decks
+    musicLib.setMixer(&mixer);
+    musicLib.setDuplicateFinder(&duplicateFinder);
+    musicLib.setAnalysisCache(&analysisCache);
+
+    deck1.setMemoryBudget(&memoryBudget);
+    deck2.setMemoryBudget(&memoryBudget);
+    deck1.setAnalysisCache(&analysisCache);
+    deck2.setAnalysisCache(&analysisCache);
+    mixer.getPadBank().setMemoryBudget(&memoryBudget);
+    musicLib.setMemoryBudget(&memoryBudget);
+    thumCache.setMemoryBudget(&memoryBudget);
+    duplicateFinder.setMemoryBudget(&memoryBudget);
+    
+    musicLib.onLibraryLoaded = [this] { finishStartupIfReady(); };
+    
+    setSize(900, 780);
+    analysisCache.start();
+    startTimerHz(30);
+    StartupTrace::mark("components built");
+
+    // Opening a device can take hundreds of milliseconds, so let the window paint first
+    juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<MainComponent>(this)]
+    {
+        if (safeThis != nullptr)
+        {
+            safeThis->openAudioDevice();
+        }
+    });
+}
+
+MainComponent::~MainComponent()
+{
+    stopTimer();
+    automix.setEnabled(false);
+    deck1.stopDecoding(); // The analysis cache they report to is destroyed first
+    deck2.stopDecoding();
+    midiController.detach();
+    shutdownAudio();
+    mixer.getRecorder().stop();
+}
+
+void MainComponent::openAudioDevice()
+{
+    setAudioChannels(0, 4); // Master on outputs 1/2, cue bus on 3/4 where the device has them
+    updateCueAvailability();
+    StartupTrace::mark("audio device open");
+    midiController.attach(deviceManager);
+    StartupTrace::mark("MIDI inputs open");
+    audioDeviceOpen = true;
+    finishStartupIfReady();
+}
+
+// The trace is complete once the device is running and the saved library is listed
+void MainComponent::finishStartupIfReady()
+{
+    if (audioDeviceOpen && musicLib.isLibraryLoaded())
+    {
+        StartupTrace::finish();
+    }
+}
+
+// Prepare the mixer, which prepares both decks and sizes its buffers up front
+void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    mixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    latencyTuner.prepare(sampleRate);
+}
+
+// Mix audio from both decks into output buffer, timing the callback for the latency tuner
+void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const LatencyTuner::ScopedCallback measure(latencyTuner, bufferToFill.numSamples);
+    mixer.getNextAudioBlock(bufferToFill);
+}
+
+// Free up audio resources for both decks
+void MainComponent::releaseResources()
+{
+    mixer.releaseResources();
+}
+
+// Start a new recording of the master output, or finish the current one
+void MainComponent::toggleRecording()
+{
+    auto& recorder = mixer.getRecorder();
+
+    if (recorder.isRecording())
+    {
+        recorder.stop();
+        recordButton.setToggleState(false, juce::dontSendNotification);
+        recordFormatSelector.setEnabled(true);
+        recordStatus.setText("Saved " + recorder.getFile().getFileName(), juce::dontSendNotification);
+        return;
+    }
+
+    auto format = static_cast<SessionRecorder::Format>(recordFormatSelector.getSelectedId() - 1);
+    auto file = juce::File::getSpecialLocation(juce::File::userMusicDirectory)
+        .getChildFile("DJ Sets")
+        .getChildFile("Set " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S")
+                      + SessionRecorder::getFileExtension(format));
+
+    if (recorder.start(file, format))
+    {
+        recordButton.setToggleState(true, juce::dontSendNotification);
+        recordFormatSelector.setEnabled(false);
+    }
+    else
+    {
+        recordStatus.setText("Cannot write " + file.getFullPathName(), juce::dontSendNotification);
+    }
+}
+
+void MainComponent::updateCueAvailability()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+    auto available = device != nullptr && device->getActiveOutputChannels().countNumberOfSetBits() >= 4;
+
+    cueMixKnob.setEnabled(available);
+    cueMixLabel.setText(available ? "Cue/Mst" : "No cue", juce::dontSendNotification);
+    cueMixLabel.setColour(juce::Label::textColourId, available ? juce::Colours::white : juce::Colours::grey);
+}
+
+void MainComponent::updateMemoryStatus()
+{
+    thumCache.updateMemoryUse();
+    memoryStatus.setText(memoryBudget.getSummary(), juce::dontSendNotification);
+    memoryStatus.setTooltip(memoryBudget.getReport());
+}
+
+// Restarting the device to shrink the buffer is audible, so only while nothing plays;
+// and never while recording, since the restart would leave a gap in the set
+void MainComponent::updateLatency()
+{
+    if (audioDeviceOpen)
+    {
+        auto decksIdle = !deck1.isPlaying() && !deck2.isPlaying();
+        latencyTuner.update(deviceManager, decksIdle, mixer.getRecorder().isRecording());
+    }
+    latencyButton.setButtonText(latencyTuner.getSummary());
+    const auto& meterCost = mixer.getMasterMeterSource().getCost();
+    const auto& commandLatency = mixer.getCommandLatency();
+    auto tooltip = latencyTuner.getReport()
+                   + juce::String::formatted("\nMaster metering: avg %.1f us, max %.1f us per callback",
+                                             meterCost.getAverageMicros(), meterCost.getMaxMicros());
+    if (commandLatency.getNumCalls() > 0)
+    {
+        tooltip << juce::String::formatted("\nController to audio: avg %.1f ms, max %.1f ms",
+                                           commandLatency.getAverageMicros() / 1000.0, commandLatency.getMaxMicros() / 1000.0);
+    }
+    latencyButton.setTooltip(tooltip);
+}
+
+void MainComponent::timerCallback()
+{
+    musicLib.syncCrossfader();
+    if (!cueMixKnob.isMouseButtonDown() && static_cast<float>(cueMixKnob.getValue()) != mixer.getCueMix())
+    {
+        cueMixKnob.setValue(mixer.getCueMix(), juce::dontSendNotification);
+    }
+
+    if (--statusRefreshCountdown <= 0)
+    {
+        statusRefreshCountdown = 30; // About once a second
+        updateMemoryStatus();
+        updateLatency();
+    }
+
+    auto& recorder = mixer.getRecorder();
+    if (!recorder.isRecording())
+    {
+        if (recordButton.getToggleState()) // Ended by the device, not the button
+        {
+            recordButton.setToggleState(false, juce::dontSendNotification);
+            recordFormatSelector.setEnabled(true);
+            recordStatus.setText((recorder.wasInterrupted() ? "Recording stopped: device restarted. Saved "
+                                                            : "Recording stopped. Saved ")
+                                 + recorder.getFile().getFileName(), juce::dontSendNotification);
+        }
+        return;
+    }
+
+    auto seconds = static_cast<int>(recorder.getRecordedSeconds());
+    auto status = juce::String::formatted("REC %d:%02d:%02d", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+
+    if (auto overruns = recorder.getOverruns(); overruns > 0)
+    {
+        status << "  overruns: " << overruns; // Blocks lost while the disk was stalled
+    }
+    recordStatus.setText(status, juce::dontSendNotification);
+}
+
+// Draw radial gradient background
+void MainComponent::paint(juce::Graphics& g)
+{
+    juce::ColourGradient bgGradient(
+        juce::Colours::darkgrey.darker(0.8f), getWidth() / 2.0f, getHeight() / 2.0f,
+        juce::Colours::darkgrey.brighter(0.2f), 0, 0,
+        true);
+    bgGradient.addColour(0.5, juce::Colours::darkgrey);
+    g.setGradientFill(bgGradient);
+    g.fillAll();
+
+    g.setColour(juce::Colours::grey.darker(0.5f).withAlpha(0.5f));
+    g.drawRect(getLocalBounds().toFloat(), 1.0f);
+
+    if (!firstPaintTraced)
+    {
+        firstPaintTraced = true;
+        StartupTrace::mark("first paint");
+    }
+}
+
+// Layout components: Decks on sides, master meters and pads above the music library in center
+void MainComponent::resized()
+{
+    auto area = getLocalBounds().reduced(10);
+    auto contentArea = area;
+    int totalWidth = contentArea.getWidth();
+    
+    int deckWidth = totalWidth * 0.3f;
+    int libraryWidth = totalWidth * 0.4f;
+    
+    int libraryX = (totalWidth - libraryWidth) / 2 + contentArea.getX();
+    
+    deck1.setBounds(contentArea.getX(), contentArea.getY(), deckWidth, contentArea.getHeight());
+
+    juce::Rectangle<int> centreArea(libraryX, contentArea.getY(), libraryWidth, contentArea.getHeight());
+    auto recordArea = centreArea.removeFromTop(26).reduced(5, 0).withTrimmedBottom(4);
+    recordButton.setBounds(recordArea.removeFromLeft(70));
+    recordFormatSelector.setBounds(recordArea.removeFromLeft(70).withTrimmedLeft(4));
+    memoryStatus.setBounds(recordArea.removeFromRight(110));
+    latencyButton.setBounds(recordArea.removeFromRight(120).withTrimmedLeft(4));
+    recordStatus.setBounds(recordArea.withTrimmedLeft(4));
+
+    auto masterArea = centreArea.removeFromTop(50).reduced(5, 0).withTrimmedBottom(5);
+    auto cueArea = masterArea.removeFromLeft(48);
+    cueMixLabel.setBounds(cueArea.removeFromBottom(14));
+    cueMixKnob.setBounds(cueArea);
+    masterMeter.setBounds(masterArea.removeFromRight(14));
+    masterSpectrum.setBounds(masterArea.withTrimmedLeft(4).withTrimmedRight(5));
+    padGrid.setBounds(centreArea.removeFromTop(96).reduced(5, 0).withTrimmedBottom(5));
+    playlistPanel.setBounds(centreArea.removeFromTop(120).reduced(5, 0).withTrimmedBottom(5));
+    suggestionsPanel.setBounds(centreArea.removeFromTop(120).reduced(5, 0).withTrimmedBottom(5));
+    musicLib.setBounds(centreArea);
+    deck2.setBounds(contentArea.getX() + totalWidth - deckWidth, contentArea.getY(), deckWidth, contentArea.getHeight());
+}
@@ -1,45 +1,91 @@
-/*
-  ==============================================================================
-
-    This file defines the MainComponent class for a JUCE application,
-    acting as the main container for decks and music library components.
-
-  ==============================================================================
-*/
-
-#pragma once
-#include <JuceHeader.h>
-#include "DeckGUI.h"
-#include "MusicLibrary.h"
-
-// MainComponent: Top-level component managing decks and library
-class MainComponent  : public juce::AudioAppComponent
-{
-    
-//==============================================================================
-public:
-    MainComponent();
-    ~MainComponent() override;
-
-    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
-    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
-    void releaseResources() override;
-
-    void paint(juce::Graphics& g) override;
-    void resized() override;
-    
-//==============================================================================
-private:
-    juce::AudioFormatManager formatManager;
-    juce::AudioThumbnailCache thumCache{100};
-    
-    DeckGUI deck1{1, formatManager, thumCache};
-    DeckGUI deck2{2, formatManager, thumCache};
-    MusicLibrary musicLib;
-
-    juce::FileChooser fChooser{"Choose an audio file",
-                              juce::File::getSpecialLocation(juce::File::userDesktopDirectory),
-                              "*.mp3;*.wav;*.aiff"};
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
-};
+/*
+  ==============================================================================
+
+    This file defines the MainComponent class for a JUCE application,
+    acting as the main container for decks and music library components.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DeckGUI.h"
+#include "MusicLibrary.h"
+#include "Mixer.h"
+#include "LevelMeter.h"
+#include "SpectrumDisplay.h"
+#include "SamplePadGrid.h"
+#include "MidiController.h"
+#include "AnalysisCache.h"
+#include "Automix.h"
+#include "PlaylistPanel.h"
+#include "SuggestionsPanel.h"
+#include "DuplicateFinder.h"
+#include "ThumbnailDiskCache.h"
+#include "LatencyTuner.h"
+
+// MainComponent: Top-level component managing decks and library
+class MainComponent  : public juce::AudioAppComponent,
+                       private juce::Timer
+{
+    
+//==============================================================================
+public:
+    MainComponent();
+    ~MainComponent() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    
+//==============================================================================
+private:
+    juce::AudioFormatManager formatManager;
+    MemoryBudget memoryBudget; // Before every cache it accounts for, so it outlives them
+    ThumbnailDiskCache thumCache{100}; // Overviews built by --batch are picked up from disk
+    
+    DeckGUI deck1{1, formatManager, thumCache};
+    DeckGUI deck2{2, formatManager, thumCache};
+    MusicLibrary musicLib;
+
+    Mixer mixer;
+    LevelMeter masterMeter{mixer.getMasterMeterSource()};
+    SpectrumDisplay masterSpectrum{mixer.getMasterMeterSource()};
+    SamplePadGrid padGrid{mixer.getPadBank(), formatManager};
+    MidiController midiController{mixer.getCommandQueue()};
+    AnalysisCache analysisCache{formatManager};
+    DuplicateFinder duplicateFinder{formatManager};
+    Automix automix{deck1, deck2, mixer, analysisCache};
+    PlaylistPanel playlistPanel{automix, analysisCache, musicLib};
+    SuggestionsPanel suggestionsPanel{deck1, deck2, mixer, musicLib, analysisCache, automix};
+    juce::Slider cueMixKnob;
+    juce::Label cueMixLabel;
+
+    juce::TextButton recordButton{"Record"};
+    juce::ComboBox recordFormatSelector;
+    juce::Label recordStatus;
+    juce::Label memoryStatus; // Tooltip has the per-pool breakdown
+    juce::TextButton latencyButton; // Shows the buffer size; click cycles the tuner's mode
+    juce::TooltipWindow tooltipWindow{this};
+    LatencyTuner latencyTuner;
+    int statusRefreshCountdown = 0;
+    bool audioDeviceOpen = false;
+    bool firstPaintTraced = false;
+
+    juce::FileChooser fChooser{"Choose an audio file",
+                              juce::File::getSpecialLocation(juce::File::userDesktopDirectory),
+                              "*.mp3;*.wav;*.aiff"};
+
+    void openAudioDevice(); // Deferred until after the first paint
+    void finishStartupIfReady();
+    void toggleRecording();
+    void updateCueAvailability(); // The cue knob only means something with outputs 3/4
+    void updateMemoryStatus();
+    void updateLatency();
+    void timerCallback() override; // Follow controller moves and refresh the recording time
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MasterLimiter class for a JUCE application,
+    detecting true peaks and applying a lookahead gain envelope to the master bus.
+
+  ==============================================================================
+*/
+
+#include "MasterLimiter.h"
+#include "Benchmarks.h"
+
+// Constructor: Kaiser-windowed sinc interpolators for each fractional position
+MasterLimiter::MasterLimiter()
+{
+    constexpr double beta = 5.0;
+    auto besselI0 = [](double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+
+    for (int phase = 0; phase < numPhases; ++phase)
+    {
+        auto fraction = (phase + 1) / static_cast<double>(numPhases + 1);
+        double total = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            // Taps sit at -3..+4 samples around the interpolated point between taps 3 and 4
+            auto t = (tap - (numTaps / 2 - 1)) - fraction;
+            auto sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+            auto r = t / (numTaps / 2.0);
+            auto window = std::abs(r) >= 1.0 ? 0.0 : besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+            phaseCoefficients[phase][tap] = static_cast<float>(sinc * window);
+            total += sinc * window;
+        }
+
+        for (auto& c : phaseCoefficients[phase])
+        {
+            c = static_cast<float>(c / total); // Unity gain at DC
+        }
+    }
+}
+
+void MasterLimiter::prepare(double sampleRate)
+{
+    lookahead = juce::jmax(1, juce::roundToInt(lookaheadSeconds * sampleRate));
+    delaySamples = lookahead - 1 + numTaps / 2 - 1; // Hold window ends on the sample being output
+    releaseCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (releaseSeconds * sampleRate)));
+
+    minimumValues.assign(static_cast<size_t>(lookahead + 1), 1.0f);
+    minimumIndices.assign(static_cast<size_t>(lookahead + 1), 0);
+    boxHistory.assign(static_cast<size_t>(lookahead), 1.0f);
+    delayBuffer.setSize(2, delaySamples + 1);
+    reset();
+}
+
+void MasterLimiter::reset()
+{
+    for (auto& channel : history)
+    {
+        std::fill(std::begin(channel), std::end(channel), 0.0f);
+    }
+
+    std::fill(boxHistory.begin(), boxHistory.end(), 1.0f);
+    boxSum = static_cast<double>(boxHistory.size());
+    boxPosition = 0;
+    minimumHead = minimumCount = 0;
+    sampleIndex = 0;
+    releasedGain = 1.0f;
+    delayBuffer.clear();
+    delayPosition = 0;
+    gainReductionDb.store(0.0f);
+}
+
+void MasterLimiter::setCeilingDecibels(float ceilingDb)
+{
+    ceiling.store(juce::Decibels::decibelsToGain(juce::jmin(0.0f, ceilingDb)));
+}
+
+// Audio thread: in place; output is delayed by getLatencySamples()
+void MasterLimiter::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (buffer.getNumChannels() < 2 || delayBuffer.getNumSamples() == 0)
+    {
+        return;
+    }
+
+    auto threshold = ceiling.load();
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getWritePointer(1, startSample);
+    auto* delayedLeft = delayBuffer.getWritePointer(0);
+    auto* delayedRight = delayBuffer.getWritePointer(1);
+    auto delaySize = delayBuffer.getNumSamples();
+    auto lowestGain = 1.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto peak = juce::jmax(truePeak(0, left[i]), truePeak(1, right[i]));
+        auto required = peak > threshold ? threshold / peak : 1.0f;
+
+        // Instant attack into the hold, slow release out of it
+        auto held = slidingMinimum(required);
+        releasedGain = held < releasedGain ? held : releasedGain + releaseCoefficient * (held - releasedGain);
+
+        boxSum += static_cast<double>(releasedGain - boxHistory[static_cast<size_t>(boxPosition)]);
+        boxHistory[static_cast<size_t>(boxPosition)] = releasedGain;
+        if (++boxPosition == lookahead)
+        {
+            boxPosition = 0;
+        }
+        auto gain = juce::jmin(1.0f, static_cast<float>(boxSum / lookahead));
+        lowestGain = juce::jmin(lowestGain, gain);
+
+        // Swap the incoming sample for the one that entered delaySamples ago
+        delayedLeft[delayPosition] = left[i];
+        delayedRight[delayPosition] = right[i];
+        if (++delayPosition == delaySize)
+        {
+            delayPosition = 0;
+        }
+        left[i] = delayedLeft[delayPosition] * gain;
+        right[i] = delayedRight[delayPosition] * gain;
+    }
+
+    gainReductionDb.store(juce::Decibels::gainToDecibels(lowestGain, -60.0f));
+}
+
+// Largest of the sample itself and the three interpolated points before it,
+// taken at the centre of the interpolator window
+float MasterLimiter::truePeak(int channel, float input) noexcept
+{
+    auto* h = history[channel];
+    std::memmove(h, h + 1, sizeof(float) * (numTaps - 1));
+    h[numTaps - 1] = input;
+
+    auto peak = std::abs(h[numTaps / 2]);
+    for (const auto& coefficients : phaseCoefficients)
+    {
+        auto value = 0.0f;
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            value += coefficients[tap] * h[tap];
+        }
+        peak = juce::jmax(peak, std::abs(value));
+    }
+    return peak;
+}
+
+// Minimum of the last `lookahead` required gains, amortised O(1)
+float MasterLimiter::slidingMinimum(float requiredGain) noexcept
+{
+    auto capacity = static_cast<int>(minimumValues.size());
+
+    while (minimumCount > 0)
+    {
+        auto back = (minimumHead + minimumCount - 1) % capacity;
+        if (minimumValues[static_cast<size_t>(back)] < requiredGain)
+        {
+            break;
+        }
+        --minimumCount;
+    }
+
+    auto slot = static_cast<size_t>((minimumHead + minimumCount) % capacity);
+    minimumValues[slot] = requiredGain;
+    minimumIndices[slot] = sampleIndex;
+    ++minimumCount;
+
+    if (minimumIndices[static_cast<size_t>(minimumHead)] <= sampleIndex - lookahead)
+    {
+        minimumHead = (minimumHead + 1) % capacity;
+        --minimumCount;
+    }
+
+    ++sampleIndex;
+    return minimumValues[static_cast<size_t>(minimumHead)];
+}
+
+// Driven 12 dB into the ceiling so the envelope is always working
+juce::String MasterLimiter::runBenchmark()
+{
+    MasterLimiter limiter;
+    return Benchmarks::timeBlockSizes("MasterLimiter",
+        [&limiter](double rate, int)
+        {
+            limiter.prepare(rate);
+            limiter.setCeilingDecibels(-13.0f);
+        },
+        [&limiter](juce::AudioBuffer<float>& buffer, int numSamples)
+        {
+            limiter.process(buffer, 0, numSamples);
+        });
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    This file defines the MasterLimiter class for a JUCE application,
+    a lookahead true-peak limiter for the master bus.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// MasterLimiter: Estimates inter-sample peaks with a 4x polyphase interpolator and
+// delays the audio by a short lookahead, so the gain is already down when a peak
+// arrives. The gain envelope is a sliding minimum followed by a box filter of the
+// same length, which keeps it smooth yet never above the gain a peak requires.
+class MasterLimiter
+{
+//==============================================================================
+public:
+    MasterLimiter();
+
+    void prepare(double sampleRate); // Allocates: call from prepareToPlay only
+    void reset();
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    void setCeilingDecibels(float ceilingDb);
+    float getGainReductionDecibels() const noexcept { return gainReductionDb.load(); } // Deepest in last block
+    int getLatencySamples() const noexcept { return delaySamples; }
+
+    static juce::String runBenchmark();
+
+//==============================================================================
+private:
+    static constexpr int numTaps = 8;    // Interpolator length per phase
+    static constexpr int numPhases = 3;  // Positions 1/4, 1/2 and 3/4 between samples
+    static constexpr double lookaheadSeconds = 0.0015;
+    static constexpr double releaseSeconds = 0.08;
+
+    float phaseCoefficients[numPhases][numTaps];
+    float history[2][numTaps] = {};
+
+    int lookahead = 1;    // Length of the hold and smoothing windows
+    int delaySamples = 1; // Lookahead plus the interpolator's group delay
+    std::atomic<float> ceiling{0.891f}; // -1 dBTP
+    std::atomic<float> gainReductionDb{0.0f};
+    float releaseCoefficient = 0.0f;
+    float releasedGain = 1.0f;
+
+    // Sliding minimum as a monotonic queue over a fixed ring of (value, index) pairs
+    std::vector<float> minimumValues;
+    std::vector<juce::int64> minimumIndices;
+    int minimumHead = 0, minimumCount = 0;
+    juce::int64 sampleIndex = 0;
+
+    // Box filter over the released gain
+    std::vector<float> boxHistory;
+    int boxPosition = 0;
+    double boxSum = 0.0;
+
+    juce::AudioBuffer<float> delayBuffer;
+    int delayPosition = 0;
+
+    float truePeak(int channel, float input) noexcept;
+    float slidingMinimum(float requiredGain) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterLimiter)
+};
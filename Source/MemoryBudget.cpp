@@ -0,0 +1,340 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MemoryBudget class for a JUCE application,
+    reserving cache memory and evicting least recently used, unpinned clients to make room.
+
+  ==============================================================================
+*/
+
+#include "MemoryBudget.h"
+
+namespace
+{
+    constexpr size_t megabyte = 1024 * 1024;
+
+    struct PoolInfo
+    {
+        const char* key;   // Attribute prefix in memory-budget.xml
+        const char* name;
+        size_t defaultMegabytes; // 0: a share of the global cap
+    };
+
+    const PoolInfo poolInfo[MemoryBudget::numPools] = {
+        { "decoded",      "Decoded audio", 0 },
+        { "waveforms",    "Waveforms",     64 },
+        { "cue",          "Cue buffers",   256 },
+        { "tags",         "Tags",          64 },
+        { "fingerprints", "Fingerprints",  256 },
+    };
+}
+
+MemoryBudget::MemoryBudget()
+{
+    // A quarter of physical memory (2 GB on an 8 GB laptop) leaves the system and
+    // other applications room, so nothing is paged out during a set
+    auto physical = static_cast<size_t>(juce::jmax(1024, juce::SystemStats::getMemorySizeInMegabytes())) * megabyte;
+    globalCap = physical / 4;
+
+    for (int pool = 0; pool < numPools; ++pool)
+    {
+        auto megabytes = poolInfo[pool].defaultMegabytes;
+        budgets[pool] = megabytes > 0 ? megabytes * megabyte : globalCap / 2;
+    }
+
+    loadSettings();
+}
+
+void MemoryBudget::addClient(Client* client, Pool pool, bool pinned)
+{
+    const juce::ScopedLock sl(lock);
+    auto& record = clients[client];
+    record.pool = pool;
+    record.pinned = pinned;
+    record.lastUsed = ++useClock;
+}
+
+void MemoryBudget::removeClient(Client* client)
+{
+    const juce::ScopedLock evictionGuard(evictionLock); // Never while someone is evicting it
+    const juce::ScopedLock sl(lock);
+    auto it = clients.find(client);
+    if (it == clients.end())
+    {
+        return;
+    }
+
+    poolBytes[it->second.pool] -= it->second.bytes;
+    totalBytes -= it->second.bytes;
+    clients.erase(it);
+}
+
+void MemoryBudget::setPinned(Client* client, bool pinned)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = clients.find(client);
+    if (it != clients.end())
+    {
+        it->second.pinned = pinned;
+    }
+}
+
+bool MemoryBudget::reserve(Client* client, size_t bytes)
+{
+    const juce::ScopedLock evictionGuard(evictionLock);
+    if (!makeRoom(client, bytes))
+    {
+        return false;
+    }
+
+    account(client, bytes);
+    return true;
+}
+
+size_t MemoryBudget::reserveUpTo(Client* client, size_t bytes)
+{
+    const juce::ScopedLock evictionGuard(evictionLock);
+    makeRoom(client, bytes);
+
+    size_t granted = 0;
+    {
+        const juce::ScopedLock sl(lock);
+        auto it = clients.find(client);
+        if (it == clients.end())
+        {
+            jassertfalse; // addClient() first
+            return 0;
+        }
+
+        auto pool = it->second.pool;
+        auto poolRoom = budgets[pool] > poolBytes[pool] ? budgets[pool] - poolBytes[pool] : 0;
+        auto globalRoom = globalCap > totalBytes ? globalCap - totalBytes : 0;
+        granted = juce::jmin(bytes, poolRoom, globalRoom);
+    }
+
+    account(client, granted);
+    return granted;
+}
+
+void MemoryBudget::charge(Client* client, size_t bytes)
+{
+    const juce::ScopedLock evictionGuard(evictionLock);
+    makeRoom(client, bytes);
+    account(client, bytes);
+}
+
+void MemoryBudget::account(Client* client, size_t bytes)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = clients.find(client);
+    if (it == clients.end())
+    {
+        jassertfalse; // addClient() first
+        return;
+    }
+
+    it->second.bytes += bytes;
+    it->second.lastUsed = ++useClock;
+    poolBytes[it->second.pool] += bytes;
+    totalBytes += bytes;
+}
+
+void MemoryBudget::release(Client* client, size_t bytes)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = clients.find(client);
+    if (it == clients.end())
+    {
+        return;
+    }
+
+    bytes = juce::jmin(bytes, it->second.bytes);
+    it->second.bytes -= bytes;
+    poolBytes[it->second.pool] -= bytes;
+    totalBytes -= bytes;
+}
+
+void MemoryBudget::touch(Client* client)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = clients.find(client);
+    if (it != clients.end())
+    {
+        it->second.lastUsed = ++useClock;
+    }
+}
+
+size_t MemoryBudget::shortfall(Pool pool, size_t bytes) const
+{
+    auto overPool = poolBytes[pool] + bytes > budgets[pool] ? poolBytes[pool] + bytes - budgets[pool] : 0;
+    auto overCap = totalBytes + bytes > globalCap ? totalBytes + bytes - globalCap : 0;
+    return juce::jmax(overPool, overCap);
+}
+
+// Under evictionLock. Victims are asked outside the accounting lock, since evicting takes their own locks.
+bool MemoryBudget::makeRoom(Client* client, size_t bytes)
+{
+    for (int round = 0; round < 4; ++round)
+    {
+        std::vector<std::pair<juce::uint32, Client*>> victims;
+        size_t needed = 0;
+        {
+            const juce::ScopedLock sl(lock);
+            auto it = clients.find(client);
+            if (it == clients.end())
+            {
+                jassertfalse; // addClient() first
+                return false;
+            }
+
+            auto pool = it->second.pool;
+            needed = shortfall(pool, bytes);
+            if (needed == 0)
+            {
+                return true;
+            }
+
+            // Over the pool's own budget only its own pool can help; over the cap, any pool
+            auto poolLimited = poolBytes[pool] + bytes > budgets[pool];
+            for (const auto& [other, record] : clients)
+            {
+                if (other != client && !record.pinned && record.bytes > 0 && (!poolLimited || record.pool == pool))
+                {
+                    victims.emplace_back(record.lastUsed, other);
+                }
+            }
+        }
+
+        if (victims.empty())
+        {
+            return false;
+        }
+
+        std::sort(victims.begin(), victims.end()); // Least recently used first
+        size_t freed = 0;
+        for (const auto& victim : victims)
+        {
+            auto released = victim.second->evict(needed - freed);
+            if (released > 0)
+            {
+                const juce::ScopedLock sl(lock);
+                auto pool = clients[victim.second].pool;
+                ++evictions[pool];
+                evictedBytes[pool] += released;
+            }
+
+            freed += released;
+            if (freed >= needed)
+            {
+                break;
+            }
+        }
+
+        if (freed == 0)
+        {
+            return false;
+        }
+    }
+
+    const juce::ScopedLock sl(lock);
+    return shortfall(clients[client].pool, bytes) == 0;
+}
+
+void MemoryBudget::setBudget(Pool pool, size_t bytes)
+{
+    const juce::ScopedLock sl(lock);
+    budgets[pool] = bytes;
+}
+
+void MemoryBudget::setGlobalCap(size_t bytes)
+{
+    const juce::ScopedLock sl(lock);
+    globalCap = bytes;
+}
+
+size_t MemoryBudget::getGlobalCap() const
+{
+    const juce::ScopedLock sl(lock);
+    return globalCap;
+}
+
+size_t MemoryBudget::getTotalBytes() const
+{
+    const juce::ScopedLock sl(lock);
+    return totalBytes;
+}
+
+MemoryBudget::Stats MemoryBudget::getStats(Pool pool) const
+{
+    Stats stats;
+    stats.hits = counters[pool].hits.load(std::memory_order_relaxed);
+    stats.misses = counters[pool].misses.load(std::memory_order_relaxed);
+
+    const juce::ScopedLock sl(lock);
+    stats.bytes = poolBytes[pool];
+    stats.budget = budgets[pool];
+    stats.evictions = evictions[pool];
+    stats.evictedBytes = evictedBytes[pool];
+    return stats;
+}
+
+juce::String MemoryBudget::getSummary() const
+{
+    const juce::ScopedLock sl(lock);
+    return juce::String::formatted("Mem %d/%d MB", static_cast<int>(totalBytes / megabyte), static_cast<int>(globalCap / megabyte));
+}
+
+juce::String MemoryBudget::getReport() const
+{
+    juce::String report;
+    for (int pool = 0; pool < numPools; ++pool)
+    {
+        auto stats = getStats(static_cast<Pool>(pool));
+        auto lookups = stats.hits + stats.misses;
+        report << juce::String::formatted("%-14s %8.1f / %6.0f MB  hits %5.1f%% of %lld  evicted %lld (%.1f MB)\n",
+                                          poolInfo[pool].name,
+                                          static_cast<double>(stats.bytes) / megabyte,
+                                          static_cast<double>(stats.budget) / megabyte,
+                                          lookups > 0 ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups) : 0.0,
+                                          static_cast<long long>(lookups),
+                                          static_cast<long long>(stats.evictions),
+                                          static_cast<double>(stats.evictedBytes) / megabyte);
+    }
+    report << getSummary() << "\n";
+    return report;
+}
+
+juce::String MemoryBudget::getPoolName(Pool pool)
+{
+    return poolInfo[pool].name;
+}
+
+juce::File MemoryBudget::getSettingsFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("memory-budget.xml");
+}
+
+// <MemoryBudget globalMB="2048" decodedMB="1024" waveformsMB="64" cueMB="256" tagsMB="64" fingerprintsMB="256"/>
+void MemoryBudget::loadSettings()
+{
+    auto xml = juce::XmlDocument::parse(getSettingsFile());
+    if (xml == nullptr || !xml->hasTagName("MemoryBudget"))
+    {
+        return;
+    }
+
+    if (auto megabytes = xml->getIntAttribute("globalMB"); megabytes > 0)
+    {
+        globalCap = static_cast<size_t>(megabytes) * megabyte;
+    }
+
+    for (int pool = 0; pool < numPools; ++pool)
+    {
+        if (auto megabytes = xml->getIntAttribute(juce::String(poolInfo[pool].key) + "MB"); megabytes > 0)
+        {
+            budgets[pool] = static_cast<size_t>(megabytes) * megabyte;
+        }
+    }
+}
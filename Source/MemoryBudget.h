@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    This file defines the MemoryBudget class for a JUCE application,
+    accounting for every cache's memory against per-cache budgets and a global cap.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// MemoryBudget: Caches reserve memory here before allocating it. When a reservation would
+// exceed its pool's budget or the global cap, the least recently used clients that are not
+// pinned are asked to give memory back first; data behind a loaded deck is pinned and never
+// evicted. Clients must not hold their own locks while reserving, since making room may
+// call back into any other client. Defaults scale with physical memory so a set never
+// pushes the machine into swap, and can be overridden in appdata/AudioProj/memory-budget.xml.
+// Hit and miss counters are lock-free, so the audio thread may record them.
+class MemoryBudget
+{
+//==============================================================================
+public:
+    enum Pool
+    {
+        decodedAudio,  // PCM caches behind the decks
+        waveforms,     // Thumbnail overviews held in memory
+        cueBuffers,    // Resident loops, scratch windows and sample pads
+        tagData,       // Interned track tags
+        fingerprints,  // Duplicate finder fingerprints
+        numPools
+    };
+
+    // Client: One cache. Evict is called without the budget's lock held and should free at
+    // least bytesWanted if it can, oldest data first, reporting it through release().
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+        virtual size_t evict(size_t bytesWanted) = 0; // Returns the bytes freed
+    };
+
+    struct Stats
+    {
+        size_t bytes = 0;
+        size_t budget = 0;
+        juce::int64 hits = 0;
+        juce::int64 misses = 0;
+        juce::int64 evictions = 0;
+        size_t evictedBytes = 0;
+    };
+
+    MemoryBudget();
+
+    void addClient(Client* client, Pool pool, bool pinned = false);
+    void removeClient(Client* client); // Releases whatever it still holds
+    void setPinned(Client* client, bool pinned);
+
+    bool reserve(Client* client, size_t bytes);       // All or nothing, evicting others as needed
+    size_t reserveUpTo(Client* client, size_t bytes); // As much as fits after evicting
+    void charge(Client* client, size_t bytes);        // Data that must be held: makes what room it can, then accounts it anyway
+    void release(Client* client, size_t bytes);
+    void touch(Client* client);                       // Mark as recently used
+
+    void recordHit(Pool pool) noexcept { counters[pool].hits.fetch_add(1, std::memory_order_relaxed); }
+    void recordMiss(Pool pool) noexcept { counters[pool].misses.fetch_add(1, std::memory_order_relaxed); }
+
+    void setBudget(Pool pool, size_t bytes);
+    void setGlobalCap(size_t bytes);
+    size_t getGlobalCap() const;
+    size_t getTotalBytes() const;
+    Stats getStats(Pool pool) const;
+    juce::String getSummary() const; // One line for the status bar
+    juce::String getReport() const;  // A line per pool
+
+    static juce::String getPoolName(Pool pool);
+    static juce::File getSettingsFile();
+
+//==============================================================================
+private:
+    struct Record
+    {
+        Pool pool = decodedAudio;
+        size_t bytes = 0;
+        bool pinned = false;
+        juce::uint32 lastUsed = 0;
+    };
+
+    struct Counters
+    {
+        std::atomic<juce::int64> hits{0};
+        std::atomic<juce::int64> misses{0};
+    };
+
+    mutable juce::CriticalSection lock;  // Accounting
+    juce::CriticalSection evictionLock;  // Held while clients are asked to evict, so none is removed meanwhile
+    std::unordered_map<Client*, Record> clients;
+    size_t budgets[numPools] = {};
+    size_t poolBytes[numPools] = {};
+    juce::int64 evictions[numPools] = {};
+    size_t evictedBytes[numPools] = {};
+    size_t globalCap = 0;
+    size_t totalBytes = 0;
+    juce::uint32 useClock = 0;
+    Counters counters[numPools];
+
+    void account(Client* client, size_t bytes);
+    size_t shortfall(Pool pool, size_t bytes) const; // Under the lock
+    bool makeRoom(Client* client, size_t bytes);     // Evicts until the shortfall is gone; false if it cannot be
+    void loadSettings();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryBudget)
+};
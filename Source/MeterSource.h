@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    This file defines the MeterSource class for a JUCE application,
+    the audio-thread side of the level meters and spectrum analyser.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PerfCounter.h"
+
+// MeterSource: Measures block peak/RMS and streams decimated mono samples to the GUI.
+// process() is wait-free and never allocates; everything else is for the GUI thread.
+class MeterSource
+{
+//==============================================================================
+public:
+    MeterSource();
+
+    void prepare(double sampleRate);
+    void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    float getPeakAndReset(int channel) noexcept; // Highest peak since the last call
+    float getRms(int channel) const noexcept;    // RMS of the most recent block
+    int readSamples(float* destination, int maxSamples) noexcept; // Pull decimated samples
+    double getDecimatedSampleRate() const noexcept { return decimatedRate.load(); }
+    juce::int64 getDroppedSamples() const noexcept { return droppedSamples.load(); }
+    const PerfCounter& getCost() const noexcept { return cost; } // Time spent in process()
+
+    static juce::String runBenchmark(); // Cost per block at 64-512 sample buffers, as measured by getCost()
+
+    static constexpr int numChannels = 2;
+    static constexpr int decimation = 2;
+    static constexpr int fifoSize = 8192;
+
+//==============================================================================
+private:
+    std::atomic<float> peak[numChannels];
+    std::atomic<float> rms[numChannels];
+    std::atomic<double> decimatedRate{22050.0};
+    std::atomic<juce::int64> droppedSamples{0};
+
+    juce::AbstractFifo fifo{fifoSize};
+    std::array<float, fifoSize> fifoData{};
+    std::array<float, 1024> scratch{}; // Decimated block staged before the FIFO write
+    float decimationSum{0.0f};
+    int decimationCount{0};
+
+    PerfCounter cost;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterSource)
+};
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MidiController class for a JUCE application,
+    scaling mapped controls into engine commands.
+
+  ==============================================================================
+*/
+
+#include "MidiController.h"
+
+MidiController::MidiController(EngineCommandQueue& queueToFeed)
+    : queue(queueToFeed)
+{
+}
+
+MidiController::~MidiController()
+{
+    detach();
+}
+
+void MidiController::attach(juce::AudioDeviceManager& deviceManager)
+{
+    auto userMapping = MidiMapping::getUserMappingFile();
+    if (userMapping.existsAsFile())
+    {
+        mapping.compile(userMapping.loadFileAsString());
+    }
+
+    for (const auto& device : juce::MidiInput::getAvailableDevices())
+    {
+        deviceManager.setMidiInputDeviceEnabled(device.identifier, true);
+    }
+    deviceManager.addMidiInputDeviceCallback({}, this);
+    attachedManager = &deviceManager;
+
+   #if JUCE_MAC || JUCE_LINUX
+    // Lets another app, or a MIDI file player, drive the decks for testing
+    virtualInput = juce::MidiInput::createNewDevice("AudioProj DJ Controller", this);
+    if (virtualInput != nullptr)
+    {
+        virtualInput->start();
+    }
+   #endif
+}
+
+void MidiController::detach()
+{
+    if (virtualInput != nullptr)
+    {
+        virtualInput->stop();
+        virtualInput.reset();
+    }
+
+    if (attachedManager != nullptr)
+    {
+        attachedManager->removeMidiInputDeviceCallback({}, this);
+        attachedManager = nullptr;
+    }
+}
+
+void MidiController::handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message)
+{
+    const juce::SpinLock::ScopedLockType lock(producerLock);
+    handleMessage(message);
+}
+
+// One table read, a little scaling, one push: no locks, no allocation
+void MidiController::handleMessage(const juce::MidiMessage& message)
+{
+    auto isNote = message.isNoteOnOrOff();
+    if (!isNote && !message.isController())
+    {
+        return;
+    }
+
+    auto number = isNote ? message.getNoteNumber() : message.getControllerNumber();
+    const auto& binding = mapping.lookUp(isNote, message.getChannel(), number);
+    if (!binding.mapped)
+    {
+        return;
+    }
+
+    auto pressed = isNote ? message.isNoteOn() : message.getControllerValue() >= 64;
+    auto level = isNote ? message.getFloatVelocity() : message.getControllerValue() / 127.0f;
+
+    EngineCommand command;
+    command.type = binding.type;
+    command.target = binding.target;
+    command.value = level;
+    command.ticks = juce::Time::getHighResolutionTicks();
+
+    switch (binding.type)
+    {
+        case EngineCommand::pitch:
+            command.value = 0.5f + level; // Same 0.5x..1.5x range as the pitch slider
+            break;
+
+        case EngineCommand::play:
+        case EngineCommand::cue:
+        case EngineCommand::pad:
+            if (!pressed)
+            {
+                return; // Buttons act on the press
+            }
+            break;
+
+        case EngineCommand::jogTouch:
+            command.value = pressed ? 1.0f : 0.0f;
+            break;
+
+        case EngineCommand::jog:
+        {
+            // Relative encoder: 64 is still, above turns forward, below backward
+            auto deck = juce::jlimit(0, 1, binding.target);
+            auto ticks = message.getControllerValue() - 64;
+            auto elapsed = juce::jlimit(0.001, 0.05, message.getTimeStamp() - lastJogTime[deck]);
+            lastJogTime[deck] = message.getTimeStamp();
+            command.value = static_cast<float>(ticks / jogTicksPerRevolution / elapsed / normalRevolutionsPerSecond);
+            break;
+        }
+
+        case EngineCommand::crossfader:
+        case EngineCommand::cueMix:
+        case EngineCommand::volume:
+            break;
+    }
+
+    if (!queue.push(command))
+    {
+        dropped.fetch_add(1);
+    }
+}
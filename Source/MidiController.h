@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    This file defines the MidiController class for a JUCE application,
+    turning controller MIDI into engine commands on the MIDI thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MidiMapping.h"
+#include "EngineCommandQueue.h"
+
+// MidiController: Receives MIDI from every enabled input (and a virtual input where the
+// platform has them), decodes it through the compiled mapping and pushes the result
+// straight onto the engine's command queue. Nothing goes through the message thread;
+// the GUI picks up the new state from the engine on its next timer tick. The device
+// manager's inputs and the virtual input call in on different threads, so a spin lock
+// taken only on this side keeps the queue single-producer; the audio thread never waits.
+class MidiController : public juce::MidiInputCallback
+{
+//==============================================================================
+public:
+    explicit MidiController(EngineCommandQueue& queueToFeed);
+    ~MidiController() override;
+
+    // GUI thread: load the user's mapping (or the default) and open every MIDI input
+    void attach(juce::AudioDeviceManager& deviceManager);
+    void detach();
+
+    // Decode one message; called on the MIDI thread, or by the offline renderer on replay
+    void handleMessage(const juce::MidiMessage& message);
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+
+    int getNumDropped() const noexcept { return dropped.load(); } // Commands lost to a full queue
+
+    static constexpr double jogTicksPerRevolution = 128.0;
+    static constexpr double normalRevolutionsPerSecond = 0.25; // Matches the on-screen platter
+
+//==============================================================================
+private:
+    EngineCommandQueue& queue;
+    MidiMapping mapping;
+    juce::AudioDeviceManager* attachedManager = nullptr;
+    std::unique_ptr<juce::MidiInput> virtualInput;
+    std::atomic<int> dropped{0};
+    juce::SpinLock producerLock; // Serialises the MIDI threads; held for one decode and push
+
+    double lastJogTime[2] = {};  // MIDI thread: timestamp of each deck's previous jog tick
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiController)
+};
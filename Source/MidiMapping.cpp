@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MidiMapping class for a JUCE application,
+    parsing mapping text and filling the lookup table.
+
+  ==============================================================================
+*/
+
+#include "MidiMapping.h"
+
+MidiMapping::MidiMapping()
+{
+    compile(getDefaultMapping());
+}
+
+int MidiMapping::slotFor(bool isNote, int channel, int number) noexcept
+{
+    return (isNote ? 16 * 128 : 0) + (channel - 1) * 128 + number;
+}
+
+int MidiMapping::compile(const juce::String& mappingText)
+{
+    table.fill({});
+    int errors = 0;
+
+    for (auto line : juce::StringArray::fromLines(mappingText))
+    {
+        line = line.upToFirstOccurrenceOf("#", false, false).trim();
+        if (line.isEmpty())
+        {
+            continue;
+        }
+
+        auto tokens = juce::StringArray::fromTokens(line, false);
+        tokens.removeEmptyStrings();
+        auto kind = tokens[0].toLowerCase();
+        auto channel = tokens[1].getIntValue();
+        auto number = tokens[2].getIntValue();
+        auto action = tokens[3].toLowerCase();
+        auto targetText = tokens[4].toUpperCase();
+
+        if ((kind != "cc" && kind != "note") || channel < 1 || channel > 16
+            || !tokens[2].containsOnly("0123456789") || number > 127)
+        {
+            ++errors;
+            continue;
+        }
+
+        static const std::pair<const char*, EngineCommand::Type> actions[] = {
+            { "crossfader", EngineCommand::crossfader }, { "cuemix", EngineCommand::cueMix },
+            { "volume", EngineCommand::volume },         { "pitch", EngineCommand::pitch },
+            { "play", EngineCommand::play },             { "cue", EngineCommand::cue },
+            { "jogtouch", EngineCommand::jogTouch },     { "jog", EngineCommand::jog },
+            { "pad", EngineCommand::pad }
+        };
+
+        Binding binding;
+        for (const auto& [name, type] : actions)
+        {
+            if (action == name)
+            {
+                binding.mapped = true;
+                binding.type = type;
+            }
+        }
+
+        if (!binding.mapped)
+        {
+            ++errors;
+            continue;
+        }
+
+        // Decks are A/B (or 1/2); pads are numbered from 1
+        if (binding.type == EngineCommand::pad)
+        {
+            binding.target = targetText.getIntValue() - 1;
+        }
+        else if (targetText == "B" || targetText == "2")
+        {
+            binding.target = 1;
+        }
+
+        table[static_cast<size_t>(slotFor(kind == "note", channel, number))] = binding;
+    }
+
+    return errors;
+}
+
+const MidiMapping::Binding& MidiMapping::lookUp(bool isNote, int channel, int number) const noexcept
+{
+    return table[static_cast<size_t>(slotFor(isNote, channel, number))];
+}
+
+// A generic two-channel layout: deck A on channel 1, deck B on channel 2, pads on the drum channel
+juce::String MidiMapping::getDefaultMapping()
+{
+    return "# <cc|note> <channel> <number> <action> [deck A/B | pad 1-16]\n"
+           "cc   1 7  volume A\n"
+           "cc   2 7  volume B\n"
+           "cc   1 1  pitch A\n"
+           "cc   2 1  pitch B\n"
+           "cc   1 16 jog A\n"
+           "cc   2 16 jog B\n"
+           "note 1 54 jogtouch A\n"
+           "note 2 54 jogtouch B\n"
+           "note 1 11 play A\n"
+           "note 2 11 play B\n"
+           "note 1 12 cue A\n"
+           "note 2 12 cue B\n"
+           "cc   1 10 crossfader\n"
+           "cc   1 11 cuemix\n"
+           "note 10 36 pad 1\nnote 10 37 pad 2\nnote 10 38 pad 3\nnote 10 39 pad 4\n"
+           "note 10 40 pad 5\nnote 10 41 pad 6\nnote 10 42 pad 7\nnote 10 43 pad 8\n"
+           "note 10 44 pad 9\nnote 10 45 pad 10\nnote 10 46 pad 11\nnote 10 47 pad 12\n"
+           "note 10 48 pad 13\nnote 10 49 pad 14\nnote 10 50 pad 15\nnote 10 51 pad 16\n";
+}
+
+juce::File MidiMapping::getUserMappingFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("midi-mapping.txt");
+}
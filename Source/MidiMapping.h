@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    This file defines the MidiMapping class for a JUCE application,
+    compiling a controller mapping into a flat lookup table.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "EngineCommandQueue.h"
+
+// MidiMapping: A mapping is written as text, one control per line:
+//     <cc|note> <channel 1-16> <number 0-127> <action> [deck A/B or pad 1-16]
+// and compiled once into a table with a slot for every note and controller on every
+// channel, so decoding a message on the MIDI thread is a single indexed read.
+class MidiMapping
+{
+//==============================================================================
+public:
+    struct Binding
+    {
+        bool mapped = false;
+        EngineCommand::Type type = EngineCommand::crossfader;
+        int target = 0;
+    };
+
+    MidiMapping(); // Starts with the default mapping
+
+    // GUI thread, before the controller is attached. Returns the number of lines that
+    // could not be parsed; those are skipped.
+    int compile(const juce::String& mappingText);
+    const Binding& lookUp(bool isNote, int channel, int number) const noexcept;
+
+    static juce::String getDefaultMapping();
+    static juce::File getUserMappingFile(); // Loaded instead of the default when present
+
+//==============================================================================
+private:
+    static constexpr int numSlots = 2 * 16 * 128;
+    std::array<Binding, numSlots> table;
+
+    static int slotFor(bool isNote, int channel, int number) noexcept; // channel 1..16
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMapping)
+};
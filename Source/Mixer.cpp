@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the Mixer class for a JUCE application,
+    applying the crossfader curves and deck faders and limiting the master bus.
+
+  ==============================================================================
+*/
+
+#include "Mixer.h"
+#include "DeckGUI.h"
+
+// Constructor: Precompute every crossfader curve so the audio thread only interpolates
+Mixer::Mixer()
+{
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        auto position = static_cast<float>(i) / tableSize;
+        auto index = static_cast<size_t>(i);
+
+        curveTables[constantPower][index] = std::cos(position * juce::MathConstants<float>::halfPi);
+        curveTables[linear][index] = 1.0f - position;
+        curveTables[cut][index] = juce::jlimit(0.0f, 1.0f, (1.0f - position) / cutWidth);
+    }
+}
+
+void Mixer::setDecks(DeckGUI* deckA, DeckGUI* deckB)
+{
+    decks[0] = deckA;
+    decks[1] = deckB;
+}
+
+// Prepare the decks and size every buffer for the largest block we expect
+void Mixer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    for (auto* deck : decks)
+    {
+        if (deck != nullptr)
+        {
+            deck->prepareToPlay(samplesPerBlockExpected, sampleRate);
+        }
+    }
+
+    auto capacity = juce::jmax(samplesPerBlockExpected, 4096);
+    mixBuffer.setSize(2, capacity); // Only used on mono devices
+    deckBuffer.setSize(2, capacity);
+    gainRamps.setSize(numDecks, capacity);
+
+    crossfader.reset(sampleRate, 0.01);
+    crossfader.setCurrentAndTargetValue(crossfaderTarget.load());
+    curveBlend.reset(sampleRate, 0.02);
+    curveBlend.setCurrentAndTargetValue(1.0f);
+    activeCurve = previousCurve = curveTarget.load();
+
+    for (int i = 0; i < numDecks; ++i)
+    {
+        deckVolumes[i].reset(sampleRate, 0.02);
+        deckVolumes[i].setCurrentAndTargetValue(decks[i] != nullptr ? decks[i]->getVolume() : 0.0f);
+        cueGains[i].reset(sampleRate, 0.01);
+        cueGains[i].setCurrentAndTargetValue(0.0f);
+    }
+    cueMix.reset(sampleRate, 0.02);
+    cueMix.setCurrentAndTargetValue(cueMixTarget.load());
+
+    padBank.prepare(sampleRate);
+    limiter.prepare(sampleRate);
+    masterMeterSource.prepare(sampleRate);
+    recorder.prepare(sampleRate);
+}
+
+// Audio thread: decks -> fader and crossfader ramps, plus pads -> limiter -> meter and recorder.
+// The master is summed straight into output channels 1/2 and the cue bus into 3/4, so the
+// extra bus costs no intermediate buffer or final copy.
+void Mixer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto numSamples = bufferToFill.numSamples;
+    auto& output = *bufferToFill.buffer;
+    auto outputChannels = output.getNumChannels();
+    auto hasCueOutputs = outputChannels >= 4;
+    cueOutputsPresent.store(hasCueOutputs);
+
+    applyCommands(); // Controller moves land in this block
+
+    // Only reallocates if the device delivers a larger block than prepareToPlay announced
+    deckBuffer.setSize(2, numSamples, false, false, true);
+    gainRamps.setSize(numDecks, numSamples, false, false, true);
+
+    // A mono device still gets a stereo master, folded down at the end
+    auto renderInPlace = outputChannels >= 2;
+    if (!renderInPlace)
+    {
+        mixBuffer.setSize(2, numSamples, false, false, true);
+    }
+    auto& master = renderInPlace ? output : mixBuffer;
+    auto masterStart = renderInPlace ? bufferToFill.startSample : 0;
+
+    master.clear(0, masterStart, numSamples);
+    master.clear(1, masterStart, numSamples);
+    if (hasCueOutputs)
+    {
+        output.clear(2, bufferToFill.startSample, numSamples);
+        output.clear(3, bufferToFill.startSample, numSamples);
+    }
+
+    renderGainRamps(numSamples);
+
+    juce::AudioSourceChannelInfo deckInfo(&deckBuffer, 0, numSamples);
+    for (int i = 0; i < numDecks; ++i)
+    {
+        if (decks[i] == nullptr)
+        {
+            continue;
+        }
+
+        decks[i]->getNextAudioBlock(deckInfo);
+
+        // Fold the deck fader into this deck's crossfade ramp
+        auto* ramp = gainRamps.getWritePointer(i);
+        deckVolumes[i].setTargetValue(decks[i]->getVolume());
+        for (int s = 0; s < numSamples; ++s)
+        {
+            ramp[s] *= deckVolumes[i].getNextValue();
+        }
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            juce::FloatVectorOperations::addWithMultiply(master.getWritePointer(ch, masterStart),
+                                                         deckBuffer.getReadPointer(ch), ramp, numSamples);
+        }
+
+        // Pre-fader listen: the same deck signal, ramped in and out by its PFL button
+        cueGains[i].setTargetValue(decks[i]->isCueEnabled() ? 1.0f : 0.0f);
+        if (!hasCueOutputs || (!cueGains[i].isSmoothing() && cueGains[i].getTargetValue() == 0.0f))
+        {
+            cueGains[i].skip(numSamples);
+            continue;
+        }
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            ramp[s] = cueGains[i].getNextValue(); // The crossfade ramp is spent, so reuse it
+        }
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            juce::FloatVectorOperations::addWithMultiply(output.getWritePointer(ch + 2, bufferToFill.startSample),
+                                                         deckBuffer.getReadPointer(ch), ramp, numSamples);
+        }
+    }
+
+    padBank.renderNextBlock(master, masterStart, numSamples); // Pads bypass the crossfader
+    limiter.process(master, masterStart, numSamples);
+    masterMeterSource.process(master, masterStart, numSamples);
+    recorder.pushBlock(master, masterStart, numSamples);
+
+    if (hasCueOutputs)
+    {
+        // Cue/master knob: blend the limited master into the headphones
+        cueMix.setTargetValue(cueMixTarget.load());
+        auto* cueLeft = output.getWritePointer(2, bufferToFill.startSample);
+        auto* cueRight = output.getWritePointer(3, bufferToFill.startSample);
+        auto* masterLeft = output.getReadPointer(0, bufferToFill.startSample);
+        auto* masterRight = output.getReadPointer(1, bufferToFill.startSample);
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            auto amount = cueMix.getNextValue();
+            cueLeft[s] += amount * (masterLeft[s] - cueLeft[s]);
+            cueRight[s] += amount * (masterRight[s] - cueRight[s]);
+        }
+    }
+    else
+    {
+        cueMix.skip(numSamples);
+    }
+
+    for (int ch = hasCueOutputs ? 4 : 2; ch < outputChannels; ++ch)
+    {
+        output.clear(ch, bufferToFill.startSample, numSamples);
+    }
+
+    if (!renderInPlace && outputChannels == 1)
+    {
+        output.copyFrom(0, bufferToFill.startSample, mixBuffer, 0, 0, numSamples, 0.5f);
+        output.addFrom(0, bufferToFill.startSample, mixBuffer, 1, 0, numSamples, 0.5f);
+    }
+}
+
+// Audio thread: mixer controls are applied here, deck controls by the deck itself
+void Mixer::applyCommands() noexcept
+{
+    EngineCommand command;
+    while (commands.pop(command))
+    {
+        commandLatency.addSample(juce::Time::getHighResolutionTicks() - command.ticks);
+
+        switch (command.type)
+        {
+            case EngineCommand::crossfader:
+                crossfaderTarget.store(juce::jlimit(0.0f, 1.0f, command.value));
+                break;
+
+            case EngineCommand::cueMix:
+                cueMixTarget.store(juce::jlimit(0.0f, 1.0f, command.value));
+                break;
+
+            case EngineCommand::pad:
+                padBank.triggerNow(command.target, command.value, command.ticks);
+                break;
+
+            default:
+                if (command.target >= 0 && command.target < numDecks && decks[command.target] != nullptr)
+                {
+                    decks[command.target]->applyCommand(command);
+                }
+                break;
+        }
+    }
+}
+
+void Mixer::releaseResources()
+{
+    for (auto* deck : decks)
+    {
+        if (deck != nullptr)
+        {
+            deck->releaseResources();
+        }
+    }
+}
+
+void Mixer::setCrossfader(float position)
+{
+    crossfaderTarget.store(juce::jlimit(0.0f, 1.0f, position));
+}
+
+void Mixer::setCueMix(float masterAmount)
+{
+    cueMixTarget.store(juce::jlimit(0.0f, 1.0f, masterAmount));
+}
+
+void Mixer::setCurve(Curve curve)
+{
+    curveTarget.store(juce::jlimit(0, numCurves - 1, static_cast<int>(curve)));
+}
+
+juce::String Mixer::getCurveName(Curve curve)
+{
+    switch (curve)
+    {
+        case constantPower: return "Smooth";
+        case linear:        return "Linear";
+        case cut:           return "Cut";
+        case numCurves:     break;
+    }
+    return {};
+}
+
+// Linear interpolation into a curve table
+float Mixer::lookUp(int curve, float position) const noexcept
+{
+    auto scaled = position * tableSize;
+    auto index = juce::jlimit(0, tableSize - 1, static_cast<int>(scaled));
+    auto fraction = scaled - static_cast<float>(index);
+    const auto& table = curveTables[static_cast<size_t>(curve)];
+    return table[static_cast<size_t>(index)]
+         + fraction * (table[static_cast<size_t>(index + 1)] - table[static_cast<size_t>(index)]);
+}
+
+// Per-sample crossfade gains for both decks. A curve change blends from the old
+// curve to the new one rather than stepping the gains.
+void Mixer::renderGainRamps(int numSamples) noexcept
+{
+    auto requestedCurve = curveTarget.load();
+    if (requestedCurve != activeCurve)
+    {
+        previousCurve = activeCurve;
+        activeCurve = requestedCurve;
+        curveBlend.setCurrentAndTargetValue(0.0f);
+        curveBlend.setTargetValue(1.0f);
+    }
+
+    crossfader.setTargetValue(crossfaderTarget.load());
+    auto* gainA = gainRamps.getWritePointer(0);
+    auto* gainB = gainRamps.getWritePointer(1);
+
+    for (int s = 0; s < numSamples; ++s)
+    {
+        auto position = crossfader.getNextValue();
+        gainA[s] = lookUp(activeCurve, position);
+        gainB[s] = lookUp(activeCurve, 1.0f - position);
+
+        if (curveBlend.isSmoothing())
+        {
+            auto blend = curveBlend.getNextValue();
+            gainA[s] = lookUp(previousCurve, position) + blend * (gainA[s] - lookUp(previousCurve, position));
+            gainB[s] = lookUp(previousCurve, 1.0f - position) + blend * (gainB[s] - lookUp(previousCurve, 1.0f - position));
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    This file defines the Mixer class for a JUCE application,
+    summing the decks through the crossfader into the limited master bus.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MeterSource.h"
+#include "MasterLimiter.h"
+#include "SessionRecorder.h"
+#include "SamplePadBank.h"
+#include "EngineCommandQueue.h"
+#include "PerfCounter.h"
+
+class DeckGUI; // Forward declaration
+
+// Mixer: Owns the master bus. Controls are set from the GUI thread as atomic targets;
+// the audio thread smooths them into per-sample gain ramps, so moving the crossfader
+// or a deck fader never zippers. With four outputs, 1/2 carry the master and 3/4 a
+// headphone cue bus fed by each deck's PFL button. All buffers are sized in prepareToPlay.
+class Mixer
+{
+//==============================================================================
+public:
+    enum Curve { constantPower = 0, linear, cut, numCurves };
+    static constexpr int numDecks = 2;
+
+    Mixer();
+
+    void setDecks(DeckGUI* deckA, DeckGUI* deckB); // Call before audio starts
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+    void releaseResources();
+
+    void setCrossfader(float position); // 0 = deck A only, 1 = deck B only
+    void setCurve(Curve curve);
+    void setCueMix(float masterAmount); // Headphones: 0 = cue only, 1 = master only
+    bool hasCueOutputs() const noexcept { return cueOutputsPresent.load(); } // Device has outputs 3/4
+    static juce::String getCurveName(Curve curve);
+    float getCrossfader() const noexcept { return crossfaderTarget.load(); } // Also moved by MIDI
+    float getCueMix() const noexcept { return cueMixTarget.load(); }
+
+    MeterSource& getMasterMeterSource() noexcept { return masterMeterSource; }
+    MasterLimiter& getLimiter() noexcept { return limiter; }
+    SessionRecorder& getRecorder() noexcept { return recorder; }
+    SamplePadBank& getPadBank() noexcept { return padBank; }
+    EngineCommandQueue& getCommandQueue() noexcept { return commands; } // Controller input, drained each block
+    const PerfCounter& getCommandLatency() const noexcept { return commandLatency; } // Arrival to callback
+
+//==============================================================================
+private:
+    static constexpr int tableSize = 256;
+    static constexpr float cutWidth = 0.04f; // Travel over which the cut curve fades at each end
+
+    // Gain of deck A against crossfader position; deck B reads the table mirrored
+    std::array<std::array<float, tableSize + 1>, numCurves> curveTables;
+
+    DeckGUI* decks[numDecks] = {};
+
+    std::atomic<float> crossfaderTarget{0.5f};
+    std::atomic<int> curveTarget{constantPower};
+    int activeCurve = constantPower;
+    int previousCurve = constantPower;
+    juce::SmoothedValue<float> crossfader;
+    juce::SmoothedValue<float> curveBlend;    // 0 = previousCurve, 1 = activeCurve
+    juce::SmoothedValue<float> deckVolumes[numDecks];
+    juce::SmoothedValue<float> cueGains[numDecks];
+    std::atomic<float> cueMixTarget{0.0f};
+    juce::SmoothedValue<float> cueMix;
+    std::atomic<bool> cueOutputsPresent{false};
+
+    juce::AudioBuffer<float> mixBuffer;  // Master sum when the device has fewer than two outputs
+    juce::AudioBuffer<float> deckBuffer; // One deck's output
+    juce::AudioBuffer<float> gainRamps;  // Per-sample crossfade gains, one channel per deck
+
+    EngineCommandQueue commands;
+    PerfCounter commandLatency;
+    SamplePadBank padBank;
+    MasterLimiter limiter;
+    MeterSource masterMeterSource;
+    SessionRecorder recorder;
+
+    float lookUp(int curve, float position) const noexcept;
+    void applyCommands() noexcept;
+    void renderGainRamps(int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Mixer)
+};
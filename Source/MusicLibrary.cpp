@@ -1,329 +1,790 @@
-/*
-  ==============================================================================
-
-    This file contains the implementation of the MusicLibrary class for a JUCE application,
-    handling track management, search, and crossfader functionality.
-
-  ==============================================================================
-*/
-
-#include "MusicLibrary.h"
-#include "DeckGUI.h"
-
-// Custom crossfader appearance
-void MusicLibrary::CrossfaderLookAndFeel::drawLinearSlider(juce::Graphics& g, int x, int y, int width, int height,
-                                                         float sliderPos, float minSliderPos, float maxSliderPos,
-                                                         const juce::Slider::SliderStyle, juce::Slider& slider)
-{
-    auto trackBounds = juce::Rectangle<float>(x, y + height * 0.4f, width, height * 0.2f);
-    g.setColour(juce::Colours::black);
-    g.fillRoundedRectangle(trackBounds, 2.0f);
-
-    g.setColour(juce::Colours::grey.darker(0.5f));
-    for (int i = 0; i <= 10; ++i)
-    {
-        float tickX = x + (width * i / 10.0f);
-        g.drawVerticalLine(static_cast<int>(tickX), trackBounds.getY() - 5, trackBounds.getBottom() + 5);
-    }
-
-    auto thumbWidth = 12.0f;
-    auto thumbHeight = 20.0f;
-    auto thumbBounds = juce::Rectangle<float>(sliderPos - thumbWidth / 2, y + (height - thumbHeight) / 2, thumbWidth, thumbHeight);
-    g.setColour(juce::Colours::orange);
-    g.fillRect(thumbBounds);
-    g.setColour(juce::Colours::black.withAlpha(0.3f));
-    g.drawRect(thumbBounds, 1.0f);
-}
-
-// Constructor: Initialize UI components
-MusicLibrary::MusicLibrary()
-{
-    addAndMakeVisible(searchBox);
-    addAndMakeVisible(trackList);
-    addAndMakeVisible(leftArrowButton);
-    addAndMakeVisible(addButton);
-    addAndMakeVisible(deleteButton);
-    addAndMakeVisible(rightArrowButton);
-    addAndMakeVisible(crossfaderSlider);
-    addAndMakeVisible(crossfaderLabel);
-
-    searchBox.addListener(this);
-    trackList.setModel(this);
-    crossfaderSlider.addListener(this);
-    
-    searchBox.setTextToShowWhenEmpty("Search tracks...", juce::Colours::grey);
-    
-    leftArrowButton.onClick = [this] { leftArrowClicked(); };
-    addButton.onClick = [this] { addButtonClicked(); };
-    deleteButton.onClick = [this] { deleteButtonClicked(); };
-    rightArrowButton.onClick = [this] { rightArrowClicked(); };
-    
-    crossfaderSlider.setRange(0.0, 1.0);
-    crossfaderSlider.setValue(0.5);
-    crossfaderSlider.setLookAndFeel(&crossfaderLookAndFeel);
-    crossfaderSlider.setSliderStyle(juce::Slider::LinearHorizontal);
-    crossfaderSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
-    
-    crossfaderLabel.setText("Crossfader", juce::dontSendNotification);
-    crossfaderLabel.setFont(juce::FontOptions(14.0f));
-    crossfaderLabel.setJustificationType(juce::Justification::centred);
-
-    libraryFile = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
-        .getChildFile("dj_library.xml");
-    loadLibrary();
-}
-
-MusicLibrary::~MusicLibrary()
-{
-    crossfaderSlider.setLookAndFeel(nullptr);
-    saveLibrary(); // Persist library on shutdown
-}
-
-// Draw the music library UI with a gradient background and rounded borders
-void MusicLibrary::paint(juce::Graphics& g)
-{
-    juce::ColourGradient gradient(
-        juce::Colours::lightgrey.brighter(0.2f), 0, 0,
-        juce::Colours::lightgrey.darker(0.1f), 0, getHeight(),
-        false);
-    gradient.addColour(0.7, juce::Colours::lightgrey);
-    g.setGradientFill(gradient);
-    g.fillRoundedRectangle(getLocalBounds().toFloat(), 12.0f);
-
-    g.setColour(juce::Colours::white.withAlpha(0.1f));
-    g.drawRoundedRectangle(getLocalBounds().reduced(1).toFloat(), 12.0f, 3.0f);
-
-    g.setColour(juce::Colours::grey.darker(0.7f).withAlpha(0.8f));
-    g.drawRoundedRectangle(getLocalBounds().toFloat(), 12.0f, 1.5f);
-}
-
-// Arrange UI components (search box, buttons, crossfader, track list) within the library
-void MusicLibrary::resized()
-{
-    auto area = getLocalBounds().reduced(5);
-    searchBox.setBounds(area.removeFromTop(30));
-    
-    auto controlArea = area.removeFromBottom(80);
-    auto buttonArea = controlArea.removeFromTop(30);
-    leftArrowButton.setBounds(buttonArea.removeFromLeft(30).reduced(2));
-    addButton.setBounds(buttonArea.removeFromLeft(120).reduced(2));
-    deleteButton.setBounds(buttonArea.removeFromLeft(120).reduced(2));
-    rightArrowButton.setBounds(buttonArea.removeFromRight(30).reduced(2));
-    
-    auto crossfaderArea = controlArea;
-    crossfaderLabel.setBounds(crossfaderArea.removeFromTop(20).reduced(5));
-    crossfaderSlider.setBounds(crossfaderArea.reduced(5, 2));
-    
-    trackList.setBounds(area);
-}
-
-// Update track list display when search text changes
-void MusicLibrary::textEditorTextChanged(juce::TextEditor&)
-{
-    trackList.updateContent(); // Refresh list on search input
-}
-
-// Adjust deck volumes based on crossfader position
-void MusicLibrary::sliderValueChanged(juce::Slider* slider)
-{
-    if (slider == &crossfaderSlider && deck1Ptr != nullptr && deck2Ptr != nullptr)
-    {
-        float value = static_cast<float>(crossfaderSlider.getValue());
-        deck1Ptr->getVolume() = 1.0f - value;
-        deck2Ptr->getVolume() = value;
-    }
-}
-
-// Count visible rows based on search filter
-int MusicLibrary::getNumRows()
-{
-    auto searchText = searchBox.getText().toLowerCase();
-    if (searchText.isEmpty())
-        return tracks.size();
-    
-    int count = 0;
-    for (const auto& track : tracks)
-        if (track.getFileName().toLowerCase().contains(searchText))
-            count++;
-    return count;
-}
-
-// Draw a single track item in the list box, applying search filter and selection styling
-void MusicLibrary::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
-{
-    auto searchText = searchBox.getText().toLowerCase();
-    int visibleRow = 0;
-    
-    for (int i = 0; i < tracks.size(); i++)
-    {
-        if (searchText.isEmpty() || tracks[i].getFileName().toLowerCase().contains(searchText))
-        {
-            if (visibleRow == rowNumber)
-            {
-                g.fillAll(rowIsSelected ? juce::Colours::lightblue : (rowNumber % 2 == 0 ? juce::Colours::white : juce::Colours::lightgrey.brighter(0.5f)));
-                g.setColour(juce::Colours::black);
-                g.setFont(juce::FontOptions(16.0f));
-                g.drawText(tracks[i].getFileName(), 10, 0, width - 20, height, juce::Justification::centredLeft);
-                break;
-            }
-            visibleRow++;
-        }
-    }
-}
-
-// Handle track selection when a list box item is clicked
-void MusicLibrary::listBoxItemClicked(int row, const juce::MouseEvent&)
-{
-    trackList.selectRow(row);
-}
-
-// Get file of selected track, accounting for search filter
-juce::File MusicLibrary::getSelectedTrack()
-{
-    int row = trackList.getSelectedRow();
-    if (row < 0) return juce::File();
-    
-    auto searchText = searchBox.getText().toLowerCase();
-    int visibleRow = 0;
-    
-    for (int i = 0; i < tracks.size(); i++)
-    {
-        if (searchText.isEmpty() || tracks[i].getFileName().toLowerCase().contains(searchText))
-        {
-            if (visibleRow == row)
-            {
-                return tracks[i];
-            }
-            visibleRow++;
-        }
-    }
-    return juce::File();
-}
-
-// Add a new track to the library if it exists and isn’t already present
-void MusicLibrary::addTrack(const juce::File& file)
-{
-    if (file.existsAsFile() && !tracks.contains(file))
-    {
-        tracks.add(file);
-        trackList.updateContent(); // Refresh the track list display
-    }
-}
-
-// Load track list from XML file
-void MusicLibrary::loadLibrary()
-{
-    tracks.clear();
-    
-    if (libraryFile.existsAsFile())
-    {
-        std::unique_ptr<juce::XmlElement> xml = juce::XmlDocument::parse(libraryFile);
-        if (xml && xml->hasTagName("MusicLibrary"))
-        {
-            for (auto* element : xml->getChildIterator())
-            {
-                if (element->hasTagName("Track"))
-                {
-                    juce::String path = element->getStringAttribute("path");
-                    juce::File trackFile(path);
-                    if (trackFile.existsAsFile())
-                    {
-                        tracks.add(trackFile);
-                    }
-                }
-            }
-        }
-    }
-    trackList.updateContent();
-}
-
-// Save track list to XML file
-void MusicLibrary::saveLibrary()
-{
-    juce::XmlElement xml("MusicLibrary");
-    
-    for (const auto& track : tracks)
-    {
-        auto* trackElement = xml.createNewChildElement("Track");
-        trackElement->setAttribute("path", track.getFullPathName());
-    }
-    
-    if (!xml.writeTo(libraryFile))
-    {
-        DBG("Failed to save music library to " << libraryFile.getFullPathName());
-    }
-}
-
-// Link the music library to two decks and initialize their volumes
-void MusicLibrary::setDecks(DeckGUI* deck1, DeckGUI* deck2)
-{
-    deck1Ptr = deck1;
-    deck2Ptr = deck2;
-    if (deck1Ptr && deck2Ptr)
-    {
-        deck1Ptr->getVolume() = 0.5f;
-        deck2Ptr->getVolume() = 0.5f; // Balance volumes initially
-    }
-}
-
-// Load the selected track into Deck 1 when the left arrow is clicked
-void MusicLibrary::leftArrowClicked()
-{
-    juce::File selectedTrack = getSelectedTrack();
-    if (selectedTrack.exists() && deck1Ptr != nullptr)
-    {
-        deck1Ptr->loadFile(selectedTrack);
-    }
-}
-
-// Load the selected track into Deck 2 when the right arrow is clicked
-void MusicLibrary::rightArrowClicked()
-{
-    juce::File selectedTrack = getSelectedTrack();
-    if (selectedTrack.exists() && deck2Ptr != nullptr)
-    {
-        deck2Ptr->loadFile(selectedTrack);
-    }
-}
-
-// Open file chooser to add new track
-void MusicLibrary::addButtonClicked()
-{
-    auto fileChooserFlags = juce::FileBrowserComponent::canSelectFiles;
-    fChooser.launchAsync(fileChooserFlags, [this](const juce::FileChooser& chooser)
-    {
-        juce::File chosenFile = chooser.getResult();
-        if (chosenFile != juce::File())
-        {
-            DBG("Adding file: " << chosenFile.getFullPathName());
-            addTrack(chosenFile);
-        }
-    });
-}
-
-// Remove selected track from list
-void MusicLibrary::deleteButtonClicked()
-{
-    int selectedRow = trackList.getSelectedRow();
-    if (selectedRow >= 0)
-    {
-        auto searchText = searchBox.getText().toLowerCase();
-        int visibleRow = 0;
-        
-        for (int i = 0; i < tracks.size(); i++)
-        {
-            if (searchText.isEmpty() || tracks[i].getFileName().toLowerCase().contains(searchText))
-            {
-                if (visibleRow == selectedRow)
-                {
-                    DBG("Deleting track: " << tracks[i].getFullPathName());
-                    tracks.remove(i);
-                    trackList.updateContent();
-                    trackList.deselectAllRows();
-                    break;
-                }
-                visibleRow++;
-            }
-        }
-    }
-}
+/*
+  ==============================================================================
+
+    This file contains the implementation of the MusicLibrary class for a JUCE application,
+    handling track management, search, and crossfader functionality.
+
+  ==============================================================================
+*/
+
+#include "MusicLibrary.h"
+#include "DeckGUI.h"
+#include "Mixer.h"
+#include "StartupTrace.h"
+#include "AnalysisCache.h"
+
+// Custom crossfader appearance
+void MusicLibrary::CrossfaderLookAndFeel::drawLinearSlider(juce::Graphics& g, int x, int y, int width, int height,
+                                                         float sliderPos, float minSliderPos, float maxSliderPos,
+                                                         const juce::Slider::SliderStyle, juce::Slider& slider)
+{
+    auto trackBounds = juce::Rectangle<float>(x, y + height * 0.4f, width, height * 0.2f);
+    g.setColour(juce::Colours::black);
+    g.fillRoundedRectangle(trackBounds, 2.0f);
+
+    g.setColour(juce::Colours::grey.darker(0.5f));
+    for (int i = 0; i <= 10; ++i)
+    {
+        float tickX = x + (width * i / 10.0f);
+        g.drawVerticalLine(static_cast<int>(tickX), trackBounds.getY() - 5, trackBounds.getBottom() + 5);
+    }
+
+    auto thumbWidth = 12.0f;
+    auto thumbHeight = 20.0f;
+    auto thumbBounds = juce::Rectangle<float>(sliderPos - thumbWidth / 2, y + (height - thumbHeight) / 2, thumbWidth, thumbHeight);
+    g.setColour(juce::Colours::orange);
+    g.fillRect(thumbBounds);
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.drawRect(thumbBounds, 1.0f);
+}
+
+// Constructor: Initialize UI components and start reading the saved library
+MusicLibrary::MusicLibrary()
+    : juce::Thread("Library loader")
+{
+    addAndMakeVisible(searchBox);
+    addAndMakeVisible(trackList);
+    addAndMakeVisible(leftArrowButton);
+    addAndMakeVisible(addButton);
+    addAndMakeVisible(deleteButton);
+    addAndMakeVisible(rightArrowButton);
+    addAndMakeVisible(duplicatesButton);
+    addAndMakeVisible(cratesButton);
+    addAndMakeVisible(crossfaderSlider);
+    addAndMakeVisible(crossfaderLabel);
+    addAndMakeVisible(curveSelector);
+
+    searchBox.addListener(this);
+    trackList.setModel(this);
+    crossfaderSlider.addListener(this);
+    
+    searchBox.setTextToShowWhenEmpty("Search tracks...", juce::Colours::grey);
+    tagCache.onTagsArrived = [this](const juce::Array<juce::File>& files)
+    {
+        for (const auto& file : files)
+        {
+            indexTags(libraryFilter.indexOf(file)); // Found by later searches too
+        }
+        trackList.repaint(); // Rows repaint as their tags arrive
+    };
+    
+    leftArrowButton.onClick = [this] { leftArrowClicked(); };
+    addButton.onClick = [this] { addButtonClicked(); };
+    deleteButton.onClick = [this] { deleteButtonClicked(); };
+    rightArrowButton.onClick = [this] { rightArrowClicked(); };
+    duplicatesButton.onClick = [this] { duplicatesButtonClicked(); };
+    cratesButton.onClick = [this] { cratesButtonClicked(); };
+    duplicatesButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::orange.darker(0.3f));
+    duplicatesButton.setEnabled(false); // Until a finder is linked
+    
+    crossfaderSlider.setRange(0.0, 1.0);
+    crossfaderSlider.setValue(0.5);
+    crossfaderSlider.setLookAndFeel(&crossfaderLookAndFeel);
+    crossfaderSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    crossfaderSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    
+    crossfaderLabel.setText("Crossfader", juce::dontSendNotification);
+    crossfaderLabel.setFont(juce::FontOptions(14.0f));
+    crossfaderLabel.setJustificationType(juce::Justification::centred);
+
+    for (int curve = 0; curve < Mixer::numCurves; ++curve)
+    {
+        curveSelector.addItem(Mixer::getCurveName(static_cast<Mixer::Curve>(curve)), curve + 1);
+    }
+    curveSelector.setSelectedId(Mixer::constantPower + 1, juce::dontSendNotification);
+    curveSelector.onChange = [this]
+    {
+        if (mixer != nullptr)
+        {
+            mixer->setCurve(static_cast<Mixer::Curve>(curveSelector.getSelectedId() - 1));
+        }
+    };
+
+    libraryFile = getLibraryFile();
+    startThread(juce::Thread::Priority::normal);
+}
+
+MusicLibrary::~MusicLibrary()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+    crossfaderSlider.setLookAndFeel(nullptr);
+
+    if (libraryLoaded || mergeLoadedTracks())
+    {
+        saveLibrary(); // Persist library on shutdown
+    }
+}
+
+// Draw the music library UI with a gradient background and rounded borders
+void MusicLibrary::paint(juce::Graphics& g)
+{
+    juce::ColourGradient gradient(
+        juce::Colours::lightgrey.brighter(0.2f), 0, 0,
+        juce::Colours::lightgrey.darker(0.1f), 0, getHeight(),
+        false);
+    gradient.addColour(0.7, juce::Colours::lightgrey);
+    g.setGradientFill(gradient);
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 12.0f);
+
+    g.setColour(juce::Colours::white.withAlpha(0.1f));
+    g.drawRoundedRectangle(getLocalBounds().reduced(1).toFloat(), 12.0f, 3.0f);
+
+    g.setColour(juce::Colours::grey.darker(0.7f).withAlpha(0.8f));
+    g.drawRoundedRectangle(getLocalBounds().toFloat(), 12.0f, 1.5f);
+}
+
+// Arrange UI components (search box, buttons, crossfader, track list) within the library
+void MusicLibrary::resized()
+{
+    auto area = getLocalBounds().reduced(5);
+    searchBox.setBounds(area.removeFromTop(30));
+    
+    auto controlArea = area.removeFromBottom(80);
+    auto buttonArea = controlArea.removeFromTop(30);
+    leftArrowButton.setBounds(buttonArea.removeFromLeft(30).reduced(2));
+    addButton.setBounds(buttonArea.removeFromLeft(120).reduced(2));
+    deleteButton.setBounds(buttonArea.removeFromLeft(120).reduced(2));
+    duplicatesButton.setBounds(buttonArea.removeFromLeft(120).reduced(2));
+    cratesButton.setBounds(buttonArea.removeFromLeft(90).reduced(2));
+    rightArrowButton.setBounds(buttonArea.removeFromRight(30).reduced(2));
+    
+    auto crossfaderArea = controlArea;
+    auto crossfaderHeader = crossfaderArea.removeFromTop(20);
+    curveSelector.setBounds(crossfaderHeader.removeFromRight(80).reduced(2, 0));
+    crossfaderLabel.setBounds(crossfaderHeader.reduced(5));
+    crossfaderSlider.setBounds(crossfaderArea.reduced(5, 2));
+    
+    trackList.setBounds(area);
+}
+
+// Update track list display when search text changes
+void MusicLibrary::textEditorTextChanged(juce::TextEditor&)
+{
+    updateFilter();
+    trackList.updateContent(); // Refresh list on search input
+    trackList.deselectAllRows(); // Row numbers now mean different tracks
+    requestVisibleTags();
+}
+
+// Rank the tracks against the search text; an empty search shows the library in order
+void MusicLibrary::updateFilter()
+{
+    filtering = searchBox.getText().trim().isNotEmpty();
+    filteredRows.clear();
+    if (filtering)
+    {
+        filteredRows = findMatches(maxLooseResults);
+    }
+
+    if (showingDuplicates)
+    {
+        rebuildDuplicateRows();
+    }
+}
+
+// Filter terms give a bitmap; any words are then searched among the tracks it allows.
+// A filter on its own lists every match, since a bitmap is cheap to turn into rows.
+std::vector<int> MusicLibrary::findMatches(int maxLoose)
+{
+    auto searchText = searchBox.getText().trim();
+    auto query = libraryFilter.evaluate(searchText);
+    if (query.usesAnalysis && analysisCache != nullptr && libraryFilter.updateAnalysis(*analysisCache))
+    {
+        query = libraryFilter.evaluate(searchText); // Tracks analysed since the last query
+    }
+
+    searchBox.setTooltip(query.error);
+    if (query.error.isNotEmpty())
+    {
+        searchBox.setColour(juce::TextEditor::outlineColourId, juce::Colours::red);
+    }
+    else
+    {
+        searchBox.removeColour(juce::TextEditor::outlineColourId);
+    }
+
+    if (query.text.isEmpty())
+    {
+        return query.hasFilter ? query.matches.toVector() : std::vector<int>();
+    }
+
+    return searchIndex.search(query.text, maxLoose, query.hasFilter ? &query.matches : nullptr);
+}
+
+// Pass the crossfader position to the mixer, which ramps the deck gains on the audio thread
+void MusicLibrary::sliderValueChanged(juce::Slider* slider)
+{
+    if (slider == &crossfaderSlider && mixer != nullptr)
+    {
+        mixer->setCrossfader(static_cast<float>(crossfaderSlider.getValue()));
+    }
+}
+
+// Count visible rows based on search filter
+int MusicLibrary::getNumRows()
+{
+    if (showingDuplicates)
+    {
+        return static_cast<int>(duplicateRows.size());
+    }
+
+    return filtering ? static_cast<int>(filteredRows.size()) : tracks.size();
+}
+
+// Draw a single track item in the list box, applying search filter and selection styling.
+// Shows tags once the background reader has them, the filename until then.
+void MusicLibrary::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+    auto index = getTrackIndexForRow(rowNumber);
+    if (index < 0)
+    {
+        return;
+    }
+
+    const auto& track = tracks.getReference(index);
+    auto text = track.getFileName();
+    juce::String bpmText;
+
+    TrackTags tags;
+    if (tagCache.lookup(track, tags))
+    {
+        if (!tags.isEmpty())
+        {
+            text = tags.artist.isNotEmpty() ? tags.artist + " - " + tags.title : tags.title;
+        }
+        if (tags.bpm > 0.0f)
+        {
+            bpmText = juce::String(tags.bpm, 1);
+        }
+    }
+    else
+    {
+        tagCache.request(track); // Painted rows are by definition visible
+    }
+
+    // In the duplicates view the shading alternates per group, and the right column tells the copies apart
+    auto stripe = showingDuplicates ? duplicateGroup[static_cast<size_t>(rowNumber)] : rowNumber;
+    if (showingDuplicates)
+    {
+        bpmText = track.getFileExtension().substring(1).toUpperCase() + " "
+                + juce::String(static_cast<double>(track.getSize()) / (1024.0 * 1024.0), 1) + " MB";
+    }
+
+    g.fillAll(rowIsSelected ? juce::Colours::lightblue : (stripe % 2 == 0 ? juce::Colours::white : juce::Colours::lightgrey.brighter(0.5f)));
+    g.setColour(juce::Colours::black);
+    g.setFont(juce::FontOptions(16.0f));
+    auto detailWidth = showingDuplicates ? 110 : 50;
+    g.drawText(text, 10, 0, width - detailWidth - 20, height, juce::Justification::centredLeft);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.setFont(juce::FontOptions(13.0f));
+    g.drawText(bpmText, width - detailWidth - 10, 0, detailWidth, height, juce::Justification::centredRight);
+}
+
+// Handle track selection when a list box item is clicked
+void MusicLibrary::listBoxItemClicked(int row, const juce::MouseEvent&)
+{
+    trackList.selectRow(row);
+}
+
+// Prefetch tags for rows scrolled into or near the viewport
+void MusicLibrary::listWasScrolled()
+{
+    requestVisibleTags();
+}
+
+// Get file of selected track, accounting for search filter
+juce::File MusicLibrary::getSelectedTrack()
+{
+    auto index = getTrackIndexForRow(trackList.getSelectedRow());
+    return index >= 0 ? tracks[index] : juce::File();
+}
+
+// Map a visible (filtered) row onto its index in tracks
+int MusicLibrary::getTrackIndexForRow(int row)
+{
+    if (row < 0)
+    {
+        return -1;
+    }
+
+    if (showingDuplicates)
+    {
+        return row < static_cast<int>(duplicateRows.size()) ? duplicateRows[static_cast<size_t>(row)] : -1;
+    }
+
+    if (filtering)
+    {
+        return row < static_cast<int>(filteredRows.size()) ? filteredRows[static_cast<size_t>(row)] : -1;
+    }
+
+    return row < tracks.size() ? row : -1;
+}
+
+// Queue tag reads for the visible rows plus a page either side, so scrolling finds them ready
+void MusicLibrary::requestVisibleTags()
+{
+    auto rowHeight = juce::jmax(1, trackList.getRowHeight());
+    auto* viewport = trackList.getViewport();
+    if (viewport == nullptr)
+    {
+        return;
+    }
+
+    auto firstVisible = viewport->getViewPositionY() / rowHeight;
+    auto numVisible = viewport->getViewHeight() / rowHeight + 1;
+    auto numRows = getNumRows();
+
+    // Visible rows are queued last so the LIFO reader serves them first
+    for (auto row : { juce::Range<int>(firstVisible + numVisible, firstVisible + 2 * numVisible),
+                      juce::Range<int>(firstVisible - numVisible, firstVisible),
+                      juce::Range<int>(firstVisible, firstVisible + numVisible) })
+    {
+        for (int r = juce::jmax(0, row.getStart()); r < juce::jmin(numRows, row.getEnd()); ++r)
+        {
+            auto index = getTrackIndexForRow(r);
+            if (index >= 0)
+            {
+                tagCache.request(tracks.getReference(index));
+            }
+        }
+    }
+}
+
+// Requests analysis of the playing track if it has none; callers retry when the cache's generation moves
+juce::Array<juce::File> MusicLibrary::suggestNextTracks(const juce::File& playing, int maxResults)
+{
+    juce::Array<juce::File> result;
+    TrackAnalysis analysis;
+    if (analysisCache == nullptr || playing == juce::File())
+    {
+        return result;
+    }
+
+    if (!analysisCache->lookup(playing, analysis))
+    {
+        analysisCache->request(playing);
+        return result;
+    }
+
+    libraryFilter.updateAnalysis(*analysisCache);
+
+    SuggestionIndex::Features features;
+    features.bpm = analysis.grid.isValid() ? static_cast<float>(analysis.grid.bpm) : 0.0f;
+    features.key = LibraryFilter::camelotIndex(analysis.key);
+    features.loudnessDb = analysis.loudnessDb;
+
+    for (const auto& suggestion : libraryFilter.getSuggestionIndex().suggest(features, libraryFilter.indexOf(playing), maxResults))
+    {
+        result.add(tracks[suggestion.track]);
+    }
+    return result;
+}
+
+// Add a new track to the library if it exists and isn’t already present
+void MusicLibrary::addTrack(const juce::File& file)
+{
+    if (file.existsAsFile() && !tracks.contains(file))
+    {
+        tracks.add(file);
+        searchIndex.addTrack(tracks.size() - 1, file);
+        libraryFilter.addTrack(tracks.size() - 1, file);
+        indexTags(tracks.size() - 1); // Deleted and added again with its tags still cached
+        if (filtering)
+        {
+            updateFilter();
+        }
+        trackList.updateContent(); // Refresh the track list display
+    }
+}
+
+// Loader thread: read the track list from the XML file
+void MusicLibrary::run()
+{
+    juce::Array<juce::File> found;
+    if (!readTrackList(libraryFile, found, [this] { return threadShouldExit(); }))
+    {
+        return; // Incomplete: the file on disk is left alone
+    }
+
+    {
+        const juce::ScopedLock sl(loadLock);
+        loadedTracks.swapWith(found);
+        loadFinished = true;
+    }
+    triggerAsyncUpdate();
+}
+
+juce::File MusicLibrary::getLibraryFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+        .getChildFile("dj_library.xml");
+}
+
+bool MusicLibrary::readTrackList(const juce::File& xmlFile, juce::Array<juce::File>& result,
+                                 const std::function<bool()>& shouldExit)
+{
+    if (!xmlFile.existsAsFile())
+    {
+        return true;
+    }
+
+    std::unique_ptr<juce::XmlElement> xml = juce::XmlDocument::parse(xmlFile);
+    if (xml && xml->hasTagName("MusicLibrary"))
+    {
+        for (auto* element : xml->getChildIterator())
+        {
+            if (shouldExit())
+            {
+                return false;
+            }
+
+            if (element->hasTagName("Track"))
+            {
+                juce::String path = element->getStringAttribute("path");
+                juce::File trackFile(path);
+                if (trackFile.existsAsFile()) // One stat per track, which is why the app reads this off the message thread
+                {
+                    result.add(trackFile);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool MusicLibrary::writeTrackList(const juce::File& xmlFile, const juce::Array<juce::File>& tracks)
+{
+    juce::XmlElement xml("MusicLibrary");
+    
+    for (const auto& track : tracks)
+    {
+        auto* trackElement = xml.createNewChildElement("Track");
+        trackElement->setAttribute("path", track.getFullPathName());
+    }
+    
+    return xml.writeTo(xmlFile);
+}
+
+void MusicLibrary::handleAsyncUpdate()
+{
+    if (!mergeLoadedTracks())
+    {
+        return;
+    }
+
+    rebuildIndices(); // Indices moved with the merge
+    updateFilter();
+    trackList.updateContent();
+    trackList.repaint();
+    StartupTrace::mark("library loaded (" + juce::String(tracks.size()) + " tracks)");
+
+    if (onLibraryLoaded)
+    {
+        onLibraryLoaded();
+    }
+}
+
+// Re-index every track by its new position; tags already read join the search index again
+void MusicLibrary::rebuildIndices()
+{
+    searchIndex.rebuild(tracks);
+    libraryFilter.rebuild(tracks);
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        indexTags(i);
+    }
+}
+
+// Add a track's tags to the search index once they have been read
+void MusicLibrary::indexTags(int trackIndex)
+{
+    TrackTags tags;
+    if (trackIndex >= 0 && trackIndex < tracks.size()
+        && tagCache.peek(tracks.getReference(trackIndex), tags) && !tags.isEmpty())
+    {
+        searchIndex.addTags(trackIndex, tags.artist, tags.title);
+    }
+}
+
+bool MusicLibrary::mergeLoadedTracks()
+{
+    juce::Array<juce::File> merged;
+    {
+        const juce::ScopedLock sl(loadLock);
+        if (!loadFinished || libraryLoaded)
+        {
+            return false;
+        }
+        merged.swapWith(loadedTracks);
+    }
+
+    for (const auto& track : tracks)
+    {
+        merged.addIfNotAlreadyThere(track);
+    }
+    tracks.swapWith(merged);
+    libraryLoaded = true;
+    return true;
+}
+
+// Save track list to XML file
+void MusicLibrary::saveLibrary()
+{
+    if (!writeTrackList(libraryFile, tracks))
+    {
+        DBG("Failed to save music library to " << libraryFile.getFullPathName());
+    }
+}
+
+// Link the music library to the two decks it loads tracks into
+void MusicLibrary::setDecks(DeckGUI* deck1, DeckGUI* deck2)
+{
+    deck1Ptr = deck1;
+    deck2Ptr = deck2;
+}
+
+// Link the crossfader to the mixer and send it the current position
+void MusicLibrary::setMixer(Mixer* mixerToControl)
+{
+    mixer = mixerToControl;
+    if (mixer != nullptr)
+    {
+        mixer->setCrossfader(static_cast<float>(crossfaderSlider.getValue()));
+        mixer->setCurve(static_cast<Mixer::Curve>(curveSelector.getSelectedId() - 1));
+    }
+}
+
+void MusicLibrary::setDuplicateFinder(DuplicateFinder* finder)
+{
+    duplicateFinder = finder;
+    duplicatesButton.setEnabled(duplicateFinder != nullptr);
+    if (duplicateFinder != nullptr)
+    {
+        duplicateFinder->onProgress = [this] { duplicateScanProgressed(); };
+    }
+}
+
+void MusicLibrary::syncCrossfader()
+{
+    if (mixer != nullptr && !crossfaderSlider.isMouseButtonDown()
+        && static_cast<float>(crossfaderSlider.getValue()) != mixer->getCrossfader())
+    {
+        crossfaderSlider.setValue(mixer->getCrossfader(), juce::dontSendNotification);
+    }
+}
+
+// Load the selected track into Deck 1 when the left arrow is clicked
+void MusicLibrary::leftArrowClicked()
+{
+    juce::File selectedTrack = getSelectedTrack();
+    if (selectedTrack.exists() && deck1Ptr != nullptr)
+    {
+        deck1Ptr->loadFile(selectedTrack);
+    }
+}
+
+// Load the selected track into Deck 2 when the right arrow is clicked
+void MusicLibrary::rightArrowClicked()
+{
+    juce::File selectedTrack = getSelectedTrack();
+    if (selectedTrack.exists() && deck2Ptr != nullptr)
+    {
+        deck2Ptr->loadFile(selectedTrack);
+    }
+}
+
+// Open file chooser to add new track
+void MusicLibrary::addButtonClicked()
+{
+    auto fileChooserFlags = juce::FileBrowserComponent::canSelectFiles;
+    fChooser.launchAsync(fileChooserFlags, [this](const juce::FileChooser& chooser)
+    {
+        juce::File chosenFile = chooser.getResult();
+        if (chosenFile != juce::File())
+        {
+            DBG("Adding file: " << chosenFile.getFullPathName());
+            addTrack(chosenFile);
+        }
+    });
+}
+
+// Remove selected track from list
+void MusicLibrary::deleteButtonClicked()
+{
+    auto index = getTrackIndexForRow(trackList.getSelectedRow());
+    if (index >= 0)
+    {
+        DBG("Deleting track: " << tracks[index].getFullPathName());
+        tracks.remove(index);
+        rebuildIndices();
+        updateFilter();
+        trackList.updateContent();
+        trackList.deselectAllRows();
+    }
+}
+
+// Crates and tags for the selected track, and shortcuts that put one in the search box
+void MusicLibrary::cratesButtonClicked()
+{
+    auto index = getTrackIndexForRow(trackList.getSelectedRow());
+    auto track = index >= 0 ? tracks[index] : juce::File();
+    auto hasTrack = index >= 0;
+
+    juce::PopupMenu menu;
+    for (auto kind : { LibraryFilter::crate, LibraryFilter::tag })
+    {
+        auto names = libraryFilter.getNames(kind);
+        juce::PopupMenu membership, show, remove;
+
+        for (const auto& name : names)
+        {
+            membership.addItem(name, hasTrack, hasTrack && libraryFilter.isMember(kind, name, index), [this, kind, name, track]
+            {
+                auto trackIndex = tracks.indexOf(track);
+                if (trackIndex >= 0)
+                {
+                    libraryFilter.setMember(kind, name, trackIndex, !libraryFilter.isMember(kind, name, trackIndex));
+                    updateFilter();
+                    trackList.updateContent();
+                }
+            });
+            show.addItem(name, [this, kind, name] { searchBox.setText(LibraryFilter::makeQueryTerm(kind, name), true); });
+            remove.addItem(name, [this, kind, name]
+            {
+                libraryFilter.removeSet(kind, name);
+                updateFilter();
+                trackList.updateContent();
+            });
+        }
+
+        auto noun = kind == LibraryFilter::crate ? juce::String("crate") : juce::String("tag");
+        membership.addSeparator();
+        membership.addItem("New " + noun + "...", hasTrack, false, [this, kind, track] { askForSetName(kind, track); });
+
+        menu.addSubMenu(kind == LibraryFilter::crate ? "Add to crate" : "Tag track", membership, hasTrack);
+        menu.addSubMenu("Show " + noun, show, names.size() > 0);
+        menu.addSubMenu("Delete " + noun, remove, names.size() > 0);
+        menu.addSeparator();
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&cratesButton));
+}
+
+// The new crate or tag is created with the track in it
+void MusicLibrary::askForSetName(LibraryFilter::Kind kind, const juce::File& track)
+{
+    auto noun = kind == LibraryFilter::crate ? juce::String("crate") : juce::String("tag");
+    auto* window = new juce::AlertWindow("New " + noun, "Add " + track.getFileName() + " to a new " + noun + " called:",
+                                         juce::MessageBoxIconType::NoIcon, this);
+    window->addTextEditor("name", {});
+    window->addButton("OK", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    // Called before the window deletes itself, so its text is still there to read
+    window->enterModalState(true, juce::ModalCallbackFunction::create([this, window, kind, track](int result)
+    {
+        auto trackIndex = tracks.indexOf(track);
+        if (result == 1 && trackIndex >= 0)
+        {
+            libraryFilter.setMember(kind, window->getTextEditorContents("name"), trackIndex, true);
+            updateFilter();
+            trackList.updateContent();
+        }
+    }), true);
+}
+
+// Toggle the duplicates view; turning it on fingerprints whatever is new since the last scan
+void MusicLibrary::duplicatesButtonClicked()
+{
+    if (duplicateFinder == nullptr)
+    {
+        return;
+    }
+
+    showingDuplicates = !showingDuplicates;
+    duplicatesButton.setToggleState(showingDuplicates, juce::dontSendNotification);
+    if (showingDuplicates)
+    {
+        duplicateFinder->scan(tracks);
+        rebuildDuplicateRows();
+    }
+
+    trackList.deselectAllRows();
+    trackList.updateContent();
+    trackList.repaint();
+    duplicateScanProgressed();
+}
+
+void MusicLibrary::duplicateScanProgressed()
+{
+    if (duplicateFinder->isScanning())
+    {
+        duplicatesButton.setButtonText("Scanning " + juce::String(juce::roundToInt(duplicateFinder->getProgress() * 100.0f)) + "%");
+        return;
+    }
+
+    duplicatesButton.setButtonText("Duplicates");
+    if (showingDuplicates)
+    {
+        rebuildDuplicateRows();
+        trackList.updateContent();
+        trackList.repaint();
+    }
+}
+
+// Lay out the finder's groups as rows, keeping only tracks still in the library and matching the search.
+// Groups keep the finder's order; the search only decides which are shown.
+void MusicLibrary::rebuildDuplicateRows()
+{
+    duplicateRows.clear();
+    duplicateGroup.clear();
+    if (duplicateFinder == nullptr)
+    {
+        return;
+    }
+
+    std::unordered_map<juce::String, int> indexOfPath;
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        indexOfPath.emplace(tracks.getReference(i).getFullPathName(), i);
+    }
+
+    std::vector<bool> matched;
+    if (filtering)
+    {
+        matched.resize(static_cast<size_t>(tracks.size()), false);
+        for (auto index : findMatches(tracks.size()))
+        {
+            matched[static_cast<size_t>(index)] = true;
+        }
+    }
+
+    int groupNumber = 0;
+    for (const auto& group : duplicateFinder->getGroups())
+    {
+        std::vector<int> members;
+        for (const auto& file : group)
+        {
+            auto it = indexOfPath.find(file.getFullPathName());
+            if (it != indexOfPath.end())
+            {
+                members.push_back(it->second);
+            }
+        }
+
+        auto anyMatches = !filtering
+            || std::any_of(members.begin(), members.end(), [&matched](int index) { return matched[static_cast<size_t>(index)]; });
+
+        if (members.size() > 1 && anyMatches) // A group stays whole if any copy matches
+        {
+            for (auto index : members)
+            {
+                duplicateRows.push_back(index);
+                duplicateGroup.push_back(groupNumber);
+            }
+            ++groupNumber;
+        }
+    }
+}
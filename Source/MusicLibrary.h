@@ -1,82 +1,149 @@
-/*
-  ==============================================================================
-
-    This file defines the MusicLibrary class for a JUCE application,
-    managing a track list, search functionality, and crossfader controls.
-
-  ==============================================================================
-*/
-
-#pragma once
-#include <JuceHeader.h>
-
-class DeckGUI;  // Forward declaration
-
-// MusicLibrary: Manages track list and crossfader
-class MusicLibrary : public juce::Component,
-                     public juce::TextEditor::Listener,
-                     public juce::ListBoxModel,
-                     public juce::Slider::Listener
-{
-//==============================================================================
-public:
-    MusicLibrary();
-    ~MusicLibrary() override;
-
-    void paint(juce::Graphics&) override;
-    void resized() override;
-    void textEditorTextChanged(juce::TextEditor&) override;
-    void sliderValueChanged(juce::Slider* slider) override;
-
-    // ListBoxModel: Manage track list display
-    int getNumRows() override;
-    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
-    void listBoxItemClicked(int row, const juce::MouseEvent&) override;
-
-    juce::File getSelectedTrack();
-    void addTrack(const juce::File& file);
-    
-    void setDecks(DeckGUI* deck1, DeckGUI* deck2); // Link to decks for loading tracks
-    
-//==============================================================================
-private:
-    juce::TextEditor searchBox;
-    juce::ListBox trackList;
-    juce::Array<juce::File> tracks;
-    juce::File libraryFile;
-    
-    juce::TextButton leftArrowButton{"<"};
-    juce::TextButton addButton{"Add Track"};
-    juce::TextButton deleteButton{"Delete"};
-    juce::TextButton rightArrowButton{">"};
-    
-    juce::Slider crossfaderSlider;
-    juce::Label crossfaderLabel;
-    
-    DeckGUI* deck1Ptr{nullptr};
-    DeckGUI* deck2Ptr{nullptr};
-    
-    juce::FileChooser fChooser{"Choose an audio file",
-                              juce::File::getSpecialLocation(juce::File::userDesktopDirectory),
-                              "*.mp3;*.wav;*.aiff"};
-    
-    class CrossfaderLookAndFeel : public juce::LookAndFeel_V4
-    {
-    public:
-        void drawLinearSlider(juce::Graphics&, int x, int y, int width, int height,
-                            float sliderPos, float minSliderPos, float maxSliderPos,
-                            const juce::Slider::SliderStyle, juce::Slider&) override;
-    };
-    
-    CrossfaderLookAndFeel crossfaderLookAndFeel;
-
-    void loadLibrary(); // Load tracks from XML file
-    void saveLibrary(); // Save tracks to XML file
-    
-    void leftArrowClicked();  // Load track to Deck 1
-    void rightArrowClicked(); // Load track to Deck 2
-    void addButtonClicked();  // Open file chooser to add track
-    void deleteButtonClicked(); // Remove selected track
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MusicLibrary)
-};
+/*
+  ==============================================================================
+
+    This file defines the MusicLibrary class for a JUCE application,
+    managing a track list, search functionality, and crossfader controls.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TagCache.h"
+#include "DuplicateFinder.h"
+#include "LibrarySearch.h"
+#include "LibraryFilter.h"
+
+class DeckGUI;  // Forward declaration
+class Mixer;
+class AnalysisCache;
+
+// MusicLibrary: Manages track list and crossfader. The saved library is read on a
+// background thread so the window is usable before a large library has been checked.
+// The search box takes words for the fuzzy search and filter terms such as
+// "bpm 120-126 key 8A/9A tag:peak-time" for the crate, tag and attribute bitmaps.
+class MusicLibrary : public juce::Component,
+                     public juce::TextEditor::Listener,
+                     public juce::ListBoxModel,
+                     public juce::Slider::Listener,
+                     private juce::Thread,
+                     private juce::AsyncUpdater
+{
+//==============================================================================
+public:
+    MusicLibrary();
+    ~MusicLibrary() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void textEditorTextChanged(juce::TextEditor&) override;
+    void sliderValueChanged(juce::Slider* slider) override;
+
+    // ListBoxModel: Manage track list display
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemClicked(int row, const juce::MouseEvent&) override;
+    void listWasScrolled() override;
+
+    juce::File getSelectedTrack();
+    void addTrack(const juce::File& file);
+
+    // Library tracks to mix into next, best first; empty until the playing track is analysed
+    juce::Array<juce::File> suggestNextTracks(const juce::File& playing, int maxResults);
+    
+    void setDecks(DeckGUI* deck1, DeckGUI* deck2); // Link to decks for loading tracks
+    void setMixer(Mixer* mixerToControl);          // Crossfader target
+    void setDuplicateFinder(DuplicateFinder* finder); // Enables the duplicates view
+    void setAnalysisCache(AnalysisCache* cache) { analysisCache = cache; } // BPM and key filters
+    void setMemoryBudget(MemoryBudget* budget) { tagCache.setMemoryBudget(budget); }
+    void syncCrossfader();                         // Follow a controller moving the crossfader
+    bool isLibraryLoaded() const noexcept { return libraryLoaded; }
+    std::function<void()> onLibraryLoaded;         // Message thread, once the saved tracks are listed
+
+    // The saved library, also read and written by the headless batch mode
+    static juce::File getLibraryFile();
+    static bool readTrackList(const juce::File& xmlFile, juce::Array<juce::File>& result,
+                              const std::function<bool()>& shouldExit); // False if interrupted
+    static bool writeTrackList(const juce::File& xmlFile, const juce::Array<juce::File>& tracks);
+    
+//==============================================================================
+private:
+    juce::TextEditor searchBox;
+    juce::ListBox trackList;
+    juce::Array<juce::File> tracks;
+    juce::File libraryFile;
+    TagCache tagCache;
+    LibrarySearch searchIndex;
+    LibraryFilter libraryFilter;
+
+    // Search results: rows follow the ranking, best match first. Every substring match is
+    // listed; only the looser (subsequence and typo) matches after them are capped.
+    static constexpr int maxLooseResults = 1000;
+    bool filtering = false;
+    std::vector<int> filteredRows; // Track index per row
+
+    juce::CriticalSection loadLock;
+    juce::Array<juce::File> loadedTracks; // Handed from the loader thread under loadLock
+    bool loadFinished = false;
+    bool libraryLoaded = false;           // Message thread: never save over a library not yet read
+    
+    juce::TextButton leftArrowButton{"<"};
+    juce::TextButton addButton{"Add Track"};
+    juce::TextButton deleteButton{"Delete"};
+    juce::TextButton rightArrowButton{">"};
+    juce::TextButton duplicatesButton{"Duplicates"};
+    juce::TextButton cratesButton{"Crates"};
+    
+    juce::Slider crossfaderSlider;
+    juce::Label crossfaderLabel;
+    juce::ComboBox curveSelector;
+    
+    DeckGUI* deck1Ptr{nullptr};
+    DeckGUI* deck2Ptr{nullptr};
+    Mixer* mixer{nullptr};
+    DuplicateFinder* duplicateFinder{nullptr};
+    AnalysisCache* analysisCache{nullptr};
+
+    // Duplicates view: rows follow the groups, so copies of one song sit together
+    bool showingDuplicates = false;
+    std::vector<int> duplicateRows;  // Track index per row
+    std::vector<int> duplicateGroup; // Group number per row, for shading
+    
+    juce::FileChooser fChooser{"Choose an audio file",
+                              juce::File::getSpecialLocation(juce::File::userDesktopDirectory),
+                              "*.mp3;*.wav;*.aiff"};
+    
+    class CrossfaderLookAndFeel : public juce::LookAndFeel_V4
+    {
+    public:
+        void drawLinearSlider(juce::Graphics&, int x, int y, int width, int height,
+                            float sliderPos, float minSliderPos, float maxSliderPos,
+                            const juce::Slider::SliderStyle, juce::Slider&) override;
+    };
+    
+    CrossfaderLookAndFeel crossfaderLookAndFeel;
+
+    int getTrackIndexForRow(int row); // Map a visible row to its index in tracks, or -1
+    void updateFilter();              // Re-run the search after the text or the tracks change
+    std::vector<int> findMatches(int maxLoose); // Ranked if the query has words, else in library order
+    void requestVisibleTags(); // Queue tag reads for rows in or near the viewport
+    void duplicatesButtonClicked();
+    void cratesButtonClicked();  // Crate and tag menu for the selected track
+    void askForSetName(LibraryFilter::Kind kind, const juce::File& track);
+    void duplicateScanProgressed();
+    void rebuildDuplicateRows();
+
+    void run() override; // Loader thread: parse the XML file and drop missing tracks
+    void handleAsyncUpdate() override;
+    bool mergeLoadedTracks(); // Saved tracks first, then any added while loading
+    void rebuildIndices();    // After tracks move: search, filter and the tags read so far
+    void indexTags(int trackIndex); // Searchable by artist and title once its tags are read
+    void saveLibrary(); // Save tracks to XML file
+    
+    void leftArrowClicked();  // Load track to Deck 1
+    void rightArrowClicked(); // Load track to Deck 2
+    void addButtonClicked();  // Open file chooser to add track
+    void deleteButtonClicked(); // Remove selected track
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MusicLibrary)
+};
@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the OfflineRenderer class for a JUCE application,
+    rendering the mixer faster than real time and reporting the levels on every output.
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+OfflineRenderer::OfflineRenderer()
+{
+    formatManager.registerBasicFormats();
+    mixer.setDecks(&deckA, &deckB);
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    if (prepared)
+    {
+        mixer.releaseResources();
+    }
+}
+
+void OfflineRenderer::prepare(double newSampleRate, int newBlockSize)
+{
+    sampleRate = newSampleRate;
+    blockSize = newBlockSize;
+    mixer.prepareToPlay(blockSize, sampleRate);
+    prepared = true;
+}
+
+// Walk the buffer in device-sized blocks so the callback sees the same sizes it would live
+void OfflineRenderer::render(juce::AudioBuffer<float>& output, const juce::MidiMessageSequence* midi,
+                             const BlockCallback& beforeBlock, PerfCounter* blockTimes)
+{
+    int nextEvent = 0;
+
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        auto numSamples = juce::jmin(blockSize, output.getNumSamples() - start);
+
+        if (midi != nullptr)
+        {
+            auto blockEnd = (start + numSamples) / sampleRate;
+            while (nextEvent < midi->getNumEvents() && midi->getEventTime(nextEvent) < blockEnd)
+            {
+                auto wait = blockEnd - juce::jmax(start / sampleRate, midi->getEventTime(nextEvent));
+                midiLatency.addSample(juce::Time::secondsToHighResolutionTicks(wait));
+                midiController.handleMessage(midi->getEventPointer(nextEvent++)->message);
+            }
+        }
+
+        if (beforeBlock)
+        {
+            beforeBlock(start / sampleRate, numSamples / sampleRate);
+        }
+
+        juce::AudioSourceChannelInfo info(&output, start, numSamples);
+        if (blockTimes != nullptr)
+        {
+            const PerfCounter::ScopedTimer timer(*blockTimes);
+            mixer.getNextAudioBlock(info);
+        }
+        else
+        {
+            mixer.getNextAudioBlock(info);
+        }
+    }
+}
+
+bool OfflineRenderer::writeWav(const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::File& file)
+{
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                        static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                        24, {}, 0));
+    if (writer == nullptr)
+    {
+        return false;
+    }
+    stream.release(); // Now owned by the writer
+
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+juce::String OfflineRenderer::runCommandLine(const juce::String& commandLine)
+{
+    auto tokens = juce::StringArray::fromTokens(commandLine, true);
+    tokens.trim();
+    tokens.removeEmptyStrings();
+
+    juce::Array<juce::File> deckFiles;
+    double seconds = 30.0;
+    int cueDeck = 0;
+    float cueMix = 0.0f;
+    float crossfader = 0.5f;
+    int numChannels = 4;
+    juce::File outFile;
+    juce::File midiFile;
+
+    for (int i = 0; i < tokens.size(); ++i)
+    {
+        auto token = tokens[i].unquoted();
+        auto value = tokens[i + 1].unquoted();
+
+        if (token == "--render-offline")
+        {
+            continue;
+        }
+
+        // Every option takes one value
+        if (token.startsWith("--"))
+        {
+            if (token == "--seconds")
+            {
+                seconds = value.getDoubleValue();
+            }
+            else if (token == "--cue-deck")
+            {
+                cueDeck = value.getIntValue();
+            }
+            else if (token == "--cue-mix")
+            {
+                cueMix = value.getFloatValue();
+            }
+            else if (token == "--crossfader")
+            {
+                crossfader = value.getFloatValue();
+            }
+            else if (token == "--channels")
+            {
+                numChannels = juce::jlimit(1, 8, value.getIntValue());
+            }
+            else if (token == "--midi")
+            {
+                midiFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            }
+            else if (token == "--out")
+            {
+                outFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+            }
+            ++i;
+        }
+        else if (deckFiles.size() < Mixer::numDecks)
+        {
+            deckFiles.add(juce::File::getCurrentWorkingDirectory().getChildFile(token));
+        }
+    }
+
+    if (deckFiles.isEmpty())
+    {
+        return "usage: --render-offline deckA [deckB] [--seconds N] [--cue-deck 1|2] [--cue-mix X]"
+               " [--crossfader X] [--channels 2|4] [--midi file.mid] [--out file.wav]\n";
+    }
+
+    // A replayed controller session: every track merged, timestamps in seconds
+    juce::MidiMessageSequence midi;
+    if (midiFile != juce::File())
+    {
+        juce::FileInputStream stream(midiFile);
+        juce::MidiFile file;
+        if (!stream.openedOk() || !file.readFrom(stream))
+        {
+            return "Cannot read MIDI file " + midiFile.getFullPathName() + "\n";
+        }
+
+        file.convertTimestampTicksToSeconds();
+        for (int track = 0; track < file.getNumTracks(); ++track)
+        {
+            midi.addSequence(*file.getTrack(track), 0.0);
+        }
+    }
+    auto replayingMidi = midi.getNumEvents() > 0;
+
+    constexpr double sampleRate = 44100.0;
+    constexpr int deviceBlock = 512;
+
+    OfflineRenderer renderer;
+    for (int i = 0; i < deckFiles.size(); ++i)
+    {
+        auto& deck = renderer.getDeck(i);
+        deck.loadFile(deckFiles[i]);
+        deck.setCueEnabled(cueDeck == i + 1);
+        if (!replayingMidi)
+        {
+            deck.setPlaying(true); // Otherwise the MIDI file presses play
+        }
+    }
+    renderer.getMixer().setCrossfader(crossfader);
+    renderer.getMixer().setCueMix(cueMix);
+    renderer.prepare(sampleRate, deviceBlock);
+
+    juce::AudioBuffer<float> output(numChannels, static_cast<int>(seconds * sampleRate));
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    renderer.render(output, replayingMidi ? &midi : nullptr);
+    auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    juce::String report;
+    report << "Rendered " << seconds << " s to " << numChannels << " outputs in "
+           << juce::String(elapsed * 1000.0, 1) << " ms (" << juce::String(seconds / juce::jmax(elapsed, 1.0e-9), 1)
+           << "x real time)\n";
+
+    if (replayingMidi)
+    {
+        const auto& commandLatency = renderer.getMixer().getCommandLatency();
+        const auto& midiLatency = renderer.getMidiLatency();
+        auto periodMicros = 1.0e6 * deviceBlock / sampleRate;
+
+        report << "  " << midi.getNumEvents() << " MIDI events, "
+               << static_cast<int>(commandLatency.getNumCalls()) << " engine commands applied\n";
+        report << juce::String::formatted("  controller to audio: avg %.2f ms, max %.2f ms against a %.2f ms block (%s)\n",
+                                          midiLatency.getAverageMicros() / 1000.0, midiLatency.getMaxMicros() / 1000.0,
+                                          periodMicros / 1000.0,
+                                          midiLatency.getMaxMicros() <= periodMicros + 1.0 ? "within one block" : "LATE");
+        report << juce::String::formatted("  command queue hop: avg %.1f us, max %.1f us\n",
+                                          commandLatency.getAverageMicros(), commandLatency.getMaxMicros());
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto bus = ch < 2 ? "master" : (ch < 4 ? "cue" : "unused");
+        report << "  out " << (ch + 1) << " (" << bus << "): peak "
+               << juce::String(juce::Decibels::gainToDecibels(output.getMagnitude(ch, 0, output.getNumSamples())), 1)
+               << " dB, rms "
+               << juce::String(juce::Decibels::gainToDecibels(output.getRMSLevel(ch, 0, output.getNumSamples())), 1)
+               << " dB\n";
+    }
+
+    if (outFile != juce::File())
+    {
+        report << (writeWav(output, sampleRate, outFile) ? "Wrote " : "Cannot write ") << outFile.getFullPathName() << "\n";
+    }
+    return report;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    This file defines the OfflineRenderer class for a JUCE application,
+    running the decks and mixer without an audio device.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DeckGUI.h"
+#include "Mixer.h"
+#include "MidiController.h"
+#include "PerfCounter.h"
+
+// OfflineRenderer: Two decks and a Mixer driven block by block into a buffer, exactly as
+// the device callback would drive them. Used headless by --render-offline so the master
+// and cue outputs can be checked without a sound card, optionally replaying a MIDI file
+// through the controller mapping as if it arrived live.
+class OfflineRenderer
+{
+//==============================================================================
+public:
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    DeckGUI& getDeck(int index) { return index == 0 ? deckA : deckB; }
+    Mixer& getMixer() noexcept { return mixer; }
+    // Render time from each MIDI event to the end of the block it arrived in, where a live
+    // callback would pick it up; never more than one block period
+    const PerfCounter& getMidiLatency() const noexcept { return midiLatency; }
+
+    using BlockCallback = std::function<void(double blockStartSeconds, double blockSeconds)>;
+
+    void prepare(double sampleRate, int blockSize);
+    // Fills every channel of the buffer. MIDI events (timestamps in seconds) are decoded
+    // just before the block they fall in, so each is heard one block later, as live.
+    // beforeBlock runs ahead of each block, and blockTimes collects the mixer's time per block.
+    void render(juce::AudioBuffer<float>& output, const juce::MidiMessageSequence* midi = nullptr,
+                const BlockCallback& beforeBlock = {}, PerfCounter* blockTimes = nullptr);
+
+    static bool writeWav(const juce::AudioBuffer<float>& buffer, double sampleRate, const juce::File& file);
+
+    // --render-offline deckA [deckB] [--seconds N] [--cue-deck 1|2] [--cue-mix X]
+    //                  [--crossfader X] [--channels 2|4] [--midi file.mid] [--out file.wav]
+    static juce::String runCommandLine(const juce::String& commandLine);
+
+//==============================================================================
+private:
+    juce::AudioFormatManager formatManager;
+    juce::AudioThumbnailCache thumbCache{4};
+
+    DeckGUI deckA{1, formatManager, thumbCache};
+    DeckGUI deckB{2, formatManager, thumbCache};
+    Mixer mixer;
+    MidiController midiController{mixer.getCommandQueue()};
+    PerfCounter midiLatency;
+
+    double sampleRate{44100.0};
+    int blockSize{512};
+    bool prepared{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
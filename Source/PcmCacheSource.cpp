@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the PcmCacheSource class for a JUCE application,
+    keeping the decoded track as 16-bit PCM and reading it back on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "PcmCacheSource.h"
+
+PcmCacheSource::PcmCacheSource(size_t budgetBytes)
+    : budget(budgetBytes)
+{
+}
+
+PcmCacheSource::~PcmCacheSource()
+{
+    setMemoryBudget(nullptr);
+}
+
+void PcmCacheSource::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::decodedAudio, true);
+        memoryBudget->charge(this, static_cast<size_t>(capacityFrames) * sizeof(juce::int16) * static_cast<size_t>(numChannels));
+    }
+}
+
+// Throw away the old cache and size one for the new file. The caller has detached us from
+// the transport and stopped the pipeline, so nothing can be using the block being replaced.
+void PcmCacheSource::setSource(juce::AudioFormatReaderSource* readerSource, const juce::File& file)
+{
+    fallback = readerSource;
+    samples.free();
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->release(this, static_cast<size_t>(capacityFrames) * sizeof(juce::int16) * static_cast<size_t>(numChannels));
+    }
+    numChannels = 0;
+    capacityFrames = 0;
+    totalFrames = 0;
+    cachedFrames.store(0);
+    cacheBytes.store(0);
+    position.store(0);
+
+    if (readerSource == nullptr || file.hasFileExtension("wav;aif;aiff"))
+    {
+        return;
+    }
+
+    auto* reader = readerSource->getAudioFormatReader();
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        return;
+    }
+
+    numChannels = juce::jlimit(1, 2, static_cast<int>(reader->numChannels));
+    totalFrames = reader->lengthInSamples;
+    auto frameBytes = sizeof(juce::int16) * static_cast<size_t>(numChannels);
+    auto granted = memoryBudget != nullptr ? memoryBudget->reserveUpTo(this, static_cast<size_t>(totalFrames) * frameBytes)
+                                           : budget;
+    capacityFrames = juce::jmin(totalFrames, static_cast<juce::int64>(granted / frameBytes)); // A long mix keeps its opening minutes
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->release(this, granted - static_cast<size_t>(capacityFrames) * frameBytes); // Rounding
+    }
+    if (capacityFrames == 0)
+    {
+        return; // Nothing granted: the reader serves everything
+    }
+
+    // Uninitialised on purpose: pages are only committed as the decoder reaches them
+    samples.malloc(static_cast<size_t>(capacityFrames) * static_cast<size_t>(numChannels));
+}
+
+float PcmCacheSource::getCachedFraction() const noexcept
+{
+    auto total = getTotalLength();
+    return total > 0 ? static_cast<float>(cachedFrames.load()) / static_cast<float>(total) : 0.0f;
+}
+
+void PcmCacheSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    if (fallback != nullptr)
+    {
+        fallback->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    }
+}
+
+void PcmCacheSource::releaseResources()
+{
+    if (fallback != nullptr)
+    {
+        fallback->releaseResources();
+    }
+}
+
+juce::int64 PcmCacheSource::getTotalLength() const
+{
+    return fallback != nullptr ? fallback->getTotalLength() : 0;
+}
+
+// Audio thread: serve the block from memory when it lies inside the decoded region,
+// otherwise from the reader, seeking it only if it is not already where we are
+void PcmCacheSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto start = position.load();
+    auto end = start + bufferToFill.numSamples;
+
+    if (end <= cachedFrames.load(std::memory_order_acquire))
+    {
+        readCached(bufferToFill, start);
+        if (memoryBudget != nullptr)
+        {
+            memoryBudget->recordHit(MemoryBudget::decodedAudio);
+        }
+    }
+    else if (fallback != nullptr)
+    {
+        if (memoryBudget != nullptr && capacityFrames > 0)
+        {
+            memoryBudget->recordMiss(MemoryBudget::decodedAudio); // Beyond the budget or not decoded yet
+        }
+
+        if (fallback->getNextReadPosition() != start)
+        {
+            fallback->setNextReadPosition(start);
+        }
+        fallback->getNextAudioBlock(bufferToFill);
+    }
+    else
+    {
+        bufferToFill.clearActiveBufferRegion();
+    }
+
+    // A seek from the GUI during the block wins over our own advance
+    position.compare_exchange_strong(start, end);
+}
+
+void PcmCacheSource::readCached(const juce::AudioSourceChannelInfo& info, juce::int64 start) const noexcept
+{
+    constexpr float scale = 1.0f / 32768.0f;
+    auto& buffer = *info.buffer;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const auto* source = samples + static_cast<size_t>(juce::jmin(ch, numChannels - 1)) * static_cast<size_t>(capacityFrames)
+                                     + static_cast<size_t>(start);
+        auto* dest = buffer.getWritePointer(ch, info.startSample);
+
+        for (int i = 0; i < info.numSamples; ++i)
+        {
+            dest[i] = source[i] * scale;
+        }
+    }
+}
+
+bool PcmCacheSource::copyDecoded(juce::AudioBuffer<float>& dest, int destStart, juce::int64 start, int numFrames) const noexcept
+{
+    if (start < 0 || numFrames <= 0 || start + numFrames > cachedFrames.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    constexpr float scale = 1.0f / 32768.0f;
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const auto* source = samples + static_cast<size_t>(juce::jmin(ch, numChannels - 1)) * static_cast<size_t>(capacityFrames)
+                                     + static_cast<size_t>(start);
+        auto* out = dest.getWritePointer(ch, destStart);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            out[i] = source[i] * scale;
+        }
+    }
+    return true;
+}
+
+juce::int64 PcmCacheSource::decodeStarting(const juce::AudioFormatReader&)
+{
+    return capacityFrames;
+}
+
+// Pipeline thread: blocks arrive in order from the start, each published as it lands
+void PcmCacheSource::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples)
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = samples + static_cast<size_t>(ch) * static_cast<size_t>(capacityFrames) + static_cast<size_t>(startSample);
+        const auto* source = block.getReadPointer(ch);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[i] = static_cast<juce::int16>(juce::roundToInt(juce::jlimit(-1.0f, 1.0f, source[i]) * 32767.0f));
+        }
+    }
+
+    auto decoded = startSample + numSamples;
+    cachedFrames.store(decoded, std::memory_order_release);
+    cacheBytes.store(static_cast<size_t>(decoded) * static_cast<size_t>(numChannels) * sizeof(juce::int16));
+}
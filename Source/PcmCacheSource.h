@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    This file defines the PcmCacheSource class for a JUCE application,
+    a pre-decode of compressed tracks that serves seeks from memory.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MemoryBudget.h"
+#include "DecodePipeline.h"
+
+// PcmCacheSource: Sits between a deck's reader source and its transport. The deck's decode
+// pipeline feeds it the whole track from the start, kept as 16-bit PCM up to a memory budget.
+// Blocks inside the decoded region are served from memory, so a seek there is just a
+// new index; anything beyond it still comes from the reader, which is only re-synced
+// when playback actually leaves the cache. With a MemoryBudget the cache is sized by what
+// the decoded-audio pool can grant, and is pinned: it is never evicted while loaded.
+class PcmCacheSource : public juce::PositionableAudioSource,
+                       public DecodePipeline::Consumer,
+                       private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    explicit PcmCacheSource(size_t budgetBytes = defaultBudgetBytes); // Used without a MemoryBudget
+    ~PcmCacheSource() override;
+
+    void setMemoryBudget(MemoryBudget* budgetToUse); // GUI thread, before the first setSource()
+
+    // GUI thread, with the source detached from the audio callback and the pipeline stopped.
+    // Uncompressed files already seek exactly, so only compressed ones are cached.
+    void setSource(juce::AudioFormatReaderSource* readerSource, const juce::File& file);
+
+    bool isCaching() const noexcept { return capacityFrames > 0; } // GUI thread: a compressed file is loaded
+    float getCachedFraction() const noexcept; // 0..1 of the track, for the waveform
+    size_t getCacheBytes() const noexcept { return cacheBytes.load(); }
+
+    // Any thread, while the source stays set: copies decoded frames into a two-channel buffer,
+    // so the scratch window and loop capture reuse the pipeline's decode. False if not decoded yet.
+    bool copyDecoded(juce::AudioBuffer<float>& dest, int destStart, juce::int64 start, int numFrames) const noexcept;
+
+    // Audio thread
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    void setNextReadPosition(juce::int64 newPosition) override { position.store(newPosition); }
+    juce::int64 getNextReadPosition() const override { return position.load(); }
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override { return false; }
+
+    // Pipeline thread
+    juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+    void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+
+    static constexpr size_t defaultBudgetBytes = 256 * 1024 * 1024; // About 25 minutes of 44.1 kHz stereo
+
+//==============================================================================
+private:
+    size_t budget;
+    MemoryBudget* memoryBudget = nullptr;
+
+    juce::PositionableAudioSource* fallback = nullptr;
+
+    // Planar 16-bit samples: channel c starts at c * capacityFrames
+    juce::HeapBlock<juce::int16> samples;
+    int numChannels = 0;
+    juce::int64 capacityFrames = 0;
+    juce::int64 totalFrames = 0;
+    std::atomic<juce::int64> cachedFrames{0}; // Frames [0, cachedFrames) are valid
+    std::atomic<size_t> cacheBytes{0};
+
+    std::atomic<juce::int64> position{0};
+
+    void readCached(const juce::AudioSourceChannelInfo& info, juce::int64 start) const noexcept;
+    size_t evict(size_t) override { return 0; } // Pinned: only a new track frees the cache
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PcmCacheSource)
+};
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    This file defines the PerfCounter class for a JUCE application,
+    a lock-free timing accumulator for measuring work done on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// PerfCounter: Collects call count, total and worst-case time of a code section.
+// Written by one thread (usually the audio callback), read by any other thread.
+class PerfCounter
+{
+//==============================================================================
+public:
+    PerfCounter() = default;
+
+    void addSample(juce::int64 ticks) noexcept
+    {
+        totalTicks.store(totalTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+        numCalls.store(numCalls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (ticks > maxTicks.load(std::memory_order_relaxed))
+        {
+            maxTicks.store(ticks, std::memory_order_relaxed);
+        }
+    }
+
+    juce::int64 getNumCalls() const noexcept { return numCalls.load(std::memory_order_relaxed); }
+
+    double getAverageMicros() const noexcept
+    {
+        auto calls = numCalls.load(std::memory_order_relaxed);
+        return calls > 0 ? ticksToMicros(totalTicks.load(std::memory_order_relaxed)) / static_cast<double>(calls) : 0.0;
+    }
+
+    double getMaxMicros() const noexcept { return ticksToMicros(maxTicks.load(std::memory_order_relaxed)); }
+
+    void reset() noexcept
+    {
+        totalTicks.store(0);
+        maxTicks.store(0);
+        numCalls.store(0);
+    }
+
+    static double ticksToMicros(juce::int64 ticks) noexcept
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    // ScopedTimer: Adds the lifetime of the enclosing scope to a counter
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(PerfCounter& counterToUse) noexcept
+            : counter(counterToUse), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedTimer() { counter.addSample(juce::Time::getHighResolutionTicks() - startTicks); }
+
+    private:
+        PerfCounter& counter;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+//==============================================================================
+private:
+    std::atomic<juce::int64> totalTicks{0};
+    std::atomic<juce::int64> maxTicks{0};
+    std::atomic<juce::int64> numCalls{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerfCounter)
+};
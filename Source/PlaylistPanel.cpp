@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the PlaylistPanel class for a JUCE application,
+    drawing playlist rows with their analysed tempo and mix-out time.
+
+  ==============================================================================
+*/
+
+#include "PlaylistPanel.h"
+#include "MusicLibrary.h"
+
+PlaylistPanel::PlaylistPanel(Automix& automixToControl, AnalysisCache& cacheToShow, MusicLibrary& libraryToQueueFrom)
+    : automix(automixToControl), analysisCache(cacheToShow), library(libraryToQueueFrom)
+{
+    addAndMakeVisible(list);
+    addAndMakeVisible(queueButton);
+    addAndMakeVisible(removeButton);
+    addAndMakeVisible(automixButton);
+    addAndMakeVisible(statusLabel);
+
+    list.setModel(this);
+    list.setRowHeight(20);
+
+    queueButton.onClick = [this]
+    {
+        auto track = library.getSelectedTrack();
+        if (track.existsAsFile())
+        {
+            automix.addTrack(track);
+        }
+    };
+    removeButton.onClick = [this] { automix.removeTrack(list.getSelectedRow()); };
+
+    automixButton.setClickingTogglesState(true);
+    automixButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green.darker(0.3f));
+    automixButton.onClick = [this]
+    {
+        automix.setEnabled(automixButton.getToggleState());
+        automixButton.setToggleState(automix.isEnabled(), juce::dontSendNotification); // Refused when empty
+    };
+
+    statusLabel.setFont(juce::FontOptions(12.0f));
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+
+    automix.onChange = [this]
+    {
+        list.updateContent();
+        list.repaint();
+        statusLabel.setText(automix.getStatus(), juce::dontSendNotification);
+    };
+    analysisCache.onAnalysisArrived = [this] { list.repaint(); };
+
+    startTimer(500);
+}
+
+PlaylistPanel::~PlaylistPanel()
+{
+    stopTimer();
+    automix.onChange = nullptr;
+    analysisCache.onAnalysisArrived = nullptr;
+}
+
+void PlaylistPanel::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.25f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+}
+
+// Header row with the controls and status, then the list
+void PlaylistPanel::resized()
+{
+    auto area = getLocalBounds().reduced(4);
+    auto header = area.removeFromTop(22);
+    automixButton.setBounds(header.removeFromLeft(70));
+    queueButton.setBounds(header.removeFromLeft(60).withTrimmedLeft(4));
+    removeButton.setBounds(header.removeFromLeft(64).withTrimmedLeft(4));
+    statusLabel.setBounds(header.withTrimmedLeft(4));
+    list.setBounds(area.withTrimmedTop(4));
+}
+
+int PlaylistPanel::getNumRows()
+{
+    return automix.getNumTracks();
+}
+
+// Live entry in green, cued entry in amber; tempo and mix-out time once analysed
+void PlaylistPanel::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+    if (rowNumber >= automix.getNumTracks())
+    {
+        return;
+    }
+
+    auto track = automix.getTrack(rowNumber);
+    auto current = automix.getCurrentIndex();
+
+    auto background = rowIsSelected ? juce::Colours::lightblue : juce::Colours::white;
+    if (rowNumber == current)
+    {
+        background = juce::Colours::lightgreen;
+    }
+    else if (rowNumber == automix.getCuedIndex())
+    {
+        background = juce::Colours::moccasin;
+    }
+    g.fillAll(background);
+
+    auto played = rowNumber < automix.getNextIndex() && rowNumber != current;
+    g.setColour(played ? juce::Colours::grey : juce::Colours::black);
+    g.setFont(juce::FontOptions(13.0f));
+    g.drawText(juce::String(rowNumber + 1) + ". " + track.getFileNameWithoutExtension(),
+               6, 0, width - 120, height, juce::Justification::centredLeft);
+
+    TrackAnalysis analysis;
+    if (analysisCache.lookup(track, analysis))
+    {
+        auto mixOut = static_cast<int>(analysis.mixOutSeconds);
+        auto info = (analysis.grid.isValid() ? juce::String(analysis.grid.bpm, 1) + " BPM  " : juce::String())
+                    + juce::String::formatted("out %d:%02d", mixOut / 60, mixOut % 60);
+        g.setColour(juce::Colours::darkgrey);
+        g.setFont(juce::FontOptions(11.0f));
+        g.drawText(info, width - 115, 0, 110, height, juce::Justification::centredRight);
+    }
+}
+
+void PlaylistPanel::timerCallback()
+{
+    statusLabel.setText(automix.getStatus(), juce::dontSendNotification);
+    automixButton.setToggleState(automix.isEnabled(), juce::dontSendNotification);
+}
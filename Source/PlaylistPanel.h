@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    This file defines the PlaylistPanel class for a JUCE application,
+    showing the automix playlist and its controls.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Automix.h"
+
+class MusicLibrary;
+
+// PlaylistPanel: The ordered playlist with the live and cued entries marked, plus buttons
+// to queue the library selection, remove an entry and switch automix on or off
+class PlaylistPanel : public juce::Component,
+                      public juce::ListBoxModel,
+                      private juce::Timer
+{
+//==============================================================================
+public:
+    PlaylistPanel(Automix& automixToControl, AnalysisCache& cacheToShow, MusicLibrary& libraryToQueueFrom);
+    ~PlaylistPanel() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+
+//==============================================================================
+private:
+    Automix& automix;
+    AnalysisCache& analysisCache;
+    MusicLibrary& library;
+
+    juce::ListBox list;
+    juce::TextButton queueButton{"Queue"};
+    juce::TextButton removeButton{"Remove"};
+    juce::TextButton automixButton{"Automix"};
+    juce::Label statusLabel;
+
+    void timerCallback() override; // Countdown to the next transition
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaylistPanel)
+};
@@ -0,0 +1,348 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the PolyphaseResampler class for a JUCE application,
+    building the shared filter tables and interpolating each deck in a single pass.
+
+  ==============================================================================
+*/
+
+#include "PolyphaseResampler.h"
+#include "Benchmarks.h"
+
+namespace
+{
+    constexpr int numTaps = PolyphaseResampler::numTaps;
+    constexpr int numPhases = PolyphaseResampler::numPhases;
+    constexpr int numTables = PolyphaseResampler::numTables;
+    constexpr int centreTap = numTaps / 2 - 1; // The tap aligned with the output at phase 0
+
+    // FilterTables: Kaiser-windowed sinc for every phase of every cutoff, built once and
+    // shared by all decks. Phase numPhases repeats phase 0 one tap later, so the audio
+    // thread can always interpolate between phase p and p + 1.
+    struct FilterTables
+    {
+        std::vector<float> coefficients;
+
+        FilterTables()
+            : coefficients(static_cast<size_t>(numTables * (numPhases + 1) * numTaps))
+        {
+            constexpr double beta = 7.0;
+            auto besselI0 = [](double x)
+            {
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 25; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            for (int table = 0; table < numTables; ++table)
+            {
+                // Table k serves ratios up to 2^(k/3); the cutoff leaves a 10% transition band
+                auto cutoff = 0.9 / std::pow(2.0, table / 3.0);
+
+                for (int phase = 0; phase <= numPhases; ++phase)
+                {
+                    auto* c = get(table, phase);
+                    auto fraction = static_cast<double>(phase) / numPhases;
+                    double total = 0.0;
+
+                    for (int tap = 0; tap < numTaps; ++tap)
+                    {
+                        auto x = tap - centreTap - fraction;
+                        auto t = cutoff * x;
+                        auto sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+                        auto r = x / (numTaps / 2);
+                        auto window = std::abs(r) >= 1.0 ? 0.0 : besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+                        c[tap] = static_cast<float>(sinc * window);
+                        total += sinc * window;
+                    }
+
+                    for (int tap = 0; tap < numTaps; ++tap)
+                    {
+                        c[tap] = static_cast<float>(c[tap] / total); // Unity gain at DC
+                    }
+                }
+            }
+        }
+
+        float* get(int table, int phase) noexcept
+        {
+            return coefficients.data() + (static_cast<size_t>(table) * (numPhases + 1) + static_cast<size_t>(phase)) * numTaps;
+        }
+
+        const float* get(int table, int phase) const noexcept
+        {
+            return coefficients.data() + (static_cast<size_t>(table) * (numPhases + 1) + static_cast<size_t>(phase)) * numTaps;
+        }
+    };
+
+    const FilterTables& getTables()
+    {
+        static const FilterTables tables;
+        return tables;
+    }
+
+    // SineSource: Test tone at a given source rate, for the benchmark
+    class SineSource : public juce::AudioSource
+    {
+    public:
+        SineSource(double frequency, double rate)
+            : increment(juce::MathConstants<double>::twoPi * frequency / rate) {}
+
+        void prepareToPlay(int, double) override {}
+        void releaseResources() override {}
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override
+        {
+            for (int i = 0; i < info.numSamples; ++i)
+            {
+                auto value = static_cast<float>(0.5 * std::sin(phase));
+                phase += increment;
+                for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+                {
+                    info.buffer->setSample(ch, info.startSample + i, value);
+                }
+            }
+        }
+
+    private:
+        double phase = 0.0;
+        double increment;
+    };
+
+    // Fit a sine at the expected frequency by least squares and report what is left over
+    double measureSnr(juce::AudioSource& resampler, double frequency, double outputRate)
+    {
+        constexpr int blockSize = 512;
+        constexpr int settle = 4096;
+        juce::AudioBuffer<float> output(2, static_cast<int>(outputRate));
+
+        for (int start = 0; start < output.getNumSamples(); start += blockSize)
+        {
+            juce::AudioSourceChannelInfo info(&output, start, juce::jmin(blockSize, output.getNumSamples() - start));
+            resampler.getNextAudioBlock(info);
+        }
+
+        auto w = juce::MathConstants<double>::twoPi * frequency / outputRate;
+        const auto* y = output.getReadPointer(0);
+        double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+
+        for (int n = settle; n < output.getNumSamples(); ++n)
+        {
+            auto s = std::sin(w * n), c = std::cos(w * n);
+            ss += s * s; sc += s * c; cc += c * c;
+            ys += y[n] * s; yc += y[n] * c;
+        }
+
+        auto det = ss * cc - sc * sc;
+        auto a = (ys * cc - yc * sc) / det;
+        auto b = (yc * ss - ys * sc) / det;
+        double signal = 0.0, noise = 0.0;
+
+        for (int n = settle; n < output.getNumSamples(); ++n)
+        {
+            auto fit = a * std::sin(w * n) + b * std::cos(w * n);
+            signal += fit * fit;
+            noise += (y[n] - fit) * (y[n] - fit);
+        }
+
+        return 10.0 * std::log10(signal / juce::jmax(noise, 1.0e-30));
+    }
+}
+
+PolyphaseResampler::PolyphaseResampler(juce::AudioSource* inputSource, int channels)
+    : input(inputSource), numChannels(channels)
+{
+    getTables(); // Build the shared tables now rather than on the first audio block
+}
+
+void PolyphaseResampler::setSourceSampleRate(double rate)
+{
+    sourceRate.store(rate);
+}
+
+void PolyphaseResampler::setSpeed(double newSpeed)
+{
+    speed.store(newSpeed);
+}
+
+double PolyphaseResampler::getTargetRatio() const noexcept
+{
+    auto rate = sourceRate.load();
+    auto correction = rate > 0.0 ? rate / deviceRate : 1.0;
+    return juce::jlimit(1.0 / maxRatio, maxRatio, correction * speed.load());
+}
+
+// Size the input history for the largest pull a block can need at the maximum ratio
+void PolyphaseResampler::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    deviceRate = sampleRate;
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    auto capacity = static_cast<int>(std::ceil(juce::jmax(samplesPerBlockExpected, 1024) * maxRatio)) + 2 * numTaps + 2;
+    history.setSize(numChannels, capacity);
+    currentRatio = getTargetRatio();
+    flushBuffers();
+}
+
+void PolyphaseResampler::releaseResources()
+{
+    input->releaseResources();
+}
+
+void PolyphaseResampler::flushBuffers() noexcept
+{
+    available = 0;
+    readPosition = 0.0;
+}
+
+// Audio thread: pull just enough input, then filter every output from the shared tables
+void PolyphaseResampler::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto numSamples = bufferToFill.numSamples;
+    auto targetRatio = getTargetRatio();
+    auto ratioStep = (targetRatio - currentRatio) / juce::jmax(1, numSamples);
+
+    auto lastWindow = readPosition + numSamples * juce::jmax(currentRatio, targetRatio);
+    auto needed = static_cast<int>(std::ceil(lastWindow)) + numTaps + 1 - available;
+    if (needed > 0)
+    {
+        pullInput(needed);
+    }
+
+    auto outputChannels = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+
+    // Unity ratio on a whole sample: the filter would only delay, so copy instead
+    if (currentRatio == 1.0 && targetRatio == 1.0 && readPosition == std::floor(readPosition))
+    {
+        auto start = static_cast<int>(readPosition) + centreTap;
+        for (int ch = 0; ch < outputChannels; ++ch)
+        {
+            bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample, history, ch, start, numSamples);
+        }
+        readPosition += numSamples;
+        consumeInput();
+        return;
+    }
+
+    const auto& tables = getTables();
+    auto table = juce::jlimit(0, numTables - 1,
+                              static_cast<int>(std::ceil(3.0 * std::log2(juce::jmax(currentRatio, targetRatio)) - 1.0e-9)));
+    float coefficients[numTaps];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto base = static_cast<int>(readPosition);
+        auto phasePosition = static_cast<float>((readPosition - base) * numPhases);
+        auto phase = juce::jmin(static_cast<int>(phasePosition), numPhases - 1);
+        auto blend = phasePosition - static_cast<float>(phase);
+        const auto* lower = tables.get(table, phase);
+        const auto* upper = tables.get(table, phase + 1);
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            coefficients[tap] = lower[tap] + blend * (upper[tap] - lower[tap]);
+        }
+
+        for (int ch = 0; ch < outputChannels; ++ch)
+        {
+            const auto* x = history.getReadPointer(ch, base);
+            float sum = 0.0f;
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+                sum += coefficients[tap] * x[tap];
+            }
+            bufferToFill.buffer->setSample(ch, bufferToFill.startSample + i, sum);
+        }
+
+        readPosition += currentRatio;
+        currentRatio += ratioStep;
+    }
+
+    currentRatio = targetRatio;
+    consumeInput();
+}
+
+void PolyphaseResampler::pullInput(int numSamples)
+{
+    // Only reallocates if the device delivers a larger block than prepareToPlay announced
+    history.setSize(numChannels, available + numSamples, true, false, true);
+
+    juce::AudioSourceChannelInfo info(&history, available, numSamples);
+    input->getNextAudioBlock(info);
+    available += numSamples;
+}
+
+// Drop the input samples no later output can reach
+void PolyphaseResampler::consumeInput() noexcept
+{
+    auto consumed = juce::jmin(static_cast<int>(readPosition), available);
+    if (consumed <= 0)
+    {
+        return;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = history.getWritePointer(ch);
+        std::memmove(data, data + consumed, static_cast<size_t>(available - consumed) * sizeof(float));
+    }
+    available -= consumed;
+    readPosition -= consumed;
+}
+
+juce::String PolyphaseResampler::runBenchmark()
+{
+    constexpr double fileRate = 48000.0;
+    juce::String report;
+
+    SineSource polyphaseTone(1000.0, fileRate);
+    PolyphaseResampler polyphase(&polyphaseTone);
+    polyphase.setSourceSampleRate(fileRate);
+    polyphase.setSpeed(1.06);
+
+    SineSource juceTone(1000.0, fileRate);
+    juce::ResamplingAudioSource juceResampler(&juceTone, false, 2);
+
+    report << Benchmarks::timeBlockSizes("Polyphase 48k x1.06",
+        [&polyphase](double rate, int blockSize) { polyphase.prepareToPlay(blockSize, rate); },
+        [&polyphase](juce::AudioBuffer<float>& buffer, int numSamples)
+        {
+            polyphase.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, numSamples));
+        });
+    report << Benchmarks::timeBlockSizes("JUCE resampler 48k x1.06",
+        [&juceResampler](double rate, int blockSize)
+        {
+            juceResampler.setResamplingRatio(fileRate / rate * 1.06);
+            juceResampler.prepareToPlay(blockSize, rate);
+        },
+        [&juceResampler](juce::AudioBuffer<float>& buffer, int numSamples)
+        {
+            juceResampler.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, numSamples));
+        });
+
+    // Quality: a tone at the file rate should come out as a clean tone at the device rate
+    for (auto frequency : { 1000.0, 8000.0, 16000.0 })
+    {
+        SineSource toneA(frequency, fileRate);
+        PolyphaseResampler resampler(&toneA);
+        resampler.setSourceSampleRate(fileRate);
+        resampler.prepareToPlay(512, Benchmarks::sampleRate);
+
+        SineSource toneB(frequency, fileRate);
+        juce::ResamplingAudioSource reference(&toneB, false, 2);
+        reference.setResamplingRatio(fileRate / Benchmarks::sampleRate);
+        reference.prepareToPlay(512, Benchmarks::sampleRate);
+
+        report << juce::String::formatted("%-24s %5.0f Hz: SNR polyphase %6.1f dB, JUCE %6.1f dB\n",
+                                          "Resampler 48k -> 44.1k", frequency,
+                                          measureSnr(resampler, frequency, Benchmarks::sampleRate),
+                                          measureSnr(reference, frequency, Benchmarks::sampleRate));
+    }
+
+    return report;
+}
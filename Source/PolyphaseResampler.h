@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    This file defines the PolyphaseResampler class for a JUCE application,
+    converting a deck from its file's sample rate to the device rate at any pitch.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// PolyphaseResampler: Windowed-sinc interpolation from precomputed polyphase tables. The
+// file-to-device rate correction and the pitch fader are folded into one ratio, so each
+// deck is interpolated once per block. When the ratio goes above 1 a table with a lower
+// cutoff is chosen, so speeding up or playing a high-rate file does not alias.
+class PolyphaseResampler : public juce::AudioSource
+{
+//==============================================================================
+public:
+    explicit PolyphaseResampler(juce::AudioSource* inputSource, int numChannels = 2);
+
+    // GUI thread
+    void setSourceSampleRate(double rate); // The file's rate; 0 plays at the device rate
+    void setSpeed(double newSpeed);
+
+    // Audio thread
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+    void flushBuffers() noexcept; // Forget the input history, e.g. after the source jumps
+
+    static juce::String runBenchmark(); // Cost per block and SNR against juce::ResamplingAudioSource
+
+    static constexpr int numTaps = 32;     // Input samples per output sample
+    static constexpr int numPhases = 256;  // Fractional positions per table, interpolated between
+    static constexpr int numTables = 7;    // Cutoffs for ratios up to 1, 2^(1/3), ... 4
+    static constexpr double maxRatio = 4.0;
+
+//==============================================================================
+private:
+    juce::AudioSource* input;
+    int numChannels;
+
+    std::atomic<double> sourceRate{0.0};
+    std::atomic<double> speed{1.0};
+    double deviceRate{44100.0};
+    double currentRatio{1.0};          // Ramped towards the target across each block
+
+    juce::AudioBuffer<float> history;  // Input samples not yet fully consumed
+    int available = 0;                 // Valid samples at the front of history
+    double readPosition = 0.0;         // Start of the next output's filter window in history
+
+    double getTargetRatio() const noexcept; // Source samples per output sample
+    void pullInput(int numSamples);
+    void consumeInput() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResampler)
+};
@@ -0,0 +1,484 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the RegressionSuite class for a JUCE application,
+    scripting the decks and mixer block by block and diffing the result against golden files.
+
+  ==============================================================================
+*/
+
+#include "RegressionSuite.h"
+#include "OfflineRenderer.h"
+#include "EffectsRack.h"
+#include <iostream>
+
+namespace
+{
+    constexpr double inputSeconds = 8.0;
+
+    // True for the block that contains time t, so each scripted event fires exactly once
+    bool at(double now, double blockSeconds, double t)
+    {
+        return now <= t && t < now + blockSeconds;
+    }
+
+    void send(OfflineRenderer& renderer, EngineCommand::Type type, int deck, float value)
+    {
+        EngineCommand command;
+        command.type = type;
+        command.target = deck;
+        command.value = value;
+        command.ticks = juce::Time::getHighResolutionTicks();
+        renderer.getMixer().getCommandQueue().push(command); // Applied at the start of the next block
+    }
+}
+
+int RegressionSuite::runCommandLine(const juce::String& commandLine)
+{
+    auto tokens = juce::StringArray::fromTokens(commandLine, true);
+    tokens.trim();
+    tokens.removeEmptyStrings();
+
+    Options options;
+    auto cwd = juce::File::getCurrentWorkingDirectory();
+    options.goldenDirectory = cwd.getChildFile("regression");
+
+    for (int i = 0; i < tokens.size(); ++i)
+    {
+        auto token = tokens[i].unquoted();
+        auto value = tokens[i + 1].unquoted();
+
+        if (token == "--regress")
+        {
+            continue;
+        }
+        else if (token == "--update")
+        {
+            options.update = true;
+        }
+        else if (token == "--allow-missing")
+        {
+            options.allowMissing = true;
+        }
+        else if (token == "--golden")
+        {
+            options.goldenDirectory = cwd.getChildFile(value);
+            ++i;
+        }
+        else if (token == "--only")
+        {
+            options.only = value;
+            ++i;
+        }
+        else if (token == "--tolerance")
+        {
+            options.tolerance = juce::jmax(0.0f, value.getFloatValue());
+            ++i;
+        }
+        else if (token == "--timing-tolerance")
+        {
+            options.timingTolerance = juce::jmax(0.0, value.getDoubleValue());
+            ++i;
+        }
+        else if (token == "--strict-timing")
+        {
+            options.strictTiming = true;
+        }
+        else
+        {
+            std::cout << "Unknown option " << token << "\n"
+                      << "usage: --regress [--golden DIR] [--update] [--allow-missing] [--only NAME] [--tolerance X]"
+                         " [--timing-tolerance X] [--strict-timing]\n";
+            return 1;
+        }
+    }
+
+    // Synthesised every run, so the inputs can never drift from what the goldens were made from
+    auto inputs = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("AudioProj-regress");
+    auto tone = inputs.getChildFile("tone44k.wav");
+    auto beats = inputs.getChildFile("beats48k.wav");
+    if (!inputs.createDirectory() || !writeInputs(tone, beats))
+    {
+        std::cout << "Cannot write inputs to " << inputs.getFullPathName() << "\n";
+        return 1;
+    }
+
+    if (options.update && !options.goldenDirectory.createDirectory())
+    {
+        std::cout << "Cannot create " << options.goldenDirectory.getFullPathName() << "\n";
+        return 1;
+    }
+
+    // Timings only compare on the machine that made them, so they stay out of the golden directory
+    auto baselineFile = getBaselineFile();
+    auto baselines = juce::XmlDocument::parse(baselineFile);
+    if (baselines == nullptr || !baselines->hasTagName("Baselines"))
+    {
+        baselines = std::make_unique<juce::XmlElement>("Baselines");
+    }
+    auto baselinesBefore = baselines->toString();
+
+    int run = 0, failed = 0, skipped = 0, scenariosRun = 0;
+
+    // Self-checking scenarios compare against their own reference and need no golden file
+    for (const auto& check : makeChecks())
+    {
+        if (options.only.isNotEmpty() && check.first != options.only)
+        {
+            continue;
+        }
+
+        ++run;
+        auto failures = check.second();
+        std::cout << (failures.isEmpty() ? "PASSED  " : "FAILED  ") << check.first << "\n" << failures;
+        failed += failures.isEmpty() ? 0 : 1;
+    }
+
+    for (const auto& scenario : makeScenarios(tone, beats))
+    {
+        if (options.only.isNotEmpty() && scenario.name != options.only)
+        {
+            continue;
+        }
+
+        ++run;
+        ++scenariosRun;
+        switch (runScenario(scenario, options, *baselines))
+        {
+            case RegressionSuite::failed:  ++failed; break;
+            case RegressionSuite::skipped: ++skipped; break;
+            case RegressionSuite::passed:  break;
+        }
+    }
+
+    if (baselines->toString() != baselinesBefore
+        && !(baselineFile.getParentDirectory().createDirectory() && baselines->writeTo(baselineFile)))
+    {
+        std::cout << "Cannot write " << baselineFile.getFullPathName() << "\n";
+    }
+
+    std::cout << run << " scenarios, " << failed << " failed, " << skipped << " skipped"
+              << (options.update ? ", goldens updated in " + options.goldenDirectory.getFullPathName() : juce::String())
+              << "\n";
+    if (skipped > 0)
+    {
+        std::cout << "Skipped scenarios have no golden file in " << options.goldenDirectory.getFullPathName()
+                  << "; make them with --update on a known-good build\n";
+    }
+
+    // Skipping every scenario compares nothing, so it cannot count as a pass
+    auto nothingCompared = scenariosRun > 0 && skipped == scenariosRun;
+    if (nothingCompared)
+    {
+        std::cout << "No scenario was compared with a golden file\n";
+    }
+    std::cout << std::flush;
+    return run > 0 && failed == 0 && !nothingCompared ? 0 : 1;
+}
+
+juce::File RegressionSuite::getBaselineFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("regress-baselines.xml");
+}
+
+std::vector<std::pair<juce::String, std::function<juce::String()>>> RegressionSuite::makeChecks()
+{
+    return { { "fx-mix", [] { return EffectsRack::checkMixLaw(); } } };
+}
+
+// Each scenario exercises one part of the chain; two-decks catches decks overwriting each other
+std::vector<RegressionSuite::Scenario> RegressionSuite::makeScenarios(const juce::File& tone, const juce::File& beats)
+{
+    std::vector<Scenario> scenarios;
+
+    scenarios.push_back({ "load-play", 3.0, [tone](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(tone);
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getMixer().setCrossfader(0.0f);
+        }
+        if (at(now, block, 2.0))
+        {
+            renderer.getDeck(0).setPlaying(false); // The stop fade
+        }
+    } });
+
+    scenarios.push_back({ "speed", 3.0, [beats](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(beats); // 48 kHz through the resampler
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getMixer().setCrossfader(0.0f);
+        }
+        if (at(now, block, 1.0))
+        {
+            send(renderer, EngineCommand::pitch, 0, 1.08f);
+        }
+        if (at(now, block, 2.0))
+        {
+            send(renderer, EngineCommand::pitch, 0, 0.92f);
+        }
+    } });
+
+    scenarios.push_back({ "seek", 3.0, [tone](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(tone);
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getMixer().setCrossfader(0.0f);
+        }
+        if (at(now, block, 1.0))
+        {
+            renderer.getDeck(0).setTransportPosition(5.0);
+        }
+        if (at(now, block, 2.0))
+        {
+            renderer.getDeck(0).setTransportPosition(0.25);
+        }
+    } });
+
+    scenarios.push_back({ "two-decks", 2.0, [tone, beats](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(tone);
+            renderer.getDeck(1).loadFile(beats);
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getDeck(1).setPlaying(true);
+            renderer.getMixer().setCrossfader(0.5f);
+            send(renderer, EngineCommand::volume, 0, 0.8f);
+            send(renderer, EngineCommand::volume, 1, 0.6f);
+        }
+    } });
+
+    scenarios.push_back({ "crossfade", 4.0, [tone, beats](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(tone);
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getMixer().setCrossfader(0.0f);
+        }
+        if (at(now, block, 0.5))
+        {
+            renderer.getDeck(1).loadFile(beats); // Loaded while the other deck plays
+        }
+        if (at(now, block, 1.0))
+        {
+            renderer.getDeck(1).setPlaying(true);
+        }
+        if (now >= 1.0 && now < 3.0)
+        {
+            renderer.getMixer().setCrossfader(static_cast<float>((now - 1.0) / 2.0)); // Swept once per block
+        }
+        if (at(now, block, 3.0))
+        {
+            renderer.getMixer().setCrossfader(1.0f);
+        }
+    } });
+
+    scenarios.push_back({ "cue", 2.0, [tone, beats](OfflineRenderer& renderer, double now, double block)
+    {
+        if (at(now, block, 0.0))
+        {
+            renderer.getDeck(0).loadFile(tone);
+            renderer.getDeck(1).loadFile(beats);
+            renderer.getDeck(0).setPlaying(true);
+            renderer.getDeck(1).setPlaying(true);
+            renderer.getDeck(1).setCueEnabled(true);
+            renderer.getMixer().setCrossfader(0.0f); // Deck 2 only reaches the cue outputs
+            renderer.getMixer().setCueMix(0.0f);
+        }
+        if (at(now, block, 1.0))
+        {
+            renderer.getMixer().setCueMix(0.5f);
+        }
+    } });
+
+    return scenarios;
+}
+
+// A tone with a click on every beat, and a kick, saw and seeded noise pattern at 48 kHz
+bool RegressionSuite::writeInputs(const juce::File& tone, const juce::File& beats)
+{
+    const auto twoPi = juce::MathConstants<double>::twoPi;
+
+    juce::AudioBuffer<float> toneBuffer(2, static_cast<int>(inputSeconds * sampleRate));
+    for (int i = 0; i < toneBuffer.getNumSamples(); ++i)
+    {
+        auto t = i / sampleRate;
+        auto sinceClick = std::fmod(t, 0.5);
+        auto click = 0.4 * std::sin(twoPi * 2000.0 * sinceClick) * std::exp(-sinceClick / 0.005);
+        toneBuffer.setSample(0, i, static_cast<float>(0.4 * std::sin(twoPi * 440.0 * t) + click));
+        toneBuffer.setSample(1, i, static_cast<float>(0.4 * std::sin(twoPi * 660.0 * t) + click));
+    }
+
+    constexpr double beatsRate = 48000.0;
+    const auto beatSeconds = 60.0 / 126.0;
+    juce::Random random(1234);
+    juce::AudioBuffer<float> beatsBuffer(2, static_cast<int>(inputSeconds * beatsRate));
+    for (int i = 0; i < beatsBuffer.getNumSamples(); ++i)
+    {
+        auto t = i / beatsRate;
+        auto sinceBeat = std::fmod(t, beatSeconds);
+        auto kick = 0.5 * std::sin(twoPi * (50.0 + 100.0 * std::exp(-sinceBeat / 0.03)) * sinceBeat) * std::exp(-sinceBeat / 0.15);
+        auto saw = 0.15 * (2.0 * std::fmod(110.0 * t, 1.0) - 1.0);
+        auto sinceHat = std::fmod(t + beatSeconds / 2.0, beatSeconds);
+        auto hat = 0.1 * (random.nextDouble() * 2.0 - 1.0) * std::exp(-sinceHat / 0.01);
+        beatsBuffer.setSample(0, i, static_cast<float>(kick + saw + hat));
+        beatsBuffer.setSample(1, i, static_cast<float>(kick - saw + hat));
+    }
+
+    return OfflineRenderer::writeWav(toneBuffer, sampleRate, tone)
+        && OfflineRenderer::writeWav(beatsBuffer, beatsRate, beats);
+}
+
+RegressionSuite::Result RegressionSuite::runScenario(const Scenario& scenario, const Options& options,
+                                                     juce::XmlElement& baselines)
+{
+    OfflineRenderer renderer;
+    renderer.prepare(sampleRate, blockSize);
+
+    juce::AudioBuffer<float> output(numOutputs, static_cast<int>(scenario.seconds * sampleRate));
+    output.clear();
+    PerfCounter blockTimes;
+    renderer.render(output, nullptr, [&](double now, double block) { scenario.script(renderer, now, block); }, &blockTimes);
+
+    auto goldenFile = options.goldenDirectory.getChildFile(scenario.name + ".wav");
+    auto* baseline = baselines.getChildByAttribute("name", scenario.name);
+    auto timing = juce::String::formatted("%.1f us/block avg, %.1f max", blockTimes.getAverageMicros(), blockTimes.getMaxMicros());
+
+    // This machine's first run of a scenario, or an update, sets its timing baseline
+    auto newBaseline = options.update || baseline == nullptr;
+    if (newBaseline)
+    {
+        if (baseline == nullptr)
+        {
+            baseline = baselines.createNewChildElement("Scenario");
+            baseline->setAttribute("name", scenario.name);
+        }
+        baseline->setAttribute("avgMicros", blockTimes.getAverageMicros());
+        baseline->setAttribute("maxMicros", blockTimes.getMaxMicros());
+    }
+
+    if (options.update)
+    {
+        auto written = writeFloatWav(output, goldenFile);
+        std::cout << (written ? "UPDATED " : "FAILED  ") << scenario.name << "  " << timing << "\n";
+        return written ? passed : failed;
+    }
+
+    juce::AudioBuffer<float> golden;
+    if (!goldenFile.existsAsFile())
+    {
+        std::cout << (options.allowMissing ? "SKIPPED " : "FAILED  ") << scenario.name << "  no golden file "
+                  << goldenFile.getFullPathName() << " (record it with --update)  " << timing << "\n";
+        return options.allowMissing ? skipped : failed;
+    }
+    if (!readWav(goldenFile, golden))
+    {
+        std::cout << "FAILED  " << scenario.name << "  cannot read " << goldenFile.getFullPathName() << "\n";
+        return failed;
+    }
+
+    if (golden.getNumChannels() != output.getNumChannels() || golden.getNumSamples() != output.getNumSamples())
+    {
+        std::cout << "FAILED  " << scenario.name << "  golden has " << golden.getNumChannels() << " channels of "
+                  << golden.getNumSamples() << " samples, render has " << output.getNumChannels() << " of "
+                  << output.getNumSamples() << "\n";
+        return failed;
+    }
+
+    // Largest difference and where it is, which usually names the block that went wrong
+    float maxDifference = 0.0f;
+    int worstChannel = 0, worstSample = 0;
+    for (int ch = 0; ch < output.getNumChannels(); ++ch)
+    {
+        auto* rendered = output.getReadPointer(ch);
+        auto* expected = golden.getReadPointer(ch);
+        for (int i = 0; i < output.getNumSamples(); ++i)
+        {
+            auto difference = std::abs(rendered[i] - expected[i]);
+            if (!(difference <= maxDifference)) // NaN counts as the worst
+            {
+                maxDifference = std::isfinite(difference) ? difference : std::numeric_limits<float>::infinity();
+                worstChannel = ch;
+                worstSample = i;
+            }
+        }
+    }
+
+    auto soundPassed = maxDifference <= options.tolerance;
+    auto timingPassed = true;
+    if (newBaseline)
+    {
+        timing << " (baseline recorded)";
+    }
+    else
+    {
+        auto baselineAverage = baseline->getDoubleAttribute("avgMicros");
+        timingPassed = baselineAverage <= 0.0 || blockTimes.getAverageMicros() <= baselineAverage * (1.0 + options.timingTolerance);
+        timing << juce::String::formatted(" (baseline %.1f avg)", baselineAverage);
+    }
+    auto passes = soundPassed && (timingPassed || !options.strictTiming);
+
+    std::cout << (passes ? "PASSED  " : "FAILED  ") << scenario.name << "  ";
+    if (soundPassed)
+    {
+        std::cout << "max difference " << juce::String(juce::Decibels::gainToDecibels(maxDifference, -200.0f), 1) << " dB";
+    }
+    else
+    {
+        std::cout << "differs by " << juce::String(maxDifference, 6) << " on output " << (worstChannel + 1)
+                  << " at " << juce::String(worstSample / sampleRate, 3) << " s (block " << worstSample / blockSize << ")";
+    }
+    std::cout << "  " << timing << (timingPassed ? "" : "  SLOWER than baseline") << "\n";
+    return passes ? passed : failed;
+}
+
+bool RegressionSuite::readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    if (!file.existsAsFile())
+    {
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+    if (reader == nullptr)
+    {
+        return false;
+    }
+
+    buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
+
+// 32-bit float, so a golden file holds exactly what was rendered
+bool RegressionSuite::writeFloatWav(const juce::AudioBuffer<float>& buffer, const juce::File& file)
+{
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                        static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                        32, {}, 0));
+    if (writer == nullptr)
+    {
+        return false;
+    }
+    stream.release(); // Now owned by the writer
+
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
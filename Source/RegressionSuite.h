@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    This file defines the RegressionSuite class for a JUCE application,
+    checking the rendered output and speed of the deck and mixer chain against stored results.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class OfflineRenderer;
+
+// RegressionSuite: Renders scripted scenarios (load, play, speed change, seek, crossfade,
+// cue) through the real decks and mixer via OfflineRenderer. Each output is compared
+// sample by sample with a golden file within a tolerance, so a change that alters the sound
+// fails the run. A missing golden file fails too, unless --allow-missing is given, and a run
+// in which no scenario could be compared never passes; goldens are recorded with --update
+// on a known-good build (see regression/README.md). The mixer's time per block is
+// compared with a baseline kept per machine (recorded by its first run there), and a
+// slowdown is reported, failing the run only with --strict-timing. The input tracks are
+// synthesised, so only the golden directory is needed. Checks such as the effects mix law
+// carry their own reference and run without one.
+class RegressionSuite
+{
+//==============================================================================
+public:
+    // --regress [--golden DIR] [--update] [--allow-missing] [--only NAME] [--tolerance X]
+    //           [--timing-tolerance X] [--strict-timing]
+    // Returns the process exit code: 0 when nothing failed and at least one scenario was compared.
+    static int runCommandLine(const juce::String& commandLine);
+
+    static juce::File getBaselineFile(); // This machine's block timings, in appdata
+
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blockSize = 512;
+    static constexpr int numOutputs = 4; // Master and cue
+
+//==============================================================================
+private:
+    struct Options
+    {
+        juce::File goldenDirectory;
+        juce::String only;
+        bool update = false;          // Write new golden files and baselines instead of comparing
+        bool allowMissing = false;    // A scenario without a golden file is skipped rather than failed
+        float tolerance = 1.0e-4f;    // Largest difference per sample, about -80 dBFS
+        double timingTolerance = 0.5; // Allowed slowdown of the mean block time
+        bool strictTiming = false;    // A slowdown fails the run rather than only being reported
+    };
+
+    enum Result { passed, failed, skipped };
+
+    // Scenario: A script run before every block, given the block's start time and length
+    struct Scenario
+    {
+        juce::String name;
+        double seconds = 0.0;
+        std::function<void(OfflineRenderer&, double now, double blockSeconds)> script;
+    };
+
+    static std::vector<std::pair<juce::String, std::function<juce::String()>>> makeChecks(); // Name and failures
+    static std::vector<Scenario> makeScenarios(const juce::File& tone, const juce::File& beats);
+    static bool writeInputs(const juce::File& tone, const juce::File& beats);
+    static Result runScenario(const Scenario& scenario, const Options& options, juce::XmlElement& baselines);
+    static bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer);
+    static bool writeFloatWav(const juce::AudioBuffer<float>& buffer, const juce::File& file);
+};
@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SamplePadBank class for a JUCE application,
+    decoding pads into the arena and mixing the voice pool on the audio thread.
+
+  ==============================================================================
+*/
+
+#include "SamplePadBank.h"
+
+// The audio device is closed before the bank is destroyed, so every arena can be freed here
+SamplePadBank::~SamplePadBank()
+{
+    delete pendingArena.exchange(nullptr);
+    delete retiredArena.exchange(nullptr);
+    delete arena;
+    setMemoryBudget(nullptr);
+}
+
+void SamplePadBank::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::cueBuffers, true);
+        memoryBudget->charge(this, arenaBytes.load());
+    }
+}
+
+// Decode every file into one block sized from the pads actually loaded (each capped at
+// maxPadSeconds); each reader keeps its file, so unreadable files leave no gap in the names
+std::unique_ptr<SamplePadBank::Arena> SamplePadBank::decodePads(juce::AudioFormatManager& formatManager,
+                                                                 const juce::Array<juce::File>& files,
+                                                                 const std::function<bool()>& shouldExit)
+{
+    juce::OwnedArray<juce::AudioFormatReader> readers;
+    juce::Array<juce::File> readerFiles;
+    juce::Array<int> readerFrames;
+    size_t totalSamples = 0;
+
+    for (const auto& file : files)
+    {
+        if (readers.size() == maxPads)
+        {
+            break;
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+        {
+            continue;
+        }
+
+        auto frames = static_cast<int>(juce::jmin(reader->lengthInSamples, static_cast<juce::int64>(maxPadSeconds * reader->sampleRate)));
+        if (frames < 2)
+        {
+            continue; // Nothing to play
+        }
+
+        totalSamples += static_cast<size_t>(frames) * (reader->numChannels > 1 ? 2 : 1);
+        readerFrames.add(frames);
+        readerFiles.add(file);
+        readers.add(reader.release());
+    }
+
+    if (readers.isEmpty())
+    {
+        return nullptr;
+    }
+
+    auto newBytes = totalSamples * sizeof(float);
+    if (memoryBudget != nullptr && !memoryBudget->reserve(this, newBytes))
+    {
+        return nullptr; // The current pads stay loaded
+    }
+
+    auto newArena = std::make_unique<Arena>();
+    newArena->samples.calloc(totalSamples);
+    newArena->bytes = newBytes;
+    size_t offset = 0;
+
+    for (int i = 0; i < readers.size(); ++i)
+    {
+        if (shouldExit())
+        {
+            discardPads(std::move(newArena));
+            return nullptr;
+        }
+
+        auto* reader = readers[i];
+        auto& pad = newArena->pads[static_cast<size_t>(i)];
+        pad.offset = offset;
+        pad.numFrames = readerFrames[i];
+        pad.stereo = reader->numChannels > 1;
+        pad.sampleRate = reader->sampleRate;
+        pad.name = readerFiles[i].getFileNameWithoutExtension();
+
+        // Read straight into the arena: left then right, no intermediate buffer
+        float* channels[2] = { newArena->samples + offset, pad.stereo ? newArena->samples + offset + static_cast<size_t>(pad.numFrames) : nullptr };
+        reader->read(channels, pad.stereo ? 2 : 1, 0, pad.numFrames);
+
+        offset += static_cast<size_t>(pad.numFrames) * (pad.stereo ? 2 : 1);
+    }
+
+    newArena->numPads = readers.size();
+    return newArena;
+}
+
+// The old arena's reservation is returned by collectGarbage(), once the audio thread has let go of it
+void SamplePadBank::installPads(std::unique_ptr<Arena> newArena)
+{
+    collectGarbage();
+
+    juce::StringArray names;
+    for (int i = 0; i < newArena->numPads; ++i)
+    {
+        names.add(newArena->pads[static_cast<size_t>(i)].name);
+    }
+
+    padNames = names;
+    numPads.store(newArena->numPads);
+    arenaBytes.store(newArena->bytes);
+
+    // An arena the audio thread never took can go at once
+    discardPads(std::unique_ptr<Arena>(pendingArena.exchange(newArena.release())));
+}
+
+void SamplePadBank::discardPads(std::unique_ptr<Arena> unused)
+{
+    if (unused != nullptr && memoryBudget != nullptr)
+    {
+        memoryBudget->release(this, unused->bytes);
+    }
+}
+
+juce::String SamplePadBank::getPadName(int pad) const
+{
+    return padNames[pad];
+}
+
+// GUI thread: the press time travels with the trigger so the audio thread can measure latency
+void SamplePadBank::trigger(int pad, float gain)
+{
+    int start1, size1, start2, size2;
+    triggerFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+    {
+        return; // Audio thread is not running or far behind
+    }
+
+    triggers[static_cast<size_t>(start1)] = { pad, gain, juce::Time::getHighResolutionTicks() };
+    triggerFifo.finishedWrite(1);
+}
+
+void SamplePadBank::stopAll()
+{
+    stopRequested.store(true);
+}
+
+// The audio thread has swapped arenas, so the one it retired and its reservation can go
+void SamplePadBank::collectGarbage()
+{
+    discardPads(std::unique_ptr<Arena>(retiredArena.exchange(nullptr)));
+}
+
+void SamplePadBank::prepare(double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+}
+
+// Audio thread: swap in a new arena, start triggered voices, then mix every active voice
+void SamplePadBank::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (pendingArena.load() != nullptr && retiredArena.load() == nullptr)
+    {
+        // Voices point into the old arena, so they end with it
+        for (auto& voice : voices)
+        {
+            voice.pad = -1;
+        }
+        retiredArena.store(arena);
+        arena = pendingArena.exchange(nullptr);
+    }
+
+    if (stopRequested.exchange(false))
+    {
+        for (auto& voice : voices)
+        {
+            voice.pad = -1;
+        }
+    }
+
+    int start1, size1, start2, size2;
+    triggerFifo.prepareToRead(triggerFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; ++i)
+    {
+        startVoice(triggers[static_cast<size_t>(start1 + i)]);
+    }
+    for (int i = 0; i < size2; ++i)
+    {
+        startVoice(triggers[static_cast<size_t>(start2 + i)]);
+    }
+    triggerFifo.finishedRead(size1 + size2);
+
+    if (arena == nullptr || buffer.getNumChannels() < 2)
+    {
+        return;
+    }
+
+    auto* left = buffer.getWritePointer(0, startSample);
+    auto* right = buffer.getWritePointer(1, startSample);
+
+    for (auto& voice : voices)
+    {
+        if (voice.pad < 0)
+        {
+            continue;
+        }
+
+        const auto& pad = arena->pads[static_cast<size_t>(voice.pad)];
+        const auto* padLeft = arena->samples + pad.offset;
+        const auto* padRight = pad.stereo ? padLeft + pad.numFrames : padLeft;
+        auto lastFrame = pad.numFrames - 1;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto index = static_cast<int>(voice.position);
+            if (index >= lastFrame)
+            {
+                voice.pad = -1; // Played out: the voice returns to the pool
+                break;
+            }
+
+            // Linear interpolation also covers pads recorded at another sample rate
+            auto fraction = static_cast<float>(voice.position - index);
+            left[i] += voice.gain * (padLeft[index] + fraction * (padLeft[index + 1] - padLeft[index]));
+            right[i] += voice.gain * (padRight[index] + fraction * (padRight[index + 1] - padRight[index]));
+            voice.position += voice.increment;
+        }
+
+        // Latency runs from the press to the block that first renders the voice
+        if (voice.triggerTicks != 0)
+        {
+            triggerLatency.addSample(juce::Time::getHighResolutionTicks() - voice.triggerTicks);
+            voice.triggerTicks = 0;
+        }
+    }
+}
+
+void SamplePadBank::triggerNow(int pad, float gain, juce::int64 pressedTicks) noexcept
+{
+    startVoice({ pad, gain, pressedTicks });
+}
+
+// Take a free voice, or steal the one that started first
+void SamplePadBank::startVoice(const Trigger& trigger) noexcept
+{
+    if (arena == nullptr || trigger.pad < 0 || trigger.pad >= arena->numPads)
+    {
+        return;
+    }
+
+    auto* chosen = &voices[0];
+    for (auto& voice : voices)
+    {
+        if (voice.pad < 0)
+        {
+            chosen = &voice;
+            break;
+        }
+        if (voice.startOrder < chosen->startOrder)
+        {
+            chosen = &voice;
+        }
+    }
+
+    chosen->pad = trigger.pad;
+    chosen->position = 0.0;
+    chosen->increment = arena->pads[static_cast<size_t>(trigger.pad)].sampleRate / deviceSampleRate;
+    chosen->gain = trigger.gain;
+    chosen->startOrder = nextStartOrder++;
+    chosen->triggerTicks = trigger.ticks;
+}
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    This file defines the SamplePadBank class for a JUCE application,
+    one-shot sample pads decoded into a single arena and played from a fixed voice pool.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PerfCounter.h"
+#include "MemoryBudget.h"
+
+// SamplePadBank: Loading decodes every pad into one contiguous block of memory and hands
+// it to the audio thread in one step. Triggers travel through a lock-free FIFO, and each
+// one takes a voice from a fixed pool (stealing the oldest), so pressing a pad never
+// allocates, locks or reads from disk.
+class SamplePadBank : private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    static constexpr int maxPads = 16;
+    static constexpr int numVoices = 32;
+    static constexpr double maxPadSeconds = 120.0;
+
+    struct Pad
+    {
+        size_t offset = 0;    // First left-channel sample in the arena
+        int numFrames = 0;
+        bool stereo = false;  // Right channel follows the left at offset + numFrames
+        double sampleRate = 44100.0;
+        juce::String name;
+    };
+
+    struct Arena
+    {
+        juce::HeapBlock<float> samples;
+        std::array<Pad, maxPads> pads;
+        int numPads = 0;
+        size_t bytes = 0; // Reserved from the budget
+    };
+
+    SamplePadBank() = default;
+    ~SamplePadBank() override;
+
+    void setMemoryBudget(MemoryBudget* budgetToUse); // The arena is charged as cue buffers
+
+    // Any thread: decodes the first maxPads readable files into a new arena, reserved from the
+    // budget. Null if none could be read, it does not fit, or shouldExit() turned true.
+    std::unique_ptr<Arena> decodePads(juce::AudioFormatManager& formatManager, const juce::Array<juce::File>& files,
+                                      const std::function<bool()>& shouldExit);
+    void discardPads(std::unique_ptr<Arena> unused); // Frees an arena and returns its reservation
+
+    // GUI thread
+    void installPads(std::unique_ptr<Arena> newArena); // Hands a decoded arena to the audio thread
+    int getNumPads() const noexcept { return numPads.load(); }
+    juce::String getPadName(int pad) const;
+    void trigger(int pad, float gain = 1.0f); // Wait-free; dropped if the FIFO is full
+    void stopAll();
+    void collectGarbage(); // Free the arena the audio thread has finished with
+    const PerfCounter& getTriggerLatency() const noexcept { return triggerLatency; }
+    size_t getArenaBytes() const noexcept { return arenaBytes.load(); }
+
+    // Audio thread: adds the active voices into the buffer
+    void prepare(double sampleRate);
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+    void triggerNow(int pad, float gain, juce::int64 pressedTicks) noexcept; // From a controller command, before renderNextBlock
+
+//==============================================================================
+private:
+    struct Voice
+    {
+        int pad = -1;          // -1 when free
+        double position = 0.0;
+        double increment = 1.0;
+        float gain = 1.0f;
+        juce::uint32 startOrder = 0;
+        juce::int64 triggerTicks = 0; // Press time, until the voice's first block is rendered
+    };
+
+    struct Trigger
+    {
+        int pad = 0;
+        float gain = 1.0f;
+        juce::int64 ticks = 0; // When the pad was pressed
+    };
+
+    // Arena handoff: GUI -> audio through `pendingArena`, back through `retiredArena`. Each
+    // arena holds its budget reservation until it is freed, so two can be charged briefly
+    std::atomic<Arena*> pendingArena{nullptr};
+    std::atomic<Arena*> retiredArena{nullptr};
+    Arena* arena = nullptr;   // Audio thread
+    juce::StringArray padNames; // GUI thread
+    std::atomic<int> numPads{0};
+    std::atomic<size_t> arenaBytes{0}; // The newest installed arena
+    std::atomic<bool> stopRequested{false};
+
+    juce::AbstractFifo triggerFifo{64};
+    std::array<Trigger, 64> triggers;
+
+    std::array<Voice, numVoices> voices;
+    juce::uint32 nextStartOrder = 0;
+    double deviceSampleRate{44100.0};
+    PerfCounter triggerLatency;
+    MemoryBudget* memoryBudget = nullptr;
+
+    void startVoice(const Trigger& trigger) noexcept;
+    size_t evict(size_t) override { return 0; } // Pads must fire the moment they are hit
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePadBank)
+};
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SamplePadGrid class for a JUCE application,
+    triggering pads on mouse down and loading a folder of samples into the bank.
+
+  ==============================================================================
+*/
+
+#include "SamplePadGrid.h"
+
+SamplePadGrid::SamplePadGrid(SamplePadBank& bankToUse, juce::AudioFormatManager& formatManagerToUse)
+    : juce::Thread("Pad loader"), bank(bankToUse), formatManager(formatManagerToUse)
+{
+    for (int i = 0; i < SamplePadBank::maxPads; ++i)
+    {
+        auto& pad = pads[i];
+        addAndMakeVisible(pad);
+        pad.setColour(juce::TextButton::buttonColourId, juce::Colours::darkslategrey);
+        pad.onStateChange = [this, i]
+        {
+            // Fire on the press itself; onClick would wait for the release
+            auto down = pads[i].isDown();
+            if (down && !padHeld[i])
+            {
+                bank.trigger(i);
+            }
+            padHeld[i] = down;
+        };
+    }
+
+    addAndMakeVisible(loadButton);
+    addAndMakeVisible(stopButton);
+    addAndMakeVisible(latencyLabel);
+
+    loadButton.onClick = [this]
+    {
+        chooser = std::make_unique<juce::FileChooser>("Choose a folder of pad samples",
+                                                      juce::File::getSpecialLocation(juce::File::userMusicDirectory));
+        chooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+                             [this](const juce::FileChooser& fc)
+                             {
+                                 if (fc.getResult().isDirectory())
+                                 {
+                                     loadFolder(fc.getResult());
+                                 }
+                             });
+    };
+    stopButton.onClick = [this] { bank.stopAll(); };
+
+    latencyLabel.setFont(juce::FontOptions(11.0f));
+    latencyLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    latencyLabel.setJustificationType(juce::Justification::centredRight);
+
+    refreshPadNames();
+    startTimer(250);
+    startThread(juce::Thread::Priority::low);
+}
+
+SamplePadGrid::~SamplePadGrid()
+{
+    stopTimer();
+    stopThread(4000);
+    cancelPendingUpdate();
+    bank.discardPads(std::move(decoded));
+}
+
+void SamplePadGrid::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.25f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+}
+
+// Header row with the loader, then the pads in two rows
+void SamplePadGrid::resized()
+{
+    auto area = getLocalBounds().reduced(4);
+    auto header = area.removeFromTop(22);
+    loadButton.setBounds(header.removeFromLeft(90));
+    stopButton.setBounds(header.removeFromLeft(50).withTrimmedLeft(4));
+    latencyLabel.setBounds(header);
+
+    auto columns = SamplePadBank::maxPads / 2;
+    auto padWidth = area.getWidth() / columns;
+    auto rowHeight = area.getHeight() / 2;
+
+    for (int i = 0; i < SamplePadBank::maxPads; ++i)
+    {
+        pads[i].setBounds(area.getX() + (i % columns) * padWidth, area.getY() + (i / columns) * rowHeight,
+                          padWidth, rowHeight);
+        pads[i].setBounds(pads[i].getBounds().reduced(2));
+    }
+}
+
+// Decode the first maxPads audio files in the folder, in name order, on the loader thread
+void SamplePadGrid::loadFolder(const juce::File& folder)
+{
+    auto files = folder.findChildFiles(juce::File::findFiles, false, formatManager.getWildcardForAllFormats());
+    files.sort();
+
+    {
+        const juce::ScopedLock sl(loadLock);
+        filesToLoad = files;
+        loadRequested = true;
+    }
+    loadButton.setEnabled(false);
+    latencyLabel.setText("Loading " + folder.getFileName() + "...", juce::dontSendNotification);
+    notify();
+}
+
+// Up to 16 pads of two minutes is hundreds of MB to read, so never on the message thread
+void SamplePadGrid::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::Array<juce::File> files;
+        {
+            const juce::ScopedLock sl(loadLock);
+            if (loadRequested)
+            {
+                files.swapWith(filesToLoad);
+                loadRequested = false;
+            }
+        }
+
+        if (files.isEmpty())
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto arena = bank.decodePads(formatManager, files, [this] { return threadShouldExit(); });
+        std::unique_ptr<SamplePadBank::Arena> untaken;
+        {
+            const juce::ScopedLock sl(loadLock);
+            untaken = std::move(decoded);
+            loadFailed = arena == nullptr;
+            decoded = std::move(arena);
+        }
+        bank.discardPads(std::move(untaken)); // A previous folder the message thread never took
+        triggerAsyncUpdate();
+    }
+}
+
+void SamplePadGrid::handleAsyncUpdate()
+{
+    std::unique_ptr<SamplePadBank::Arena> arena;
+    bool failed;
+    {
+        const juce::ScopedLock sl(loadLock);
+        arena = std::move(decoded);
+        failed = loadFailed;
+        loadFailed = false;
+    }
+
+    if (arena != nullptr)
+    {
+        bank.installPads(std::move(arena));
+        refreshPadNames();
+        latencyLabel.setText({}, juce::dontSendNotification);
+    }
+    else if (failed)
+    {
+        latencyLabel.setText("No pads loaded: no readable files, or not enough memory", juce::dontSendNotification);
+    }
+    loadButton.setEnabled(true);
+}
+
+void SamplePadGrid::refreshPadNames()
+{
+    for (int i = 0; i < SamplePadBank::maxPads; ++i)
+    {
+        auto loaded = i < bank.getNumPads();
+        pads[i].setButtonText(loaded ? bank.getPadName(i) : juce::String(i + 1));
+        pads[i].setEnabled(loaded);
+    }
+}
+
+void SamplePadGrid::timerCallback()
+{
+    bank.collectGarbage();
+
+    auto& latency = bank.getTriggerLatency();
+    if (latency.getNumCalls() > 0 && loadButton.isEnabled()) // Otherwise the label says what is loading
+    {
+        latencyLabel.setText(juce::String::formatted("trigger %.1f ms avg, %.1f ms max, %.1f MB",
+                                                     latency.getAverageMicros() / 1000.0,
+                                                     latency.getMaxMicros() / 1000.0,
+                                                     static_cast<double>(bank.getArenaBytes()) / (1024.0 * 1024.0)),
+                             juce::dontSendNotification);
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    This file defines the SamplePadGrid class for a JUCE application,
+    the pad buttons and loader for the sample pad bank.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SamplePadBank.h"
+
+// SamplePadGrid: Two rows of pads that fire on press rather than release,
+// plus a folder loader and a readout of the measured trigger latency. A folder is
+// decoded on a background thread; the pads switch over once it is all in memory.
+class SamplePadGrid : public juce::Component,
+                      private juce::Timer,
+                      private juce::Thread,
+                      private juce::AsyncUpdater
+{
+//==============================================================================
+public:
+    SamplePadGrid(SamplePadBank& bankToUse, juce::AudioFormatManager& formatManagerToUse);
+    ~SamplePadGrid() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+//==============================================================================
+private:
+    SamplePadBank& bank;
+    juce::AudioFormatManager& formatManager;
+
+    juce::TextButton pads[SamplePadBank::maxPads];
+    bool padHeld[SamplePadBank::maxPads] = {};
+    juce::TextButton loadButton{"Load pads..."};
+    juce::TextButton stopButton{"Stop"};
+    juce::Label latencyLabel;
+    std::unique_ptr<juce::FileChooser> chooser;
+
+    juce::CriticalSection loadLock;
+    juce::Array<juce::File> filesToLoad;              // Waiting for the loader thread
+    bool loadRequested = false;
+    std::unique_ptr<SamplePadBank::Arena> decoded;    // Waiting for the message thread
+    bool loadFailed = false;
+
+    void loadFolder(const juce::File& folder);
+    void refreshPadNames();
+    void timerCallback() override; // Free retired arenas and refresh the latency readout
+    void run() override;           // Decodes the newest folder asked for
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePadGrid)
+};
@@ -0,0 +1,245 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the ScratchEngine class for a JUCE application,
+    following jog-wheel motion with smoothed, cubic-interpolated variable-rate reading.
+
+  ==============================================================================
+*/
+
+#include "ScratchEngine.h"
+
+namespace
+{
+    constexpr double velocitySmoothingMs = 8.0;  // Time constant of the platter inertia
+    constexpr double handBackTolerance = 0.01;   // Velocity error at which the transport takes over
+}
+
+ScratchEngine::ScratchEngine(juce::AudioFormatManager& formatManagerToUse, const PcmCacheSource& decodedAudio)
+    : juce::Thread("Scratch window"), formatManager(formatManagerToUse), decoded(decodedAudio)
+{
+}
+
+ScratchEngine::~ScratchEngine()
+{
+    stopThread(2000);
+    setMemoryBudget(nullptr);
+}
+
+void ScratchEngine::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::cueBuffers, true);
+        memoryBudget->charge(this, 2 * 2 * static_cast<size_t>(windowCapacity) * sizeof(float));
+    }
+}
+
+// Start keeping a resident window of the newly loaded file
+void ScratchEngine::loadFile(const juce::File& file)
+{
+    unload();
+    sourceFile = file;
+    startThread();
+}
+
+// Stop the window builder; windows of the old generation are ignored from here on
+void ScratchEngine::unload()
+{
+    stopThread(2000);
+    generation.store(generation.load() + 1);
+    fileSampleRate.store(0.0);
+    centreRequest.store(0);
+    touched.store(false);
+}
+
+void ScratchEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+    smoothing = 1.0 - std::exp(-1000.0 / (velocitySmoothingMs * sampleRate));
+    bufferDurationMs.store(1000.0 * samplesPerBlockExpected / sampleRate);
+}
+
+// Hand on the platter: the audio thread takes over from the transport on its next block
+void ScratchEngine::touch()
+{
+    targetVelocity.store(0.0);
+    targetTimestamp.store(juce::Time::getHighResolutionTicks());
+    touched.store(true);
+}
+
+void ScratchEngine::setTargetVelocity(double newVelocity)
+{
+    targetVelocity.store(newVelocity);
+    targetTimestamp.store(juce::Time::getHighResolutionTicks());
+}
+
+// Hand off the platter: glide back to the deck's normal speed, then hand back
+void ScratchEngine::release(double velocityToReturnTo)
+{
+    setTargetVelocity(velocityToReturnTo);
+    touched.store(false);
+}
+
+bool ScratchEngine::renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill,
+                                    juce::int64 transportPosition,
+                                    juce::int64& handBackPosition) noexcept
+{
+    handBackPosition = -1;
+
+    // Acknowledge the latest window so the builder may refill the other one
+    auto windowIndex = publishedWindow.load(std::memory_order_acquire);
+    windowInUse.store(windowIndex);
+
+    auto rate = fileSampleRate.load();
+    auto* window = windowIndex >= 0 ? &windows[windowIndex] : nullptr;
+    if (window == nullptr || window->generation != generation.load() || rate <= 0.0)
+    {
+        engaged = false;
+        return false;
+    }
+
+    if (!engaged)
+    {
+        if (!touched.load())
+        {
+            centreRequest.store(transportPosition); // Follow the transport while idle
+            publishedPosition.store(static_cast<double>(transportPosition) / rate);
+            return false;
+        }
+
+        engaged = true;
+        position = static_cast<double>(transportPosition);
+    }
+
+    // Motion-to-audio latency: time from the GUI event to the block that first uses it
+    auto timestamp = targetTimestamp.load();
+    if (timestamp != lastTimestamp)
+    {
+        motionLatency.addSample(juce::Time::getHighResolutionTicks() - timestamp);
+        lastTimestamp = timestamp;
+    }
+
+    auto target = targetVelocity.load();
+    auto step = rate / deviceSampleRate; // Source samples per output sample at velocity 1
+    auto numChannels = juce::jmin(2, bufferToFill.buffer->getNumChannels());
+    auto* left = window->samples.getReadPointer(0);
+    auto* right = window->samples.getReadPointer(1);
+    auto offset = static_cast<double>(window->startSample);
+
+    for (int i = 0; i < bufferToFill.numSamples; ++i)
+    {
+        velocity += (target - velocity) * smoothing;
+        position += velocity * step;
+
+        auto index = position - offset;
+        bufferToFill.buffer->setSample(0, bufferToFill.startSample + i, interpolate(left, window->numSamples, index));
+        if (numChannels > 1)
+        {
+            bufferToFill.buffer->setSample(1, bufferToFill.startSample + i, interpolate(right, window->numSamples, index));
+        }
+    }
+
+    position = juce::jmax(0.0, position);
+    centreRequest.store(static_cast<juce::int64>(position));
+    publishedPosition.store(position / rate);
+
+    if (!touched.load() && std::abs(velocity - target) < handBackTolerance)
+    {
+        engaged = false;
+        velocity = target;
+        handBackPosition = static_cast<juce::int64>(position);
+    }
+
+    return true;
+}
+
+double ScratchEngine::getPositionInSeconds() const noexcept
+{
+    return publishedPosition.load();
+}
+
+// Window builder: keep the resident window centred on wherever the audio is reading
+void ScratchEngine::run()
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
+    if (reader == nullptr)
+    {
+        return;
+    }
+
+    fileSampleRate.store(reader->sampleRate);
+
+    while (!threadShouldExit())
+    {
+        refreshWindow(*reader);
+        wait(20);
+    }
+}
+
+void ScratchEngine::refreshWindow(juce::AudioFormatReader& reader)
+{
+    auto current = publishedWindow.load();
+    auto centre = centreRequest.load();
+    auto length = reader.lengthInSamples;
+    auto desiredStart = juce::jlimit<juce::int64>(0, juce::jmax<juce::int64>(0, length - windowCapacity),
+                                                  centre - windowCapacity / 2);
+
+    if (current >= 0)
+    {
+        auto& window = windows[current];
+        auto centred = centre >= window.startSample + windowCapacity / 4
+                    && centre < window.startSample + 3 * windowCapacity / 4;
+
+        if (window.generation == generation.load() && (centred || window.startSample == desiredStart))
+        {
+            return;
+        }
+
+        if (windowInUse.load() != current)
+        {
+            return; // The audio thread may still be reading the other window
+        }
+    }
+
+    auto target = current < 0 ? 0 : 1 - current;
+    auto& window = windows[target];
+    auto numSamples = static_cast<int>(juce::jmin<juce::int64>(windowCapacity, length - desiredStart));
+
+    if (!decoded.copyDecoded(window.samples, 0, desiredStart, numSamples))
+    {
+        reader.read(&window.samples, 0, numSamples, desiredStart, true, true); // A mono file fills both channels
+    }
+
+    window.startSample = desiredStart;
+    window.numSamples = numSamples;
+    window.generation = generation.load();
+    publishedWindow.store(target, std::memory_order_release);
+}
+
+// Four-point Catmull-Rom interpolation; silence outside the resident window
+float ScratchEngine::interpolate(const float* data, int numSamples, double index) const noexcept
+{
+    auto base = static_cast<int>(std::floor(index));
+    if (base < 1 || base + 2 >= numSamples)
+    {
+        return 0.0f;
+    }
+
+    auto t = static_cast<float>(index - base);
+    auto y0 = data[base - 1];
+    auto y1 = data[base];
+    auto y2 = data[base + 1];
+    auto y3 = data[base + 2];
+
+    auto a = -0.5f * y0 + 1.5f * y1 - 1.5f * y2 + 0.5f * y3;
+    auto b = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+    auto c = -0.5f * y0 + 0.5f * y2;
+    return ((a * t + b) * t + c) * t + y1;
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    This file defines the ScratchEngine class for a JUCE application,
+    providing variable-rate, bidirectional playback for the turntable jog wheel.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PerfCounter.h"
+#include "MemoryBudget.h"
+#include "PcmCacheSource.h"
+
+// ScratchEngine: Plays from a resident PCM window around the playhead at a smoothed,
+// GUI-controlled velocity. A background thread keeps the window centred on the playhead
+// so the audio thread never waits on the decoder, whichever direction the platter moves.
+// Windows are copied from the deck's PCM cache wherever the pipeline has decoded it; the
+// engine's own reader is only used beyond that (and for uncompressed files, which the
+// cache leaves to the reader).
+class ScratchEngine : private juce::Thread,
+                      private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    ScratchEngine(juce::AudioFormatManager& formatManagerToUse, const PcmCacheSource& decodedAudio);
+    ~ScratchEngine() override;
+
+    void loadFile(const juce::File& file);
+    void unload();
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void setMemoryBudget(MemoryBudget* budgetToUse); // Both windows are charged as cue buffers
+
+    // GUI thread: velocity is in multiples of normal playback speed, negative for reverse
+    void touch();
+    void setTargetVelocity(double velocity);
+    void release(double velocityToReturnTo);
+    bool isTouched() const noexcept { return touched.load(); }
+
+    // Audio thread: returns true when the engine produced this block. When control
+    // returns to the transport, handBackPosition is set to the source sample to resume from.
+    bool renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill,
+                         juce::int64 transportPosition,
+                         juce::int64& handBackPosition) noexcept;
+
+    double getPositionInSeconds() const noexcept;
+    const PerfCounter& getMotionLatency() const noexcept { return motionLatency; }
+    double getBufferDurationMs() const noexcept { return bufferDurationMs.load(); }
+
+    static constexpr int windowCapacity = 1 << 19; // Frames per resident window (~11 s at 44.1 kHz)
+
+//==============================================================================
+private:
+    struct Window
+    {
+        juce::AudioBuffer<float> samples{2, windowCapacity};
+        juce::int64 startSample{0};
+        int numSamples{0};
+        int generation{-1};
+    };
+
+    juce::AudioFormatManager& formatManager;
+    const PcmCacheSource& decoded;
+    juce::File sourceFile;
+
+    // Double-buffered window: the builder only writes the window the audio thread has let go of
+    Window windows[2];
+    std::atomic<int> publishedWindow{-1};
+    std::atomic<int> windowInUse{-1};
+    std::atomic<int> generation{0};
+    std::atomic<juce::int64> centreRequest{0};
+    std::atomic<double> fileSampleRate{0.0};
+
+    // GUI -> audio controls
+    std::atomic<bool> touched{false};
+    std::atomic<double> targetVelocity{0.0};
+    std::atomic<juce::int64> targetTimestamp{0};
+
+    // Audio thread state
+    bool engaged{false};
+    double position{0.0};
+    double velocity{0.0};
+    double smoothing{0.0};
+    double deviceSampleRate{44100.0};
+    juce::int64 lastTimestamp{0};
+    std::atomic<double> publishedPosition{0.0};
+    std::atomic<double> bufferDurationMs{0.0};
+
+    PerfCounter motionLatency;
+    MemoryBudget* memoryBudget = nullptr;
+
+    void run() override; // Window builder thread
+    void refreshWindow(juce::AudioFormatReader& reader);
+    float interpolate(const float* data, int numSamples, double index) const noexcept;
+    size_t evict(size_t) override { return 0; } // Allocated once, for the deck's lifetime
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScratchEngine)
+};
@@ -0,0 +1,253 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the ScrollingWaveform class for a JUCE application,
+    building a peak table as the track decodes and scrolling a cached raster under the playhead.
+
+  ==============================================================================
+*/
+
+#include "ScrollingWaveform.h"
+
+// Constructor: The strip is fully covered by its raster, so it can be drawn opaque
+ScrollingWaveform::ScrollingWaveform()
+{
+    setOpaque(true);
+}
+
+ScrollingWaveform::~ScrollingWaveform()
+{
+}
+
+// Blit the cached raster and overlay the fixed centre playhead
+void ScrollingWaveform::paint(juce::Graphics& g)
+{
+    if (raster.isValid())
+    {
+        g.drawImageAt(raster, 0, 0);
+    }
+    else
+    {
+        g.fillAll(juce::Colours::black.brighter(0.1f));
+    }
+
+    if (numPeaks.load() == 0)
+    {
+        g.setColour(juce::Colours::lightgreen.withAlpha(0.5f));
+        g.setFont(juce::FontOptions(14.0f, juce::Font::italic));
+        g.drawText("No track", getLocalBounds(), juce::Justification::centred, true);
+    }
+
+    auto centreX = getWidth() / 2;
+    g.setColour(juce::Colours::red.brighter(0.5f));
+    g.drawVerticalLine(centreX, 0.0f, static_cast<float>(getHeight()));
+
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.drawRect(getLocalBounds(), 1);
+}
+
+// Recreate the raster at the new size and redraw it from the peak table
+void ScrollingWaveform::resized()
+{
+    raster = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()),
+                         true, juce::SoftwareImageType());
+    rasterValid = false;
+    setPosition(playheadPosition);
+}
+
+// Mouse wheel zooms in and out by powers of two
+void ScrollingWaveform::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    if (wheel.deltaY == 0.0f)
+    {
+        return;
+    }
+
+    peaksPerColumn = juce::jlimit(1, 32, wheel.deltaY > 0.0f ? peaksPerColumn / 2 : peaksPerColumn * 2);
+    rasterValid = false;
+    setPosition(playheadPosition);
+}
+
+// Blank the strip; the pipeline is stopped, so no build is running
+void ScrollingWaveform::clear()
+{
+    numPeaks.store(0);
+    peaksReady.store(0);
+    sourceSampleRate.store(0.0);
+    playheadPosition = 0.0;
+    rasterValid = false;
+    rasterFirstColumn = 0;
+    rasterPeaksReady = 0;
+
+    // Wipe the old track's columns now; setPosition will not redraw until the next track has a rate
+    if (raster.isValid())
+    {
+        raster.clear(raster.getBounds(), juce::Colours::black.brighter(0.1f));
+    }
+
+    repaint();
+}
+
+// Scroll the raster to the published playhead, drawing only the columns that changed
+void ScrollingWaveform::setPosition(double positionInSeconds)
+{
+    playheadPosition = positionInSeconds;
+
+    if (!raster.isValid() || sourceSampleRate.load() <= 0.0)
+    {
+        return;
+    }
+
+    bool changed = false;
+
+    if (!rasterValid)
+    {
+        redrawRaster();
+        changed = true;
+    }
+    else
+    {
+        auto columnDelta = firstColumnFor(playheadPosition) - rasterFirstColumn;
+        if (columnDelta != 0)
+        {
+            scrollRaster(static_cast<int>(juce::jlimit<juce::int64>(-raster.getWidth(), raster.getWidth(), columnDelta)));
+            changed = true;
+        }
+    }
+
+    // Columns drawn before their peaks were built are refreshed as the builder progresses
+    auto ready = peaksReady.load(std::memory_order_acquire);
+    if (ready != rasterPeaksReady)
+    {
+        auto startX = static_cast<int>(juce::jlimit<juce::int64>(0, raster.getWidth(), rasterPeaksReady / peaksPerColumn - rasterFirstColumn));
+        auto endX = static_cast<int>(juce::jlimit<juce::int64>(0, raster.getWidth(), ready / peaksPerColumn + 1 - rasterFirstColumn));
+        drawColumns(startX, endX, ready);
+        rasterPeaksReady = ready;
+        changed = changed || endX > startX;
+    }
+
+    if (changed)
+    {
+        repaint();
+    }
+}
+
+// Peak builder: size the table for the whole track before the first block arrives
+juce::int64 ScrollingWaveform::decodeStarting(const juce::AudioFormatReader& reader)
+{
+    auto total = static_cast<int>((reader.lengthInSamples + samplesPerPeak - 1) / samplesPerPeak);
+    peakMin.assign(static_cast<size_t>(total), 0);
+    peakMax.assign(static_cast<size_t>(total), 0);
+    sourceSampleRate.store(reader.sampleRate);
+    numPeaks.store(total);
+    return reader.lengthInSamples;
+}
+
+// Summarise each block into signed 8-bit min/max pairs; blocks start on a peak boundary
+void ScrollingWaveform::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples)
+{
+    auto firstPeak = static_cast<int>(startSample / samplesPerPeak);
+    auto count = (numSamples + samplesPerPeak - 1) / samplesPerPeak;
+
+    for (int p = 0; p < count; ++p)
+    {
+        auto offset = p * samplesPerPeak;
+        auto length = juce::jmin(samplesPerPeak, numSamples - offset);
+        float low = 0.0f, high = 0.0f;
+
+        for (int ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto range = juce::FloatVectorOperations::findMinAndMax(block.getReadPointer(ch, offset), length);
+            low = juce::jmin(low, range.getStart());
+            high = juce::jmax(high, range.getEnd());
+        }
+
+        peakMin[static_cast<size_t>(firstPeak + p)] = static_cast<juce::int8>(juce::jlimit(-127, 127, juce::roundToInt(low * 127.0f)));
+        peakMax[static_cast<size_t>(firstPeak + p)] = static_cast<juce::int8>(juce::jlimit(-127, 127, juce::roundToInt(high * 127.0f)));
+    }
+
+    peaksReady.store(firstPeak + count, std::memory_order_release); // Publish the finished range
+}
+
+// Leftmost raster column for a playhead position, keeping the playhead centred
+juce::int64 ScrollingWaveform::firstColumnFor(double positionInSeconds) const
+{
+    auto samplesPerColumn = static_cast<double>(samplesPerPeak * peaksPerColumn);
+    auto centreColumn = static_cast<juce::int64>(std::floor(positionInSeconds * sourceSampleRate.load() / samplesPerColumn));
+    return centreColumn - raster.getWidth() / 2;
+}
+
+// Full redraw, used on load, resize and zoom changes
+void ScrollingWaveform::redrawRaster()
+{
+    auto ready = peaksReady.load(std::memory_order_acquire);
+    rasterFirstColumn = firstColumnFor(playheadPosition);
+    drawColumns(0, raster.getWidth(), ready);
+    rasterPeaksReady = ready;
+    rasterValid = true;
+}
+
+// Shift the existing raster sideways and draw only the newly exposed columns
+void ScrollingWaveform::scrollRaster(int columnDelta)
+{
+    auto width = raster.getWidth();
+    if (std::abs(columnDelta) >= width)
+    {
+        redrawRaster();
+        return;
+    }
+
+    auto ready = peaksReady.load(std::memory_order_acquire);
+
+    if (columnDelta > 0)
+    {
+        raster.moveImageSection(0, 0, columnDelta, 0, width - columnDelta, raster.getHeight());
+        rasterFirstColumn += columnDelta;
+        drawColumns(width - columnDelta, width, ready);
+    }
+    else
+    {
+        auto shift = -columnDelta;
+        raster.moveImageSection(shift, 0, 0, 0, width - shift, raster.getHeight());
+        rasterFirstColumn -= shift;
+        drawColumns(0, shift, ready);
+    }
+}
+
+// Draw raster columns [startX, endX) from the peaks that have been published so far
+void ScrollingWaveform::drawColumns(int startX, int endX, int ready)
+{
+    if (endX <= startX)
+    {
+        return;
+    }
+
+    juce::Graphics g(raster);
+    auto height = raster.getHeight();
+    auto middle = height * 0.5f;
+
+    g.setColour(juce::Colours::black.brighter(0.1f));
+    g.fillRect(startX, 0, endX - startX, height);
+
+    g.setColour(juce::Colours::cyan.darker(0.2f));
+    for (int x = startX; x < endX; ++x)
+    {
+        auto firstPeak = (rasterFirstColumn + x) * peaksPerColumn;
+        if (firstPeak < 0 || firstPeak >= ready)
+        {
+            continue;
+        }
+
+        auto lastPeak = juce::jmin<juce::int64>(firstPeak + peaksPerColumn, ready);
+        int low = 0, high = 0;
+        for (auto p = firstPeak; p < lastPeak; ++p)
+        {
+            low = juce::jmin(low, static_cast<int>(peakMin[static_cast<size_t>(p)]));
+            high = juce::jmax(high, static_cast<int>(peakMax[static_cast<size_t>(p)]));
+        }
+
+        auto top = juce::roundToInt(middle - high * middle / 127.0f);
+        auto bottom = juce::roundToInt(middle - low * middle / 127.0f);
+        g.fillRect(x, top, 1, juce::jmax(1, bottom - top));
+    }
+}
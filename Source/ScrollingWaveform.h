@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    This file defines the ScrollingWaveform class for a JUCE application,
+    drawing a zoomed waveform strip that scrolls under a fixed playhead.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DecodePipeline.h"
+
+// ScrollingWaveform: Zoomed, incrementally rendered waveform centred on the playhead.
+// Its peak table is built from the deck's decode pipeline as the track is read.
+class ScrollingWaveform : public juce::Component,
+                          public DecodePipeline::Consumer
+{
+//==============================================================================
+public:
+    ScrollingWaveform();
+    ~ScrollingWaveform() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+
+    void clear(); // With the pipeline stopped
+    void setPosition(double positionInSeconds); // Scroll the strip to the published playhead
+
+    // Pipeline thread: the peak builder
+    juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+    void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+
+    static constexpr int samplesPerPeak = 256; // Source samples summarised by one peak entry
+
+//==============================================================================
+private:
+    // Peak table: written by the pipeline thread, read by the GUI up to peaksReady
+    std::vector<juce::int8> peakMin;
+    std::vector<juce::int8> peakMax;
+    std::atomic<int> numPeaks{0};
+    std::atomic<int> peaksReady{0};
+    std::atomic<double> sourceSampleRate{0.0};
+
+    // Raster state: the strip is kept in an image and only newly exposed columns are drawn
+    juce::Image raster;
+    bool rasterValid{false};
+    juce::int64 rasterFirstColumn{0};
+    int rasterPeaksReady{0};
+    int peaksPerColumn{2};
+    double playheadPosition{0.0};
+
+    juce::int64 firstColumnFor(double positionInSeconds) const;
+    void redrawRaster();
+    void scrollRaster(int columnDelta);
+    void drawColumns(int startX, int endX, int ready);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScrollingWaveform)
+};
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SessionRecorder class for a JUCE application,
+    moving master blocks through a lock-free ring to an encoder on the writer thread.
+
+  ==============================================================================
+*/
+
+#include "SessionRecorder.h"
+
+SessionRecorder::SessionRecorder()
+    : juce::Thread("Session recorder")
+{
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    stop();
+}
+
+// Size the ring for the device sample rate. Called from prepareToPlay, so the
+// audio thread is not pushing while the ring is replaced.
+void SessionRecorder::prepare(double newSampleRate)
+{
+    if (isRecording())
+    {
+        if (newSampleRate == sampleRate)
+        {
+            return; // Same ring, same file: the writer thread never noticed the restart
+        }
+        interrupted.store(true); // The file's rate cannot change mid-way
+    }
+
+    stop();
+    sampleRate = newSampleRate;
+
+    auto capacity = static_cast<int>(ringSeconds * sampleRate);
+    ring.setSize(2, capacity);
+    fifo = std::make_unique<juce::AbstractFifo>(capacity);
+}
+
+// Open the encoder, then let the audio thread start filling the ring
+bool SessionRecorder::start(const juce::File& file, Format format)
+{
+    stop();
+
+    if (fifo == nullptr || !file.getParentDirectory().createDirectory())
+    {
+        return false;
+    }
+
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (stream->failedToOpen())
+    {
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormat> audioFormat;
+    if (format == flac)
+    {
+        audioFormat = std::make_unique<juce::FlacAudioFormat>();
+    }
+    else
+    {
+        audioFormat = std::make_unique<juce::WavAudioFormat>();
+    }
+
+    writer.reset(audioFormat->createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+    if (writer == nullptr)
+    {
+        return false;
+    }
+    stream.release(); // Now owned by the writer
+
+    currentFile = file;
+    fifo->reset();
+    samplesPushed.store(0);
+    overruns.store(0);
+    ringHighWater.store(0.0f);
+    interrupted.store(false);
+
+    startThread(juce::Thread::Priority::high);
+    recording.store(true);
+    return true;
+}
+
+// Stop accepting blocks, then let the writer thread flush what is left and close the file
+void SessionRecorder::stop()
+{
+    if (!isThreadRunning())
+    {
+        return;
+    }
+
+    recording.store(false);
+    signalThreadShouldExit();
+    notify();
+    stopThread(10000);
+}
+
+double SessionRecorder::getRecordedSeconds() const noexcept
+{
+    return static_cast<double>(samplesPushed.load()) / sampleRate;
+}
+
+void SessionRecorder::pushBlock(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    if (!recording.load() || buffer.getNumChannels() == 0)
+    {
+        return;
+    }
+
+    if (fifo->getFreeSpace() < numSamples)
+    {
+        overruns.store(overruns.load() + 1); // Disk fell behind by the whole ring: drop the block
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo->prepareToWrite(numSamples, start1, size1, start2, size2);
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        auto source = juce::jmin(ch, buffer.getNumChannels() - 1);
+        ring.copyFrom(ch, start1, buffer, source, startSample, size1);
+        if (size2 > 0)
+        {
+            ring.copyFrom(ch, start2, buffer, source, startSample + size1, size2);
+        }
+    }
+    fifo->finishedWrite(size1 + size2);
+    samplesPushed.store(samplesPushed.load() + numSamples);
+
+    auto fill = static_cast<float>(fifo->getNumReady()) / static_cast<float>(fifo->getTotalSize());
+    if (fill > ringHighWater.load())
+    {
+        ringHighWater.store(fill);
+    }
+}
+
+// Writer thread: drains every 50 ms until stopped, then flushes the remainder and closes.
+// It polls because waking it with notify() could take a lock on the audio thread.
+void SessionRecorder::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(50);
+        drain();
+    }
+
+    drain();
+    writer.reset();
+}
+
+void SessionRecorder::drain()
+{
+    int start1, size1, start2, size2;
+    fifo->prepareToRead(fifo->getNumReady(), start1, size1, start2, size2);
+
+    if (size1 > 0)
+    {
+        writer->writeFromAudioSampleBuffer(ring, start1, size1);
+    }
+    if (size2 > 0)
+    {
+        writer->writeFromAudioSampleBuffer(ring, start2, size2);
+    }
+
+    fifo->finishedRead(size1 + size2);
+}
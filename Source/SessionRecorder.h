@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    This file defines the SessionRecorder class for a JUCE application,
+    recording the master mix to a WAV or FLAC file on a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// SessionRecorder: The audio thread copies each master block into a preallocated
+// ring; a writer thread drains the ring into the encoder. The ring holds several
+// seconds, so a stalled disk only fills it. If it does fill, the block is dropped
+// and counted rather than making the audio callback wait.
+class SessionRecorder : private juce::Thread
+{
+//==============================================================================
+public:
+    enum Format { wav = 0, flac };
+
+    SessionRecorder();
+    ~SessionRecorder() override;
+
+    // Allocates the ring. A recording carries on through a device restart at the same
+    // sample rate (a new buffer size); at a different rate it is stopped and marked interrupted.
+    void prepare(double sampleRate);
+
+    // GUI thread
+    bool start(const juce::File& file, Format format); // False if the file could not be opened
+    void stop();                                        // Flushes the ring and closes the file
+    bool isRecording() const noexcept { return recording.load(); }
+    double getRecordedSeconds() const noexcept;
+    juce::int64 getOverruns() const noexcept { return overruns.load(); }       // Blocks dropped
+    float getRingHighWater() const noexcept { return ringHighWater.load(); } // Worst fill, 0..1
+    juce::File getFile() const { return currentFile; }
+    bool wasInterrupted() const noexcept { return interrupted.load(); } // Stopped by prepare(), until the next start()
+
+    static juce::String getFileExtension(Format format) { return format == flac ? ".flac" : ".wav"; }
+
+    // Audio thread: wait-free, never blocks on the writer
+    void pushBlock(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    static constexpr double ringSeconds = 10.0;
+
+//==============================================================================
+private:
+    std::atomic<bool> recording{false};
+    std::atomic<juce::int64> samplesPushed{0};
+    std::atomic<juce::int64> overruns{0};
+    std::atomic<float> ringHighWater{0.0f};
+    std::atomic<bool> interrupted{false};
+    double sampleRate{44100.0};
+
+    juce::AudioBuffer<float> ring;
+    std::unique_ptr<juce::AbstractFifo> fifo;
+    std::unique_ptr<juce::AudioFormatWriter> writer; // Only touched by the writer thread while recording
+    juce::File currentFile;
+
+    void run() override;
+    void drain();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SessionRecorder)
+};
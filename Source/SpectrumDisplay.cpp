@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SpectrumDisplay class for a JUCE application,
+    turning the decimated meter stream into smoothed log-spaced spectrum bands.
+
+  ==============================================================================
+*/
+
+#include "SpectrumDisplay.h"
+
+SpectrumDisplay::SpectrumDisplay(MeterSource& sourceToUse)
+    : source(sourceToUse)
+{
+    setOpaque(true);
+    startTimerHz(60);
+}
+
+SpectrumDisplay::~SpectrumDisplay()
+{
+    stopTimer();
+}
+
+// Draw the bands as bars over a dark background
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black.brighter(0.1f));
+
+    auto bounds = getLocalBounds().toFloat().reduced(2.0f);
+    auto barWidth = bounds.getWidth() / numBands;
+
+    juce::ColourGradient barGradient(juce::Colours::orange, 0, bounds.getY(),
+                                     juce::Colours::cyan.darker(0.2f), 0, bounds.getBottom(), false);
+    g.setGradientFill(barGradient);
+
+    for (int b = 0; b < numBands; ++b)
+    {
+        auto barHeight = bounds.getHeight() * bands[static_cast<size_t>(b)];
+        g.fillRect(bounds.getX() + b * barWidth, bounds.getBottom() - barHeight,
+                   juce::jmax(1.0f, barWidth - 1.0f), barHeight);
+    }
+
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.drawRect(getLocalBounds(), 1);
+}
+
+// Drain the meter FIFO, then transform the latest fftSize samples into bands
+void SpectrumDisplay::timerCallback()
+{
+    int numRead;
+    while ((numRead = source.readSamples(incoming.data(), static_cast<int>(incoming.size()))) > 0)
+    {
+        appendSamples(incoming.data(), numRead);
+    }
+
+    if (!isShowing())
+    {
+        return; // Keep the FIFO drained but skip the FFT while hidden
+    }
+
+    auto sampleRate = source.getDecimatedSampleRate();
+    if (sampleRate != bandRate)
+    {
+        updateBandEdges(sampleRate);
+    }
+
+    std::copy(history.begin(), history.end(), fftData.begin());
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+    window.multiplyWithWindowingTable(fftData.data(), static_cast<size_t>(fftSize));
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    const float normalisation = 4.0f / fftSize; // Hann window has a coherent gain of 0.5
+    for (int b = 0; b < numBands; ++b)
+    {
+        auto first = bandEdges[static_cast<size_t>(b)];
+        auto last = juce::jmax(first + 1, bandEdges[static_cast<size_t>(b + 1)]);
+        auto magnitude = juce::FloatVectorOperations::findMaximum(fftData.data() + first, last - first) * normalisation;
+
+        auto db = juce::Decibels::gainToDecibels(magnitude, -90.0f);
+        auto target = juce::jmap(juce::jlimit(-90.0f, 0.0f, db), -90.0f, 0.0f, 0.0f, 1.0f);
+        auto& band = bands[static_cast<size_t>(b)];
+        band = juce::jmax(target, band * 0.85f);
+    }
+
+    repaint();
+}
+
+// Slide the history window along by the newly arrived samples
+void SpectrumDisplay::appendSamples(const float* samples, int numSamples)
+{
+    if (numSamples >= fftSize)
+    {
+        std::copy_n(samples + numSamples - fftSize, fftSize, history.begin());
+        return;
+    }
+
+    std::copy(history.begin() + numSamples, history.end(), history.begin());
+    std::copy_n(samples, numSamples, history.end() - numSamples);
+}
+
+// Log-spaced band edges from 30 Hz up to Nyquist, in FFT bins
+void SpectrumDisplay::updateBandEdges(double sampleRate)
+{
+    bandRate = sampleRate;
+    auto lowest = 30.0;
+    auto highest = sampleRate * 0.5;
+
+    for (int b = 0; b <= numBands; ++b)
+    {
+        auto frequency = lowest * std::pow(highest / lowest, static_cast<double>(b) / numBands);
+        bandEdges[static_cast<size_t>(b)] = juce::jlimit(1, fftSize / 2, static_cast<int>(frequency / sampleRate * fftSize));
+    }
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    This file defines the SpectrumDisplay class for a JUCE application,
+    rendering a log-frequency spectrum of the samples streamed by a MeterSource.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MeterSource.h"
+
+// SpectrumDisplay: GUI-side FFT analyser with all working memory preallocated
+class SpectrumDisplay : public juce::Component,
+                        private juce::Timer
+{
+//==============================================================================
+public:
+    SpectrumDisplay(MeterSource& sourceToUse);
+    ~SpectrumDisplay() override;
+
+    void paint(juce::Graphics&) override;
+
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBands = 48;
+
+//==============================================================================
+private:
+    MeterSource& source;
+    juce::dsp::FFT fft{fftOrder};
+    juce::dsp::WindowingFunction<float> window{static_cast<size_t>(fftSize),
+                                               juce::dsp::WindowingFunction<float>::hann};
+
+    std::array<float, fftSize> history{};
+    std::array<float, fftSize * 2> fftData{};
+    std::array<float, 2048> incoming{};
+    std::array<float, numBands> bands{};
+    std::array<int, numBands + 1> bandEdges{};
+    double bandRate{0.0};
+
+    void timerCallback() override; // Drain the FIFO and run one FFT per frame
+    void appendSamples(const float* samples, int numSamples);
+    void updateBandEdges(double sampleRate);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the StartupTrace class for a JUCE application,
+    collecting startup milestones and formatting them as a phase report.
+
+  ==============================================================================
+*/
+
+#include "StartupTrace.h"
+#include <iostream>
+
+namespace
+{
+    struct Milestone
+    {
+        juce::String name;
+        double milliseconds = 0.0;
+    };
+
+    juce::CriticalSection traceLock;
+    std::vector<Milestone> milestones;
+    double startMs = 0.0;
+    bool echo = false;
+    bool finished = false;
+}
+
+void StartupTrace::begin(bool echoToStdout)
+{
+    const juce::ScopedLock sl(traceLock);
+    startMs = juce::Time::getMillisecondCounterHiRes();
+    echo = echoToStdout;
+    milestones.clear();
+    milestones.push_back({ "initialise", 0.0 });
+}
+
+void StartupTrace::mark(const juce::String& milestone)
+{
+    const juce::ScopedLock sl(traceLock);
+    milestones.push_back({ milestone, juce::Time::getMillisecondCounterHiRes() - startMs });
+}
+
+void StartupTrace::finish()
+{
+    {
+        const juce::ScopedLock sl(traceLock);
+        if (finished)
+        {
+            return;
+        }
+        finished = true;
+    }
+
+    auto report = getReport();
+    DBG(report);
+    if (echo)
+    {
+        std::cout << report << std::flush;
+    }
+}
+
+juce::String StartupTrace::getReport()
+{
+    const juce::ScopedLock sl(traceLock);
+    juce::String report("Startup trace\n");
+    double previous = 0.0;
+
+    for (const auto& milestone : milestones)
+    {
+        report << juce::String::formatted("  %8.1f ms  (+%7.1f)  ", milestone.milliseconds, milestone.milliseconds - previous)
+               << milestone.name << "\n";
+        previous = milestone.milliseconds;
+    }
+    return report;
+}
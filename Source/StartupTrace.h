@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    This file defines the StartupTrace class for a JUCE application,
+    timing each phase of a cold start.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// StartupTrace: Milestones stamped from any thread, relative to app initialisation.
+// The report lists each one with its offset and the time since the previous milestone.
+// Run with --startup-trace to print it to stdout once startup has finished.
+class StartupTrace
+{
+//==============================================================================
+public:
+    static void begin(bool echoToStdout);           // Called first thing in initialise()
+    static void mark(const juce::String& milestone); // Thread-safe
+    static void finish();                            // Report, once, when the last phase lands
+    static juce::String getReport();
+
+//==============================================================================
+private:
+    StartupTrace() = delete;
+};
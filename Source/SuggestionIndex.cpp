@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SuggestionIndex class for a JUCE application,
+    scoring the tracks in compatible key and tempo buckets against the playing track.
+
+  ==============================================================================
+*/
+
+#include "SuggestionIndex.h"
+
+namespace
+{
+    // Key matters most for a clean blend, then tempo, then a similar level
+    constexpr float keyWeight = 0.45f;
+    constexpr float tempoWeight = 0.35f;
+    constexpr float energyWeight = 0.2f;
+    constexpr float loudnessRangeDb = 10.0f; // Further apart than this scores no energy match
+    constexpr float halfTimePenalty = 0.7f;  // Half or double tempo mixes, but less smoothly
+}
+
+SuggestionIndex::SuggestionIndex()
+{
+    clear();
+}
+
+void SuggestionIndex::clear()
+{
+    buckets.assign(static_cast<size_t>((numKeys + 1) * (maxBpm + 1)), {});
+    numTracks = 0;
+}
+
+size_t SuggestionIndex::bucketFor(int key, int bpm)
+{
+    return static_cast<size_t>((juce::jlimit(-1, numKeys - 1, key) + 1) * (maxBpm + 1) + juce::jlimit(0, maxBpm, bpm));
+}
+
+void SuggestionIndex::add(int track, const Features& features)
+{
+    buckets[bucketFor(features.key, juce::roundToInt(features.bpm))].push_back({ track, features });
+    ++numTracks;
+}
+
+std::vector<int> SuggestionIndex::compatibleKeys(int key)
+{
+    if (key < 0 || key >= numKeys)
+    {
+        return {};
+    }
+
+    auto number = key % 12;
+    auto mode = key - number;
+    return { key, mode + (number + 11) % 12, mode + (number + 1) % 12, (key + 12) % numKeys };
+}
+
+float SuggestionIndex::keyScore(int playingKey, int candidateKey)
+{
+    if (playingKey < 0 || candidateKey < 0)
+    {
+        return 0.4f; // Unknown: no clash we know of, no match either
+    }
+    if (playingKey == candidateKey)
+    {
+        return 1.0f;
+    }
+    return playingKey % 12 == candidateKey % 12 ? 0.8f : 0.85f; // Relative key, or a step round the wheel
+}
+
+std::vector<SuggestionIndex::Suggestion> SuggestionIndex::suggest(const Features& playing, int excludeTrack, int maxResults) const
+{
+    std::vector<Suggestion> result;
+    if (maxResults <= 0 || (playing.key < 0 && playing.bpm <= 0.0f))
+    {
+        return result; // Nothing to match on
+    }
+
+    // Unknown key: every key, and tracks without one, are equally fair
+    std::vector<int> keys;
+    if (playing.key >= 0)
+    {
+        keys = compatibleKeys(playing.key);
+    }
+    else
+    {
+        for (int key = -1; key < numKeys; ++key)
+        {
+            keys.push_back(key);
+        }
+    }
+
+    auto score = [&playing](const Features& candidate, float tempoScore)
+    {
+        auto energyScore = 0.5f;
+        if (playing.loudnessDb > -90.0f && candidate.loudnessDb > -90.0f)
+        {
+            energyScore = 1.0f - juce::jmin(1.0f, std::abs(candidate.loudnessDb - playing.loudnessDb) / loudnessRangeDb);
+        }
+        return keyWeight * keyScore(playing.key, candidate.key) + tempoWeight * tempoScore + energyWeight * energyScore;
+    };
+
+    for (auto key : keys)
+    {
+        if (playing.bpm <= 0.0f)
+        {
+            for (int bpm = 0; bpm <= maxBpm; ++bpm)
+            {
+                for (const auto& entry : buckets[bucketFor(key, bpm)])
+                {
+                    if (entry.track != excludeTrack)
+                    {
+                        result.push_back({ entry.track, score(entry.features, 0.5f) });
+                    }
+                }
+            }
+            continue;
+        }
+
+        for (auto ratio : { 1.0f, 0.5f, 2.0f })
+        {
+            auto target = playing.bpm * ratio;
+            auto first = juce::jmax(1, static_cast<int>(std::floor(target * (1.0f - bpmTolerance))));
+            auto last = juce::jmin(maxBpm, static_cast<int>(std::ceil(target * (1.0f + bpmTolerance))));
+
+            for (int bpm = first; bpm <= last; ++bpm)
+            {
+                for (const auto& entry : buckets[bucketFor(key, bpm)])
+                {
+                    auto distance = std::abs(entry.features.bpm / target - 1.0f);
+                    if (entry.track == excludeTrack || distance > bpmTolerance)
+                    {
+                        continue;
+                    }
+
+                    auto tempoScore = (1.0f - distance / bpmTolerance) * (ratio == 1.0f ? 1.0f : halfTimePenalty);
+                    result.push_back({ entry.track, score(entry.features, tempoScore) });
+                }
+            }
+        }
+    }
+
+    auto numResults = juce::jmin(result.size(), static_cast<size_t>(maxResults));
+    std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(numResults), result.end(),
+                      [](const Suggestion& a, const Suggestion& b)
+                      {
+                          return a.score != b.score ? a.score > b.score : a.track < b.track;
+                      });
+    result.resize(numResults);
+    return result;
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    This file defines the SuggestionIndex class for a JUCE application,
+    bucketing analysed tracks by key and tempo to suggest what to mix in next.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// SuggestionIndex: Analysed tracks filed by Camelot key and whole BPM. A suggestion only
+// visits the buckets of the harmonically compatible keys (the same key, one step either
+// way round the wheel, and the relative major or minor) within the tempo tolerance, and at
+// half and double tempo, so it costs the same for 1k or 100k tracks. Each candidate is
+// scored on its key relation, tempo distance and loudness difference, best first.
+class SuggestionIndex
+{
+//==============================================================================
+public:
+    struct Features
+    {
+        float bpm = 0.0f;          // 0 if no beat grid was found
+        int key = -1;              // 0..11 for 1A..12A, 12..23 for 1B..12B, -1 if unknown
+        float loudnessDb = -100.0f;
+    };
+
+    struct Suggestion
+    {
+        int track = 0;
+        float score = 0.0f; // 0..1
+    };
+
+    SuggestionIndex();
+
+    void clear();
+    void add(int track, const Features& features); // Once per track
+    int getNumTracks() const noexcept { return numTracks; }
+
+    std::vector<Suggestion> suggest(const Features& playing, int excludeTrack, int maxResults) const;
+
+    static std::vector<int> compatibleKeys(int key); // The key first, then its neighbours
+
+    static constexpr int numKeys = 24;
+    static constexpr int maxBpm = 300;
+    static constexpr float bpmTolerance = 0.06f; // The usual pitch fader range
+
+//==============================================================================
+private:
+    struct Entry
+    {
+        int track;
+        Features features;
+    };
+
+    std::vector<std::vector<Entry>> buckets; // By key (unknown first), then whole BPM
+    int numTracks = 0;
+
+    static size_t bucketFor(int key, int bpm);
+    static float keyScore(int playingKey, int candidateKey);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SuggestionIndex)
+};
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the SuggestionsPanel class for a JUCE application,
+    following the deck on air and showing the suggestion index's picks for it.
+
+  ==============================================================================
+*/
+
+#include "SuggestionsPanel.h"
+#include "DeckGUI.h"
+#include "Mixer.h"
+#include "MusicLibrary.h"
+
+SuggestionsPanel::SuggestionsPanel(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToFollow,
+                                   MusicLibrary& libraryToSearch, AnalysisCache& cacheToShow, Automix& automixToQueue)
+    : decks{ &deckA, &deckB }, mixer(mixerToFollow), library(libraryToSearch),
+      analysisCache(cacheToShow), automix(automixToQueue)
+{
+    addAndMakeVisible(list);
+    addAndMakeVisible(titleLabel);
+    addAndMakeVisible(loadButton);
+    addAndMakeVisible(queueButton);
+
+    list.setModel(this);
+    list.setRowHeight(20);
+
+    titleLabel.setFont(juce::FontOptions(12.0f));
+    titleLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    titleLabel.setText("Suggestions: load a track", juce::dontSendNotification);
+
+    loadButton.onClick = [this] { loadSelected(); };
+    queueButton.onClick = [this]
+    {
+        auto row = list.getSelectedRow();
+        if (row >= 0 && row < suggestions.size())
+        {
+            automix.addTrack(suggestions[row]);
+        }
+    };
+
+    startTimer(500);
+}
+
+SuggestionsPanel::~SuggestionsPanel()
+{
+    stopTimer();
+}
+
+void SuggestionsPanel::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::black.withAlpha(0.25f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+}
+
+// Header row with the title and buttons, then the list
+void SuggestionsPanel::resized()
+{
+    auto area = getLocalBounds().reduced(4);
+    auto header = area.removeFromTop(22);
+    queueButton.setBounds(header.removeFromRight(60));
+    loadButton.setBounds(header.removeFromRight(64).withTrimmedRight(4));
+    titleLabel.setBounds(header);
+    list.setBounds(area.withTrimmedTop(4));
+}
+
+int SuggestionsPanel::getNumRows()
+{
+    return suggestions.size();
+}
+
+// Name on the left; key, tempo and level on the right, from the analysis cache
+void SuggestionsPanel::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+    if (rowNumber >= suggestions.size())
+    {
+        return;
+    }
+
+    const auto& track = suggestions.getReference(rowNumber);
+    g.fillAll(rowIsSelected ? juce::Colours::lightblue : (rowNumber % 2 == 0 ? juce::Colours::white : juce::Colours::lightgrey.brighter(0.5f)));
+
+    g.setColour(juce::Colours::black);
+    g.setFont(juce::FontOptions(13.0f));
+    g.drawText(track.getFileNameWithoutExtension(), 6, 0, width - 140, height, juce::Justification::centredLeft);
+
+    TrackAnalysis analysis;
+    if (analysisCache.lookup(track, analysis))
+    {
+        auto info = analysis.key.paddedRight(' ', 4)
+                    + (analysis.grid.isValid() ? juce::String(analysis.grid.bpm, 1) + " BPM  " : juce::String())
+                    + juce::String(juce::roundToInt(analysis.loudnessDb)) + " dB";
+        g.setColour(juce::Colours::darkgrey);
+        g.setFont(juce::FontOptions(11.0f));
+        g.drawText(info, width - 135, 0, 130, height, juce::Justification::centredRight);
+    }
+}
+
+void SuggestionsPanel::listBoxItemDoubleClicked(int row, const juce::MouseEvent&)
+{
+    list.selectRow(row);
+    loadSelected();
+}
+
+// Into the deck that is not on air, and never into one that is playing
+void SuggestionsPanel::loadSelected()
+{
+    auto row = list.getSelectedRow();
+    if (row < 0 || row >= suggestions.size())
+    {
+        return;
+    }
+
+    auto* target = onAir == decks[0] ? decks[1] : decks[0];
+    if (!target->isPlaying())
+    {
+        target->loadFile(suggestions[row]);
+    }
+}
+
+// Both playing: the one the crossfader favours. Neither: the last one on air, or whichever has a track.
+DeckGUI* SuggestionsPanel::findDeckOnAir()
+{
+    auto playingA = decks[0]->isPlaying();
+    auto playingB = decks[1]->isPlaying();
+    if (playingA && playingB)
+    {
+        return mixer.getCrossfader() <= 0.5f ? decks[0] : decks[1];
+    }
+    if (playingA || playingB)
+    {
+        return playingA ? decks[0] : decks[1];
+    }
+    if (onAir != nullptr && onAir->getLoadedFile() != juce::File())
+    {
+        return onAir;
+    }
+    return decks[0]->getLoadedFile() != juce::File() ? decks[0] : decks[1];
+}
+
+void SuggestionsPanel::timerCallback()
+{
+    onAir = findDeckOnAir();
+    auto file = onAir->getLoadedFile();
+    auto generation = analysisCache.getGeneration();
+    if (file != shownFor || generation != shownGeneration)
+    {
+        shownFor = file;
+        shownGeneration = generation;
+        refresh();
+    }
+}
+
+// Both decks' tracks are left out: one is playing, the other is probably the next mix already
+void SuggestionsPanel::refresh()
+{
+    auto selected = list.getSelectedRow() >= 0 ? suggestions[list.getSelectedRow()] : juce::File();
+    suggestions.clearQuick();
+
+    for (const auto& track : library.suggestNextTracks(shownFor, maxSuggestions + 2))
+    {
+        if (track != decks[0]->getLoadedFile() && track != decks[1]->getLoadedFile() && suggestions.size() < maxSuggestions)
+        {
+            suggestions.add(track);
+        }
+    }
+
+    if (shownFor == juce::File())
+    {
+        titleLabel.setText("Suggestions: load a track", juce::dontSendNotification);
+    }
+    else if (suggestions.isEmpty())
+    {
+        TrackAnalysis analysis;
+        titleLabel.setText((analysisCache.lookup(shownFor, analysis) ? "Nothing in the library fits " : "Analysing ")
+                           + shownFor.getFileNameWithoutExtension(), juce::dontSendNotification);
+    }
+    else
+    {
+        titleLabel.setText("After " + shownFor.getFileNameWithoutExtension(), juce::dontSendNotification);
+    }
+
+    list.updateContent();
+    list.repaint();
+    auto row = suggestions.indexOf(selected);
+    if (row >= 0)
+    {
+        list.selectRow(row, true); // Keep the selection if it is still suggested
+    }
+    else
+    {
+        list.deselectAllRows();
+    }
+}
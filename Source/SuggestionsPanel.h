@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    This file defines the SuggestionsPanel class for a JUCE application,
+    listing library tracks that mix well after the track on air.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Automix.h"
+
+class MusicLibrary;
+
+// SuggestionsPanel: Follows the deck on air (the playing one, or the one the crossfader
+// favours when both play) and lists the library's best next tracks by key, tempo and
+// loudness. It refreshes when that deck loads a track or new analyses arrive, and can load
+// a suggestion into the other deck or queue it for automix.
+class SuggestionsPanel : public juce::Component,
+                         public juce::ListBoxModel,
+                         private juce::Timer
+{
+//==============================================================================
+public:
+    SuggestionsPanel(DeckGUI& deckA, DeckGUI& deckB, Mixer& mixerToFollow,
+                     MusicLibrary& libraryToSearch, AnalysisCache& cacheToShow, Automix& automixToQueue);
+    ~SuggestionsPanel() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void listBoxItemDoubleClicked(int row, const juce::MouseEvent&) override; // Load into the other deck
+
+    static constexpr int maxSuggestions = 50;
+
+//==============================================================================
+private:
+    DeckGUI* decks[2];
+    Mixer& mixer;
+    MusicLibrary& library;
+    AnalysisCache& analysisCache;
+    Automix& automix;
+
+    juce::ListBox list;
+    juce::Label titleLabel;
+    juce::TextButton loadButton{"Load"};
+    juce::TextButton queueButton{"Queue"};
+
+    juce::Array<juce::File> suggestions;
+    DeckGUI* onAir = nullptr;
+    juce::File shownFor;
+    int shownGeneration = -1;
+
+    void timerCallback() override; // Polls the decks; a refresh only happens when something changed
+    void refresh();
+    void loadSelected();
+    DeckGUI* findDeckOnAir();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SuggestionsPanel)
+};
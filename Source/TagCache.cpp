@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the TagCache class for a JUCE application,
+    serving interned tag data to the GUI and reading missing tags on a background thread.
+
+  ==============================================================================
+*/
+
+#include "TagCache.h"
+
+TagCache::TagCache()
+    : juce::Thread("Tag reader")
+{
+    strings.add({}); // Id 0 is the empty string
+    stringIds[juce::String()] = 0;
+    startThread(juce::Thread::Priority::low);
+}
+
+TagCache::~TagCache()
+{
+    stopThread(2000);
+    cancelPendingUpdate();
+    setMemoryBudget(nullptr);
+}
+
+void TagCache::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::tagData);
+        size_t held;
+        {
+            const juce::ScopedLock sl(lock);
+            held = approxBytes;
+        }
+        memoryBudget->charge(this, held); // Outside the lock: charging may evict other caches
+    }
+}
+
+// Copy out the tags for a file if they have been read
+bool TagCache::lookup(const juce::File& file, TrackTags& result) const
+{
+    auto found = peek(file, result);
+    if (memoryBudget != nullptr)
+    {
+        if (found)
+        {
+            memoryBudget->recordHit(MemoryBudget::tagData);
+        }
+        else
+        {
+            memoryBudget->recordMiss(MemoryBudget::tagData);
+        }
+    }
+    return found;
+}
+
+// The search index copies tags as they arrive and again after a rebuild; neither is a row being shown
+bool TagCache::peek(const juce::File& file, TrackTags& result) const
+{
+    const juce::ScopedLock sl(lock);
+    auto it = entries.find(keyFor(file));
+    if (it == entries.end() || !it->second.ready)
+    {
+        return false;
+    }
+
+    const auto& entry = it->second;
+    result.title = strings[static_cast<int>(entry.title)];
+    result.artist = strings[static_cast<int>(entry.artist)];
+    result.album = strings[static_cast<int>(entry.album)];
+    result.key = strings[static_cast<int>(entry.key)];
+    result.bpm = entry.bpmTenths / 10.0f;
+    return true;
+}
+
+// Queue a file for the background reader; the newest request is served first
+void TagCache::request(const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        auto key = keyFor(file);
+        if (entries.find(key) != entries.end())
+        {
+            return;
+        }
+
+        entries.emplace(key, Entry());
+        pending.push_back(file);
+
+        if (pending.size() > maxPendingRequests)
+        {
+            entries.erase(keyFor(pending.front())); // Forget it so it can be requested again later
+            pending.pop_front();
+        }
+    }
+
+    notify();
+}
+
+int TagCache::getNumEntries() const
+{
+    const juce::ScopedLock sl(lock);
+    return static_cast<int>(entries.size());
+}
+
+// Background reader: file I/O happens here and never under the lock
+void TagCache::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::File next;
+        {
+            const juce::ScopedLock sl(lock);
+            if (!pending.empty())
+            {
+                next = pending.back();
+                pending.pop_back();
+            }
+        }
+
+        if (next == juce::File())
+        {
+            wait(-1);
+            continue;
+        }
+
+        auto tags = TagReader::read(next);
+
+        // Reserve for the worst case (every string new) before taking the lock, then return the rest
+        size_t reserved = entryBytes;
+        for (const auto* text : { &tags.title, &tags.artist, &tags.album, &tags.key })
+        {
+            reserved += stringBytes(*text);
+        }
+        auto granted = memoryBudget == nullptr || memoryBudget->reserve(this, reserved);
+        size_t used = 0;
+
+        {
+            const juce::ScopedLock sl(lock);
+            auto it = entries.find(keyFor(next));
+            if (it != entries.end())
+            {
+                auto& entry = it->second;
+                if (granted) // Otherwise the row keeps showing the file name
+                {
+                    auto numStrings = strings.size();
+                    entry.title = intern(tags.title);
+                    entry.artist = intern(tags.artist);
+                    entry.album = intern(tags.album);
+                    entry.key = intern(tags.key);
+                    entry.bpmTenths = static_cast<juce::uint16>(juce::jlimit(0, 65535, juce::roundToInt(tags.bpm * 10.0f)));
+
+                    used = entryBytes;
+                    for (int i = numStrings; i < strings.size(); ++i)
+                    {
+                        used += stringBytes(strings[i]);
+                    }
+                    approxBytes += used;
+                    arrived.add(next);
+                }
+                entry.ready = true;
+            }
+        }
+
+        if (granted && memoryBudget != nullptr)
+        {
+            memoryBudget->release(this, reserved - used);
+        }
+
+        triggerAsyncUpdate(); // Coalesces into one repaint per message loop iteration
+    }
+}
+
+void TagCache::handleAsyncUpdate()
+{
+    juce::Array<juce::File> files;
+    {
+        const juce::ScopedLock sl(lock);
+        files.swapWith(arrived);
+    }
+
+    if (onTagsArrived)
+    {
+        onTagsArrived(files);
+    }
+}
+
+// Drop the whole table: tags are cheap to read again, and only visible rows ask for them
+size_t TagCache::evict(size_t)
+{
+    size_t freed = 0;
+    {
+        const juce::ScopedLock sl(lock);
+        entries.clear();
+        pending.clear();
+        arrived.clearQuick();
+        strings.clearQuick();
+        strings.add({});
+        stringIds.clear();
+        stringIds[juce::String()] = 0;
+        freed = approxBytes;
+        approxBytes = 0;
+    }
+
+    memoryBudget->release(this, freed);
+    triggerAsyncUpdate(); // Repainted rows request their tags again
+    return freed;
+}
+
+juce::uint32 TagCache::intern(const juce::String& text)
+{
+    auto it = stringIds.find(text);
+    if (it != stringIds.end())
+    {
+        return it->second;
+    }
+
+    auto id = static_cast<juce::uint32>(strings.size());
+    strings.add(text);
+    stringIds.emplace(text, id);
+    return id;
+}
+
+juce::int64 TagCache::keyFor(const juce::File& file)
+{
+    return file.getFullPathName().hashCode64();
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    This file defines the TagCache class for a JUCE application,
+    lazily reading track tags in the background for the rows the library shows.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TagReader.h"
+#include "MemoryBudget.h"
+
+// TagCache: Compact, string-interned tag table filled on demand by a background reader.
+// Only files that have been requested are ever opened, newest request first. Under memory
+// pressure the whole table is dropped; visible rows simply request their tags again.
+class TagCache : private juce::Thread,
+                 private juce::AsyncUpdater,
+                 private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    TagCache();
+    ~TagCache() override;
+
+    bool lookup(const juce::File& file, TrackTags& result) const; // False until the tags have been read
+    bool peek(const juce::File& file, TrackTags& result) const;   // As lookup, but not counted as a hit or miss
+    void request(const juce::File& file);                          // Queue a file if it isn't known yet
+    int getNumEntries() const;
+    void setMemoryBudget(MemoryBudget* budgetToUse);
+
+    // Called on the message thread after new tags are stored, with the files read since the last call
+    std::function<void(const juce::Array<juce::File>& files)> onTagsArrived;
+
+//==============================================================================
+private:
+    // Entry: Interned string ids instead of strings, so repeated artists/albums cost 4 bytes
+    struct Entry
+    {
+        juce::uint32 title = 0;
+        juce::uint32 artist = 0;
+        juce::uint32 album = 0;
+        juce::uint32 key = 0;
+        juce::uint16 bpmTenths = 0;
+        bool ready = false;
+    };
+
+    static constexpr size_t maxPendingRequests = 256; // Older requests have scrolled out of view
+
+    juce::CriticalSection lock;
+    std::unordered_map<juce::int64, Entry> entries;
+    juce::StringArray strings;
+    std::unordered_map<juce::String, juce::uint32> stringIds;
+    std::deque<juce::File> pending;
+    juce::Array<juce::File> arrived; // Read but not yet passed to onTagsArrived
+    MemoryBudget* memoryBudget = nullptr;
+    size_t approxBytes = 0; // Entries plus interned strings, as charged to the budget
+
+    void run() override;
+    void handleAsyncUpdate() override;
+    size_t evict(size_t bytesWanted) override;
+
+    juce::uint32 intern(const juce::String& text); // Call with the lock held
+    static size_t stringBytes(const juce::String& text) { return text.getNumBytesAsUTF8() + 48; } // With map and array overhead
+    static constexpr size_t entryBytes = sizeof(Entry) + 32;
+    static juce::int64 keyFor(const juce::File& file);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TagCache)
+};
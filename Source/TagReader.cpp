@@ -0,0 +1,408 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the TagReader class for a JUCE application,
+    parsing the small set of tag formats found in DJ libraries without decoding audio.
+
+  ==============================================================================
+*/
+
+#include "TagReader.h"
+
+namespace
+{
+    constexpr int maxFieldBytes = 4096;       // Text frames larger than this are skipped (e.g. lyrics)
+    constexpr int maxCommentBlockBytes = 1 << 20;
+    constexpr int oggProbeBytes = 1 << 16;
+
+    juce::uint32 readSyncsafe(const juce::uint8* bytes)
+    {
+        return (juce::uint32(bytes[0] & 0x7f) << 21) | (juce::uint32(bytes[1] & 0x7f) << 14)
+             | (juce::uint32(bytes[2] & 0x7f) << 7) | juce::uint32(bytes[3] & 0x7f);
+    }
+
+    juce::uint32 readBigEndian(const juce::uint8* bytes, int numBytes)
+    {
+        juce::uint32 value = 0;
+        for (int i = 0; i < numBytes; ++i)
+            value = (value << 8) | bytes[i];
+        return value;
+    }
+
+    juce::uint32 readLittleEndian(const juce::uint8* bytes)
+    {
+        return juce::uint32(bytes[0]) | (juce::uint32(bytes[1]) << 8)
+             | (juce::uint32(bytes[2]) << 16) | (juce::uint32(bytes[3]) << 24);
+    }
+
+    juce::String latin1ToString(const juce::uint8* data, size_t size)
+    {
+        juce::String result;
+        for (size_t i = 0; i < size && data[i] != 0; ++i)
+            result += juce::String::charToString(static_cast<juce::juce_wchar>(data[i]));
+        return result.trim();
+    }
+
+    // Maps ID3v2.2 and v2.3/2.4 frame IDs onto the common field names
+    juce::String fieldForFrame(const juce::String& frameId)
+    {
+        if (frameId == "TIT2" || frameId == "TT2") return "TITLE";
+        if (frameId == "TPE1" || frameId == "TP1") return "ARTIST";
+        if (frameId == "TALB" || frameId == "TAL") return "ALBUM";
+        if (frameId == "TBPM" || frameId == "TBP") return "BPM";
+        if (frameId == "TKEY" || frameId == "TKE") return "KEY";
+        return {};
+    }
+}
+
+// Dispatch on the file's magic bytes, falling back to an ID3v1 trailer for MP3s
+TrackTags TagReader::read(const juce::File& file)
+{
+    TrackTags tags;
+    juce::FileInputStream in(file);
+    if (!in.openedOk())
+    {
+        return tags;
+    }
+
+    char magic[4] = {};
+    in.read(magic, 4);
+    in.setPosition(0);
+
+    if (std::memcmp(magic, "ID3", 3) == 0)
+        readID3v2(in, tags);
+    else if (std::memcmp(magic, "RIFF", 4) == 0)
+        readRiffInfo(in, tags);
+    else if (std::memcmp(magic, "fLaC", 4) == 0)
+        readFlac(in, tags);
+    else if (std::memcmp(magic, "OggS", 4) == 0)
+        readOgg(in, tags);
+
+    if (tags.isEmpty() && file.hasFileExtension("mp3"))
+    {
+        readID3v1(in, tags);
+    }
+
+    return tags;
+}
+
+// ID3v2.2-2.4: walk the frames, reading only the text frames we display and skipping the rest
+bool TagReader::readID3v2(juce::InputStream& in, TrackTags& tags)
+{
+    juce::uint8 header[10];
+    if (in.read(header, 10) != 10)
+    {
+        return false;
+    }
+
+    auto tagStart = in.getPosition() - 10;
+    auto version = static_cast<int>(header[3]);
+    auto tagEnd = tagStart + 10 + static_cast<juce::int64>(readSyncsafe(header + 6));
+
+    if ((header[5] & 0x40) != 0 && version >= 3)
+    {
+        juce::uint8 extended[4];
+        in.read(extended, 4);
+        auto extendedSize = version == 4 ? static_cast<juce::int64>(readSyncsafe(extended)) - 4
+                                         : static_cast<juce::int64>(readBigEndian(extended, 4));
+        in.skipNextBytes(extendedSize);
+    }
+
+    auto frameHeaderSize = version == 2 ? 6 : 10;
+    juce::HeapBlock<juce::uint8> frameData(maxFieldBytes);
+
+    while (in.getPosition() + frameHeaderSize <= tagEnd)
+    {
+        juce::uint8 frameHeader[10];
+        if (in.read(frameHeader, frameHeaderSize) != frameHeaderSize || frameHeader[0] == 0)
+        {
+            break; // Padding or truncated tag
+        }
+
+        juce::String frameId;
+        juce::int64 frameSize;
+        if (version == 2)
+        {
+            frameId = juce::String(reinterpret_cast<const char*>(frameHeader), 3);
+            frameSize = readBigEndian(frameHeader + 3, 3);
+        }
+        else
+        {
+            frameId = juce::String(reinterpret_cast<const char*>(frameHeader), 4);
+            frameSize = version == 4 ? readSyncsafe(frameHeader + 4) : readBigEndian(frameHeader + 4, 4);
+        }
+
+        if (frameSize <= 0 || in.getPosition() + frameSize > tagEnd)
+        {
+            break;
+        }
+
+        auto field = fieldForFrame(frameId);
+        if (field.isNotEmpty() && frameSize <= maxFieldBytes)
+        {
+            in.read(frameData.get(), static_cast<int>(frameSize));
+            applyField(field, decodeID3Text(frameData.get(), static_cast<size_t>(frameSize)), tags);
+        }
+        else
+        {
+            in.skipNextBytes(frameSize); // Artwork, lyrics and everything else
+        }
+    }
+
+    return !tags.isEmpty();
+}
+
+// ID3v1: fixed 128-byte trailer
+bool TagReader::readID3v1(juce::InputStream& in, TrackTags& tags)
+{
+    auto length = in.getTotalLength();
+    juce::uint8 trailer[128];
+
+    if (length < 128 || !in.setPosition(length - 128) || in.read(trailer, 128) != 128
+        || std::memcmp(trailer, "TAG", 3) != 0)
+    {
+        return false;
+    }
+
+    applyField("TITLE", latin1ToString(trailer + 3, 30), tags);
+    applyField("ARTIST", latin1ToString(trailer + 33, 30), tags);
+    applyField("ALBUM", latin1ToString(trailer + 63, 30), tags);
+    return !tags.isEmpty();
+}
+
+// WAV: LIST/INFO chunk, or an embedded "id3 " chunk
+bool TagReader::readRiffInfo(juce::InputStream& in, TrackTags& tags)
+{
+    char riffHeader[12];
+    if (in.read(riffHeader, 12) != 12 || std::memcmp(riffHeader + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    while (!in.isExhausted())
+    {
+        char chunkId[4];
+        if (in.read(chunkId, 4) != 4)
+        {
+            break;
+        }
+
+        auto chunkSize = static_cast<juce::int64>(static_cast<juce::uint32>(in.readInt()));
+        auto chunkEnd = in.getPosition() + chunkSize + (chunkSize & 1);
+
+        if (std::memcmp(chunkId, "LIST", 4) == 0 && chunkSize >= 4)
+        {
+            char listType[4];
+            in.read(listType, 4);
+
+            if (std::memcmp(listType, "INFO", 4) == 0)
+            {
+                while (in.getPosition() + 8 <= chunkEnd)
+                {
+                    char infoId[4];
+                    in.read(infoId, 4);
+                    auto infoSize = static_cast<juce::int64>(static_cast<juce::uint32>(in.readInt()));
+                    auto infoEnd = in.getPosition() + infoSize + (infoSize & 1);
+
+                    if (infoSize > 0 && infoSize <= maxFieldBytes)
+                    {
+                        juce::MemoryBlock value;
+                        in.readIntoMemoryBlock(value, static_cast<juce::ssize_t>(infoSize));
+                        auto text = latin1ToString(static_cast<const juce::uint8*>(value.getData()), value.getSize());
+
+                        if (std::memcmp(infoId, "INAM", 4) == 0)      applyField("TITLE", text, tags);
+                        else if (std::memcmp(infoId, "IART", 4) == 0) applyField("ARTIST", text, tags);
+                        else if (std::memcmp(infoId, "IPRD", 4) == 0) applyField("ALBUM", text, tags);
+                    }
+
+                    in.setPosition(infoEnd);
+                }
+            }
+        }
+        else if ((std::memcmp(chunkId, "id3 ", 4) == 0 || std::memcmp(chunkId, "ID3 ", 4) == 0)
+                 && chunkSize <= maxCommentBlockBytes)
+        {
+            juce::MemoryBlock block;
+            in.readIntoMemoryBlock(block, static_cast<juce::ssize_t>(chunkSize));
+            juce::MemoryInputStream id3(block, false);
+            readID3v2(id3, tags);
+        }
+
+        if (!tags.isEmpty() || !in.setPosition(chunkEnd))
+        {
+            break;
+        }
+    }
+
+    return !tags.isEmpty();
+}
+
+// FLAC: walk the metadata blocks up to the VORBIS_COMMENT block
+bool TagReader::readFlac(juce::InputStream& in, TrackTags& tags)
+{
+    in.skipNextBytes(4);
+
+    for (;;)
+    {
+        juce::uint8 blockHeader[4];
+        if (in.read(blockHeader, 4) != 4)
+        {
+            return false;
+        }
+
+        auto isLast = (blockHeader[0] & 0x80) != 0;
+        auto type = blockHeader[0] & 0x7f;
+        auto length = static_cast<juce::int64>(readBigEndian(blockHeader + 1, 3));
+
+        if (type == 4 && length <= maxCommentBlockBytes)
+        {
+            juce::MemoryBlock block;
+            in.readIntoMemoryBlock(block, static_cast<juce::ssize_t>(length));
+            return parseVorbisComments(static_cast<const juce::uint8*>(block.getData()), block.getSize(), tags);
+        }
+
+        if (isLast)
+        {
+            return false;
+        }
+
+        in.skipNextBytes(length);
+    }
+}
+
+// Ogg Vorbis/Opus: the comment header sits in the first pages, so probe only the start of the file
+bool TagReader::readOgg(juce::InputStream& in, TrackTags& tags)
+{
+    juce::MemoryBlock probe;
+    in.readIntoMemoryBlock(probe, oggProbeBytes);
+
+    auto* data = static_cast<const juce::uint8*>(probe.getData());
+    auto size = probe.getSize();
+
+    for (size_t i = 0; i + 8 < size; ++i)
+    {
+        if (std::memcmp(data + i, "\x03vorbis", 7) == 0)
+            return parseVorbisComments(data + i + 7, size - i - 7, tags);
+
+        if (std::memcmp(data + i, "OpusTags", 8) == 0)
+            return parseVorbisComments(data + i + 8, size - i - 8, tags);
+    }
+
+    return false;
+}
+
+// Vorbis comment list: vendor string, then count of length-prefixed "KEY=value" entries
+bool TagReader::parseVorbisComments(const juce::uint8* data, size_t size, TrackTags& tags)
+{
+    size_t pos = 0;
+    auto readLength = [&](juce::uint32& value)
+    {
+        if (pos + 4 > size) return false;
+        value = readLittleEndian(data + pos);
+        pos += 4;
+        return true;
+    };
+
+    juce::uint32 vendorLength, count;
+    if (!readLength(vendorLength) || (pos += vendorLength) > size || !readLength(count))
+    {
+        return false;
+    }
+
+    for (juce::uint32 i = 0; i < count; ++i)
+    {
+        juce::uint32 length;
+        if (!readLength(length) || pos + length > size)
+        {
+            break;
+        }
+
+        auto comment = juce::String::fromUTF8(reinterpret_cast<const char*>(data + pos), static_cast<int>(length));
+        pos += length;
+
+        auto field = comment.upToFirstOccurrenceOf("=", false, false).toUpperCase();
+        applyField(field == "INITIALKEY" ? juce::String("KEY") : field,
+                   comment.fromFirstOccurrenceOf("=", false, false), tags);
+    }
+
+    return !tags.isEmpty();
+}
+
+// ID3v2 text frames start with an encoding byte: Latin-1, UTF-16 with BOM, UTF-16BE or UTF-8
+juce::String TagReader::decodeID3Text(const juce::uint8* data, size_t size)
+{
+    if (size < 2)
+    {
+        return {};
+    }
+
+    auto encoding = data[0];
+    auto* text = data + 1;
+    auto length = size - 1;
+
+    if (encoding == 0)
+    {
+        return latin1ToString(text, length);
+    }
+
+    if (encoding == 3)
+    {
+        auto end = static_cast<size_t>(std::find(text, text + length, 0) - text);
+        return juce::String::fromUTF8(reinterpret_cast<const char*>(text), static_cast<int>(end)).trim();
+    }
+
+    auto bigEndian = encoding == 2;
+    if (encoding == 1 && length >= 2)
+    {
+        bigEndian = text[0] == 0xfe && text[1] == 0xff;
+        if ((text[0] == 0xff && text[1] == 0xfe) || bigEndian)
+        {
+            text += 2;
+            length -= 2;
+        }
+    }
+
+    juce::String result;
+    for (size_t i = 0; i + 1 < length; i += 2)
+    {
+        auto unit = bigEndian ? (juce::uint32(text[i]) << 8) | text[i + 1]
+                              : (juce::uint32(text[i + 1]) << 8) | text[i];
+        if (unit == 0)
+        {
+            break;
+        }
+
+        if (unit >= 0xd800 && unit < 0xdc00 && i + 3 < length) // Surrogate pair
+        {
+            auto low = bigEndian ? (juce::uint32(text[i + 2]) << 8) | text[i + 3]
+                                 : (juce::uint32(text[i + 3]) << 8) | text[i + 2];
+            unit = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+            i += 2;
+        }
+
+        result += juce::String::charToString(static_cast<juce::juce_wchar>(unit));
+    }
+
+    return result.trim();
+}
+
+// Keep the first non-empty value of each field
+void TagReader::applyField(const juce::String& field, const juce::String& value, TrackTags& tags)
+{
+    auto trimmed = value.trim();
+    if (trimmed.isEmpty())
+    {
+        return;
+    }
+
+    if (field == "TITLE" && tags.title.isEmpty())
+        tags.title = trimmed;
+    else if (field == "ARTIST" && tags.artist.isEmpty())
+        tags.artist = trimmed;
+    else if (field == "ALBUM" && tags.album.isEmpty())
+        tags.album = trimmed;
+    else if (field == "KEY" && tags.key.isEmpty())
+        tags.key = trimmed;
+    else if (field == "BPM" && tags.bpm <= 0.0f)
+        tags.bpm = trimmed.getFloatValue();
+}
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    This file defines the TagReader class for a JUCE application,
+    extracting track metadata from ID3, RIFF INFO and Vorbis comment tags.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// TrackTags: The metadata fields the library displays
+struct TrackTags
+{
+    juce::String title;
+    juce::String artist;
+    juce::String album;
+    juce::String key;
+    float bpm = 0.0f;
+
+    bool isEmpty() const { return title.isEmpty() && artist.isEmpty(); }
+};
+
+// TagReader: Reads only the tag headers of a file, never its audio
+class TagReader
+{
+//==============================================================================
+public:
+    static TrackTags read(const juce::File& file);
+
+//==============================================================================
+private:
+    static bool readID3v2(juce::InputStream& in, TrackTags& tags);
+    static bool readID3v1(juce::InputStream& in, TrackTags& tags);
+    static bool readRiffInfo(juce::InputStream& in, TrackTags& tags);
+    static bool readFlac(juce::InputStream& in, TrackTags& tags);
+    static bool readOgg(juce::InputStream& in, TrackTags& tags);
+    static bool parseVorbisComments(const juce::uint8* data, size_t size, TrackTags& tags);
+
+    static juce::String decodeID3Text(const juce::uint8* data, size_t size);
+    static void applyField(const juce::String& field, const juce::String& value, TrackTags& tags);
+};
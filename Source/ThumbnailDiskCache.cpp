@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the ThumbnailDiskCache class for a JUCE application,
+    storing one file per thumbnail, named by its source hash.
+
+  ==============================================================================
+*/
+
+#include "ThumbnailDiskCache.h"
+
+ThumbnailDiskCache::ThumbnailDiskCache(int maxThumbsInMemory)
+    : juce::AudioThumbnailCache(maxThumbsInMemory), maxThumbs(maxThumbsInMemory)
+{
+}
+
+ThumbnailDiskCache::~ThumbnailDiskCache()
+{
+    setMemoryBudget(nullptr);
+}
+
+void ThumbnailDiskCache::setMemoryBudget(MemoryBudget* budgetToUse)
+{
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->removeClient(this);
+        accountedBytes.store(0);
+    }
+
+    memoryBudget = budgetToUse;
+    if (memoryBudget != nullptr)
+    {
+        memoryBudget->addClient(this, MemoryBudget::waveforms);
+        updateMemoryUse();
+    }
+}
+
+void ThumbnailDiskCache::updateMemoryUse()
+{
+    if (memoryBudget == nullptr)
+    {
+        return;
+    }
+
+    size_t held;
+    {
+        const juce::ScopedLock sl(sizeLock);
+        held = heldBytes;
+    }
+
+    auto accounted = accountedBytes.load();
+    if (held > accounted)
+    {
+        if (memoryBudget->reserve(this, held - accounted))
+        {
+            accountedBytes.store(held);
+        }
+        else
+        {
+            evict(accounted); // No room for what is held: keep only what is on disk
+        }
+    }
+    else if (held < accounted)
+    {
+        memoryBudget->release(this, accounted - held);
+        accountedBytes.store(held);
+    }
+}
+
+juce::File ThumbnailDiskCache::getDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("AudioProj")
+        .getChildFile("thumbnails");
+}
+
+// Size and modification time are part of the key, so a file re-encoded or replaced at the
+// same path gets a new thumbnail instead of its predecessor's
+juce::int64 ThumbnailDiskCache::hashFor(const juce::File& file)
+{
+    auto hash = static_cast<juce::uint64>(juce::URLInputSource(juce::URL(file)).hashCode());
+    hash = hash * 1000003u ^ static_cast<juce::uint64>(file.getSize());
+    hash = hash * 1000003u ^ static_cast<juce::uint64>(file.getLastModificationTime().toMilliseconds());
+    return static_cast<juce::int64>(hash);
+}
+
+bool ThumbnailDiskCache::isCached(const juce::File& file)
+{
+    return fileFor(hashFor(file)).existsAsFile();
+}
+
+bool ThumbnailDiskCache::build(const juce::File& file, juce::AudioFormatManager& formatManager,
+                               const std::function<bool()>& shouldExit)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+    {
+        return false;
+    }
+
+    Builder builder(file, formatManager);
+    DecodePipeline::decodeNow(*reader, { &builder }, shouldExit);
+    return builder.wasWritten();
+}
+
+ThumbnailDiskCache::Builder::Builder(const juce::File& fileToBuild, juce::AudioFormatManager& formatManager)
+    : file(fileToBuild), thumb(samplesPerThumbSample, formatManager, scratch)
+{
+}
+
+juce::int64 ThumbnailDiskCache::Builder::decodeStarting(const juce::AudioFormatReader& reader)
+{
+    written = false;
+    thumb.reset(static_cast<int>(juce::jmin(2u, reader.numChannels)), reader.sampleRate, reader.lengthInSamples);
+    return reader.lengthInSamples;
+}
+
+// The block always has two channels; a mono thumbnail takes the first
+void ThumbnailDiskCache::Builder::decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples)
+{
+    thumb.addBlock(startSample, block, 0, numSamples);
+}
+
+void ThumbnailDiskCache::Builder::decodeFinished(bool complete)
+{
+    written = complete && write(thumb, hashFor(file));
+}
+
+void ThumbnailDiskCache::saveNewlyFinishedThumbnail(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode)
+{
+    write(thumb, hashCode);
+    noteHeld(static_cast<size_t>(fileFor(hashCode).getSize()));
+}
+
+// Only reached when the thumbnail is not held in memory, so a hit here is a disk hit
+bool ThumbnailDiskCache::loadNewThumb(juce::AudioThumbnailBase& thumb, juce::int64 hashCode)
+{
+    juce::FileInputStream stream(fileFor(hashCode));
+    auto loaded = stream.openedOk() && thumb.loadFrom(stream);
+
+    if (memoryBudget != nullptr)
+    {
+        if (loaded)
+        {
+            memoryBudget->recordHit(MemoryBudget::waveforms);
+        }
+        else
+        {
+            memoryBudget->recordMiss(MemoryBudget::waveforms);
+        }
+    }
+    return loaded;
+}
+
+void ThumbnailDiskCache::noteHeld(size_t bytes)
+{
+    const juce::ScopedLock sl(sizeLock);
+    heldSizes.push_back(bytes);
+    heldBytes += bytes;
+
+    // The base class recycles its oldest entry once it is full
+    while (static_cast<int>(heldSizes.size()) > maxThumbs)
+    {
+        heldBytes -= heldSizes.front();
+        heldSizes.pop_front();
+    }
+}
+
+// Drop every thumbnail held in memory; the files stay on disk to be read back
+size_t ThumbnailDiskCache::evict(size_t)
+{
+    clear();
+    {
+        const juce::ScopedLock sl(sizeLock);
+        heldSizes.clear();
+        heldBytes = 0;
+    }
+
+    auto freed = accountedBytes.exchange(0);
+    memoryBudget->release(this, freed);
+    return freed;
+}
+
+juce::File ThumbnailDiskCache::fileFor(juce::int64 hashCode)
+{
+    return getDirectory().getChildFile(juce::String::toHexString(hashCode) + ".thumb");
+}
+
+// Through a temporary file, so a reader never sees half a thumbnail
+bool ThumbnailDiskCache::write(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode)
+{
+    getDirectory().createDirectory();
+    juce::TemporaryFile temp(fileFor(hashCode));
+    {
+        juce::FileOutputStream stream(temp.getFile());
+        if (!stream.openedOk())
+        {
+            return false;
+        }
+        thumb.saveTo(stream);
+    }
+    return temp.overwriteTargetFileWithTemporary();
+}
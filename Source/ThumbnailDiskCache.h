@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    This file defines the ThumbnailDiskCache class for a JUCE application,
+    keeping finished waveform overviews on disk so tracks open with their waveform drawn.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MemoryBudget.h"
+#include "DecodePipeline.h"
+
+// ThumbnailDiskCache: An AudioThumbnailCache that writes each finished thumbnail to
+// appdata/AudioProj/thumbnails and reads it back instead of decoding the track again.
+// The batch mode fills it ahead of time with a Builder. Thumbnails held in memory count
+// against the waveform budget; under pressure they are dropped, since the disk still has them.
+class ThumbnailDiskCache : public juce::AudioThumbnailCache,
+                           private MemoryBudget::Client
+{
+//==============================================================================
+public:
+    explicit ThumbnailDiskCache(int maxThumbsInMemory);
+    ~ThumbnailDiskCache() override;
+
+    void setMemoryBudget(MemoryBudget* budgetToUse);
+    void updateMemoryUse(); // Message thread: bring the budget up to date with what is held
+
+    static juce::File getDirectory();
+    static juce::int64 hashFor(const juce::File& file); // Path, size and modification time
+    static bool isCached(const juce::File& file);
+
+    // Builder: A decode consumer that writes the track's thumbnail where the cache will look,
+    // so it can share the decode with the track's analysis
+    class Builder : public DecodePipeline::Consumer
+    {
+    public:
+        Builder(const juce::File& fileToBuild, juce::AudioFormatManager& formatManager);
+
+        juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+        void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+        void decodeFinished(bool complete) override;
+        bool wasWritten() const noexcept { return written; }
+
+    private:
+        juce::File file;
+        juce::AudioThumbnailCache scratch{1}; // The thumbnail needs a cache; the disk is the real one
+        juce::AudioThumbnail thumb;
+        bool written = false;
+    };
+
+    // Blocking: decode the whole track into a thumbnail on its own
+    static bool build(const juce::File& file, juce::AudioFormatManager& formatManager,
+                      const std::function<bool()>& shouldExit);
+
+    static constexpr int samplesPerThumbSample = 1000;
+
+//==============================================================================
+protected:
+    void saveNewlyFinishedThumbnail(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override;
+    bool loadNewThumb(juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override;
+
+//==============================================================================
+private:
+    // The base class stores thumbnails serialized, so their stream size is their footprint.
+    // Both callbacks run under the base class's lock, so they only note sizes here and
+    // updateMemoryUse() settles with the budget later.
+    juce::CriticalSection sizeLock;
+    std::deque<size_t> heldSizes; // Oldest first, at most maxThumbs
+    const int maxThumbs;
+    size_t heldBytes = 0;
+    std::atomic<size_t> accountedBytes{0}; // Evict may run on any thread that reserves
+    MemoryBudget* memoryBudget = nullptr;
+
+    static juce::File fileFor(juce::int64 hashCode);
+    static bool write(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode);
+    void noteHeld(size_t bytes);
+    size_t evict(size_t bytesWanted) override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ThumbnailDiskCache)
+};
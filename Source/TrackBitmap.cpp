@@ -0,0 +1,405 @@
+/*
+  ==============================================================================
+
+    This file contains the implementation of the TrackBitmap class for a JUCE application,
+    combining sparse and dense chunks for the library's compound filters.
+
+  ==============================================================================
+*/
+
+#include "TrackBitmap.h"
+#include "PerfCounter.h"
+
+TrackBitmap TrackBitmap::allBelow(int numTracks)
+{
+    TrackBitmap result;
+    for (int start = 0; start < numTracks; start += 65536)
+    {
+        Chunk chunk;
+        chunk.key = static_cast<juce::uint16>(start >> 16);
+        chunk.count = juce::jmin(65536, numTracks - start);
+        chunk.bits.assign(wordsPerChunk, 0);
+
+        auto fullWords = static_cast<size_t>(chunk.count / 64);
+        std::fill(chunk.bits.begin(), chunk.bits.begin() + static_cast<std::ptrdiff_t>(fullWords), ~juce::uint64());
+        if (auto rest = chunk.count % 64)
+        {
+            chunk.bits[fullWords] = (juce::uint64(1) << rest) - 1;
+        }
+
+        settle(chunk);
+        result.chunks.push_back(std::move(chunk));
+    }
+    return result;
+}
+
+TrackBitmap::Chunk* TrackBitmap::findChunk(juce::uint16 key)
+{
+    auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk& c, juce::uint16 k) { return c.key < k; });
+    return it != chunks.end() && it->key == key ? &*it : nullptr;
+}
+
+const TrackBitmap::Chunk* TrackBitmap::findChunk(juce::uint16 key) const
+{
+    auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk& c, juce::uint16 k) { return c.key < k; });
+    return it != chunks.end() && it->key == key ? &*it : nullptr;
+}
+
+void TrackBitmap::add(int track)
+{
+    jassert(track >= 0);
+    auto key = static_cast<juce::uint16>(track >> 16);
+    auto low = static_cast<juce::uint16>(track & 0xffff);
+
+    auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk& c, juce::uint16 k) { return c.key < k; });
+    if (it == chunks.end() || it->key != key)
+    {
+        it = chunks.insert(it, Chunk());
+        it->key = key;
+    }
+
+    auto& chunk = *it;
+    if (!chunk.bits.empty())
+    {
+        auto& word = chunk.bits[low >> 6];
+        auto bit = juce::uint64(1) << (low & 63);
+        if ((word & bit) == 0)
+        {
+            word |= bit;
+            ++chunk.count;
+        }
+        return;
+    }
+
+    auto pos = std::lower_bound(chunk.values.begin(), chunk.values.end(), low);
+    if (pos != chunk.values.end() && *pos == low)
+    {
+        return;
+    }
+
+    chunk.values.insert(pos, low);
+    ++chunk.count;
+    if (chunk.count > arrayLimit)
+    {
+        makeDense(chunk);
+    }
+}
+
+void TrackBitmap::remove(int track)
+{
+    auto* chunk = findChunk(static_cast<juce::uint16>(track >> 16));
+    if (track < 0 || chunk == nullptr)
+    {
+        return;
+    }
+
+    auto low = static_cast<juce::uint16>(track & 0xffff);
+    if (!chunk->bits.empty())
+    {
+        auto& word = chunk->bits[low >> 6];
+        auto bit = juce::uint64(1) << (low & 63);
+        if ((word & bit) != 0)
+        {
+            word &= ~bit;
+            --chunk->count;
+            settle(*chunk);
+        }
+    }
+    else
+    {
+        auto pos = std::lower_bound(chunk->values.begin(), chunk->values.end(), low);
+        if (pos != chunk->values.end() && *pos == low)
+        {
+            chunk->values.erase(pos);
+            --chunk->count;
+        }
+    }
+
+    if (chunk->count == 0)
+    {
+        chunks.erase(chunks.begin() + (chunk - chunks.data()));
+    }
+}
+
+bool TrackBitmap::contains(int track) const
+{
+    auto* chunk = findChunk(static_cast<juce::uint16>(track >> 16));
+    if (track < 0 || chunk == nullptr)
+    {
+        return false;
+    }
+
+    auto low = static_cast<juce::uint16>(track & 0xffff);
+    if (!chunk->bits.empty())
+    {
+        return (chunk->bits[low >> 6] & (juce::uint64(1) << (low & 63))) != 0;
+    }
+    return std::binary_search(chunk->values.begin(), chunk->values.end(), low);
+}
+
+int TrackBitmap::size() const
+{
+    int total = 0;
+    for (const auto& chunk : chunks)
+    {
+        total += chunk.count;
+    }
+    return total;
+}
+
+size_t TrackBitmap::getBytes() const
+{
+    auto bytes = chunks.capacity() * sizeof(Chunk);
+    for (const auto& chunk : chunks)
+    {
+        bytes += chunk.values.capacity() * sizeof(juce::uint16) + chunk.bits.capacity() * sizeof(juce::uint64);
+    }
+    return bytes;
+}
+
+void TrackBitmap::makeDense(Chunk& chunk)
+{
+    if (!chunk.bits.empty())
+    {
+        return;
+    }
+
+    chunk.bits.assign(wordsPerChunk, 0);
+    for (auto value : chunk.values)
+    {
+        chunk.bits[value >> 6] |= juce::uint64(1) << (value & 63);
+    }
+    chunk.values.clear();
+    chunk.values.shrink_to_fit();
+}
+
+// Recount a dense chunk and go back to an array once it is sparse enough
+void TrackBitmap::settle(Chunk& chunk)
+{
+    if (chunk.bits.empty())
+    {
+        chunk.count = static_cast<int>(chunk.values.size());
+        if (chunk.count > arrayLimit)
+        {
+            makeDense(chunk);
+        }
+        return;
+    }
+
+    chunk.count = 0;
+    for (auto word : chunk.bits)
+    {
+        chunk.count += juce::countNumberOfBits(word);
+    }
+
+    if (chunk.count <= arrayLimit)
+    {
+        std::vector<juce::uint16> values;
+        values.reserve(static_cast<size_t>(chunk.count));
+        for (size_t w = 0; w < chunk.bits.size(); ++w)
+        {
+            for (auto word = chunk.bits[w]; word != 0; word &= word - 1)
+            {
+                values.push_back(static_cast<juce::uint16>(w * 64 + static_cast<size_t>(lowestBit(word))));
+            }
+        }
+        chunk.values.swap(values);
+        chunk.bits.clear();
+        chunk.bits.shrink_to_fit();
+    }
+}
+
+TrackBitmap& TrackBitmap::operator&=(const TrackBitmap& other)
+{
+    std::vector<Chunk> result;
+    for (auto& chunk : chunks)
+    {
+        auto* match = other.findChunk(chunk.key);
+        if (match == nullptr)
+        {
+            continue;
+        }
+
+        if (chunk.bits.empty() && match->bits.empty())
+        {
+            std::vector<juce::uint16> values;
+            std::set_intersection(chunk.values.begin(), chunk.values.end(),
+                                  match->values.begin(), match->values.end(), std::back_inserter(values));
+            chunk.values.swap(values);
+        }
+        else if (chunk.bits.empty())
+        {
+            // Sparse AND dense: keep the array members whose bit is set
+            chunk.values.erase(std::remove_if(chunk.values.begin(), chunk.values.end(), [match](juce::uint16 v)
+            {
+                return (match->bits[v >> 6] & (juce::uint64(1) << (v & 63))) == 0;
+            }), chunk.values.end());
+        }
+        else if (match->bits.empty())
+        {
+            std::vector<juce::uint16> values;
+            for (auto v : match->values)
+            {
+                if ((chunk.bits[v >> 6] & (juce::uint64(1) << (v & 63))) != 0)
+                {
+                    values.push_back(v);
+                }
+            }
+            chunk.values.swap(values);
+            chunk.bits.clear();
+        }
+        else
+        {
+            for (size_t w = 0; w < wordsPerChunk; ++w)
+            {
+                chunk.bits[w] &= match->bits[w];
+            }
+        }
+
+        settle(chunk);
+        if (chunk.count > 0)
+        {
+            result.push_back(std::move(chunk));
+        }
+    }
+
+    chunks.swap(result);
+    return *this;
+}
+
+TrackBitmap& TrackBitmap::operator|=(const TrackBitmap& other)
+{
+    for (const auto& theirs : other.chunks)
+    {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), theirs.key, [](const Chunk& c, juce::uint16 k) { return c.key < k; });
+        if (it == chunks.end() || it->key != theirs.key)
+        {
+            chunks.insert(it, theirs);
+            continue;
+        }
+
+        auto& chunk = *it;
+        if (chunk.bits.empty() && theirs.bits.empty())
+        {
+            std::vector<juce::uint16> values;
+            std::set_union(chunk.values.begin(), chunk.values.end(),
+                           theirs.values.begin(), theirs.values.end(), std::back_inserter(values));
+            chunk.values.swap(values);
+        }
+        else
+        {
+            makeDense(chunk);
+            if (theirs.bits.empty())
+            {
+                for (auto v : theirs.values)
+                {
+                    chunk.bits[v >> 6] |= juce::uint64(1) << (v & 63);
+                }
+            }
+            else
+            {
+                for (size_t w = 0; w < wordsPerChunk; ++w)
+                {
+                    chunk.bits[w] |= theirs.bits[w];
+                }
+            }
+        }
+        settle(chunk);
+    }
+    return *this;
+}
+
+TrackBitmap& TrackBitmap::andNot(const TrackBitmap& other)
+{
+    std::vector<Chunk> result;
+    for (auto& chunk : chunks)
+    {
+        auto* match = other.findChunk(chunk.key);
+        if (match != nullptr)
+        {
+            if (chunk.bits.empty())
+            {
+                chunk.values.erase(std::remove_if(chunk.values.begin(), chunk.values.end(), [match](juce::uint16 v)
+                {
+                    if (match->bits.empty())
+                    {
+                        return std::binary_search(match->values.begin(), match->values.end(), v);
+                    }
+                    return (match->bits[v >> 6] & (juce::uint64(1) << (v & 63))) != 0;
+                }), chunk.values.end());
+            }
+            else if (match->bits.empty())
+            {
+                for (auto v : match->values)
+                {
+                    chunk.bits[v >> 6] &= ~(juce::uint64(1) << (v & 63));
+                }
+            }
+            else
+            {
+                for (size_t w = 0; w < wordsPerChunk; ++w)
+                {
+                    chunk.bits[w] &= ~match->bits[w];
+                }
+            }
+            settle(chunk);
+        }
+
+        if (chunk.count > 0)
+        {
+            result.push_back(std::move(chunk));
+        }
+    }
+
+    chunks.swap(result);
+    return *this;
+}
+
+std::vector<int> TrackBitmap::toVector() const
+{
+    std::vector<int> result;
+    result.reserve(static_cast<size_t>(size()));
+    forEach([&result](int track) { result.push_back(track); });
+    return result;
+}
+
+// "bpm 120-126 key 8A/9A tag:peak-time" with the bitmaps a 100k-track library would have
+juce::String TrackBitmap::runBenchmark()
+{
+    constexpr int numTracks = 100000;
+    juce::Random random(7);
+    std::vector<TrackBitmap> bpms(200), keys(24);
+    TrackBitmap peakTime;
+
+    for (int track = 0; track < numTracks; ++track)
+    {
+        bpms[static_cast<size_t>(90 + random.nextInt(60))].add(track);
+        keys[static_cast<size_t>(random.nextInt(24))].add(track);
+        if (random.nextInt(10) == 0)
+        {
+            peakTime.add(track);
+        }
+    }
+
+    PerfCounter cost;
+    int numMatches = 0;
+    for (int run = 0; run < 1000; ++run)
+    {
+        PerfCounter::ScopedTimer timer(cost);
+        TrackBitmap result;
+        for (int bpm = 120; bpm <= 126; ++bpm)
+        {
+            result |= bpms[static_cast<size_t>(bpm)];
+        }
+
+        auto key = keys[7];
+        key |= keys[8];
+        result &= key;
+        result &= peakTime;
+        numMatches = result.size();
+    }
+
+    return juce::String::formatted("%-24s %d tracks: avg %8.2f us  max %8.2f us  (%d matches)\n",
+                                   "Library compound filter", numTracks,
+                                   cost.getAverageMicros(), cost.getMaxMicros(), numMatches);
+}
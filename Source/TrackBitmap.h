@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    This file defines the TrackBitmap class for a JUCE application,
+    a compressed set of track indices for crates, tags and attribute filters.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// TrackBitmap: A set of track indices split into chunks of 65536. A chunk holds a sorted
+// array of 16-bit offsets while sparse and switches to a plain 8 KB bitset once it passes
+// 4096 members, so a small crate costs a few bytes per track and "every 124 BPM track"
+// costs at most a bit per track. AND, OR and AND NOT work chunk by chunk; bitset chunks
+// combine a 64-bit word at a time.
+class TrackBitmap
+{
+//==============================================================================
+public:
+    TrackBitmap() = default;
+
+    static TrackBitmap allBelow(int numTracks); // 0 .. numTracks - 1
+
+    void add(int track);
+    void remove(int track);
+    bool contains(int track) const;
+    void clear() { chunks.clear(); }
+
+    bool isEmpty() const noexcept { return chunks.empty(); }
+    int size() const;        // Number of members
+    size_t getBytes() const; // Heap bytes held
+
+    TrackBitmap& operator&=(const TrackBitmap& other);
+    TrackBitmap& operator|=(const TrackBitmap& other);
+    TrackBitmap& andNot(const TrackBitmap& other);
+
+    std::vector<int> toVector() const; // Ascending
+
+    static juce::String runBenchmark(); // For --benchmark: a compound filter over 100k tracks
+
+    template <typename Callback>
+    void forEach(Callback&& callback) const // Ascending; callback(int track)
+    {
+        for (const auto& chunk : chunks)
+        {
+            auto base = static_cast<int>(chunk.key) << 16;
+            if (chunk.bits.empty())
+            {
+                for (auto value : chunk.values)
+                {
+                    callback(base + value);
+                }
+                continue;
+            }
+
+            for (size_t w = 0; w < chunk.bits.size(); ++w)
+            {
+                for (auto word = chunk.bits[w]; word != 0; word &= word - 1)
+                {
+                    callback(base + static_cast<int>(w * 64) + lowestBit(word));
+                }
+            }
+        }
+    }
+
+//==============================================================================
+private:
+    // Chunk: Either values (sparse) or bits (dense) is in use
+    struct Chunk
+    {
+        juce::uint16 key = 0; // High 16 bits of the track index
+        std::vector<juce::uint16> values;
+        std::vector<juce::uint64> bits;
+        int count = 0;
+    };
+
+    static constexpr int arrayLimit = 4096; // An array this long is as big as the bitset
+    static constexpr size_t wordsPerChunk = 1024;
+
+    std::vector<Chunk> chunks; // Sorted by key
+
+    Chunk* findChunk(juce::uint16 key);
+    const Chunk* findChunk(juce::uint16 key) const;
+    static void makeDense(Chunk& chunk);
+    static void settle(Chunk& chunk); // Pick the smaller form after an operation
+    static int lowestBit(juce::uint64 word) noexcept { return juce::countNumberOfBits((word & (~word + 1)) - 1); }
+};
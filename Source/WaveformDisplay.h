@@ -1,55 +1,69 @@
-/*
-  ==============================================================================
-
-    This file defines the WaveformDisplay class for a JUCE application,
-    providing a visual representation of audio waveforms with interactive features.
-
-  ==============================================================================
-*/
-
-#pragma once
-#include <JuceHeader.h>
-
-// WaveformDisplay: Visualizes audio waveform with interactive features
-class WaveformDisplay : public juce::Component,
-                        public juce::ChangeListener,
-                        public juce::Timer
-{
-    
-//==============================================================================
-public:
-    WaveformDisplay(juce::AudioFormatManager& formatManagerToUse,
-                    juce::AudioThumbnailCache& cacheToUse);
-    ~WaveformDisplay() override;
-
-    void paint(juce::Graphics&) override;
-    void resized() override;
-    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
-    void loadURL(juce::URL audioURL);
-    void setPosition(double positionInSeconds);
-
-    // Mouse interaction for seeking
-    void mouseMove(const juce::MouseEvent& event) override;
-    void mouseDown(const juce::MouseEvent& event) override;
-    void mouseExit(const juce::MouseEvent& event) override;
-
-    std::function<void(double)> onPositionClicked; // Callback for click position
-    
-//==============================================================================
-private:
-    juce::AudioThumbnail audioThumb;
-    bool fileLoaded{false};
-    double playheadPosition{0.0};
-    float hoverPosition{-1.0f};
-
-    void timerCallback() override; // Periodic repaint
-
-    // Drawing helper methods
-    void drawBackground(juce::Graphics& g);
-    void drawWaveform(juce::Graphics& g);
-    void drawPlayhead(juce::Graphics& g);
-    void drawHoverIndicator(juce::Graphics& g);
-    void drawPlaceholderText(juce::Graphics& g);
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDisplay)
-};
+/*
+  ==============================================================================
+
+    This file defines the WaveformDisplay class for a JUCE application,
+    providing a visual representation of audio waveforms with interactive features.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DecodePipeline.h"
+
+// WaveformDisplay: Visualizes audio waveform with interactive features. A thumbnail found in
+// the cache is shown at once; otherwise it is built from the deck's decode pipeline.
+class WaveformDisplay : public juce::Component,
+                        public juce::ChangeListener,
+                        public juce::Timer,
+                        public DecodePipeline::Consumer
+{
+    
+//==============================================================================
+public:
+    WaveformDisplay(juce::AudioFormatManager& formatManagerToUse,
+                    juce::AudioThumbnailCache& cacheToUse);
+    ~WaveformDisplay() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void loadFile(const juce::File& file); // With the pipeline stopped
+    void setPosition(double positionInSeconds);
+    void setDecodeProgress(float fraction); // Share of the track in the PCM cache; -1 hides the bar
+
+    // Mouse interaction for seeking
+    void mouseMove(const juce::MouseEvent& event) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseExit(const juce::MouseEvent& event) override;
+
+    std::function<void(double)> onPositionClicked; // Callback for click position
+
+    // Pipeline thread: builds the thumbnail when the cache did not have it
+    juce::int64 decodeStarting(const juce::AudioFormatReader& reader) override;
+    void decodedBlock(const juce::AudioBuffer<float>& block, juce::int64 startSample, int numSamples) override;
+    void decodeFinished(bool complete) override;
+    
+//==============================================================================
+private:
+    juce::AudioThumbnailCache& thumbCache;
+    juce::AudioThumbnail audioThumb;
+    juce::int64 thumbHash{0};
+    bool needsBuild{false}; // Set on the GUI thread while the pipeline is stopped
+    bool fileLoaded{false};
+    double playheadPosition{0.0};
+    float hoverPosition{-1.0f};
+    float decodeProgress{-1.0f};
+
+    void timerCallback() override; // Periodic repaint
+
+    // Drawing helper methods
+    void drawBackground(juce::Graphics& g);
+    void drawWaveform(juce::Graphics& g);
+    void drawPlayhead(juce::Graphics& g);
+    void drawHoverIndicator(juce::Graphics& g);
+    void drawDecodeProgress(juce::Graphics& g);
+    void drawPlaceholderText(juce::Graphics& g);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDisplay)
+};